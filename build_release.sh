@@ -38,6 +38,9 @@ emmake make -j$(sysctl -n hw.ncpu 2>/dev/null || nproc 2>/dev/null || echo 1)
 echo -e "${YELLOW}Optimizing WebAssembly module...${NC}"
 if command -v wasm-opt &> /dev/null; then
     wasm-opt -O3 ../dist/jwwlib.wasm -o ../dist/jwwlib.wasm
+    if [ -f ../dist/jwwlib.simd.wasm ]; then
+        wasm-opt -O3 --enable-simd ../dist/jwwlib.simd.wasm -o ../dist/jwwlib.simd.wasm
+    fi
 else
     echo -e "${YELLOW}Warning: wasm-opt not found. Skipping optimization.${NC}"
 fi
@@ -48,11 +51,16 @@ cd ..
 mkdir -p wasm
 cp -f dist/jwwlib.js wasm/
 cp -f dist/jwwlib.wasm wasm/
+if [ -f dist/jwwlib.simd.wasm ]; then
+    cp -f dist/jwwlib.simd.js wasm/
+    cp -f dist/jwwlib.simd.wasm wasm/
+fi
 
 echo -e "${GREEN}WebAssembly build (Release) completed successfully!${NC}"
 echo -e "${GREEN}Output files:${NC}"
 echo -e "  - wasm/jwwlib.js"
 echo -e "  - wasm/jwwlib.wasm"
+echo -e "  - wasm/jwwlib.simd.js / wasm/jwwlib.simd.wasm (SIMD128 variant)"
 
 # Show file sizes
 echo -e "\n${YELLOW}File sizes:${NC}"
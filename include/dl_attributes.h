@@ -50,6 +50,7 @@ public:
         setColor(0);
         setWidth(0);
         setLineType("BYLAYER");
+        setPenStyle(0);
     }
 
 
@@ -72,6 +73,7 @@ public:
         setColor(color);
         setWidth(width);
         setLineType(lineType);
+        setPenStyle(0);
     }
 
 
@@ -156,11 +158,29 @@ public:
         }
     }
 
+    /**
+     * Sets the JWW pen style number (線種番号). The line type name
+     *  is only a label; the dash pattern comes from the file header.
+     */
+    void setPenStyle(int penStyle) {
+        this->penStyle = penStyle;
+    }
+
+
+
+    /**
+     * @return JWW pen style number, 0 when not from a JWW file.
+     */
+    int getPenStyle() const {
+        return penStyle;
+    }
+
 private:
     string layer;
     int color;
     int width;
     string lineType;
+    int penStyle;
 };
 
 #endif
\ No newline at end of file
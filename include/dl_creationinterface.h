@@ -237,8 +237,11 @@ public:
       */
      virtual void endSequence() = 0;
 
-    /** Sets the current attributes for entities. */
-    void setAttributes(const DL_Attributes& attrib) {
+    /**
+     * Sets the current attributes for entities. Virtual so that interfaces
+     * storing per-entity pens see every change.
+     */
+    virtual void setAttributes(const DL_Attributes& attrib) {
         attributes = attrib;
     }
 
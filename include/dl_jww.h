@@ -100,6 +100,10 @@ public:
 
     bool in(const string& file,
             DL_CreationInterface* creationInterface);
+    bool in(const char* data, size_t size,
+            DL_CreationInterface* creationInterface);
+    bool in(JWWDocument* jwdoc,
+            DL_CreationInterface* creationInterface);
     bool readJwwGroups(FILE* fp,
                        DL_CreationInterface* creationInterface,
 					   int* errorCounter = NULL);
@@ -190,6 +194,9 @@ public:
     void writeEllipse(DL_WriterA& dw,
                       const DL_EllipseData& data,
                       const DL_Attributes& attrib);
+    void writeSolid(DL_WriterA& dw,
+                    const DL_SolidData& data,
+                    const DL_Attributes& attrib);
     void writeInsert(DL_WriterA& dw,
                      const DL_InsertData& data,
                      const DL_Attributes& attrib);
@@ -323,11 +330,18 @@ public:
 	DL_Codes::version getVersion() {
 		return version;
 	}
+	/** Version written by the write* methods; out() sets it too. */
+	void setVersion(DL_Codes::version v) {
+		version = v;
+	}
 
 	int getLibVersion(const char* str);
 
 	void CreateSen(DL_CreationInterface* creationInterface, CDataSen& DSen);
 	void CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko);
+	void CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko,
+					double angle1, double angle2);
+	static void EnkoAngles(const CDataEnko& DEnko, double& angle1, double& angle2);
 	void CreateTen(DL_CreationInterface* creationInterface, CDataTen& DTen);
 	void CreateMoji(DL_CreationInterface* creationInterface, CDataMoji& DMoji);
 	void CreateSolid(DL_CreationInterface* creationInterface, CDataSolid& DSolid);
@@ -391,4 +405,28 @@ private:
 	int libVersion;
 };
 
+/**
+ * Forwards JWW records to a DL_CreationInterface in file order.
+ * Used with JWWStreamParser so entities are created while the
+ * file is still arriving.
+ */
+class DL_JwwRecordHandler : public JWWRecordHandler {
+public:
+	DL_JwwRecordHandler(DL_Jww* jww, DL_CreationInterface* creationInterface)
+		: jww(jww), creationInterface(creationInterface) {}
+
+	void OnHeader(JWWHead& Header);
+	void OnSen(CDataSen& DSen);
+	void OnEnko(CDataEnko& DEnko);
+	void OnTen(CDataTen& DTen);
+	void OnMoji(CDataMoji& DMoji);
+	void OnSolid(CDataSolid& DSolid);
+	void OnSunpou(CDataSunpou& DSunpou);
+	void OnBlock(CDataBlock& DBlock);
+
+private:
+	DL_Jww* jww;
+	DL_CreationInterface* creationInterface;
+};
+
 #endif
\ No newline at end of file
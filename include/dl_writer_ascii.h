@@ -48,8 +48,18 @@
 class DL_WriterA : public DL_Writer {
 public:
     DL_WriterA(const char* fname, DL_Codes::version version=VER_2000)
-            : DL_Writer(version), m_ofile(fname) {}
-    virtual ~DL_WriterA() = default;
+            : DL_Writer(version), m_inMemory(false), m_ofile(fname) {
+        m_buffer.reserve(BUFFER_SIZE + 512);
+    }
+    /**
+     * Collects all output in memory instead of writing a file.
+     * The text is available from buffer().
+     */
+    explicit DL_WriterA(DL_Codes::version version=VER_2000)
+            : DL_Writer(version), m_inMemory(true) {
+        m_buffer.reserve(BUFFER_SIZE);
+    }
+    virtual ~DL_WriterA();
 
 	bool openFailed() const;
     void close() const;
@@ -59,9 +69,29 @@ public:
     void dxfString(int gc, const char* value) const override;
     void dxfString(int gc, const std::string& value) const override;
 
+    /**
+     * Output written so far and not yet flushed to the file; all of
+     * it for writers created without a file name.
+     */
+    const std::string& buffer() const {
+        return m_buffer;
+    }
+
 	static void strReplace(char* str, char src, char dest);
+	static int formatReal(double value, char* str);
 
 private:
+    void put(int gc, const char* value, size_t length) const;
+    void flushBuffer() const;
+
+    /**
+     * Output is collected here and written to the file in blocks of
+     * about BUFFER_SIZE bytes.
+     */
+    static const size_t BUFFER_SIZE = 64 * 1024;
+    mutable std::string m_buffer;
+    bool m_inMemory;
+
     /**
      * DXF file to be created.
      */
@@ -0,0 +1,51 @@
+// JWW to DXF conversion for jwwlib-wasm
+// Records are decoded one at a time and written straight out as DXF
+// entities through the DL_Jww write* methods; no per-type vectors are
+// built. JWW stores block definitions after the drawing while DXF wants
+// the BLOCKS section before ENTITIES, so the entity text is staged in
+// memory and the file is assembled once the input ends: HEADER, TABLES
+// (the line types, layers and text style in use), every definition once
+// as BLOCK/ENDBLK and the drawing with INSERTs referring to them.
+//
+// Output is DXF R12 (AC1009): it needs no handles or object tables, which
+// DL_Jww does not write, and every DXF reader takes it. R12 has no
+// ELLIPSE, so elliptic arcs become polylines within Options::curveTolerance
+// of the curve. Texts keep their Shift_JIS bytes ($DWGCODEPAGE ANSI_932).
+
+#ifndef JWW_DXF_H
+#define JWW_DXF_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace JWWDxf {
+
+struct Options {
+	// Largest distance between an ellipse and its polyline, drawing units
+	double curveTolerance;
+
+	Options() : curveTolerance(0.01) {}
+};
+
+struct Stats {
+	size_t entities;	// entities written, including those inside blocks
+	size_t blocks;		// BLOCK definitions
+	size_t inserts;		// INSERTs
+	size_t bytes;		// size of the DXF output
+
+	Stats() : entities(0), blocks(0), inserts(0), bytes(0) {}
+};
+
+// Convert a JWW file held in memory. False when the data does not parse;
+// nothing is written then.
+bool convert(const char* data, size_t size, std::ostream& out,
+             const Options& options = Options(), Stats* stats = NULL);
+
+// Convert the file at input into output
+bool convertFile(const std::string& input, const std::string& output,
+                 const Options& options = Options(), Stats* stats = NULL);
+
+} // namespace JWWDxf
+
+#endif // JWW_DXF_H
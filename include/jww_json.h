@@ -0,0 +1,75 @@
+// JWW to NDJSON conversion for jwwlib-wasm
+// One JSON object per line, written straight from the decoded records
+// (no DL_Jww entities, no Embind objects) into a buffer that is handed to
+// a Sink in chunks of about Options::chunkSize bytes. Chunks always end
+// on a line boundary.
+//
+// Lines, in file order:
+//   {"type":"header","version":600,"memo":"...","layerGroups":[...],"layers":[[...],...]}
+//   {"type":"line",PEN,"x1":0,"y1":0,"x2":10.5,"y2":0}
+//   {"type":"arc",PEN,"x":0,"y":0,"radius":5,"start":0,"sweep":1.5,"tilt":0,"ratio":1,"full":false}
+//   {"type":"point",PEN,"x":1,"y":2,"temporary":false,"code":0,"angle":0,"scale":1}
+//   {"type":"text",PEN,"x1":..,"y1":..,"x2":..,"y2":..,"kind":0,"charWidth":3,"charHeight":3,
+//    "spacing":0,"angle":0,"font":"...","text":"..."}
+//   {"type":"solid",PEN,"x1":..,"y1":..,...,"x4":..,"y4":..[,"rgb":1193046]}
+//   {"type":"dimension",PEN,"line":{...},"label":{...}}
+//   {"type":"insert",PEN,"x":..,"y":..,"scaleX":1,"scaleY":1,"angle":0,"number":0}
+//   {"type":"block","number":0,"name":"door","flag":4,"count":2}
+// PEN is "glayer":1,"layer":2,"color":2,"style":1,"width":1. Records of a
+// block definition follow its "block" line and carry "block":number.
+// Angles are radians except text angles (degrees), as JWW stores them.
+// Strings are converted from Shift_JIS to UTF-8. Reals are the shortest
+// decimals that read back as the same double; non-finite values are null.
+
+#ifndef JWW_JSON_H
+#define JWW_JSON_H
+
+#include <cstddef>
+#include <string>
+
+namespace JWWJson {
+
+// Receives the output; data is only valid during the call
+class Sink {
+public:
+	virtual ~Sink() {}
+	virtual void write(const char* data, size_t size) = 0;
+};
+
+struct Options {
+	// Bytes collected before they are passed to the sink
+	size_t chunkSize;
+	// Write the header line
+	bool header;
+	// Write text records (dimensions keep their labels)
+	bool texts;
+
+	Options() : chunkSize(64 * 1024), header(true), texts(true) {}
+};
+
+struct Stats {
+	size_t records;	// entity lines, including those inside blocks
+	size_t blocks;	// "block" lines
+	size_t chunks;	// calls to the sink
+	size_t bytes;	// size of the output
+
+	Stats() : records(0), blocks(0), chunks(0), bytes(0) {}
+};
+
+// Convert a JWW file held in memory. False when the data does not parse;
+// lines are streamed as they are decoded, so the sink may already have
+// been given those before the point where a cut or corrupt file failed.
+bool convert(const char* data, size_t size, Sink& sink,
+             const Options& options = Options(), Stats* stats = NULL);
+
+// The same, appended to out; out is left as it was on failure
+bool convert(const char* data, size_t size, std::string& out,
+             const Options& options = Options(), Stats* stats = NULL);
+
+// Convert the file at input into output; no output is left on failure
+bool convertFile(const std::string& input, const std::string& output,
+                 const Options& options = Options(), Stats* stats = NULL);
+
+} // namespace JWWJson
+
+#endif // JWW_JSON_H
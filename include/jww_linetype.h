@@ -0,0 +1,99 @@
+// Line type expansion for jwwlib-wasm
+// Turns JWW pen styles (線種番号) into dash segment lists at a display
+// scale, using the pattern tables stored in the file header:
+//   2-9    m_alLType1   bit patterns
+//   11-15  m_alLType2   random (wobbly) lines
+//   16-19  m_alLType3   double-length bit patterns
+//   30-62  m_SxfLtp     SXF patterns, or user-defined pitches in mm
+// Pattern lengths are in screen dots; scale is dots per drawing unit.
+
+#ifndef JWW_LINETYPE_H
+#define JWW_LINETYPE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "jwwdoc.h"
+
+namespace JWWLinetype {
+
+struct Pattern {
+	enum Kind { Solid, Dashed, Random };
+	Kind kind;
+	std::vector<double> dashes;	// Dashed: on, off, on, off, ... (dots)
+	double amplitude;	// Random: wobble amplitude (dots)
+	double pitch;	// Random: wobble wavelength (dots)
+
+	Pattern() : kind(Solid), amplitude(0.0), pitch(0.0) {}
+	double period() const;
+};
+
+// On/off runs of the low unitDots bits of a pattern word, least
+// significant bit first, each bit `pitch` dots long. The runs start with
+// an "on" run (a leading gap becomes a zero-length dash).
+void bitsToDashes(uint32_t bits, int unitDots, int pitch, std::vector<double>& dashes);
+
+// Pattern of every pen style number; unknown styles are solid
+class PatternTable {
+public:
+	static const int STYLE_COUNT = 64;
+
+	PatternTable();
+	// dotsPerMM converts SXF user-defined pitches (mm) to dots
+	void load(const JWWHead& head, double dotsPerMM = 96.0 / 25.4);
+	void reset();
+	const Pattern& get(int penStyle) const;
+
+private:
+	std::vector<Pattern> patterns;
+};
+
+// Append line-list segments (x0, y0, x1, y1 per segment) for one entity.
+// A pattern whose period is under MIN_PERIOD dots, or that would need
+// more than MAX_DASHES dashes, is drawn solid: at that zoom the gaps are
+// not visible anyway. Arcs run counter-clockwise from start (radians) and
+// are tessellated within half a dot.
+static const double MIN_PERIOD = 2.0;
+static const size_t MAX_DASHES = 65536;
+
+void expandLine(const Pattern& pattern, double scale,
+                double x1, double y1, double x2, double y2, std::vector<double>& out);
+void expandArc(const Pattern& pattern, double scale,
+               double cx, double cy, double r, double start, double sweep,
+               std::vector<double>& out);
+
+// Scale buckets are quarter octaves: an expansion made at bucketScale(b)
+// is reused while the zoom stays within about 19% of it
+int scaleBucket(double scale);
+double bucketScale(int bucket);
+
+// Expansions keyed by (entity, scale bucket). Entries stay put while a
+// frame is built from them; trim() between frames drops everything once
+// the byte budget is exceeded, so memory stays bounded while a user zooms
+// through many buckets.
+class SegmentCache {
+public:
+	explicit SegmentCache(size_t maxBytes = 64u << 20);
+
+	const std::vector<double>* find(uint32_t entity, int bucket) const;
+	// Takes the contents of segments
+	const std::vector<double>& insert(uint32_t entity, int bucket, std::vector<double>& segments);
+	void trim();
+	void clear();
+	size_t bytes() const { return used; }
+	size_t size() const { return entries.size(); }
+
+private:
+	std::unordered_map<uint64_t, std::vector<double> > entries;
+	size_t used;
+	size_t maxBytes;
+
+	static uint64_t key(uint32_t entity, int bucket) {
+		return (static_cast<uint64_t>(entity) << 32) | static_cast<uint32_t>(bucket);
+	}
+};
+
+} // namespace JWWLinetype
+
+#endif // JWW_LINETYPE_H
@@ -0,0 +1,104 @@
+// Level-of-detail pyramid for jwwlib-wasm
+// Connected line segments are chained into polylines and simplified with
+// Douglas-Peucker at a tolerance that doubles per level (one pass ranks
+// every point, each level keeps those above its tolerance); curves are
+// tessellated at the level's tolerance, and arcs and texts smaller than it
+// are dropped. Each level is a GPU line list (x0, y0, x1, y1 per segment)
+// grouped by pen, so an overview render draws a fraction of the segments.
+
+#ifndef JWW_LOD_H
+#define JWW_LOD_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace JWWLod {
+
+static const int MAX_LEVELS = 16;
+
+// Join segments of the same pen that meet end to end at points shared by
+// exactly two segments (exact coordinates). Segment i is xy[i*4 .. i*4+3].
+// Chain c is points[offsets[c]*2 .. offsets[c+1]*2) with pen chainPens[c];
+// a closed loop repeats its first point at the end.
+void chainSegments(const std::vector<double>& xy, const std::vector<uint32_t>& pens,
+                   std::vector<double>& points, std::vector<uint32_t>& offsets,
+                   std::vector<uint32_t>& chainPens);
+
+// As above, with ends closer than tolerance joined: ends are matched
+// through a hash grid of tolerance-sized cells, so the pass is O(n)
+// expected, and a join takes the point of the first end that made it.
+// segmentOrder
+// receives the segment behind every chain edge in chain order: chain c's
+// edges are segmentOrder[offsets[c] - c .. offsets[c + 1] - c - 1).
+void chainSegments(const std::vector<double>& xy, const std::vector<uint32_t>& pens,
+                   double tolerance, std::vector<double>& points,
+                   std::vector<uint32_t>& offsets, std::vector<uint32_t>& chainPens,
+                   std::vector<uint32_t>& segmentOrder);
+
+// Douglas-Peucker significance of each point of a polyline (count
+// interleaved points): the largest tolerance at which simplification keeps
+// it. End points are HUGE_VAL; points not kept at minTolerance are 0, and
+// below minTolerance the recursion stops.
+void significance(const double* xy, size_t count, double minTolerance, std::vector<double>& out);
+
+// Douglas-Peucker: append the indices of the points of the polyline
+// (count interleaved points) that keep it within tolerance. The first and
+// last points are always kept.
+void simplify(const double* xy, size_t count, double tolerance, std::vector<uint32_t>& keep);
+
+struct Group {
+	uint32_t pen;
+	uint32_t first;	// first vertex
+	uint32_t count;	// vertex count
+};
+
+struct Level {
+	double tolerance;
+	std::vector<float> vertices;	// line list relative to the origin
+	std::vector<Group> groups;	// ascending pen
+	std::vector<uint32_t> texts;	// ids of texts at least tolerance tall
+};
+
+class Pyramid {
+public:
+	Pyramid() : originX(0.0), originY(0.0) {}
+
+	// Input, in any order; pens are small ids chosen by the caller
+	void addSegment(double x1, double y1, double x2, double y2, uint32_t pen);
+	// Elliptic arc as in JWWTessellate::emitArc; a circle is rx == ry
+	void addArc(double cx, double cy, double rx, double ry, double rotation,
+	            double start, double sweep, uint32_t pen);
+	void addText(uint32_t id, double height);
+
+	// Build levelCount levels, level i at baseTolerance * 2^i, with
+	// coordinates relative to the origin. The input is released.
+	void build(double baseTolerance, int levelCount, double originX, double originY);
+	void clear();
+
+	int levelCount() const { return static_cast<int>(levels.size()); }
+	const Level& level(int i) const { return levels[i]; }
+	// Coarsest level whose tolerance is within unitsPerPixel (0 if none)
+	int levelFor(double unitsPerPixel) const;
+	double getOriginX() const { return originX; }
+	double getOriginY() const { return originY; }
+	size_t reservedBytes() const;
+
+private:
+	struct Arc {
+		double cx, cy, rx, ry, rotation, start, sweep;
+		uint32_t pen;
+	};
+
+	std::vector<double> segmentXY;
+	std::vector<uint32_t> segmentPens;
+	std::vector<Arc> arcs;
+	std::vector<std::pair<double, uint32_t> > texts;	// height, id
+	std::vector<Level> levels;
+	double originX;
+	double originY;
+};
+
+} // namespace JWWLod
+
+#endif // JWW_LOD_H
@@ -0,0 +1,97 @@
+// Heap accounting for jwwlib-wasm
+// When built with JWW_MEMORY_TRACKING the global operator new/delete are
+// replaced by counting versions. Every allocation is charged to the category
+// of the innermost JWWMemory::Scope on the allocating thread, and the charge
+// is returned to that same category when the block is freed. Allocations
+// made under a JWWMemory::Charge are also charged to its Owner.
+
+#ifndef JWW_MEMORY_H
+#define JWW_MEMORY_H
+
+#include <cstddef>
+
+namespace JWWMemory {
+
+enum Category {
+	Other = 0,	// anything allocated outside a scope
+	Input,		// file bytes handed to the parser
+	Document,	// JWWDocument records, class list and block definitions
+	Entities,	// converted entities (JSCreationInterface)
+	Index,		// lookup indexes built after parsing
+	CategoryCount
+};
+
+struct CategoryStats {
+	size_t liveBytes;	// requested bytes currently allocated
+	size_t allocations;	// blocks allocated so far
+	size_t frees;		// blocks freed so far
+};
+
+struct Stats {
+	bool enabled;		// false when built without JWW_MEMORY_TRACKING
+	size_t liveBytes;	// sum of the categories
+	size_t peakBytes;	// highest liveBytes since the last resetPeak()
+	size_t allocations;
+	size_t frees;
+	CategoryStats category[CategoryCount];
+};
+
+bool enabled();
+Stats snapshot();
+
+// Start a new peak window (e.g. at the beginning of a parse)
+void resetPeak();
+
+// "other", "input", "document", "entities" or "index"
+const char* categoryName(Category category);
+
+// Charges allocations made on this thread to a category until destroyed.
+// Scopes nest; the innermost one wins.
+class Scope {
+public:
+	explicit Scope(Category category);
+	~Scope();
+
+private:
+	Category previous;
+	Scope(const Scope&);
+	Scope& operator=(const Scope&);
+};
+
+struct Account;
+
+// One owner's share of the counters (e.g. one reader): bytes allocated
+// under a Charge for it and not freed yet, wherever they are freed. Stays
+// valid for blocks that outlive the Owner. Always 0 without tracking.
+class Owner {
+public:
+	Owner();
+	~Owner();
+	size_t liveBytes() const;
+	// Highest liveBytes() since construction or the last resetPeak()
+	size_t peakBytes() const;
+	void resetPeak();
+
+private:
+	friend class Charge;
+	Account* account;
+	Owner(const Owner&);
+	Owner& operator=(const Owner&);
+};
+
+// Charges allocations made on this thread to owner, on top of the current
+// category, until destroyed. Charges nest; NULL keeps the current owner.
+class Charge {
+public:
+	explicit Charge(const Owner* owner);
+	~Charge();
+
+private:
+	Account* previous;
+	Charge(const Charge&);
+	Charge& operator=(const Charge&);
+};
+
+} // namespace JWWMemory
+
+#endif // JWW_MEMORY_H
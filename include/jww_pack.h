@@ -0,0 +1,45 @@
+// Packed geometry columns for jwwlib-wasm
+// Compact form for drawings that are kept open but not shown. A column of
+// interleaved values (x1, y1, x2, y2, x1, ...) is delta coded against the
+// previous value of the same component, zigzag mapped, and bit-packed in
+// blocks of BLOCK values at the width of the block's largest delta. Nearby
+// entities and shared pens give small deltas, and a run of equal values
+// packs to nothing but the block's width byte. The decoder has no
+// data-dependent branches inside a block: one unaligned 64-bit load and a
+// shift per value, then a running sum per component.
+//
+// Reals are packed exactly as their IEEE-754 bit patterns, or, when a
+// step is given, quantized to multiples of it first; the largest
+// difference from the originals is returned so callers can report it.
+
+#ifndef JWW_PACK_H
+#define JWW_PACK_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace JWWPack {
+
+const size_t BLOCK = 128;
+
+// Append count values (stride interleaved components) to out
+void pack(const int64_t* values, size_t count, size_t stride, std::vector<uint8_t>& out);
+
+// Decode count values written by pack() with the same stride from data.
+// Returns the bytes consumed, 0 when data is too short.
+size_t unpack(const uint8_t* data, size_t size, size_t count, size_t stride, int64_t* out);
+
+// Quantize to the nearest multiples of step and pack(); values too large
+// for the step are clamped and NaN is stored as 0. Returns the largest
+// |decoded - original|, infinity when a NaN was stored. With step <= 0 the
+// bit patterns are packed instead: every value, NaN included, decodes
+// exactly and 0 is returned.
+double packReals(const double* values, size_t count, size_t stride, double step, std::vector<uint8_t>& out);
+
+// Decode reals written by packReals() with the same stride and step
+size_t unpackReals(const uint8_t* data, size_t size, size_t count, size_t stride, double step, double* out);
+
+} // namespace JWWPack
+
+#endif // JWW_PACK_H
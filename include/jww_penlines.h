@@ -0,0 +1,105 @@
+// Pen-bucketed line lists for jwwlib-wasm
+// Segments and elliptic arcs become one GPU line list (x0, y0, x1, y1 per
+// segment) with each pen's vertices contiguous, so a renderer changes pen
+// state once per bucket rather than once per item. Arcs get the fewest
+// segments that keep each chord within tolerance (see jww_tessellate.h).
+// Every item is counted first and then written straight into its bucket,
+// so nothing is sorted but the handful of distinct pens.
+
+#ifndef JWW_PENLINES_H
+#define JWW_PENLINES_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace JWWPenLines {
+
+// Buckets come out ordered by layer, then line type, width and color.
+// Callers that do not key on a field set it to the same value (e.g. -1)
+// for every item.
+struct Pen {
+	int layer;
+	int lineType;
+	int width;
+	int color;
+};
+
+inline bool operator<(const Pen& a, const Pen& b)
+{
+	if (a.layer != b.layer)
+		return a.layer < b.layer;
+	if (a.lineType != b.lineType)
+		return a.lineType < b.lineType;
+	if (a.width != b.width)
+		return a.width < b.width;
+	return a.color < b.color;
+}
+
+inline bool operator==(const Pen& a, const Pen& b)
+{
+	return a.layer == b.layer && a.lineType == b.lineType &&
+	       a.width == b.width && a.color == b.color;
+}
+
+struct Group {
+	Pen pen;
+	uint32_t first;	// first vertex
+	uint32_t count;	// vertex count (two per segment)
+};
+
+class Builder {
+public:
+	Builder() : lastPen(), lastId(0) {}
+
+	// Input; within a bucket items keep the order they were added in.
+	// Pens repeat in runs, so the pen table is only consulted on a change.
+	// Segments are referenced, not copied: xy (x1, y1, x2, y2 per segment)
+	// must stay valid until the last build() before clear().
+	void addSegments(const double* xy, size_t count, const Pen& pen) {
+		if (count > 0) {
+			Item item = {xy, static_cast<uint32_t>(count), penId(pen)};
+			items.push_back(item);
+		}
+	}
+	// Elliptic arc as in JWWTessellate::emitArc; a circle is rx == ry
+	void addArc(double cx, double cy, double rx, double ry, double rotation,
+	            double start, double sweep, const Pen& pen);
+
+	// Write the line list relative to the origin and one group per pen, in
+	// pen order with the groups back to back. The input is kept.
+	void build(double tolerance, double originX, double originY,
+	           std::vector<float>& vertices, std::vector<Group>& groups) const;
+
+	// Room for this many items and arcs among them, so adding does not regrow
+	void reserve(size_t itemCount, size_t arcCount);
+	// Items added so far
+	size_t size() const { return items.size(); }
+	void clear();
+
+private:
+	struct Arc {
+		double cx, cy, rx, ry, rotation, start, sweep;
+	};
+	struct Item {
+		const double* xy;	// the caller's segments, NULL for an arc
+		uint32_t index;	// segment count, or arc index
+		uint32_t pen;	// id in order of first use
+	};
+
+	uint32_t penId(const Pen& pen) {
+		return !items.empty() && pen == lastPen ? lastId : newPen(pen);
+	}
+	uint32_t newPen(const Pen& pen);
+
+	std::vector<Arc> arcs;
+	std::vector<Item> items;	// input order
+	std::map<Pen, uint32_t> penIds;
+	Pen lastPen;
+	uint32_t lastId;
+};
+
+} // namespace JWWPenLines
+
+#endif // JWW_PENLINES_H
@@ -0,0 +1,83 @@
+// Quantized coordinate buffers for jwwlib-wasm
+// Coordinates are encoded as float32 or int32 offsets from a per-document
+// origin, with the origin and the step size kept in double. Drawings are
+// often placed far from (0, 0) (survey coordinates, sheet offsets), where
+// a plain float32 keeps only a few decimals; offsets from the middle of the
+// drawing's extents keep float32 precision relative to the drawing's size
+// instead. int32 spreads the extents over the whole integer range, a fixed
+// step everywhere. Every stored value is checked against its double, and
+// the largest error is reported.
+
+#ifndef JWW_QUANT_H
+#define JWW_QUANT_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace JWWQuant {
+
+enum Format {
+	FLOAT32,
+	INT32
+};
+
+// value = origin + stored * scale; lengths (radii, axes) = stored * scale
+struct Frame {
+	Format format;
+	double originX;
+	double originY;
+	double scale;	// drawing units per step; 1 for FLOAT32
+
+	Frame() : format(FLOAT32), originX(0), originY(0), scale(1) {}
+
+	double x(double stored) const { return originX + stored * scale; }
+	double y(double stored) const { return originY + stored * scale; }
+	double length(double stored) const { return stored * scale; }
+};
+
+// Frame for the box: origin at its center and, for INT32, the step that
+// maps the larger half extent (with a little headroom) onto int32
+Frame fit(double minX, double minY, double maxX, double maxY, Format format);
+
+// One column of quantized values: x, y and length entries in the order
+// they were added, so a line is four consecutive values
+class Store {
+public:
+	Store() : maxErr(0) {}
+	explicit Store(const Frame& frame) : maxErr(0), frm(frame) {}
+
+	// Drop the values, keeping the capacity, and use another frame
+	void reset(const Frame& frame);
+	void reserve(size_t values);
+	// Return the storage to the heap
+	void release();
+
+	void point(double x, double y) {
+		add(x, frm.originX);
+		add(y, frm.originY);
+	}
+	void length(double v) { add(v, 0.0); }
+
+	const Frame& frame() const { return frm; }
+	size_t size() const { return frm.format == INT32 ? ints.size() : floats.size(); }
+	// The values in the frame's format; the other one is empty
+	const std::vector<float>& float32() const { return floats; }
+	const std::vector<int32_t>& int32() const { return ints; }
+	// Largest |decoded - original| over the values added since reset();
+	// values outside an INT32 frame are clamped and counted here too
+	double maxError() const { return maxErr; }
+	size_t bytes() const { return floats.capacity() * sizeof(float) + ints.capacity() * sizeof(int32_t); }
+
+private:
+	void add(double v, double origin);
+
+	double maxErr;
+	Frame frm;
+	std::vector<float> floats;
+	std::vector<int32_t> ints;
+};
+
+} // namespace JWWQuant
+
+#endif // JWW_QUANT_H
@@ -0,0 +1,94 @@
+// Software rasterizer for jwwlib-wasm
+// Draws a parsed drawing into an RGBA buffer for server-side thumbnails:
+// anti-aliased lines, arcs and ellipses (Xiaolin Wu), anti-aliased solid
+// fills (four sub-scanlines with exact horizontal coverage) and texts as
+// translucent boxes. encodePNG() writes the buffer as an RGBA PNG with a
+// small built-in deflate, so no image library or browser is needed.
+
+#ifndef JWW_RASTER_H
+#define JWW_RASTER_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace JWWRaster {
+
+// Colors are 0xRRGGBBAA
+static const uint32_t WHITE = 0xFFFFFFFFu;
+static const uint32_t BLACK = 0x000000FFu;
+
+class Canvas {
+public:
+	Canvas() : w(0), h(0) {}
+	Canvas(int width, int height, uint32_t background = WHITE) { resize(width, height, background); }
+
+	// Reallocate (keeping capacity) and fill with the background
+	void resize(int width, int height, uint32_t background = WHITE);
+	void clear(uint32_t background);
+
+	int width() const { return w; }
+	int height() const { return h; }
+	// Rows top to bottom, 4 bytes per pixel
+	const std::vector<uint8_t>& pixels() const { return rgba; }
+	uint32_t pixel(int x, int y) const;
+
+	// One pixel wide anti-aliased line in pixel coordinates (pixel centers
+	// at +0.5); parts outside the canvas are clipped
+	void drawLine(double x0, double y0, double x1, double y1, uint32_t color);
+	// Elliptic arc as in JWWTessellate::emitArc, in pixel coordinates, as
+	// chords within a quarter pixel of the curve
+	void drawArc(double cx, double cy, double rx, double ry, double rotation,
+	             double start, double sweep, uint32_t color);
+	// Anti-aliased fill of a polygon (count interleaved points) with the
+	// non-zero winding rule
+	void fillPolygon(const double* xy, int count, uint32_t color);
+
+	// Blend color over the pixel with the given coverage in [0, 1]
+	void blend(int x, int y, uint32_t color, double coverage);
+
+private:
+	int w, h;
+	std::vector<uint8_t> rgba;
+	std::vector<float> coverage;	// fillPolygon row accumulator
+	std::vector<std::pair<double, int> > crossings;	// x, winding direction
+	std::vector<float> arcPoints;
+};
+
+struct Options {
+	int width;
+	int height;
+	uint32_t background;
+	// Blank border around the drawing, in pixels
+	int margin;
+	// Draw texts as boxes of their estimated extent
+	bool drawTexts;
+
+	Options() : width(256), height(256), background(WHITE), margin(4), drawTexts(true) {}
+};
+
+// DXF color number (as produced from the JWW pen color by DL_Jww) to
+// 0xRRGGBBAA. White/black (7, 0 and BYLAYER) contrast with the background.
+uint32_t aciToRGBA(int color, uint32_t background = WHITE);
+
+// Parse a JWW file held in memory and draw it fitted into an
+// options.width x options.height canvas, y axis up. Returns false when the
+// data does not parse; the canvas then holds only the background.
+bool renderThumbnail(const char* data, size_t size, const Options& options, Canvas& canvas);
+
+// Encode width x height RGBA pixels (rows top to bottom) as a PNG file,
+// replacing out
+void encodePNG(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& out);
+inline void encodePNG(const Canvas& canvas, std::vector<uint8_t>& out)
+{
+	encodePNG(canvas.pixels().data(), canvas.width(), canvas.height(), out);
+}
+
+// CRC-32 (PNG chunks) and Adler-32 (zlib stream) checksums
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+} // namespace JWWRaster
+
+#endif // JWW_RASTER_H
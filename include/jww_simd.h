@@ -0,0 +1,69 @@
+// Vectorized geometry kernels for jwwlib-wasm
+// The same entry points compile to WASM SIMD128 (-msimd128), AVX/SSE2 on
+// native builds, or plain scalar code when no vector ISA is available.
+// On SSE2 builds the bounds and angle kernels (SSE4.1, picked at run time)
+// beat the compiler's loops; transforms and float narrowing run at the
+// speed of the scalar loops the compiler vectorizes itself.
+
+#ifndef JWW_SIMD_H
+#define JWW_SIMD_H
+
+#include <cstddef>
+
+namespace JWWSimd {
+
+// Axis-aligned extents accumulated by computeBounds()
+struct Bounds {
+	double minX;
+	double minY;
+	double maxX;
+	double maxY;
+	bool valid;
+
+	Bounds() : minX(0.0), minY(0.0), maxX(0.0), maxY(0.0), valid(false) {}
+};
+
+// Name of the instruction set the kernels were compiled for:
+// "wasm-simd128", "avx", "sse2" or "scalar".
+const char* backend();
+
+// Extend bounds by count interleaved points (x0, y0, x1, y1, ...).
+void computeBounds(const double* xy, size_t count, Bounds& bounds);
+
+// Apply the affine matrix m = {a, b, c, d, e, f} to count interleaved points:
+//   x' = a*x + c*y + e,  y' = b*x + d*y + f
+// in and out may alias.
+void transformPoints(const double* in, double* out, size_t count, const double m[6]);
+
+// Wrap count angles (radians) into [0, 2*PI) using the same
+// a - floor(a / 2PI) * 2PI formula as DL_Jww::CreateEnko.
+void normalizeAngles(double* angles, size_t count);
+
+// Normalize start/end angle pairs of arcs: both are wrapped into [0, 2*PI)
+// and the start angle is moved back one turn when end <= start.
+void normalizeArcAngles(double* start, double* end, size_t count);
+
+// Narrow count doubles to float.
+void toFloat(const double* in, float* out, size_t count);
+
+// Narrow count interleaved points to float relative to an origin:
+//   out = (p - origin) * scale
+// Keeps precision for drawings far from (0, 0).
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale);
+
+// Reference implementations, always compiled without intrinsics.
+// Used by the tests and the benchmark to validate the vector paths.
+namespace scalar {
+void computeBounds(const double* xy, size_t count, Bounds& bounds);
+void transformPoints(const double* in, double* out, size_t count, const double m[6]);
+void normalizeAngles(double* angles, size_t count);
+void normalizeArcAngles(double* start, double* end, size_t count);
+void toFloat(const double* in, float* out, size_t count);
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale);
+}
+
+} // namespace JWWSimd
+
+#endif // JWW_SIMD_H
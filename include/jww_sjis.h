@@ -0,0 +1,28 @@
+// Shift_JIS to UTF-8 for jwwlib-wasm
+// Jw_cad writes texts in Windows code page 932 (Shift_JIS with the NEC and
+// IBM extensions). The conversion is table driven, so it behaves the same
+// natively and in WASM, where there is no iconv.
+
+#ifndef JWW_SJIS_H
+#define JWW_SJIS_H
+
+#include <cstddef>
+#include <string>
+
+namespace JWWSjis {
+
+// Append the UTF-8 form of size bytes of CP932 text to out. Bytes that do
+// not form a character become U+FFFD.
+void appendUtf8(const char* data, size_t size, std::string& out);
+
+inline std::string toUtf8(const std::string& sjis)
+{
+	std::string out;
+	out.reserve(sjis.size() + sjis.size() / 2);
+	appendUtf8(sjis.data(), sjis.size(), out);
+	return out;
+}
+
+} // namespace JWWSjis
+
+#endif // JWW_SJIS_H
@@ -0,0 +1,198 @@
+// Columnar binary snapshot of a parsed JWW document for jwwlib-wasm
+// A snapshot holds the decoded records as one array per field (structure
+// of arrays), so it can be mmap()ed or wrapped in an ArrayBuffer and read
+// in place: every column is a plain little-endian array at an 8-byte
+// aligned offset, and nothing is decoded per entity.
+//
+// Layout:
+//   Header     64 bytes, see FileHeader
+//   Directory  sectionCount SectionEntry records
+//   Columns    in directory order, each padded to 8 bytes
+//
+// The header carries the XXH64 hash and size of the JWW bytes the snapshot
+// was made from, so a cache can look snapshots up by source content.
+// Records of block definitions are stored with the drawing's records and
+// carry their definition number in the PEN_BLOCK column (NO_BLOCK for the
+// drawing). Strings are Shift_JIS converted to UTF-8 and stored once in a
+// string table; string columns hold ids into it, id 0 being "".
+// Angles are radians except text angles (degrees), as JWW stores them.
+
+#ifndef JWW_SNAPSHOT_H
+#define JWW_SNAPSHOT_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+namespace JWWSnapshot {
+
+const char MAGIC[8] = { 'J', 'W', 'W', 'S', 'N', 'A', 'P', '1' };
+// Bumped whenever the layout or a column changes meaning
+const uint32_t VERSION = 1;
+const uint32_t NO_BLOCK = 0xFFFFFFFFu;
+
+enum Kind {
+	KIND_LINE,
+	KIND_ARC,
+	KIND_POINT,
+	KIND_TEXT,
+	KIND_SOLID,
+	KIND_DIMENSION,
+	KIND_INSERT,
+	KIND_BLOCK,		// block definitions
+	KIND_LAYER,		// layer table, fixed length
+	KIND_STRING,	// string table
+	KIND_COUNT
+};
+
+enum Type {
+	TYPE_U8 = 1,
+	TYPE_U16 = 2,
+	TYPE_U32 = 3,
+	TYPE_F64 = 4
+};
+
+// Columns of every entity kind (KIND_LINE to KIND_INSERT)
+enum PenColumn {
+	PEN_LAYER,		// u8, layer group * 16 + layer
+	PEN_COLOR,		// u16
+	PEN_STYLE,		// u8
+	PEN_WIDTH,		// u16
+	PEN_BLOCK		// u32, definition number or NO_BLOCK
+};
+
+// Entity specific columns start here; f64 unless noted
+const int FIRST_COLUMN = 8;
+
+enum LineColumn { LINE_X1 = FIRST_COLUMN, LINE_Y1, LINE_X2, LINE_Y2 };
+enum ArcColumn {
+	ARC_X = FIRST_COLUMN, ARC_Y, ARC_RADIUS, ARC_START, ARC_SWEEP, ARC_TILT, ARC_RATIO,
+	ARC_FULL		// u8
+};
+enum PointColumn {
+	POINT_X = FIRST_COLUMN, POINT_Y, POINT_ANGLE, POINT_SCALE,
+	POINT_CODE,		// u32
+	POINT_TEMPORARY	// u8
+};
+enum TextColumn {
+	TEXT_X1 = FIRST_COLUMN, TEXT_Y1, TEXT_X2, TEXT_Y2, TEXT_WIDTH, TEXT_HEIGHT, TEXT_SPACING, TEXT_ANGLE,
+	TEXT_KIND,		// u32
+	TEXT_FONT,		// u32 string id
+	TEXT_STRING		// u32 string id
+};
+// Outline order; RGB is the color of pen 10 and 0 otherwise
+enum SolidColumn {
+	SOLID_X1 = FIRST_COLUMN, SOLID_Y1, SOLID_X2, SOLID_Y2, SOLID_X3, SOLID_Y3, SOLID_X4, SOLID_Y4,
+	SOLID_RGB		// u32
+};
+// The dimension line, and the label with its own pen fields dropped
+enum DimensionColumn {
+	DIMENSION_X1 = FIRST_COLUMN, DIMENSION_Y1, DIMENSION_X2, DIMENSION_Y2,
+	DIMENSION_LABEL_X, DIMENSION_LABEL_Y, DIMENSION_LABEL_HEIGHT, DIMENSION_LABEL_ANGLE,
+	DIMENSION_LABEL	// u32 string id
+};
+enum InsertColumn {
+	INSERT_X = FIRST_COLUMN, INSERT_Y, INSERT_SCALE_X, INSERT_SCALE_Y, INSERT_ANGLE,
+	INSERT_NUMBER	// u32
+};
+// u32; NAME is a string id without the "@@SfigorgFlag@@" suffix
+enum BlockColumn { BLOCK_NUMBER, BLOCK_NAME, BLOCK_COUNT };
+// NAME and STATE have 256 rows (group * 16 + layer), the GROUP columns 16
+enum LayerColumn {
+	LAYER_NAME,			// u32 string id
+	LAYER_STATE,		// u32
+	LAYER_GROUP_NAME,	// u32 string id
+	LAYER_GROUP_STATE,	// u32
+	LAYER_GROUP_SCALE	// f64
+};
+// OFFSETS has one row more than there are strings; string i is the bytes
+// from OFFSETS[i] to OFFSETS[i + 1]
+enum StringColumn {
+	STRING_OFFSETS,		// u32
+	STRING_BYTES		// u8
+};
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t sectionCount;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint64_t fileSize;
+	uint32_t jwwVersion;	// JW_DATA_VERSION
+	uint32_t paper;			// m_nZumen
+	uint32_t memo;			// string id
+	uint32_t reserved[3];
+};
+
+struct SectionEntry {
+	uint16_t id;		// kind << 8 | column
+	uint8_t type;		// Type
+	uint8_t reserved;
+	uint32_t count;		// rows
+	uint64_t offset;	// from the start of the snapshot
+};
+
+struct Stats {
+	size_t records;		// entities, including those inside blocks
+	size_t blocks;		// block definitions
+	size_t strings;		// entries of the string table
+	size_t bytes;		// size of the snapshot
+
+	Stats() : records(0), blocks(0), strings(0), bytes(0) {}
+};
+
+// XXH64 of data, the hash stored in snapshots (with seed 0)
+uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+// Parse a JWW file held in memory into a snapshot that replaces out.
+// False when the data does not parse; out is left empty then.
+bool write(const char* data, size_t size, std::string& out, Stats* stats = NULL);
+
+// Snapshot the file at input into output
+bool writeFile(const std::string& input, const std::string& output, Stats* stats = NULL);
+
+// Read access to a snapshot in memory. Nothing is copied; the data must
+// stay valid and unchanged while the View is used.
+class View {
+public:
+	View();
+
+	// False when data is not a snapshot of this version, is truncated, or
+	// does not start at an 8-byte boundary
+	bool open(const void* data, size_t size);
+	bool isOpen() const { return base != NULL; }
+
+	const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(base); }
+	uint64_t sourceHash() const { return header().sourceHash; }
+
+	// Rows of a kind; the entity count for KIND_LINE to KIND_BLOCK
+	size_t count(Kind kind) const;
+	// A column, or NULL when it is missing or T does not match its type
+	template<class T>
+	const T* column(Kind kind, int column, size_t* rows = NULL) const {
+		return static_cast<const T*>(find(kind, column, typeOf(static_cast<T*>(NULL)), rows));
+	}
+
+	size_t stringCount() const;
+	// UTF-8 bytes of string id, not NUL terminated; "" for a bad id
+	const char* string(uint32_t id, size_t* length) const;
+	std::string string(uint32_t id) const;
+
+private:
+	const void* find(Kind kind, int column, Type type, size_t* rows) const;
+	static Type typeOf(uint8_t*) { return TYPE_U8; }
+	static Type typeOf(uint16_t*) { return TYPE_U16; }
+	static Type typeOf(uint32_t*) { return TYPE_U32; }
+	static Type typeOf(double*) { return TYPE_F64; }
+
+	const unsigned char* base;
+	const SectionEntry* sections;
+	const uint32_t* offsets;
+	const char* bytes;
+	size_t strings;
+};
+
+} // namespace JWWSnapshot
+
+#endif // JWW_SNAPSHOT_H
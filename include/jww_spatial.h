@@ -0,0 +1,101 @@
+// Spatial index for jwwlib-wasm
+// Static packed Hilbert R-tree: items are sorted along a Hilbert curve and
+// packed bottom-up into nodes of NODE_SIZE children, so the tree is a few
+// flat arrays and a rectangle query touches only the nodes it overlaps.
+
+#ifndef JWW_SPATIAL_H
+#define JWW_SPATIAL_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace JWWSpatial {
+
+struct Box {
+	double minX;
+	double minY;
+	double maxX;
+	double maxY;
+
+	Box() : minX(0.0), minY(0.0), maxX(0.0), maxY(0.0) {}
+	Box(double x0, double y0, double x1, double y1)
+		: minX(x0), minY(y0), maxX(x1), maxY(y1) {}
+
+	bool intersects(const Box& b) const {
+		return minX <= b.maxX && minY <= b.maxY && maxX >= b.minX && maxY >= b.minY;
+	}
+};
+
+// Position of (x, y) on a Hilbert curve over a 65536 x 65536 grid
+uint32_t hilbertIndex(uint32_t x, uint32_t y);
+
+class PackedRTree {
+public:
+	static const size_t NODE_SIZE = 16;
+
+	PackedRTree() : itemCount(0) {}
+
+	// Bulk-load the tree; item i is reported as i by query()
+	void build(const std::vector<Box>& items);
+	void clear();
+
+	// Append the ids of all items whose box intersects the rectangle
+	void query(double minX, double minY, double maxX, double maxY,
+	           std::vector<uint32_t>& out) const;
+
+	size_t size() const { return itemCount; }
+	bool empty() const { return itemCount == 0; }
+	// Union of all item boxes (undefined when empty)
+	const Box& extent() const { return bounds; }
+	// Box of item id as passed to build()
+	const Box& itemBox(uint32_t id) const { return nodes[itemPosition[id]]; }
+
+private:
+	size_t itemCount;
+	Box bounds;
+	// Node boxes, leaves first (in Hilbert order), then each upper level
+	std::vector<Box> nodes;
+	// Leaf: item id. Inner node: position of its first child.
+	std::vector<uint32_t> links;
+	// Position one past the last node of each level (level 0 = leaves)
+	std::vector<size_t> levelEnd;
+	// Leaf position of each item id
+	std::vector<uint32_t> itemPosition;
+};
+
+// Nearest-point index: a 2-D tree stored implicitly in one sorted array,
+// each median splitting its range alternately on x and y.
+class PointKDTree {
+public:
+	PointKDTree() {}
+
+	// Index count interleaved points (x0, y0, x1, y1, ...); point i is id i
+	void build(const std::vector<double>& xy);
+	void clear();
+
+	// Id of the point closest to (x, y) within maxDistance, or -1.
+	// The distance is stored in *distance when a point is found.
+	long nearest(double x, double y, double maxDistance, double* distance) const;
+
+	size_t size() const { return ids.size(); }
+	bool empty() const { return ids.empty(); }
+
+private:
+	std::vector<uint32_t> ids;
+	std::vector<double> coords;	// interleaved, in tree order
+};
+
+// Distance from (px, py) to the segment (x1, y1)-(x2, y2); the closest
+// point is stored in (qx, qy).
+double distanceToSegment(double px, double py, double x1, double y1,
+                         double x2, double y2, double& qx, double& qy);
+
+// Distance to the arc of radius r around (cx, cy) running counter-clockwise
+// from start to end (radians, end > start; a full turn is a circle).
+double distanceToArc(double px, double py, double cx, double cy, double r,
+                     double start, double end, double& qx, double& qy);
+
+} // namespace JWWSpatial
+
+#endif // JWW_SPATIAL_H
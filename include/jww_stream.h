@@ -0,0 +1,109 @@
+// Push-style JWW parser for jwwlib-wasm
+// Bytes arrive in arbitrary chunks (e.g. from a fetch() ReadableStream) and
+// every complete record is handed to a JWWRecordHandler as soon as it has
+// been read. A record split across chunks is kept until the rest arrives.
+
+#ifndef JWW_STREAM_H
+#define JWW_STREAM_H
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+#include "jwwdoc.h"
+
+// streambuf over the bytes fed so far. underflow() reports EOF when the
+// buffer runs dry, so a starved read sets failbit instead of blocking.
+class JWWChunkBuf : public std::streambuf {
+public:
+	JWWChunkBuf();
+
+	void append(const char* data, size_t len);
+	// Offset of the read position from the start of the buffered bytes
+	size_t tell() const;
+	void rewind(size_t offset);
+	// Drop the bytes before the read position
+	void compact();
+	size_t buffered() const { return data.size(); }
+
+protected:
+	int_type underflow();
+
+private:
+	std::vector<char> data;
+	void resetPointers(size_t offset);
+};
+
+// Read-only streambuf over a complete file already in memory.
+// Used with JWWDocument::AttachInput() to parse without a temporary file.
+class JWWMemoryBuf : public std::streambuf {
+public:
+	JWWMemoryBuf(const char* data, size_t size) {
+		char* p = const_cast<char*>(data);
+		setg(p, p, p + size);
+	}
+};
+
+// Growable streambuf collecting output in memory, for
+// JWWDocument::AttachOutput(): Save() then writes a drawing without a file.
+// data() is valid until the next write, clear() or destruction.
+class JWWOutputBuf : public std::streambuf {
+public:
+	JWWOutputBuf();
+
+	const char* data() const { return pbase(); }
+	size_t size() const { return pptr() - pbase(); }
+	size_t capacity() const { return bytes.size(); }
+	void reserve(size_t capacity);
+	// Drop the contents, keeping the capacity
+	void clear();
+	// Drop the contents and the capacity
+	void release();
+
+protected:
+	int_type overflow(int_type c);
+	std::streamsize xsputn(const char* s, std::streamsize n);
+
+private:
+	std::vector<char> bytes;
+	void grow(size_t needed);
+};
+
+class JWWStreamParser {
+public:
+	enum Status {
+		NeedMore,	// waiting for more input
+		Done,		// finish() read every record and block definition
+		Error		// not a JWW file, a damaged record or truncated input
+	};
+
+	// With handler == NULL records are collected in document()->vSen etc.
+	explicit JWWStreamParser(JWWRecordHandler* handler = NULL);
+	~JWWStreamParser();
+
+	Status feed(const char* data, size_t len);
+	// No more input. Error unless the drawing data was complete.
+	Status finish();
+
+	Status status() const { return state; }
+	JWWDocument* document() { return doc; }
+	size_t bytesConsumed() const { return consumed; }
+	size_t bufferedBytes() const { return buf.buffered(); }
+
+private:
+	enum Phase { Header, Records, Trailer };
+
+	JWWChunkBuf buf;
+	JWWDocument* doc;
+	Phase phase;
+	Status state;
+	size_t consumed;
+	size_t headerRetryAt;
+
+	Status pump(bool final);
+
+	// Not copyable
+	JWWStreamParser(const JWWStreamParser&);
+	JWWStreamParser& operator=(const JWWStreamParser&);
+};
+
+#endif // JWW_STREAM_H
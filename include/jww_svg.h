@@ -0,0 +1,59 @@
+// JWW to SVG conversion for jwwlib-wasm
+// Records are decoded one at a time and appended to one path per pen color
+// (strokes) and one per fill color (solids), so a typical sheet becomes a
+// handful of <path> elements instead of one element per entity. Arcs,
+// circles and ellipses are written as SVG arc commands, not chords. Block
+// definitions become <g> elements in <defs> that inserts <use>. Texts are
+// <text> elements with their Shift_JIS converted to UTF-8.
+//
+// The y axis is flipped (SVG is y down) and the viewBox is the drawing
+// extents in drawing units. Points are not drawn.
+
+#ifndef JWW_SVG_H
+#define JWW_SVG_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+namespace JWWSvg {
+
+struct Options {
+	// Decimal places of coordinates, 0 to 9
+	int precision;
+	// Snap coordinates to multiples of this before formatting; 0 keeps them
+	double quantum;
+	// Stroke width in drawing units; 0 draws 1 pixel wide lines at any zoom
+	// (vector-effect: non-scaling-stroke)
+	double strokeWidth;
+	// Write texts
+	bool texts;
+	// Background rectangle, 0xRRGGBBAA; alpha 0 leaves it transparent. White
+	// and black pens contrast with it as in JWWRaster.
+	uint32_t background;
+
+	Options() : precision(2), quantum(0.0), strokeWidth(0.0), texts(true), background(0xFFFFFFFFu) {}
+};
+
+struct Stats {
+	size_t elements;	// lines, arcs, solids and texts, including those inside blocks
+	size_t paths;		// <path> elements
+	size_t texts;		// <text> elements
+	size_t inserts;		// <use> elements
+	size_t bytes;		// size of the SVG output
+
+	Stats() : elements(0), paths(0), texts(0), inserts(0), bytes(0) {}
+};
+
+// Convert a JWW file held in memory, appending the SVG to out. False when
+// the data does not parse; out is left as it was then.
+bool convert(const char* data, size_t size, std::string& out,
+             const Options& options = Options(), Stats* stats = NULL);
+
+// Convert the file at input into output
+bool convertFile(const std::string& input, const std::string& output,
+                 const Options& options = Options(), Stats* stats = NULL);
+
+} // namespace JWWSvg
+
+#endif // JWW_SVG_H
@@ -0,0 +1,35 @@
+// Curve tessellation for jwwlib-wasm
+// Circles, arcs and ellipses become GPU line lists (x0, y0, x1, y1 per
+// segment) with the segment count chosen from a chord error tolerance.
+
+#ifndef JWW_TESSELLATE_H
+#define JWW_TESSELLATE_H
+
+#include <cstddef>
+
+namespace JWWTessellate {
+
+// Segment count bounds for one curve
+static const int MIN_SEGMENTS = 1;
+static const int MAX_SEGMENTS = 1024;
+
+// Segments needed so that no chord of an arc of the given radius sweeping
+// `sweep` radians strays more than tolerance from the curve
+int segmentCount(double radius, double sweep, double tolerance);
+
+// Write `segments` line-list segments (4 floats each) of the elliptic arc
+// x = rx cos t, y = ry sin t rotated by `rotation` about (cx, cy), for t in
+// [start, start + sweep]. Coordinates are stored relative to the origin to
+// keep float precision. A circle is rx == ry. Returns the end of the output.
+float* emitArc(float* out, double cx, double cy, double rx, double ry,
+               double rotation, double start, double sweep, int segments,
+               double originX, double originY);
+
+// Exact bounding box {minX, minY, maxX, maxY} of the same elliptic arc:
+// its end points and the parameters where x or y peaks within the sweep
+void arcBounds(double cx, double cy, double rx, double ry, double rotation,
+               double start, double sweep, double box[4]);
+
+} // namespace JWWTessellate
+
+#endif // JWW_TESSELLATE_H
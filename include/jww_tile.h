@@ -0,0 +1,125 @@
+// Vector tile pyramid for jwwlib-wasm
+// A quadtree over the drawing's bounding square: tile (z, x, y) covers
+// 1/2^z of the square on each side, x to the right and y up from the
+// lower-left corner. Every tile holds all geometry crossing it, clipped to
+// the tile plus a small buffer and quantized to EXTENT units, so a viewer
+// fetches only the visible tiles of the zoom it draws. Tiles with more than
+// Options::maxItems items are split down to Options::maxZoom; a viewer
+// zoomed past a leaf keeps drawing the leaf. Tiles with nothing in them
+// are not written.
+//
+// Tile blob (little-endian, varints are LEB128, zigzag for signed values):
+//   "JWT1", varint z, x, y, float64 minX, minY, size, varint extent,
+//   varint group count, then per group: varint pen, varint segment count
+//   and per segment zigzag (x0, y0) from the previous segment's end (the
+//   origin for the first of a group) and zigzag (x1, y1) from (x0, y0).
+
+#ifndef JWW_TILE_H
+#define JWW_TILE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace JWWTile {
+
+static const int EXTENT = 4096;	// quantized units across a tile
+static const int BUFFER = 64;	// units kept past each tile edge
+static const int MAX_ZOOM = 24;
+
+struct Options {
+	int maxZoom;
+	// A tile with more items (segments and arcs crossing it) is split
+	size_t maxItems;
+	// Worker threads for native builds; 0 is one per hardware thread
+	int threads;
+
+	Options() : maxZoom(8), maxItems(8192), threads(0) {}
+};
+
+struct Tile {
+	int z, x, y;
+	bool leaf;	// not split further
+	uint32_t segments;
+	std::vector<uint8_t> blob;
+};
+
+struct Group {
+	uint32_t pen;
+	uint32_t first;	// first vertex
+	uint32_t count;	// vertex count
+};
+
+// A tile blob read back: a line list in quantized tile units
+struct DecodedTile {
+	int z, x, y;
+	double minX, minY, size;
+	int extent;
+	std::vector<int32_t> vertices;	// x0, y0, x1, y1 per segment
+	std::vector<Group> groups;	// ascending pen
+};
+
+bool decodeTile(const uint8_t* data, size_t size, DecodedTile& out);
+
+class Tiler {
+public:
+	Tiler() : minX(0.0), minY(0.0), rootSize(0.0) {}
+
+	// Input, in any order; pens are ids chosen by the caller
+	void addSegment(double x1, double y1, double x2, double y2, uint32_t pen);
+	// Elliptic arc as in JWWTessellate::emitArc; a circle is rx == ry
+	void addArc(double cx, double cy, double rx, double ry, double rotation,
+	            double start, double sweep, uint32_t pen);
+	// Add the lines, circles, arcs and ellipses of a JWW file held in
+	// memory, with pen = DXF color | (pen width << 16). False when the data
+	// does not parse.
+	bool load(const char* data, size_t size);
+
+	// Cut the tiles (replacing earlier ones); input is kept for rebuilds
+	void build(const Options& options = Options());
+
+	// Ordered by z, then y, then x
+	const std::vector<Tile>& tiles() const { return tileList; }
+	const Tile* find(int z, int x, int y) const;
+
+	// The root tile's square
+	double getMinX() const { return minX; }
+	double getMinY() const { return minY; }
+	double getSize() const { return rootSize; }
+
+	void clear();
+
+private:
+	struct Arc {
+		double cx, cy, rx, ry, rotation, start, sweep;
+	};
+	struct Task {
+		int z, x, y;
+		std::vector<uint32_t> items;
+	};
+
+	struct Segment {
+		uint32_t pen;
+		uint32_t order;	// Morton code of the start point
+		int32_t x0, y0, x1, y1;
+	};
+
+	void runTask(const Task& task, const Options& options, std::vector<Task>& children,
+	             std::vector<Segment>& scratch, std::vector<float>& arcPoints, Tile& tile) const;
+
+	static const uint32_t ARC_BIT = 0x80000000u;
+
+	std::vector<double> segments;	// x1, y1, x2, y2
+	std::vector<Arc> arcs;
+	// Per item in input order: segment index or ARC_BIT | arc index, pen,
+	// and box (minX, minY, maxX, maxY)
+	std::vector<uint32_t> refs;
+	std::vector<uint32_t> pens;
+	std::vector<double> boxes;
+	std::vector<Tile> tileList;
+	double minX, minY, rootSize;
+};
+
+} // namespace JWWTile
+
+#endif // JWW_TILE_H
@@ -2,6 +2,7 @@
 #define	JWWDOC_H
 
 #include "jwtype.h"
+#include <cstring>
 
 typedef struct	_DPoint{
 	jwDOUBLE	x;
@@ -210,7 +211,9 @@ public:
 	friend inline std::ostream& operator<<(std::ostream&, const CData&); 
 	friend inline std::istream& operator>>(std::istream&, CData&); 
 	void SetVersion(jwDWORD ver){ nOldVersionSave = ver; }
-	void Serialize(std::ofstream& ofstr) const{
+	//書き込み先はofstreamかJWWRecordBuffer
+	template<class Out>
+	void Serialize(Out& ofstr) const{
        ofstr << (jwDWORD)m_lGroup;      //曲線属性番号
        ofstr << (jwBYTE)m_nPenStyle;   //線種番号
        ofstr << (jwWORD)m_nPenColor;   //線色番号
@@ -290,7 +293,8 @@ public:
 	const char* className(){return "CDataSen";}
 	friend inline std::ostream& operator<<(std::ostream&, const CDataSen&); 
 	friend inline std::istream& operator>>(std::istream&, CDataSen&); 
-	void Serialize(std::ofstream& ofstr) const
+	template<class Out>
+	void Serialize(Out& ofstr) const
         {
 	    CData::Serialize(ofstr);
 		ofstr	<< (double)m_start.x << (double)m_start.y 
@@ -332,7 +336,8 @@ public:
 	const char* className(){return "CDataEnko";}
 	friend inline std::ostream& operator<<(std::ostream&, const CDataEnko&); 
 	friend inline std::istream& operator>>(std::istream&, CDataEnko&); 
-	void Serialize(std::ofstream& ofstr) const
+	template<class Out>
+	void Serialize(Out& ofstr) const
         {
 	    CData::Serialize(ofstr);
             ofstr	<< (double)m_start.x << (double)m_start.y
@@ -392,7 +397,8 @@ public:
 	const char* className(){return "CDataTen";}
 	friend inline std::ostream& operator<<(std::ostream&, const CDataTen&); 
 	friend inline std::istream& operator>>(std::istream&, CDataTen&); 
-	void Serialize(std::ofstream& ofstr) const
+	template<class Out>
+	void Serialize(Out& ofstr) const
         {
             m_nPenStyle = 1;
             if( nOldVersionSave >= 252 ){   //Ver.2.52以降
@@ -673,7 +679,8 @@ public:
 	const char* className(){return "CDataSolid";}
 	friend inline std::ostream& operator<<(std::ostream&, const CDataSolid&); 
 	friend inline std::istream& operator>>(std::istream&, CDataSolid&); 
-	void Serialize(std::ofstream& ofstr) const
+	template<class Out>
+	void Serialize(Out& ofstr) const
         {
             CData::Serialize(ofstr);
             ofstr << (double)m_start.x << (double)m_start.y 
@@ -762,7 +769,7 @@ public:
                         //1:部分図(数学座標系)、2: 部分図(測地座標系)、
                         //3:作図グループ、4:作図部品
 	vector<CData*> m_DataList;	//定義データの実体のリスト
-	jwWORD Count;	//テスト用
+	jwDWORD Count;	//定義データ数(m_DataList の要素数として記録される)
 	const char* className(){return "CDataList";}
 	friend inline std::ostream& operator<<(std::ostream&, const CDataList&); 
 	friend inline std::istream& operator>>(std::istream&, CDataList&); 
@@ -788,7 +795,11 @@ public:
 			}
 			ofstr.write(m_strName.c_str(), len);
 		}
-	    //SKIP m_DataList.Serialize(ofstr);
+	    //m_DataList.Serialize(ofstr) の要素数。続く Count 個のレコードが定義データ
+		if( Count < 0xFFFF )
+			ofstr << (jwWORD)Count;
+		else
+			ofstr << (jwWORD)0xFFFF << Count;
 	}
 	void Serialize(std::ifstream& ifstr) {
 	    CData::Serialize(ifstr);
@@ -830,7 +841,12 @@ cout << "MojiData1:"  << m_strName << endl;
 cout << "MojiData1:"  << m_strName << endl;
 #endif
 		}
-	    //SKIP m_DataList.Serialize(ifstr);
+	    //m_DataList.Serialize(ifstr) の要素数。続く Count 個のレコードが定義データ
+		ifstr >> wd;
+		if( wd == 0xFFFF )
+			ifstr >> Count;
+		else
+			Count = wd;
 	}
 };
 typedef	CDataList* PCDataList;
@@ -916,6 +932,73 @@ public:
 	NoList& GetItem(int i);
 	NoList& GetNoByItem(int i);
 	void AddItem(int No,string& str);
+	void Init();
+};
+
+//図形レコードの受け取り側
+//JWWDocument::pHandler に設定すると図形データはvSenなどに格納されず
+//ファイル中の順番でハンドラに渡される(ブロック定義部のデータはpBlockListに格納)
+//WantsBlockLists()がtrueならブロック定義部も格納せず、定義ごとにOnBlockList()、
+//続けてその定義データCDataList::Count個をOnSen()などで渡し、最後にOnBlockListEnd()を呼ぶ
+class	JWWRecordHandler
+{
+public:
+	virtual ~JWWRecordHandler(){}
+	virtual jwBOOL WantsBlockLists(){ return false; }
+	virtual void OnBlockList(CDataList&){}
+	virtual void OnBlockListEnd(){}
+	virtual void OnHeader(JWWHead&){}
+	virtual void OnSen(CDataSen&){}
+	virtual void OnEnko(CDataEnko&){}
+	virtual void OnTen(CDataTen&){}
+	virtual void OnMoji(CDataMoji&){}
+	virtual void OnSolid(CDataSolid&){}
+	virtual void OnSunpou(CDataSunpou&){}
+	virtual void OnBlock(CDataBlock&){}
+};
+
+//図形データ読み込み途中の状態(ReadRecord()の呼び出し間で保持)
+typedef struct	_JWWReadState{
+	int	Index;			//次に登録されるクラス番号
+	jwBOOL	ListFlag;	//ブロック定義部を読み込み中
+	int	ListCount;
+	int	ListLength;
+	jwDWORD	RecordCount;	//ファイルに記録された図形データ数
+	jwDWORD	ReadCount;		//読み込んだ図形データ数
+	jwBOOL	DefinitionPart;	//ブロック図形定義数を読み込み済み
+	jwDWORD	DefinitionCount;	//ファイルに記録されたブロック図形定義数
+	jwDWORD	DefinitionsRead;	//読み込んだブロック図形定義数
+	jwBOOL	Corrupt;		//不明なクラスなど、続きを読めないデータがあった
+	CDataSen	DSen;
+	CDataEnko	DEnko;
+	CDataTen	DTen;
+	CDataMoji	DMoji;
+	CDataSolid	DSolid;
+	CDataSunpou	DSunpou;
+	CDataBlock	DBlock;
+	CDataList	DList;
+}JWWReadState;
+
+//固定長の図形データを1回の書き込みにまとめるバッファ
+//(クラス番号と線・円弧・点・ソリッドのデータが収まる大きさ)
+class	JWWRecordBuffer
+{
+private:
+	char	data[160];
+	size_t	length;
+	JWWRecordBuffer& Put(const void* p, size_t n){
+		memcpy(data + length, p, n);
+		length += n;
+		return *this;
+	}
+public:
+	JWWRecordBuffer() : length(0) {}
+	JWWRecordBuffer& operator<<(jwBYTE v){ return Put(&v, sizeof(v)); }
+	JWWRecordBuffer& operator<<(jwWORD v){ return Put(&v, sizeof(v)); }
+	JWWRecordBuffer& operator<<(jwDWORD v){ return Put(&v, sizeof(v)); }
+	JWWRecordBuffer& operator<<(jwDOUBLE v){ return Put(&v, sizeof(v)); }
+	JWWRecordBuffer& write(const char* p, size_t n){ return Put(p, n); }
+	void WriteTo(std::ostream& ostr) const { ostr.write(data, length); }
 };
 
 //JWWファイル入出力クラス
@@ -938,6 +1021,7 @@ public:
 			ofs = NULL;
 		pList = new JWWList();
 		pBlockList = new JWWBlockList();
+		pHandler = NULL;
 	}
 	~JWWDocument(){
 		delete pList;
@@ -953,6 +1037,9 @@ public:
 	}
 // 各図形のレコードの実体
 	JWWHead	Header;
+	//jwtype.hの入出力演算子がifstream&/ofstream&を取るためこの型のまま持つ。
+	//AttachInput/AttachOutputで差し替えた後はistream/ostreamとしてのみ使い、
+	//rdbuf()やis_open()で差し替え先を調べないこと。
 	ifstream*	ifs;
 	ofstream*	ofs;
 	jwWORD objCode;
@@ -990,6 +1077,8 @@ public:
 	vector<CDataSunpou>	vSunpou;//
 	JWWList*	pList;//
 	JWWBlockList*	pBlockList;//ブロックデータ定義部のリスト
+	JWWRecordHandler*	pHandler;//NULLでなければ図形データをここへ渡す
+	JWWReadState	ReadState;//
 	vector<CData*>   m_DataList;    //図形データのリスト
 	vector<CDataList*>	m_DataListList;  //ブロックデータ定義部のリスト
 	void WriteString(string s);
@@ -998,8 +1087,24 @@ public:
 	jwBOOL ReadHeader();
 	jwBOOL WriteHeader();
 	jwBOOL Read();
+	void Clear();
+	size_t ReservedBytes() const;
+	void ReleaseMemory();
+	void AttachInput(std::streambuf* sb);
+	void AttachOutput(std::streambuf* sb);
+	jwBOOL BeginRecords();
+	jwBOOL ReadRecord();
+	jwBOOL RecordsComplete() const;
+	jwBOOL ReadRecordBody(const string& s, CDataType& type);
+	void AddRecord(CDataType type);
+	void AddBlockListRecord(CDataType type);
 	jwBOOL Save();
-	jwBOOL SaveBich16(jwDWORD id);
+	jwBOOL SaveParallel(int threads = 0);
+	void BeginSave();
+	void SaveCount(jwDWORD n);
+	void SaveBlockLists();
+	static jwBOOL SaveBich16(jwDWORD id);
+	void SaveClassTag(JWWRecordBuffer& rec, jwDWORD& classNo, jwDWORD count, const char* name);
 	jwBOOL SaveSen(CDataSen const& DSen);
 	jwBOOL SaveEnko(CDataEnko const& DEnko);
 	jwBOOL SaveTen(CDataTen const& DTen);
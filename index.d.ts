@@ -81,6 +81,14 @@ declare module "jwwlib-wasm" {
 		unit?: string;
 	}
 
+	export interface JWWBounds {
+		minX: number;
+		minY: number;
+		maxX: number;
+		maxY: number;
+		valid: boolean;
+	}
+
 	export interface JWWModule {
 		initialize(): Promise<void>;
 		loadFile(buffer: ArrayBuffer): JWWDocument;
@@ -92,23 +100,414 @@ declare module "jwwlib-wasm" {
 		getHeader(): JWWHeader;
 		getEntities(): JWWEntity[];
 		getEntityCount(): number;
+		/** getEntities() indices overlapping the rectangle (view into WASM memory) */
+		queryRect(minX: number, minY: number, maxX: number, maxY: number): Uint32Array;
 		getLayerCount(): number;
 		getLayerName(index: number): string;
 		dispose(): void;
 	}
 
+	export interface JWWMemoryStats {
+		/** False when the module was built without JWW_MEMORY_TRACKING */
+		enabled: boolean;
+		liveBytes: number;
+		peakBytes: number;
+		allocations: number;
+		frees: number;
+		inputBytes: number;
+		documentBytes: number;
+		entityBytes: number;
+		indexBytes: number;
+		otherBytes: number;
+	}
+
+	export interface JWWDrawGroup {
+		/** DXF color number shared by the group */
+		color: number;
+		/** The color as 0xRRGGBB */
+		rgb: number;
+		/** Pen width number shared by the group */
+		width: number;
+		/** Index into JWWRenderCommands.lineTypes; -1 from tessellateCurves() */
+		lineType: number;
+		/** Index into JWWRenderCommands.layers; -1 from tessellateCurves() */
+		layer: number;
+		/** First vertex and vertex count, for drawArrays(gl.LINES, first, count) */
+		first: number;
+		count: number;
+	}
+
+	export interface JWWCurveBuffers {
+		/** x, y per vertex, two vertices per segment */
+		vertices: Float32Array;
+		/** RGBA per vertex */
+		colors: Uint8Array;
+		groups: JWWDrawGroup[];
+	}
+
+	export interface JWWRenderCommands {
+		/** x, y per vertex, two vertices per segment */
+		vertices: Float32Array;
+		/** Ordered by layer, line type, width and color */
+		groups: JWWDrawGroup[];
+		layers: string[];
+		lineTypes: string[];
+	}
+
+	export interface JWWCompactResult {
+		/** getReservedBytes() before and after */
+		bytesBefore: number;
+		bytesAfter: number;
+		/** Largest coordinate change, in drawing units; 0 at tolerance 0,
+		 * Infinity when a NaN had to be rounded */
+		maxError: number;
+		/** Largest change of an angle, ratio or ellipse parameter */
+		maxParamError: number;
+	}
+
+	/** Coordinate = origin + value * scale; lengths = value * scale */
+	export interface JWWQuantizedGeometry {
+		format: "float32" | "int32";
+		originX: number;
+		originY: number;
+		/** Drawing units per step; 1 for float32 */
+		scale: number;
+		/** Largest difference from the parsed coordinates, in drawing units */
+		maxError: number;
+		/** Bytes held by the arrays, on top of the parsed doubles */
+		bytes: number;
+		/** x1, y1, x2, y2 per line */
+		lines: Float32Array | Int32Array;
+		/** cx, cy, radius per circle */
+		circles: Float32Array | Int32Array;
+		/** cx, cy, radius per arc */
+		arcs: Float32Array | Int32Array;
+		/** angle1, angle2 per arc, degrees */
+		arcAngles: Float32Array;
+		/** cx, cy, majorAxis per ellipse */
+		ellipses: Float32Array | Int32Array;
+		/** ratio, angle, startParam, endParam per ellipse */
+		ellipseParams: Float32Array;
+		points: Float32Array | Int32Array;
+		/** Four x, y corners per solid */
+		solids: Float32Array | Int32Array;
+		/** x, y per text */
+		texts: Float32Array | Int32Array;
+	}
+
+	export interface JWWLODLevel {
+		level: number;
+		/** Largest deviation from the full geometry, in drawing units */
+		tolerance: number;
+		/** vertices are relative to this point */
+		originX: number;
+		originY: number;
+		/** x, y per vertex, two vertices per segment */
+		vertices: Float32Array;
+		groups: JWWDrawGroup[];
+		/** getEntities() indices of the texts still visible at this level */
+		texts: Uint32Array;
+		layers: string[];
+		lineTypes: string[];
+	}
+
+	export interface JWWChainedPolyline {
+		vertices: Array<{ x: number; y: number; z: number; bulge: number }>;
+		/** A loop; the first vertex is not repeated */
+		closed: boolean;
+		color: number;
+		width: number;
+		/** Index into the line type names */
+		lineType: number;
+		/** Index into the layer names */
+		layer: number;
+		penStyle: number;
+		/** This polyline's edges came from sources[firstSource .. firstSource + sourceCount) */
+		firstSource: number;
+		sourceCount: number;
+	}
+
+	export interface JWWLineChains {
+		polylines: JWWChainedPolyline[];
+		/** getLines() index per polyline edge (view into WASM memory) */
+		sources: Uint32Array;
+	}
+
+	export interface JWWTileGroup {
+		/** Pen id; jww2tiles uses DXF color | (pen width << 16) */
+		pen: number;
+		/** First vertex and vertex count, for drawArrays(gl.LINES, first, count) */
+		first: number;
+		count: number;
+	}
+
+	export interface JWWTile {
+		z: number;
+		x: number;
+		y: number;
+		/** Lower-left corner and side of the tile in drawing units */
+		minX: number;
+		minY: number;
+		size: number;
+		/** Tile units across the tile */
+		extent: number;
+		/** x, y per vertex in tile units, two vertices per segment */
+		vertices: Float32Array;
+		groups: JWWTileGroup[];
+	}
+
+	export interface JWWPickResult {
+		/** getEntities() index, -1 when nothing is within the tolerance */
+		index: number;
+		distance: number;
+		/** Closest point on the entity */
+		x: number;
+		y: number;
+	}
+
+	export enum SnapKind {
+		ENDPOINT = 0,
+		MIDPOINT = 1,
+		CENTER = 2,
+		QUADRANT = 3,
+	}
+
+	export interface JWWSnapPoint {
+		found: boolean;
+		x: number;
+		y: number;
+		kind: SnapKind;
+		/** getEntities() index of the entity the point belongs to */
+		index: number;
+		distance: number;
+	}
+
 	export class JWWReader {
 		static init(): Promise<void>;
 		static isInitialized(): boolean;
 
-		constructor(buffer: ArrayBuffer);
+		/** Omit buffer to create an empty reader for load() */
+		constructor(buffer?: ArrayBuffer);
+		/** Parse from a region that `fill` writes synchronously into WASM memory */
+		static fromFill(size: number, fill: (view: Uint8Array) => void): JWWReader;
+		/** Node.js: read a file from disk directly into WASM memory */
+		static fromFile(path: string): Promise<JWWReader>;
+		/** Parse a File/Blob chunk by chunk */
+		static fromBlob(blob: Blob): Promise<JWWReader>;
+		/** Parse while downloading, e.g. `fromStream((await fetch(url)).body)` */
+		static fromStream(
+			stream: ReadableStream<Uint8Array> | AsyncIterable<Uint8Array>,
+		): Promise<JWWReader>;
 
+		/** Parse another file, reusing this reader's buffers */
+		load(buffer: ArrayBuffer): boolean;
+		/** Drop the current drawing, keeping buffer capacity */
+		reset(): void;
+		/** Release buffers when they exceed maxBytes; returns bytes still reserved */
+		shrink(maxBytes?: number): number;
+		/** Pack the geometry of a background drawing; getters expand it again */
+		compact(tolerance?: number): JWWCompactResult;
+		expand(): void;
+		isCompacted(): boolean;
 		getEntities(): JWWEntity[];
+		/** Heap bytes held by this reader (counted with memory tracking, else estimated) */
+		getMemoryUsage(): number;
+		/** Highest getMemoryUsage() during the last parse; 0 without memory tracking */
+		getLastParsePeakBytes(): number;
 		getHeader(): JWWHeader;
+		/** Drawing extents, accumulated while decoding */
+		getBounds(): JWWBounds;
+		/** [minX, minY, maxX, maxY] per getEntities() entry (view into WASM memory) */
+		getEntityBounds(): Float64Array;
+		/** Keep per-entity boxes from the next load() on (default true) */
+		setEntityBounds(enabled: boolean): void;
+		/** Keep the file's records from the next load() on, for saveToBuffer() (default false) */
+		setKeepRecords(enabled: boolean): void;
+		/** The drawing as a JWW file (view into WASM memory); null unless records were kept */
+		saveToBuffer(): Uint8Array | null;
+		/** [x1, y1, x2, y2] per line after x' = a*x + c*y + e, y' = b*x + d*y + f */
+		getLineVertices(
+			a?: number,
+			b?: number,
+			c?: number,
+			d?: number,
+			e?: number,
+			f?: number,
+		): Float32Array;
+		/** Circles, arcs and ellipses as line lists within tolerance, grouped by pen */
+		tessellateCurves(tolerance: number, originX?: number, originY?: number): JWWCurveBuffers;
+		/**
+		 * Lines and curves as a line list bucketed by pen. With scale (pixels
+		 * per drawing unit) patterned pen styles are expanded into dashes.
+		 */
+		getRenderCommands(
+			tolerance: number,
+			originX?: number,
+			originY?: number,
+			scale?: number,
+		): JWWRenderCommands;
+		/** Simplified geometry; level 0 is full detail, each level doubles the tolerance */
+		getLOD(level: number): JWWLODLevel;
+		/** Copy of the coordinates as float32 or int32 offsets from the drawing's center for GPU
+		 * upload, with the largest error; the parsed doubles are kept */
+		exportQuantizedGeometry(format?: "float32" | "int32"): JWWQuantizedGeometry;
+		/** Lines of one pen joined where two ends meet within tolerance */
+		chainLines(tolerance?: number): JWWLineChains;
+		getLODLevelCount(): number;
+		/** Coarsest level within a pixel at scale (pixels per drawing unit) */
+		getLODLevelForScale(scale: number): number;
+		/** getEntities() indices overlapping the rectangle (view into WASM memory) */
+		queryRect(minX: number, minY: number, maxX: number, maxY: number): Uint32Array;
+		/** Closest entity to (x, y) within tolerance */
+		pick(x: number, y: number, tolerance: number): JWWPickResult;
+		/** Nearest end point, midpoint, center or quadrant point within maxDistance */
+		nearestSnap(x: number, y: number, maxDistance?: number): JWWSnapPoint;
 		getLayerCount(): number;
 		getLayerName(index: number): string;
 		dispose(): void;
 	}
 
+	/** True when the engine supports WebAssembly SIMD (the jwwlib.simd build). */
+	export function isSimdSupported(): boolean;
+	/** "wasm-simd128" or "scalar" for the loaded module */
+	export function getSimdBackend(): string;
+
+	/** Decode a tile written by the native tiler (jww2tiles) */
+	export function decodeTile(buffer: ArrayBuffer | ArrayBufferView): JWWTile;
+
+	/** Heap accounting summed over every reader in the module */
+	export function getModuleMemoryStats(): JWWMemoryStats;
+
+	export interface JWWSvgOptions {
+		/** Decimal places of coordinates, 0 to 9 (default 2) */
+		precision?: number;
+		/** Snap coordinates to multiples of this (default 0: off) */
+		quantum?: number;
+		/** Stroke width in drawing units (default 0: 1 pixel at any zoom) */
+		strokeWidth?: number;
+		/** Write texts (default true) */
+		texts?: boolean;
+	}
+
+	/** The JWW file as an SVG document; throws when it does not parse */
+	export function toSVG(buffer: ArrayBuffer | ArrayBufferView, options?: JWWSvgOptions): string;
+
+	export interface JWWNDJSONOptions {
+		/** Bytes per chunk passed to onChunk (default 65536) */
+		chunkSize?: number;
+		/** Write the header line (default true) */
+		header?: boolean;
+		/** Write text records (default true) */
+		texts?: boolean;
+		/** Receives the output in chunks ending on line boundaries (view into WASM memory, valid during the call) */
+		onChunk?: (chunk: Uint8Array) => void;
+	}
+
+	/** One JSON record per line; returns the text unless onChunk is given. Throws when the file does not parse. */
+	export function toNDJSON(buffer: ArrayBuffer | ArrayBufferView, options: JWWNDJSONOptions & { onChunk: (chunk: Uint8Array) => void }): void;
+	export function toNDJSON(buffer: ArrayBuffer | ArrayBufferView, options?: JWWNDJSONOptions): string;
+
+	/** Pen columns of every entity kind in a snapshot */
+	export interface JWWSnapshotPen {
+		count: number;
+		/** Layer group * 16 + layer */
+		layer: Uint8Array;
+		color: Uint16Array;
+		style: Uint8Array;
+		width: Uint16Array;
+		/** Block definition number, 0xFFFFFFFF for the drawing */
+		block: Uint32Array;
+	}
+
+	/** A snapshot opened in place; string columns hold ids for string() */
+	export interface JWWSnapshot {
+		/** XXH64 of the source JWW bytes, 16 hex digits */
+		sourceHash: string;
+		sourceSize: number;
+		jwwVersion: number;
+		paper: number;
+		memo: string;
+		lines: JWWSnapshotPen & { x1: Float64Array; y1: Float64Array; x2: Float64Array; y2: Float64Array };
+		arcs: JWWSnapshotPen & {
+			x: Float64Array; y: Float64Array; radius: Float64Array; start: Float64Array; sweep: Float64Array;
+			tilt: Float64Array; ratio: Float64Array; full: Uint8Array;
+		};
+		points: JWWSnapshotPen & {
+			x: Float64Array; y: Float64Array; angle: Float64Array; scale: Float64Array; code: Uint32Array; temporary: Uint8Array;
+		};
+		texts: JWWSnapshotPen & {
+			x1: Float64Array; y1: Float64Array; x2: Float64Array; y2: Float64Array;
+			charWidth: Float64Array; charHeight: Float64Array; spacing: Float64Array;
+			/** Degrees */
+			angle: Float64Array;
+			kind: Uint32Array; font: Uint32Array; text: Uint32Array;
+		};
+		solids: JWWSnapshotPen & {
+			x1: Float64Array; y1: Float64Array; x2: Float64Array; y2: Float64Array;
+			x3: Float64Array; y3: Float64Array; x4: Float64Array; y4: Float64Array;
+			/** Color of pen 10, 0 otherwise */
+			rgb: Uint32Array;
+		};
+		dimensions: JWWSnapshotPen & {
+			x1: Float64Array; y1: Float64Array; x2: Float64Array; y2: Float64Array;
+			labelX: Float64Array; labelY: Float64Array; labelHeight: Float64Array; labelAngle: Float64Array; label: Uint32Array;
+		};
+		inserts: JWWSnapshotPen & {
+			x: Float64Array; y: Float64Array; scaleX: Float64Array; scaleY: Float64Array; angle: Float64Array; number: Uint32Array;
+		};
+		blocks: { number: Uint32Array; name: Uint32Array; count: Uint32Array };
+		/** name and state per layer (group * 16 + layer), the group columns per layer group */
+		layers: {
+			name: Uint32Array; state: Uint32Array; groupName: Uint32Array; groupState: Uint32Array; groupScale: Float64Array;
+		};
+		string(id: number): string;
+	}
+
+	/** Columnar snapshot of the JWW file; throws when it does not parse */
+	export function toSnapshot(buffer: ArrayBuffer | ArrayBufferView): Uint8Array;
+	/** Open a snapshot without copying or decoding it; needs no init() */
+	export function openSnapshot(buffer: ArrayBuffer | ArrayBufferView): JWWSnapshot;
+
+	/** XXH64 of the bytes as 16 hex digits, computed in WASM */
+	export function hashJWW(buffer: ArrayBuffer | ArrayBufferView): string;
+
+	/** Storage for openCached(), keyed by source hash */
+	export interface JWWSnapshotCache {
+		get(key: string): Promise<Uint8Array | undefined>;
+		set(key: string, bytes: Uint8Array): Promise<void>;
+	}
+
+	/** In-memory LRU cache */
+	export class MemoryCache implements JWWSnapshotCache {
+		constructor(options?: { maxBytes?: number; maxEntries?: number });
+		readonly size: number;
+		/** Bytes held */
+		readonly bytes: number;
+		get(key: string): Promise<Uint8Array | undefined>;
+		set(key: string, bytes: Uint8Array): Promise<void>;
+		delete(key: string): void;
+		clear(): void;
+	}
+
+	/** <hash>.jwws files in a directory (Node.js) */
+	export class FileCache implements JWWSnapshotCache {
+		constructor(directory: string);
+		get(key: string): Promise<Uint8Array | undefined>;
+		set(key: string, bytes: Uint8Array): Promise<void>;
+	}
+
+	/** IndexedDB object store (browsers, workers) */
+	export class IndexedDBCache implements JWWSnapshotCache {
+		constructor(options?: { name?: string; store?: string });
+		get(key: string): Promise<Uint8Array | undefined>;
+		set(key: string, bytes: Uint8Array): Promise<void>;
+	}
+
+	/** The drawing as a snapshot, from the cache when its hash is there (default: a shared MemoryCache) */
+	export function openCached(
+		buffer: ArrayBuffer | ArrayBufferView,
+		options?: { cache?: JWWSnapshotCache },
+	): Promise<JWWSnapshot & { cached: boolean }>;
+
 	export default JWWReader;
 }
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+# Generates src/core/jww_sjis_table.inc, the CP932 double-byte table used by
+# JWWSjis (include/jww_sjis.h), from Python's cp932 codec.
+#
+# Rows are the lead bytes 0x81-0x9F, 0xE0-0xEF and 0xFA-0xFC; columns the
+# trail bytes 0x40-0xFC. 0 marks a pair that is not a character. The
+# user-defined area (leads 0xF0-0xF9) maps linearly to U+E000 and is
+# computed instead of stored.
+#
+# Usage: python3 scripts/gen-sjis-table.py > src/core/jww_sjis_table.inc
+
+LEADS = list(range(0x81, 0xA0)) + list(range(0xE0, 0xF0)) + list(range(0xFA, 0xFD))
+TRAILS = range(0x40, 0xFD)
+
+
+def code(lead, trail):
+    if trail == 0x7F:
+        return 0
+    try:
+        text = bytes([lead, trail]).decode("cp932")
+    except UnicodeDecodeError:
+        return 0
+    return ord(text) if len(text) == 1 and ord(text) <= 0xFFFF else 0
+
+
+def main():
+    print("// Generated by scripts/gen-sjis-table.py; do not edit")
+    print("// CP932 lead byte row (see leadRow()) x trail byte - 0x40 -> UTF-16")
+    print("static const uint16_t CP932_TABLE[%d][%d] = {" % (len(LEADS), len(TRAILS)))
+    for lead in LEADS:
+        print("\t// 0x%02X" % lead)
+        print("\t{")
+        codes = [code(lead, t) for t in TRAILS]
+        for i in range(0, len(codes), 12):
+            print("\t\t" + " ".join("0x%04X," % c for c in codes[i:i + 12]))
+        print("\t},")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
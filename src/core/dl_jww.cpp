@@ -35,6 +35,9 @@
 #include <cstring>
 
 #include "dl_creationinterface.h"
+#include "jww_simd.h"
+#include "jww_stream.h"
+#include "jww_memory.h"
 #include "wasm_encoding.h"
 
 #ifndef SKIP_MOJI
@@ -101,7 +104,7 @@ static double Deg(double ang)
 /**
  * Default constructor.
  */
-DL_Jww::DL_Jww() {
+DL_Jww::DL_Jww() : version(VER_2000) {
 }
 
 
@@ -132,10 +135,11 @@ void DL_Jww::CreateSen(DL_CreationInterface* creationInterface, CDataSen& DSen)
 	else
 		width = DSen.m_nPenWidth;
 	int color = colTable[DSen.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DSen.m_nPenColor];
-	attrib = DL_Attributes(values[8],	  // layer
+	attrib = DL_Attributes(lName,	  // layer
 			       color,	      // color
 			       width,	      // width
 			       lTable[DSen.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DSen.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DSen.m_nPenStyle);
 	creationInterface->setAttributes(attrib);
 
 	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
@@ -202,7 +206,39 @@ std::cout << "線色幅 " << (jwWORD)DSen.m_nPenWidth << std::endl;//線色幅
 #endif
 }
 
+/**
+ * Raw start/end angles (radians) of an arc record, before normalization.
+ * Circular arcs are rotated by the tilt angle; ellipse arcs keep their
+ * parametric angles because the tilt goes into the major axis.
+ */
+void DL_Jww::EnkoAngles(const CDataEnko& DEnko, double& angle1, double& angle2)
+{
+	double base = DEnko.m_radKaishiKaku;
+	if(!DEnko.m_bZenEnFlg && DEnko.m_dHenpeiRitsu == 1.0)
+		base += DEnko.m_radKatamukiKaku;
+	if(DEnko.m_radEnkoKaku > 0.0){
+		angle1 = base;
+		angle2 = base + DEnko.m_radEnkoKaku;
+	}else{
+		angle1 = base + DEnko.m_radEnkoKaku;
+		angle2 = base;
+	}
+}
+
 void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko)
+{
+	double angle1, angle2;
+	EnkoAngles(DEnko, angle1, angle2);
+	JWWSimd::normalizeArcAngles(&angle1, &angle2, 1);
+	CreateEnko(creationInterface, DEnko, angle1, angle2);
+}
+
+/**
+ * @param angle1, angle2 Start/end angles already normalized with
+ *		JWWSimd::normalizeArcAngles (see DL_Jww::in for the batched path).
+ */
+void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko,
+						double angle1, double angle2)
 {
 	string lName = HEX[DEnko.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DEnko.m_nGLayer] + "-" +
 													HEX[DEnko.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DEnko.m_nLayer];
@@ -216,33 +252,21 @@ void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnk
 	else
 		width = DEnko.m_nPenWidth;
 	int color = colTable[DEnko.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DEnko.m_nPenColor];
-	attrib = DL_Attributes(values[8],	  // layer
+	attrib = DL_Attributes(lName,	  // layer
 			       color,	      // color
 			       width,	      // width
 			       lTable[DEnko.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DEnko.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DEnko.m_nPenStyle);
 	creationInterface->setAttributes(attrib);
 
 	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
 
-	double angle1, angle2;
 	//正円
 	if(DEnko.m_bZenEnFlg){
 		if(DEnko.m_dHenpeiRitsu == 1.0){
 			DL_CircleData d(DEnko.m_start.x, DEnko.m_start.y, 0.0, DEnko.m_dHankei);
 			creationInterface->addCircle(d);
 		}else{
-			double angle1, angle2;
-			if(DEnko.m_radEnkoKaku > 0.0){
-				angle1 = DEnko.m_radKaishiKaku;
-				angle2 = DEnko.m_radKaishiKaku + DEnko.m_radEnkoKaku;
-			}else{
-				angle1 = DEnko.m_radKaishiKaku + DEnko.m_radEnkoKaku;
-				angle2 = DEnko.m_radKaishiKaku;
-			}
-			angle1 = angle1 - floor(angle1 / (M_PI * 2.0)) * M_PI * 2.0;
-			angle2 = angle2 - floor(angle2 / (M_PI * 2.0)) * M_PI * 2.0;
-			if( angle2 <= angle1 )
-				angle1 = angle1 - M_PI * 2.0;
 			//楕円
 			DL_EllipseData d(DEnko.m_start.x, DEnko.m_start.y, 0.0,
 							DEnko.m_dHankei * cos(DEnko.m_radKatamukiKaku), DEnko.m_dHankei * sin(DEnko.m_radKatamukiKaku), 0.0,
@@ -254,17 +278,6 @@ void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnk
 	}else{
 		if(DEnko.m_dHenpeiRitsu == 1.0){
 			//円弧
-			if(DEnko.m_radEnkoKaku > 0.0){
-				angle1 = DEnko.m_radKaishiKaku + DEnko.m_radKatamukiKaku;
-				angle2 = DEnko.m_radKaishiKaku + DEnko.m_radKatamukiKaku + DEnko.m_radEnkoKaku;
-			}else{
-				angle1 = DEnko.m_radKaishiKaku + DEnko.m_radKatamukiKaku + DEnko.m_radEnkoKaku;
-				angle2 = DEnko.m_radKaishiKaku + DEnko.m_radKatamukiKaku;
-			}
-			angle1 = angle1 - floor(angle1 / (M_PI * 2.0)) * M_PI * 2.0;
-			angle2 = angle2 - floor(angle2 / (M_PI * 2.0)) * M_PI * 2.0;
-			if( angle2 <= angle1 )
-				angle1 = angle1 - M_PI * 2.0;
 			DL_ArcData d(DEnko.m_start.x, DEnko.m_start.y, 0.0,
 					DEnko.m_dHankei,
 					Deg(angle1),
@@ -272,18 +285,6 @@ void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnk
 
 			creationInterface->addArc(d);
 		}else{
-			double angle1, angle2;
-			if(DEnko.m_radEnkoKaku > 0.0){
-				angle1 = DEnko.m_radKaishiKaku;
-				angle2 = DEnko.m_radKaishiKaku + DEnko.m_radEnkoKaku;
-			}else{
-				angle1 = DEnko.m_radKaishiKaku + DEnko.m_radEnkoKaku;
-				angle2 = DEnko.m_radKaishiKaku;
-			}
-			angle1 = angle1 - floor(angle1 / (M_PI * 2.0)) * M_PI * 2.0;
-			angle2 = angle2 - floor(angle2 / (M_PI * 2.0)) * M_PI * 2.0;
-			if( angle2 <= angle1 )
-				angle1 = angle1 - M_PI * 2.0;
 			//楕円
 			DL_EllipseData d(DEnko.m_start.x, DEnko.m_start.y, 0.0,
 							DEnko.m_dHankei * cos(DEnko.m_radKatamukiKaku), DEnko.m_dHankei * sin(DEnko.m_radKatamukiKaku), 0.0,
@@ -410,10 +411,11 @@ void DL_Jww::CreateTen(DL_CreationInterface* creationInterface, CDataTen& DTen)
 	else
 		width = DTen.m_nPenWidth;
 	int color = colTable[DTen.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DTen.m_nPenColor];
-	attrib = DL_Attributes(values[8],	  // layer
+	attrib = DL_Attributes(lName,	  // layer
 			       color,	      // color
 			       width,	      // width
 			       lTable[DTen.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DTen.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DTen.m_nPenStyle);
 	creationInterface->setAttributes(attrib);
 
 	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
@@ -463,10 +465,11 @@ void DL_Jww::CreateMoji(DL_CreationInterface* creationInterface, CDataMoji& DMoj
 	else
 		width = DMoji.m_nPenWidth;
 	int color = colTable[DMoji.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DMoji.m_nPenColor];
-	attrib = DL_Attributes(values[8],	  // layer
+	attrib = DL_Attributes(lName,	  // layer
 			       color,	      // color
 			       width,	      // width
 			       lTable[DMoji.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DMoji.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DMoji.m_nPenStyle);
 	creationInterface->setAttributes(attrib);
 
 	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
@@ -478,8 +481,8 @@ void DL_Jww::CreateMoji(DL_CreationInterface* creationInterface, CDataMoji& DMoj
 		0.0, 0.0, 0.0,
 		// height
 		DMoji.m_dSizeY,
-		// x scale
-		1.0,
+		// x scale: character width over height
+		DMoji.m_dSizeY > 0.0 ? DMoji.m_dSizeX / DMoji.m_dSizeY : 1.0,
 		// generation flags
 		0,
 		// h just
@@ -581,8 +584,35 @@ std::cout << *text;
 #endif
 }
 
-void DL_Jww::CreateSolid(DL_CreationInterface* /*creationInterface*/, CDataSolid& /*DSolid*/)
+void DL_Jww::CreateSolid(DL_CreationInterface* creationInterface, CDataSolid& DSolid)
 {
+	string lName = HEX[DSolid.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSolid.m_nGLayer] + "-" +
+													HEX[DSolid.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSolid.m_nLayer];
+
+	// add layer
+	creationInterface->addLayer(DL_LayerData(lName,0));
+	int width;
+	if(DSolid.m_nPenWidth > 26)
+		width = 0;
+	else
+		width = DSolid.m_nPenWidth;
+	//任意色(10)はRGB値を持つが、DL_Attributesは色番号のみなので線色表で近似する
+	int color = colTable[DSolid.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DSolid.m_nPenColor];
+	attrib = DL_Attributes(lName,	  // layer
+			       color,	      // color
+			       width,	      // width
+			       lTable[DSolid.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DSolid.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DSolid.m_nPenStyle);
+	creationInterface->setAttributes(attrib);
+
+	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
+
+	// JWWの第1〜4点は外周順、DXFのSOLIDは1,2,4,3の順に結ぶ
+	DL_SolidData d(DSolid.m_start.x, DSolid.m_start.y, 0.0,
+				   DSolid.m_DPoint2.x, DSolid.m_DPoint2.y, 0.0,
+				   DSolid.m_end.x, DSolid.m_end.y, 0.0,
+				   DSolid.m_DPoint3.x, DSolid.m_DPoint3.y, 0.0);
+	creationInterface->addSolid(d);
 }
 
 void DL_Jww::CreateSunpou(DL_CreationInterface* creationInterface, CDataSunpou& DSunpou)
@@ -598,10 +628,11 @@ void DL_Jww::CreateSunpou(DL_CreationInterface* creationInterface, CDataSunpou&
 	else
 		width = DSunpou.m_nPenWidth;
 	int color = colTable[DSunpou.m_nPenColor > ArraySize(colTable)-1 ? ArraySize(colTable)-1 : DSunpou.m_nPenColor];
-	attrib = DL_Attributes(values[8],	  // layer
+	attrib = DL_Attributes(lName,	  // layer
 			       color,	      // color
 			       width,	      // width
 			       lTable[DSunpou.m_nPenStyle > ArraySize(lTable)-1 ? ArraySize(lTable)-1 : DSunpou.m_nPenStyle]);	  // linetype
+	attrib.setPenStyle(DSunpou.m_nPenStyle);
 	creationInterface->setAttributes(attrib);
 
 	creationInterface->setExtrusion(0.0, 0.0, 1.0, 0.0 );
@@ -676,8 +707,32 @@ bool DL_Jww::in(const string& file, DL_CreationInterface* creationInterface) {
 	//JWWファイル読み取り
 	string ofile("");
 	JWWDocument* jwdoc = new JWWDocument((std::string&)file, ofile);
-	if(!jwdoc->Read())
-		return false;
+	bool result = in(jwdoc, creationInterface);
+	delete jwdoc;
+	return result;
+}
+
+/**
+ * Reads a JWW file held in memory. The data is read in place (no
+ * temporary file or copy) and is not referenced after the call returns.
+ */
+bool DL_Jww::in(const char* data, size_t size, DL_CreationInterface* creationInterface) {
+	string ifile(""), ofile("");
+	JWWMemoryBuf input(data, size);
+	JWWDocument* jwdoc = new JWWDocument(ifile, ofile);
+	jwdoc->AttachInput(&input);
+	bool result = in(jwdoc, creationInterface);
+	delete jwdoc;
+	return result;
+}
+
+bool DL_Jww::in(JWWDocument* jwdoc, DL_CreationInterface* creationInterface) {
+	{
+		JWWMemory::Scope memoryScope(JWWMemory::Document);
+		if(!jwdoc->Read())
+			return false;
+	}
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
 	//DXF変数設定
 	creationInterface->setVariableString("$DWGCODEPAGE", "SJIS", 7);
 	creationInterface->setVariableString("$TEXTSTYLE", "japanese", 7);
@@ -685,8 +740,16 @@ bool DL_Jww::in(const string& file, DL_CreationInterface* creationInterface) {
 	for( unsigned int i = 0; i < jwdoc->vSen.size(); i++ )
 		CreateSen(creationInterface, jwdoc->vSen[i]);
 	//円弧データ
-	for( unsigned int i = 0; i < jwdoc->vEnko.size(); i++ )
-		CreateEnko(creationInterface, jwdoc->vEnko[i]);
+	{
+		// Normalize all arc angles in one vectorized pass
+		size_t n = jwdoc->vEnko.size();
+		std::vector<double> angle1(n), angle2(n);
+		for( size_t i = 0; i < n; i++ )
+			EnkoAngles(jwdoc->vEnko[i], angle1[i], angle2[i]);
+		JWWSimd::normalizeArcAngles(angle1.data(), angle2.data(), n);
+		for( size_t i = 0; i < n; i++ )
+			CreateEnko(creationInterface, jwdoc->vEnko[i], angle1[i], angle2[i]);
+	}
 	//点データ
 	for( unsigned int i = 0; i < jwdoc->vTen.size(); i++ )
 		CreateTen(creationInterface, jwdoc->vTen[i]);
@@ -702,11 +765,54 @@ bool DL_Jww::in(const string& file, DL_CreationInterface* creationInterface) {
 	//部品
     for(unsigned int i=0 ; i < jwdoc->vBlock.size(); i++)
 		CreateBlock(creationInterface, jwdoc->vBlock[i]);
-	delete jwdoc;
 
 	return true;
 }
 
+void DL_JwwRecordHandler::OnHeader(JWWHead& /*Header*/) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	//DXF変数設定
+	creationInterface->setVariableString("$DWGCODEPAGE", "SJIS", 7);
+	creationInterface->setVariableString("$TEXTSTYLE", "japanese", 7);
+}
+
+void DL_JwwRecordHandler::OnSen(CDataSen& DSen) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateSen(creationInterface, DSen);
+}
+
+void DL_JwwRecordHandler::OnEnko(CDataEnko& DEnko) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateEnko(creationInterface, DEnko);
+}
+
+void DL_JwwRecordHandler::OnTen(CDataTen& DTen) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateTen(creationInterface, DTen);
+}
+
+void DL_JwwRecordHandler::OnMoji(CDataMoji& DMoji) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateMoji(creationInterface, DMoji);
+}
+
+void DL_JwwRecordHandler::OnSolid(CDataSolid& DSolid) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateSolid(creationInterface, DSolid);
+}
+
+void DL_JwwRecordHandler::OnSunpou(CDataSunpou& DSunpou) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateSunpou(creationInterface, DSunpou);
+}
+
+void DL_JwwRecordHandler::OnBlock(CDataBlock& DBlock) {
+	JWWMemory::Scope memoryScope(JWWMemory::Entities);
+	jww->CreateBlock(creationInterface, DBlock);
+}
+
+
+
 /**
  * Processes a group (pair of group code and value).
  *
@@ -1050,13 +1156,17 @@ void DL_Jww::endSequence(DL_CreationInterface* /*creationInterface*/) {
  *
  * @param file Full path of the file to open.
  *
- * @return Pointer to an ascii dxf writer object.
- */
-DL_WriterA* DL_Jww::out(const char* /*file*/, DL_Codes::version /*version*/) {
-#ifdef DEBUG
-//	jwdoc->Save();
-#endif
-    return NULL; // tin-pot@gmx.net 2011-12-29: Make compiler happy.
+ * @return Pointer to an ascii dxf writer object, or NULL if the file
+ * cannot be opened.
+ */
+DL_WriterA* DL_Jww::out(const char* file, DL_Codes::version version) {
+    this->version = version;
+    DL_WriterA* dw = new DL_WriterA(file, version);
+    if (dw->openFailed()) {
+        delete dw;
+        return NULL;
+    }
+    return dw;
 }
 
 
@@ -1340,6 +1450,30 @@ void DL_Jww::writeEllipse(DL_WriterA& dw,
 
 
 
+/**
+ * Writes a solid (filled quadrilateral) to the file. The corners are
+ * written in DXF order: the fourth one follows the third diagonally.
+ *
+ * @param dw DXF writer
+ * @param data Entity data from the file
+ * @param attrib Attributes
+ */
+void DL_Jww::writeSolid(DL_WriterA& dw,
+                        const DL_SolidData& data,
+                        const DL_Attributes& attrib) {
+    dw.entity("SOLID");
+    if (version==VER_2000) {
+        dw.dxfString(100, "AcDbEntity");
+        dw.dxfString(100, "AcDbTrace");
+    }
+    dw.entityAttributes(attrib);
+    for (int i=0; i<4; i++) {
+        dw.coord(10+i, data.x[i], data.y[i], data.z[i]);
+    }
+}
+
+
+
 /**
  * Writes an insert to the file.
  *
@@ -28,16 +28,62 @@
 #pragma once
 #endif // _MSC_VER > 1000
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 #include "dl_exception.h"
 #include "dl_writer_ascii.h"
 
 
+namespace {
+
+const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+};
+
+/**
+ * Writes the decimal digits of v to str, returns the end.
+ */
+char* writeDigits(unsigned long long v, char* str) {
+    char tmp[24];
+    int n = 0;
+    do {
+        tmp[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        *str++ = tmp[--n];
+    }
+    return str;
+}
+
+char* writeInt(int value, char* str) {
+    long long v = value;
+    if (v < 0) {
+        *str++ = '-';
+        v = -v;
+    }
+    return writeDigits(static_cast<unsigned long long>(v), str);
+}
+
+}
+
+
+
+DL_WriterA::~DL_WriterA() {
+    flushBuffer();
+}
+
+
+
 /**
  * Closes the output file.
  */
 void DL_WriterA::close() const {
+    flushBuffer();
     m_ofile.close();
 }
 
@@ -53,36 +99,88 @@ bool DL_WriterA::openFailed() const {
 
 
 /**
- * Writes a real (double) variable to the DXF file.
+ * Formats value as the shortest fixed-point decimal that reads back as
+ * exactly the same double, with at least one digit after the point
+ * ("1.0", "0.1", "-12.375"). Values that need more digits than a
+ * double holds exactly in an integer fall back to "%.16g" or "%.17g".
  *
- * @param gc Group code.
- * @param value Double value
+ * A candidate n / 10^d reads back as value exactly when the double
+ * division n / 10^d gives value: both are the correctly rounded quotient
+ * while n and 10^d are exact doubles.
+ *
+ * @param str Receives the text; 32 bytes are enough.
+ * @return Length of the text.
  */
-void DL_WriterA::dxfReal(int gc, double value) const {
-    char str[256];
-    snprintf(str, 256,"%.16lf", value);
-	
-	// fix for german locale:
-	strReplace(str, ',', '.');
-
-    // Cut away those zeros at the end:
-    bool dot = false;
-    int end = -1;
-    for (unsigned int i=0; i<strlen(str); ++i) {
-        if (str[i]=='.') {
-            dot = true;
-            end = i+2;
-            continue;
-        } else if (dot && str[i]!='0') {
-            end = i+1;
+int DL_WriterA::formatReal(double value, char* str) {
+    char* p = str;
+    double a = value < 0.0 ? -value : value;
+    if (std::signbit(value) && value == value) {
+        *p++ = '-';
+    }
+    if (a == 0.0) {
+        std::memcpy(p, "0.0", 4);
+        return static_cast<int>(p - str) + 3;
+    }
+    if (a < 1e15) {
+        for (int d = 0; d < 18; ++d) {
+            double scaled = a * POW10[d];
+            if (scaled >= 9007199254740992.0) {
+                break;
+            }
+            double n = std::floor(scaled + 0.5);
+            if (n / POW10[d] != a) {
+                continue;
+            }
+            char digits[24];
+            int len = static_cast<int>(writeDigits(static_cast<unsigned long long>(n), digits) - digits);
+            int whole = len - d;
+            if (whole <= 0) {
+                *p++ = '0';
+            } else {
+                std::memcpy(p, digits, whole);
+                p += whole;
+            }
+            *p++ = '.';
+            if (d == 0) {
+                *p++ = '0';
+            } else {
+                for (int z = whole; z < 0; ++z) {
+                    *p++ = '0';
+                }
+                int from = whole > 0 ? whole : 0;
+                std::memcpy(p, digits + from, len - from);
+                p += len - from;
+            }
+            *p = '\0';
+            return static_cast<int>(p - str);
         }
     }
-    if (end>0 && end<(int)strlen(str)) {
-        str[end] = '\0';
+
+    // Full-precision, huge, tiny, inf or nan: %.16g when it reads back
+    // (up to 15 significant digits were tried above), else %.17g
+    for (int precision = 16; precision <= 17; ++precision) {
+        snprintf(str, 32, "%.*g", precision, value);
+        // fix for german locale:
+        strReplace(str, ',', '.');
+        if (precision == 17 || std::strtod(str, nullptr) == value) {
+            break;
+        }
     }
+    return static_cast<int>(std::strlen(str));
+}
 
-    dxfString(gc, str);
-    m_ofile.flush();
+
+
+/**
+ * Writes a real (double) variable to the DXF file.
+ *
+ * @param gc Group code.
+ * @param value Double value
+ */
+void DL_WriterA::dxfReal(int gc, double value) const {
+    char str[32];
+    int length = formatReal(value, str);
+    put(gc, str, length);
 }
 
 
@@ -94,8 +192,8 @@ void DL_WriterA::dxfReal(int gc, double value) const {
  * @param value Int value
  */
 void DL_WriterA::dxfInt(int gc, int value) const {
-    m_ofile << (gc<10 ? "  " : (gc<100 ? " " : "")) << gc << "\n"
-    << value << "\n";
+    char str[16];
+    put(gc, str, writeInt(value, str) - str);
 }
 
 
@@ -125,19 +223,54 @@ void DL_WriterA::dxfString(int gc, const char* value) const {
 #ifndef __GCC2x__
         //throw DL_NullStrExc();
 #endif
+        value = "";
     }
-    m_ofile << (gc<10 ? "  " : (gc<100 ? " " : "")) << gc << "\n"
-    << value << "\n";
+    put(gc, value, std::strlen(value));
 }
 
 
 
 void DL_WriterA::dxfString(int gc, const string& value) const {
-    m_ofile << (gc<10 ? "  " : (gc<100 ? " " : "")) << gc << "\n"
-    << value << "\n";
+    put(gc, value.data(), value.size());
+}
+
+
+
+/**
+ * Appends a group code line and a value line to the buffer, and writes
+ * the buffer to the file once it holds BUFFER_SIZE bytes. In-memory
+ * writers keep everything.
+ */
+void DL_WriterA::put(int gc, const char* value, size_t length) const {
+    char code[16];
+    char* p = code;
+    if (gc < 10) {
+        *p++ = ' ';
+        *p++ = ' ';
+    } else if (gc < 100) {
+        *p++ = ' ';
+    }
+    p = writeInt(gc, p);
+    *p++ = '\n';
+    m_buffer.append(code, p - code);
+    m_buffer.append(value, length);
+    m_buffer.push_back('\n');
+    if (m_buffer.size() >= BUFFER_SIZE && !m_inMemory) {
+        flushBuffer();
+    }
 }
 
 
+
+void DL_WriterA::flushBuffer() const {
+    if (!m_buffer.empty() && !m_inMemory) {
+        m_ofile.write(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+}
+
+
+
 /**
  * Replaces every occurence of src with dest in the null terminated str.
  */
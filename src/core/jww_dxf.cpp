@@ -0,0 +1,386 @@
+// JWW to DXF conversion for jwwlib-wasm
+
+#include "jww_dxf.h"
+#include "jww_stream.h"
+#include "jww_tessellate.h"
+#include "dl_creationadapter.h"
+#include "dl_jww.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <vector>
+
+namespace JWWDxf {
+
+namespace {
+
+// Stands for a block name in staged text until the definitions are read
+const char PLACEHOLDER[] = "\x01";
+const char HOLE[] = "\n\x01\n";
+
+const char* const SFIG_FLAG = "@@SfigorgFlag@@";
+
+inline bool isLeadByte(unsigned char c)
+{
+	return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC);
+}
+
+// A JWW definition name as a DXF block name: the composite-figure flag is
+// cut off and ASCII outside letters, digits, '$', '-' and '_' becomes '_'.
+// Shift_JIS characters are kept whole (trail bytes can look like '\').
+std::string blockName(const std::string& jwwName)
+{
+	std::string name = jwwName.substr(0, jwwName.find(SFIG_FLAG));
+	std::string out;
+	out.reserve(name.size());
+	for (size_t i = 0; i < name.size(); i++) {
+		unsigned char c = static_cast<unsigned char>(name[i]);
+		if (isLeadByte(c) && i + 1 < name.size()) {
+			out.push_back(name[i]);
+			out.push_back(name[++i]);
+		} else if (c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+		           (c >= 'a' && c <= 'z') || c == '$' || c == '-' || c == '_') {
+			out.push_back(name[i]);
+		} else {
+			out.push_back('_');
+		}
+	}
+	return out;
+}
+
+std::string numberedName(unsigned long number)
+{
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "JWW_BLOCK_%lu", number);
+	return buf;
+}
+
+// DXF text staged in a memory writer, with the positions of block names
+// still to be filled in
+struct Section {
+	explicit Section(DL_Codes::version version) : dw(version) {}
+
+	// Note the placeholders written since offset start as naming `number`
+	void mark(size_t start, unsigned long number) {
+		const std::string& text = dw.buffer();
+		for (size_t at = text.find(HOLE, start); at != std::string::npos; at = text.find(HOLE, at + 2))
+			names.push_back(std::make_pair(at + 1, number));
+	}
+
+	DL_WriterA dw;
+	std::vector<std::pair<size_t, unsigned long> > names;	// offset, block number
+};
+
+// Writes what DL_Jww creates into the current section
+class Writer : public DL_CreationAdapter {
+public:
+	Writer(DL_Jww& jww, const Options& options)
+		: jww(jww), options(options), section(NULL), count(0), inserts(0) {}
+
+	void addLayer(const DL_LayerData& d) override {
+		layers.insert(d.name);
+	}
+	void addPoint(const DL_PointData& d) override {
+		use();
+		jww.writePoint(section->dw, d, attributes);
+	}
+	void addLine(const DL_LineData& d) override {
+		use();
+		jww.writeLine(section->dw, d, attributes);
+	}
+	void addArc(const DL_ArcData& d) override {
+		use();
+		jww.writeArc(section->dw, d, attributes);
+	}
+	void addCircle(const DL_CircleData& d) override {
+		use();
+		jww.writeCircle(section->dw, d, attributes);
+	}
+	void addEllipse(const DL_EllipseData& d) override;
+	void addText(const DL_TextData& d) override {
+		use();
+		jww.writeText(section->dw, d, attributes);
+	}
+	void addSolid(const DL_SolidData& d) override {
+		use();
+		jww.writeSolid(section->dw, d, attributes);
+	}
+
+	// INSERT of definition `number`, named once all definitions are known
+	void addInsert(const CDataBlock& block, const std::string& layer);
+
+	DL_Jww& jww;
+	const Options& options;
+	Section* section;
+	size_t count;
+	size_t inserts;
+	std::set<std::string> layers;
+	std::set<std::string> lineTypes;
+	std::vector<DL_VertexData> vertices;
+
+private:
+	void use() {
+		count++;
+		lineTypes.insert(attributes.getLineType());
+	}
+};
+
+void Writer::addEllipse(const DL_EllipseData& d)
+{
+	double sweep = d.angle2 - d.angle1;
+	if (sweep <= 0.0)
+		sweep += 2.0 * M_PI;
+	const bool closed = sweep >= 2.0 * M_PI - 1e-9;
+	const double rx = std::hypot(d.mx, d.my);
+	const int n = JWWTessellate::segmentCount(std::max(rx, rx * std::fabs(d.ratio)), sweep, options.curveTolerance);
+	// P(t) = C + M cos t + ratio * perp(M) sin t
+	vertices.clear();
+	for (int i = 0; i <= (closed ? n - 1 : n); i++) {
+		double t = d.angle1 + sweep * i / n;
+		double c = std::cos(t), s = std::sin(t) * d.ratio;
+		vertices.push_back(DL_VertexData(d.cx + d.mx * c - d.my * s, d.cy + d.my * c + d.mx * s));
+	}
+	use();
+	jww.writePolyline(section->dw, DL_PolylineData(static_cast<int>(vertices.size()), 0, 0, closed ? 1 : 0), attributes);
+	for (size_t i = 0; i < vertices.size(); i++)
+		jww.writeVertex(section->dw, vertices[i]);
+	jww.writePolylineEnd(section->dw);
+}
+
+void Writer::addInsert(const CDataBlock& block, const std::string& layer)
+{
+	DL_Attributes attrib(layer, 256, -1, "BYLAYER");
+	DL_InsertData d(PLACEHOLDER, block.m_DPKijunTen.x, block.m_DPKijunTen.y, 0.0,
+	                block.m_dBairitsuX, block.m_dBairitsuY, 1.0,
+	                block.m_radKaitenKaku * 180.0 / M_PI, 1, 1, 0.0, 0.0);
+	size_t start = section->dw.buffer().size();
+	jww.writeInsert(section->dw, d, attrib);
+	section->mark(start, block.m_n_Number);
+	layers.insert(layer);
+	count++;
+	inserts++;
+}
+
+// Routes records: the drawing goes to `entities`, each definition to
+// `blocks` between BLOCK and ENDBLK
+class Handler : public DL_JwwRecordHandler {
+public:
+	Handler(Writer& writer, Section& entities, Section& blocks)
+		: DL_JwwRecordHandler(&writer.jww, &writer), writer(writer),
+		  entities(entities), blocks(blocks) {
+		writer.section = &entities;
+	}
+
+	jwBOOL WantsBlockLists() override { return true; }
+
+	void OnBlockList(CDataList& list) override {
+		Definition def;
+		def.number = list.m_nNumber;
+		def.name = blockName(list.m_strName);
+		definitions.push_back(def);
+		size_t start = blocks.dw.buffer().size();
+		writer.jww.writeBlock(blocks.dw, DL_BlockData(PLACEHOLDER, 0, 0.0, 0.0, 0.0));
+		blocks.mark(start, def.number);
+		writer.section = &blocks;
+	}
+
+	// A record past the end of a definition belongs to the drawing again
+	void OnBlockListEnd() override {
+		writer.jww.writeEndBlock(blocks.dw, "");
+		writer.section = &entities;
+	}
+
+	void OnBlock(CDataBlock& d) override {
+		char layer[8];
+		std::snprintf(layer, sizeof(layer), "%X-%X", std::min<unsigned>(d.m_nGLayer, 15), std::min<unsigned>(d.m_nLayer, 15));
+		writer.addInsert(d, layer);
+	}
+
+	struct Definition {
+		unsigned long number;
+		std::string name;
+	};
+	std::vector<Definition> definitions;
+
+private:
+	Writer& writer;
+	Section& entities;
+	Section& blocks;
+};
+
+// One conversion: read() stages the text, write() assembles the file
+class Conversion {
+public:
+	explicit Conversion(const Options& options)
+		: entities(VERSION), blocks(VERSION), writer(jww, options),
+		  handler(writer, entities, blocks) {
+		jww.setVersion(VERSION);
+	}
+
+	bool read(JWWDocument& doc) {
+		doc.pHandler = &handler;
+		// Read() succeeds once the header parses; a cut or corrupt record
+		// list fails the conversion
+		bool ok = doc.Read() && doc.RecordsComplete() && !doc.ReadState.Corrupt;
+		doc.pHandler = NULL;
+		return ok;
+	}
+
+	bool write(std::ostream& out, Stats* stats);
+
+private:
+	void nameBlocks();
+	size_t emit(std::ostream& out, const Section& section) const;
+
+	static const DL_Codes::version VERSION = VER_R12;
+
+	DL_Jww jww;
+	Section entities, blocks;
+	Writer writer;
+	Handler handler;
+	std::map<unsigned long, std::string> names;
+};
+
+// Unique names for the definitions, and empty definitions for INSERTs of
+// numbers that have none
+void Conversion::nameBlocks()
+{
+	std::set<std::string> taken;
+	for (size_t i = 0; i < handler.definitions.size(); i++) {
+		const Handler::Definition& def = handler.definitions[i];
+		if (names.count(def.number))
+			continue;
+		std::string name = def.name.empty() ? numberedName(def.number) : def.name;
+		while (taken.count(name))
+			name += "_";
+		taken.insert(name);
+		names[def.number] = name;
+	}
+	const Section* staged[2] = {&entities, &blocks};
+	for (int s = 0; s < 2; s++) {
+		for (size_t i = 0; i < staged[s]->names.size(); i++) {
+			unsigned long number = staged[s]->names[i].second;
+			if (names.count(number))
+				continue;
+			std::string name = numberedName(number);
+			while (taken.count(name))
+				name += "_";
+			taken.insert(name);
+			names[number] = name;
+			size_t start = blocks.dw.buffer().size();
+			jww.writeBlock(blocks.dw, DL_BlockData(PLACEHOLDER, 0, 0.0, 0.0, 0.0));
+			jww.writeEndBlock(blocks.dw, "");
+			blocks.mark(start, number);
+		}
+	}
+}
+
+// Copy staged text to out with the block names filled in; returns the
+// bytes written
+size_t Conversion::emit(std::ostream& out, const Section& section) const
+{
+	const std::string& text = section.dw.buffer();
+	size_t from = 0, bytes = 0;
+	for (size_t i = 0; i < section.names.size(); i++) {
+		size_t at = section.names[i].first;
+		const std::string& name = names.find(section.names[i].second)->second;
+		out.write(text.data() + from, static_cast<std::streamsize>(at - from));
+		out.write(name.data(), static_cast<std::streamsize>(name.size()));
+		bytes += at - from + name.size();
+		from = at + 1;
+	}
+	out.write(text.data() + from, static_cast<std::streamsize>(text.size() - from));
+	return bytes + text.size() - from;
+}
+
+bool Conversion::write(std::ostream& out, Stats* stats)
+{
+	nameBlocks();
+
+	// HEADER and TABLES
+	DL_WriterA head(VERSION);
+	jww.writeHeader(head);
+	head.dxfString(9, "$DWGCODEPAGE");
+	head.dxfString(3, "ANSI_932");
+	head.sectionEnd();
+	head.sectionTables();
+	std::set<std::string>& lineTypes = writer.lineTypes;
+	lineTypes.insert("CONTINUOUS");
+	head.tableLineTypes(static_cast<int>(lineTypes.size()));
+	for (std::set<std::string>::const_iterator it = lineTypes.begin(); it != lineTypes.end(); ++it)
+		jww.writeLineType(head, DL_LineTypeData(*it, 0));
+	head.tableEnd();
+	std::set<std::string>& layers = writer.layers;
+	layers.insert("0");
+	head.tableLayers(static_cast<int>(layers.size()));
+	for (std::set<std::string>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		jww.writeLayer(head, DL_LayerData(*it, 0), DL_Attributes("", 7, -1, "CONTINUOUS"));
+	head.tableEnd();
+	// Style of the TEXT entities DL_Jww creates
+	head.table("STYLE", 1, 3);
+	head.dxfString(0, "STYLE");
+	head.dxfString(2, "japanese");
+	head.dxfInt(70, 0);
+	head.dxfReal(40, 0.0);
+	head.dxfReal(41, 1.0);
+	head.dxfReal(50, 0.0);
+	head.dxfInt(71, 0);
+	head.dxfReal(42, 2.5);
+	head.dxfString(3, "txt");
+	head.dxfString(4, "");
+	head.tableEnd();
+	head.sectionEnd();
+	head.sectionBlocks();
+
+	DL_WriterA middle(VERSION);
+	middle.sectionEnd();
+	middle.sectionEntities();
+
+	DL_WriterA tail(VERSION);
+	tail.sectionEnd();
+	tail.dxfEOF();
+
+	out.write(head.buffer().data(), static_cast<std::streamsize>(head.buffer().size()));
+	size_t bytes = head.buffer().size() + middle.buffer().size() + tail.buffer().size();
+	bytes += emit(out, blocks);
+	out.write(middle.buffer().data(), static_cast<std::streamsize>(middle.buffer().size()));
+	bytes += emit(out, entities);
+	out.write(tail.buffer().data(), static_cast<std::streamsize>(tail.buffer().size()));
+
+	if (stats) {
+		stats->entities = writer.count;
+		stats->blocks = names.size();
+		stats->inserts = writer.inserts;
+		stats->bytes = bytes;
+	}
+	return static_cast<bool>(out);
+}
+
+} // namespace
+
+bool convert(const char* data, size_t size, std::ostream& out, const Options& options, Stats* stats)
+{
+	std::string ifile(""), ofile("");
+	JWWMemoryBuf input(data, size);
+	JWWDocument doc(ifile, ofile);
+	doc.AttachInput(&input);
+	Conversion conversion(options);
+	return conversion.read(doc) && conversion.write(out, stats);
+}
+
+bool convertFile(const std::string& input, const std::string& output, const Options& options, Stats* stats)
+{
+	std::string ifile(input), ofile("");
+	JWWDocument doc(ifile, ofile);
+	Conversion conversion(options);
+	if (!conversion.read(doc))
+		return false;
+	std::ofstream out(output.c_str(), std::ios::binary);
+	return out && conversion.write(out, stats) && static_cast<bool>(out.flush());
+}
+
+} // namespace JWWDxf
@@ -0,0 +1,405 @@
+// JWW to NDJSON conversion for jwwlib-wasm
+
+#include "jww_json.h"
+#include "jww_sjis.h"
+#include "jww_stream.h"
+#include "dl_writer_ascii.h"
+#include "jwwdoc.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace JWWJson {
+
+namespace {
+
+const char* const SFIG_FLAG = "@@SfigorgFlag@@";
+// Larger chunks grow the buffer as they fill
+const size_t MAX_RESERVE = 1 << 20;
+
+// Line-oriented JSON writer over a buffer flushed to the sink between lines
+class Emitter {
+public:
+	Emitter(Sink& sink, size_t chunkSize) : chunks(0), bytes(0), sink(sink), chunkSize(chunkSize) {
+		buf.reserve(std::min<size_t>(chunkSize, MAX_RESERVE) + 1024);
+	}
+
+	// {"type":"<type>"
+	template<size_t N>
+	void begin(const char (&type)[N]) {
+		buf += "{\"type\":\"";
+		buf.append(type, N - 1);
+		buf.push_back('"');
+	}
+	// }\n, and a chunk once enough is collected
+	void end() {
+		buf += "}\n";
+		if (buf.size() >= chunkSize)
+			flush();
+	}
+
+	// ,"<name>":
+	template<size_t N>
+	void key(const char (&name)[N]) {
+		buf += ",\"";
+		buf.append(name, N - 1);
+		buf += "\":";
+	}
+	template<size_t N>
+	void real(const char (&name)[N], double v) {
+		key(name);
+		real(v);
+	}
+	template<size_t N>
+	void integer(const char (&name)[N], unsigned long v) {
+		key(name);
+		integer(v);
+	}
+	template<size_t N>
+	void boolean(const char (&name)[N], bool v) {
+		key(name);
+		buf += v ? "true" : "false";
+	}
+	template<size_t N>
+	void string(const char (&name)[N], const std::string& sjis) {
+		key(name);
+		string(sjis);
+	}
+
+	// Integral values print as integers, others as the shortest decimal
+	// that reads back as the same double
+	void real(double v) {
+		if (!std::isfinite(v)) {
+			buf += "null";
+		} else if (v == std::floor(v) && std::fabs(v) < 1e15) {
+			if (v < 0.0)
+				buf.push_back('-');
+			integer(static_cast<unsigned long long>(std::fabs(v)));
+		} else {
+			char str[32];
+			int len = DL_WriterA::formatReal(v, str);
+			buf.append(str, static_cast<size_t>(len));
+		}
+	}
+	void integer(unsigned long long v) {
+		char digits[24];
+		char* p = digits + sizeof(digits);
+		do {
+			*--p = static_cast<char>('0' + v % 10);
+			v /= 10;
+		} while (v);
+		buf.append(p, static_cast<size_t>(digits + sizeof(digits) - p));
+	}
+	// Quoted UTF-8 with '"', '\' and control characters escaped
+	void string(const std::string& sjis) {
+		static const char HEX[] = "0123456789abcdef";
+		utf8.clear();
+		JWWSjis::appendUtf8(sjis.data(), sjis.size(), utf8);
+		buf.push_back('"');
+		for (size_t i = 0; i < utf8.size(); i++) {
+			unsigned char c = static_cast<unsigned char>(utf8[i]);
+			if (c == '"' || c == '\\') {
+				buf.push_back('\\');
+				buf.push_back(static_cast<char>(c));
+			} else if (c >= 0x20) {
+				buf.push_back(static_cast<char>(c));
+			} else if (c == '\n') {
+				buf += "\\n";
+			} else if (c == '\r') {
+				buf += "\\r";
+			} else if (c == '\t') {
+				buf += "\\t";
+			} else {
+				buf += "\\u00";
+				buf.push_back(HEX[c >> 4]);
+				buf.push_back(HEX[c & 0xF]);
+			}
+		}
+		buf.push_back('"');
+	}
+	void raw(const char* s) { buf += s; }
+
+	void flush() {
+		if (buf.empty())
+			return;
+		sink.write(buf.data(), buf.size());
+		bytes += buf.size();
+		chunks++;
+		buf.clear();
+	}
+
+	size_t chunks;
+	size_t bytes;
+
+private:
+	Sink& sink;
+	size_t chunkSize;
+	std::string buf;
+	std::string utf8;
+};
+
+// Writes each record as it is decoded
+class Handler : public JWWRecordHandler {
+public:
+	Handler(Emitter& out, const Options& options)
+		: records(0), blocks(0), out(out), options(options), block(-1) {}
+
+	jwBOOL WantsBlockLists() override { return true; }
+
+	void OnHeader(JWWHead& h) override;
+	void OnBlockList(CDataList& d) override;
+	// A record past the end of a definition belongs to the drawing again
+	void OnBlockListEnd() override { block = -1; }
+	void OnSen(CDataSen& d) override {
+		out.begin("line");
+		pen(d);
+		line(d);
+		end();
+	}
+	void OnEnko(CDataEnko& d) override {
+		out.begin("arc");
+		pen(d);
+		out.real("x", d.m_start.x);
+		out.real("y", d.m_start.y);
+		out.real("radius", d.m_dHankei);
+		out.real("start", d.m_radKaishiKaku);
+		out.real("sweep", d.m_radEnkoKaku);
+		out.real("tilt", d.m_radKatamukiKaku);
+		out.real("ratio", d.m_dHenpeiRitsu);
+		out.boolean("full", d.m_bZenEnFlg != 0);
+		end();
+	}
+	void OnTen(CDataTen& d) override {
+		out.begin("point");
+		pen(d);
+		out.real("x", d.m_start.x);
+		out.real("y", d.m_start.y);
+		out.boolean("temporary", d.m_bKariten != 0);
+		out.integer("code", d.m_nCode);
+		out.real("angle", d.m_radKaitenKaku);
+		out.real("scale", d.m_dBairitsu);
+		end();
+	}
+	void OnMoji(CDataMoji& d) override {
+		if (!options.texts)
+			return;
+		out.begin("text");
+		pen(d);
+		text(d);
+		end();
+	}
+	void OnSolid(CDataSolid& d) override {
+		out.begin("solid");
+		pen(d);
+		// Outline order
+		out.real("x1", d.m_start.x);
+		out.real("y1", d.m_start.y);
+		out.real("x2", d.m_DPoint2.x);
+		out.real("y2", d.m_DPoint2.y);
+		out.real("x3", d.m_DPoint3.x);
+		out.real("y3", d.m_DPoint3.y);
+		out.real("x4", d.m_end.x);
+		out.real("y4", d.m_end.y);
+		// Pen color 10 is "any color" with its own RGB value
+		if (d.m_nPenColor == 10)
+			out.integer("rgb", d.m_Color);
+		end();
+	}
+	void OnSunpou(CDataSunpou& d) override {
+		out.begin("dimension");
+		pen(d);
+		out.raw(",\"line\":{");
+		penFields(d.m_Sen, false);
+		line(d.m_Sen);
+		out.raw("},\"label\":{");
+		penFields(d.m_Moji, false);
+		text(d.m_Moji);
+		out.raw("}");
+		end();
+	}
+	void OnBlock(CDataBlock& d) override {
+		out.begin("insert");
+		pen(d);
+		out.real("x", d.m_DPKijunTen.x);
+		out.real("y", d.m_DPKijunTen.y);
+		out.real("scaleX", d.m_dBairitsuX);
+		out.real("scaleY", d.m_dBairitsuY);
+		out.real("angle", d.m_radKaitenKaku);
+		out.integer("number", d.m_n_Number);
+		end();
+	}
+
+	size_t records;
+	size_t blocks;
+
+private:
+	void end() {
+		if (block >= 0)
+			out.integer("block", static_cast<unsigned long>(block));
+		out.end();
+		records++;
+	}
+
+	void pen(const CData& d) { penFields(d, true); }
+	// The pen fields; the first one without a leading comma when it opens
+	// a nested object
+	void penFields(const CData& d, bool afterType) {
+		if (afterType)
+			out.key("glayer");
+		else
+			out.raw("\"glayer\":");
+		out.integer(d.m_nGLayer);
+		out.integer("layer", d.m_nLayer);
+		out.integer("color", d.m_nPenColor);
+		out.integer("style", d.m_nPenStyle);
+		out.integer("width", d.m_nPenWidth);
+	}
+	void line(const CDataSen& d) {
+		out.real("x1", d.m_start.x);
+		out.real("y1", d.m_start.y);
+		out.real("x2", d.m_end.x);
+		out.real("y2", d.m_end.y);
+	}
+	void text(const CDataMoji& d) {
+		out.real("x1", d.m_start.x);
+		out.real("y1", d.m_start.y);
+		out.real("x2", d.m_end.x);
+		out.real("y2", d.m_end.y);
+		out.integer("kind", d.m_nMojiShu);
+		out.real("charWidth", d.m_dSizeX);
+		out.real("charHeight", d.m_dSizeY);
+		out.real("spacing", d.m_dKankaku);
+		out.real("angle", d.m_degKakudo);
+		out.string("font", d.m_strFontName);
+		out.string("text", d.m_string);
+	}
+
+	Emitter& out;
+	const Options& options;
+	long block;
+};
+
+void Handler::OnHeader(JWWHead& h)
+{
+	if (!options.header)
+		return;
+	out.begin("header");
+	out.integer("version", h.JW_DATA_VERSION);
+	out.string("memo", h.m_strMemo);
+	out.integer("paper", h.m_nZumen);
+	out.key("layerGroups");
+	out.raw("[");
+	for (int g = 0; g < 16; g++) {
+		if (g)
+			out.raw(",");
+		out.string(h.m_aStrGLayName[g]);
+	}
+	out.raw("]");
+	out.key("layers");
+	out.raw("[");
+	for (int g = 0; g < 16; g++) {
+		out.raw(g ? ",[" : "[");
+		for (int l = 0; l < 16; l++) {
+			if (l)
+				out.raw(",");
+			out.string(h.m_aStrLayName[g][l]);
+		}
+		out.raw("]");
+	}
+	out.raw("]");
+	out.end();
+}
+
+void Handler::OnBlockList(CDataList& d)
+{
+	const std::string& name = d.m_strName;
+	size_t at = name.find(SFIG_FLAG);
+	out.begin("block");
+	out.integer("number", d.m_nNumber);
+	out.string("name", at == std::string::npos ? name : name.substr(0, at));
+	if (at != std::string::npos)
+		out.integer("flag", std::strtoul(name.c_str() + at + std::strlen(SFIG_FLAG), NULL, 10));
+	out.integer("count", d.Count);
+	out.end();
+	blocks++;
+	block = static_cast<long>(d.m_nNumber);
+}
+
+bool run(JWWDocument& doc, Sink& sink, const Options& options, Stats* stats)
+{
+	Emitter out(sink, options.chunkSize > 0 ? options.chunkSize : 1);
+	Handler handler(out, options);
+	doc.pHandler = &handler;
+	// Read() succeeds once the header parses; a cut or corrupt record list
+	// fails the conversion
+	bool ok = doc.Read() && doc.RecordsComplete() && !doc.ReadState.Corrupt;
+	doc.pHandler = NULL;
+	out.flush();
+	if (stats) {
+		stats->records = handler.records;
+		stats->blocks = handler.blocks;
+		stats->chunks = out.chunks;
+		stats->bytes = out.bytes;
+	}
+	return ok;
+}
+
+class StringSink : public Sink {
+public:
+	explicit StringSink(std::string& out) : out(out) {}
+	void write(const char* data, size_t size) override { out.append(data, size); }
+
+private:
+	std::string& out;
+};
+
+class FileSink : public Sink {
+public:
+	explicit FileSink(std::ofstream& out) : out(out) {}
+	void write(const char* data, size_t size) override { out.write(data, static_cast<std::streamsize>(size)); }
+
+private:
+	std::ofstream& out;
+};
+
+} // namespace
+
+bool convert(const char* data, size_t size, Sink& sink, const Options& options, Stats* stats)
+{
+	std::string ifile(""), ofile("");
+	JWWMemoryBuf input(data, size);
+	JWWDocument doc(ifile, ofile);
+	doc.AttachInput(&input);
+	return run(doc, sink, options, stats);
+}
+
+bool convert(const char* data, size_t size, std::string& out, const Options& options, Stats* stats)
+{
+	const size_t before = out.size();
+	StringSink sink(out);
+	bool ok = convert(data, size, sink, options, stats);
+	if (!ok)
+		out.resize(before);
+	return ok;
+}
+
+bool convertFile(const std::string& input, const std::string& output, const Options& options, Stats* stats)
+{
+	std::string ifile(input), ofile("");
+	JWWDocument doc(ifile, ofile);
+	std::ofstream out(output.c_str(), std::ios::binary);
+	if (!out)
+		return false;
+	FileSink sink(out);
+	if (!run(doc, sink, options, stats)) {
+		out.close();
+		std::remove(output.c_str());
+		return false;
+	}
+	return static_cast<bool>(out.flush());
+}
+
+} // namespace JWWJson
@@ -0,0 +1,352 @@
+// Line type expansion for jwwlib-wasm
+
+#include "jww_linetype.h"
+#include "jww_tessellate.h"
+#include <algorithm>
+#include <cmath>
+
+namespace JWWLinetype {
+
+namespace {
+
+const int SXF_FIRST = 30;	// SXLTP_EXT: SXF pen styles start at 30
+const int SXF_COUNT = 33;
+const int UDL_MAX_SEGMENTS = 10;
+
+// Wobble offset in [-1, 1] for vertex k of a random line
+double wobble(uint32_t k)
+{
+	k ^= k >> 16;
+	k *= 0x7feb352dU;
+	k ^= k >> 15;
+	k *= 0x846ca68bU;
+	k ^= k >> 16;
+	return static_cast<double>(k) / 2147483647.5 - 1.0;
+}
+
+// Arc-length intervals [s0, s1] of the "on" dashes along a run of length
+// `length` (drawing units), walking the pattern from its start
+void dashIntervals(const std::vector<double>& dashes, double unit, double length,
+                   std::vector<double>& spans)
+{
+	spans.clear();
+	double s = 0.0;
+	size_t k = 0;
+	const size_t n = dashes.size();
+	while (s < length) {
+		double d = dashes[k] * unit;
+		double e = std::min(s + d, length);
+		if ((k & 1) == 0 && e > s) {
+			spans.push_back(s);
+			spans.push_back(e);
+		}
+		s += d;
+		if (++k == n)
+			k = 0;
+	}
+}
+
+void pushSegment(std::vector<double>& out, double x0, double y0, double x1, double y1)
+{
+	out.push_back(x0);
+	out.push_back(y0);
+	out.push_back(x1);
+	out.push_back(y1);
+}
+
+void solidArc(double cx, double cy, double r, double start, double sweep,
+              double scale, std::vector<double>& out)
+{
+	int segments = JWWTessellate::segmentCount(r, sweep, 0.5 / scale);
+	double step = sweep / segments;
+	double px = cx + r * std::cos(start), py = cy + r * std::sin(start);
+	for (int k = 1; k <= segments; k++) {
+		double a = start + step * k;
+		double x = cx + r * std::cos(a), y = cy + r * std::sin(a);
+		pushSegment(out, px, py, x, y);
+		px = x;
+		py = y;
+	}
+}
+
+// True when the pattern is too fine (or too long) to draw at this scale
+bool drawSolid(const Pattern& pattern, double scale, double length)
+{
+	if (pattern.kind == Pattern::Solid || !(scale > 0.0))
+		return true;
+	double period = pattern.period();
+	if (period < MIN_PERIOD * (pattern.kind == Pattern::Random ? 2.0 : 1.0))
+		return true;
+	double pieces = length * scale / period *
+		(pattern.kind == Pattern::Random ? 2.0 : pattern.dashes.size() / 2.0);
+	return !(pieces <= static_cast<double>(MAX_DASHES));
+}
+
+} // namespace
+
+double Pattern::period() const
+{
+	if (kind == Random)
+		return pitch;
+	double sum = 0.0;
+	for (size_t i = 0; i < dashes.size(); i++)
+		sum += dashes[i];
+	return sum;
+}
+
+void bitsToDashes(uint32_t bits, int unitDots, int pitch, std::vector<double>& dashes)
+{
+	dashes.clear();
+	unitDots = std::max(1, std::min(32, unitDots));
+	const double bitLength = pitch > 0 ? pitch : 1;
+	bool on = true;
+	double run = 0.0;
+	for (int i = 0; i < unitDots; i++) {
+		bool bit = (bits >> i) & 1;
+		if (bit != on) {
+			dashes.push_back(run);
+			on = bit;
+			run = 0.0;
+		}
+		run += bitLength;
+	}
+	dashes.push_back(run);
+	// Keep on/off pairs so the walk can cycle through them
+	if (dashes.size() & 1)
+		dashes.push_back(0.0);
+}
+
+PatternTable::PatternTable()
+	: patterns(STYLE_COUNT)
+{
+}
+
+void PatternTable::reset()
+{
+	patterns.assign(STYLE_COUNT, Pattern());
+}
+
+void PatternTable::load(const JWWHead& head, double dotsPerMM)
+{
+	reset();
+
+	struct Bits { int style; uint32_t bits; int unitDots; int pitch; };
+	std::vector<Bits> bitPatterns;
+	for (int i = 2; i <= 9; i++) {
+		const JWWLType1& t = head.m_alLType1[i];
+		bitPatterns.push_back(Bits{i, t.m_alLtype, static_cast<int>(t.m_anTokushusSenUnitDot),
+		                           static_cast<int>(t.m_anTokushuSenPich)});
+	}
+	for (int i = 16; i <= 19; i++) {
+		const JWWLType3& t = head.m_alLType3[i];
+		bitPatterns.push_back(Bits{i, t.m_alLtype, static_cast<int>(t.m_anTokushusSenUnitDot),
+		                           static_cast<int>(t.m_anTokushuSenPich)});
+	}
+	// SXF tables are only in the file from Ver.4.20
+	const SXFLTP& sxf = head.m_SxfLtp;
+	const bool hasSxf = head.JW_DATA_VERSION >= 420;
+	if (hasSxf) {
+		for (int n = 0; n < SXF_COUNT; n++) {
+			int i = n + SXF_FIRST;
+			bitPatterns.push_back(Bits{i, sxf.m_alLType[i], static_cast<int>(sxf.m_anTokushuSenUintDot[i]),
+			                           static_cast<int>(sxf.m_anTokushuSenPich[i])});
+		}
+	}
+
+	for (size_t k = 0; k < bitPatterns.size(); k++) {
+		const Bits& b = bitPatterns[k];
+		Pattern& p = patterns[b.style];
+		if (b.bits == 0)
+			continue;
+		bitsToDashes(b.bits, b.unitDots, b.pitch, p.dashes);
+		// A pattern of only "on" bits is a solid line
+		p.kind = p.dashes.size() > 1 && p.dashes[1] > 0.0 ? Pattern::Dashed : Pattern::Solid;
+		if (p.kind == Pattern::Solid)
+			p.dashes.clear();
+	}
+
+	// User-defined SXF pitches (mm) take priority over the bit patterns
+	if (hasSxf) {
+		for (int n = 0; n < SXF_COUNT; n++) {
+			int segments = static_cast<int>(sxf.m_anUDLTypeSegment[n]);
+			if (segments <= 0 || segments > UDL_MAX_SEGMENTS)
+				continue;
+			std::vector<double> dashes;
+			bool gaps = false;
+			for (int j = 1; j <= segments; j++) {
+				double mm = sxf.m_aadUDLTypePitch[n][j];
+				if (!(mm >= 0.0))
+					mm = 0.0;
+				dashes.push_back(mm * dotsPerMM);
+				if ((j & 1) == 0 && mm > 0.0)
+					gaps = true;
+			}
+			if (dashes.size() & 1)
+				dashes.push_back(0.0);
+			if (!gaps)
+				continue;
+			Pattern& p = patterns[n + SXF_FIRST];
+			p.kind = Pattern::Dashed;
+			p.dashes.swap(dashes);
+		}
+	}
+
+	for (int i = 11; i <= 15; i++) {
+		const JWWLType2& t = head.m_alLType2[i];
+		if (t.m_anRandSenWide == 0 || t.m_anTokushuSenPich == 0)
+			continue;
+		Pattern& p = patterns[i];
+		p.kind = Pattern::Random;
+		p.amplitude = t.m_anRandSenWide;
+		p.pitch = t.m_anTokushuSenPich;
+	}
+}
+
+const Pattern& PatternTable::get(int penStyle) const
+{
+	if (penStyle < 0 || penStyle >= STYLE_COUNT)
+		return patterns[0];
+	return patterns[penStyle];
+}
+
+void expandLine(const Pattern& pattern, double scale,
+                double x1, double y1, double x2, double y2, std::vector<double>& out)
+{
+	const double dx = x2 - x1, dy = y2 - y1;
+	const double length = std::sqrt(dx * dx + dy * dy);
+	if (drawSolid(pattern, scale, length) || length == 0.0) {
+		pushSegment(out, x1, y1, x2, y2);
+		return;
+	}
+	const double ux = dx / length, uy = dy / length;
+	const double unit = 1.0 / scale;
+
+	if (pattern.kind == Pattern::Random) {
+		// Vertices every half pitch, offset across the line
+		const double half = pattern.pitch * 0.5 * unit;
+		const double amp = pattern.amplitude * unit;
+		size_t count = static_cast<size_t>(std::ceil(length / half));
+		double px = x1, py = y1;
+		for (size_t k = 1; k <= count; k++) {
+			double s = std::min(length, half * k);
+			double w = k == count ? 0.0 : amp * wobble(static_cast<uint32_t>(k));
+			double x = x1 + ux * s - uy * w;
+			double y = y1 + uy * s + ux * w;
+			pushSegment(out, px, py, x, y);
+			px = x;
+			py = y;
+		}
+		return;
+	}
+
+	// Interval walk first, then one branch-free pass over the coordinates
+	std::vector<double> spans;
+	dashIntervals(pattern.dashes, unit, length, spans);
+	size_t base = out.size();
+	out.resize(base + spans.size() * 2);
+	double* o = out.data() + base;
+	const double* s = spans.data();
+	for (size_t i = 0, n = spans.size(); i < n; i += 2, o += 4) {
+		o[0] = x1 + ux * s[i];
+		o[1] = y1 + uy * s[i];
+		o[2] = x1 + ux * s[i + 1];
+		o[3] = y1 + uy * s[i + 1];
+	}
+}
+
+void expandArc(const Pattern& pattern, double scale,
+               double cx, double cy, double r, double start, double sweep,
+               std::vector<double>& out)
+{
+	r = std::fabs(r);
+	const double length = r * sweep;
+	if (drawSolid(pattern, scale, length) || !(length > 0.0)) {
+		solidArc(cx, cy, r, start, sweep, scale > 0.0 ? scale : 1.0, out);
+		return;
+	}
+	const double unit = 1.0 / scale;
+
+	if (pattern.kind == Pattern::Random) {
+		// Radial wobble at every half pitch of arc length, chorded in between
+		const double half = pattern.pitch * 0.5 * unit;
+		const double amp = pattern.amplitude * unit;
+		size_t count = static_cast<size_t>(std::ceil(length / half));
+		double px = cx + r * std::cos(start), py = cy + r * std::sin(start);
+		for (size_t k = 1; k <= count; k++) {
+			double a = start + std::min(length, half * k) / r;
+			double rr = k == count ? r : r + amp * wobble(static_cast<uint32_t>(k));
+			double x = cx + rr * std::cos(a), y = cy + rr * std::sin(a);
+			pushSegment(out, px, py, x, y);
+			px = x;
+			py = y;
+		}
+		return;
+	}
+
+	std::vector<double> spans;
+	dashIntervals(pattern.dashes, unit, length, spans);
+	// Chord each dash within half a dot
+	const double tolerance = 0.5 * unit;
+	const double step = tolerance >= r ? 2.0943951023931953 : 2.0 * std::acos(1.0 - tolerance / r);
+	for (size_t i = 0; i < spans.size(); i += 2) {
+		double a0 = start + spans[i] / r;
+		double a1 = start + spans[i + 1] / r;
+		int segments = std::max(1, static_cast<int>(std::ceil((a1 - a0) / step)));
+		double da = (a1 - a0) / segments;
+		double px = cx + r * std::cos(a0), py = cy + r * std::sin(a0);
+		for (int k = 1; k <= segments; k++) {
+			double a = k == segments ? a1 : a0 + da * k;
+			double x = cx + r * std::cos(a), y = cy + r * std::sin(a);
+			pushSegment(out, px, py, x, y);
+			px = x;
+			py = y;
+		}
+	}
+}
+
+int scaleBucket(double scale)
+{
+	if (!(scale > 0.0))
+		return 0;
+	return static_cast<int>(std::floor(std::log2(scale) * 4.0));
+}
+
+double bucketScale(int bucket)
+{
+	return std::exp2(bucket * 0.25);
+}
+
+SegmentCache::SegmentCache(size_t maxBytes)
+	: used(0), maxBytes(maxBytes)
+{
+}
+
+const std::vector<double>* SegmentCache::find(uint32_t entity, int bucket) const
+{
+	std::unordered_map<uint64_t, std::vector<double> >::const_iterator it = entries.find(key(entity, bucket));
+	return it == entries.end() ? 0 : &it->second;
+}
+
+const std::vector<double>& SegmentCache::insert(uint32_t entity, int bucket, std::vector<double>& segments)
+{
+	size_t bytes = segments.size() * sizeof(double);
+	std::vector<double>& slot = entries[key(entity, bucket)];
+	used -= slot.size() * sizeof(double);
+	slot.swap(segments);
+	used += bytes;
+	return slot;
+}
+
+void SegmentCache::trim()
+{
+	if (used > maxBytes)
+		clear();
+}
+
+void SegmentCache::clear()
+{
+	entries.clear();
+	used = 0;
+}
+
+} // namespace JWWLinetype
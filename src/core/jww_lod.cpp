@@ -0,0 +1,464 @@
+// Level-of-detail pyramid for jwwlib-wasm
+
+#include "jww_lod.h"
+#include "jww_tessellate.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace JWWLod {
+
+namespace {
+
+struct NodeKey {
+	uint64_t x;
+	uint64_t y;
+	uint32_t pen;
+
+	bool operator==(const NodeKey& o) const { return x == o.x && y == o.y && pen == o.pen; }
+};
+
+struct NodeHash {
+	size_t operator()(const NodeKey& k) const {
+		uint64_t h = k.x * 0x9E3779B97F4A7C15ULL;
+		h ^= (k.y + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2)) * 0xC2B2AE3D27D4EB4FULL;
+		h ^= k.pen + (h >> 29);
+		return static_cast<size_t>(h ^ (h >> 32));
+	}
+};
+
+uint64_t coordBits(double v)
+{
+	if (v == 0.0)
+		v = 0.0;	// -0 and +0 are the same point
+	uint64_t bits;
+	std::memcpy(&bits, &v, sizeof(bits));
+	return bits;
+}
+
+const uint32_t NONE = 0xFFFFFFFFu;
+
+// Squared distance from p to the segment a-b
+double distanceSq(const double* p, const double* a, const double* b)
+{
+	double dx = b[0] - a[0], dy = b[1] - a[1];
+	double len2 = dx * dx + dy * dy;
+	double t = len2 > 0.0 ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / len2 : 0.0;
+	t = std::max(0.0, std::min(1.0, t));
+	double ex = a[0] + t * dx - p[0];
+	double ey = a[1] + t * dy - p[1];
+	return ex * ex + ey * ey;
+}
+
+} // namespace
+
+namespace {
+
+// Open-addressing table from NodeKey to a dense id
+class NodeTable {
+public:
+	explicit NodeTable(size_t expected) {
+		size_t capacity = 16;
+		while (capacity < expected * 2)
+			capacity <<= 1;
+		mask = capacity - 1;
+		slots.assign(capacity, NONE);
+		keys.reserve(expected);
+	}
+
+	// Id of key, or NONE when absent and !insert
+	uint32_t find(const NodeKey& key, bool insert) {
+		size_t slot = hash(key) & mask;
+		while (slots[slot] != NONE && !(keys[slots[slot]] == key))
+			slot = (slot + 1) & mask;
+		if (slots[slot] == NONE && insert) {
+			slots[slot] = static_cast<uint32_t>(keys.size());
+			keys.push_back(key);
+		}
+		return slots[slot];
+	}
+
+private:
+	std::vector<uint32_t> slots;
+	std::vector<NodeKey> keys;
+	size_t mask;
+	NodeHash hash;
+};
+
+// Grid cell of v for cells of the given size, and in side the direction
+// of the nearer neighbor cell
+uint64_t cellOf(double v, double size, int& side)
+{
+	double f = v / size;
+	double c = std::floor(f);
+	side = f - c < 0.5 ? -1 : 1;
+	c = std::max(-4.0e18, std::min(4.0e18, c));
+	return static_cast<uint64_t>(static_cast<int64_t>(c));
+}
+
+void chain(const std::vector<double>& xy, const std::vector<uint32_t>& pens, double tolerance,
+           std::vector<double>& points, std::vector<uint32_t>& offsets,
+           std::vector<uint32_t>& chainPens, std::vector<uint32_t>* segmentOrder)
+{
+	const size_t n = xy.size() / 4;
+	points.clear();
+	offsets.clear();
+	chainPens.clear();
+	if (segmentOrder)
+		segmentOrder->clear();
+	offsets.push_back(0);
+	if (n == 0)
+		return;
+
+	// Node of every segment end, and the first two ends meeting at each
+	// node. Exact matching keys nodes by coordinate bits; with a tolerance
+	// the table holds grid cells instead, each listing the nodes whose
+	// first end lies in it. Cells are twice the tolerance across, so the
+	// nodes within tolerance of an end lie in its cell and the three
+	// neighbors on the sides it is nearer to.
+	const bool snap = tolerance > 0.0;
+	const double cellSize = tolerance * 2.0;
+	const double tolerance2 = tolerance * tolerance;
+	NodeTable table(n * 2);
+	std::vector<uint32_t> cellHead, nextInCell;
+	std::vector<uint32_t> endNode(n * 2);
+	std::vector<uint32_t> degree;
+	std::vector<uint32_t> incident;	// two segment ends (segment * 2 + end) per node
+	degree.reserve(n * 2);
+	incident.reserve(n * 4);
+	if (snap)
+		nextInCell.reserve(n * 2);
+	for (size_t i = 0; i < n * 2; i++) {
+		const double x = xy[i * 2], y = xy[i * 2 + 1];
+		const uint32_t pen = pens[i / 2];
+		uint32_t node = NONE;
+		if (!snap) {
+			NodeKey key = {coordBits(x), coordBits(y), pen};
+			node = table.find(key, true);
+			if (node == degree.size()) {
+				degree.push_back(0);
+				incident.push_back(NONE);
+				incident.push_back(NONE);
+			}
+		} else {
+			int sideX, sideY;
+			const uint64_t cx = cellOf(x, cellSize, sideX), cy = cellOf(y, cellSize, sideY);
+			for (int c = 0; c < 4 && node == NONE; c++) {
+				NodeKey key = {cx + ((c & 1) ? sideX : 0), cy + ((c & 2) ? sideY : 0), pen};
+				uint32_t cell = table.find(key, false);
+				if (cell == NONE)
+					continue;
+				for (uint32_t k = cellHead[cell]; k != NONE; k = nextInCell[k]) {
+					uint32_t first = incident[k * 2];
+					double ex = xy[first * 2] - x, ey = xy[first * 2 + 1] - y;
+					if (ex * ex + ey * ey <= tolerance2) {
+						node = k;
+						break;
+					}
+				}
+			}
+			if (node == NONE) {
+				node = static_cast<uint32_t>(degree.size());
+				degree.push_back(0);
+				incident.push_back(NONE);
+				incident.push_back(NONE);
+				NodeKey key = {cx, cy, pen};
+				uint32_t cell = table.find(key, true);
+				if (cell == cellHead.size())
+					cellHead.push_back(NONE);
+				nextInCell.push_back(cellHead[cell]);
+				cellHead[cell] = node;
+			}
+		}
+		if (degree[node] < 2)
+			incident[node * 2 + degree[node]] = static_cast<uint32_t>(i);
+		degree[node]++;
+		endNode[i] = node;
+	}
+
+	// The segment end across a degree-2 node from `end`, or NONE
+	auto across = [&](uint32_t end) -> uint32_t {
+		uint32_t node = endNode[end];
+		if (degree[node] != 2)
+			return NONE;
+		return incident[node * 2] == end ? incident[node * 2 + 1] : incident[node * 2];
+	};
+	// The point a chain takes for `end`: the node's first end, so chains
+	// meeting at a snapped node share one point
+	auto pointOf = [&](uint32_t end) -> const double* {
+		return &xy[(snap ? incident[endNode[end] * 2] : end) * 2];
+	};
+
+	std::vector<uint8_t> visited(n, 0);
+	points.reserve(xy.size() / 2 + n / 4);
+	if (segmentOrder)
+		segmentOrder->reserve(n);
+	for (size_t s = 0; s < n; s++) {
+		if (visited[s])
+			continue;
+		// Walk back to the start of the chain (or all the way round a loop).
+		// tail is the end of `seg` that comes first in chain order.
+		uint32_t seg = static_cast<uint32_t>(s), tail = 0;
+		for (;;) {
+			uint32_t other = across(seg * 2 + tail);
+			if (other == NONE || other / 2 == s || other / 2 == seg || visited[other / 2])
+				break;
+			seg = other / 2;
+			tail = (other & 1) ^ 1;
+		}
+		// Forward from there, emitting points
+		const double* p = pointOf(seg * 2 + tail);
+		points.push_back(p[0]);
+		points.push_back(p[1]);
+		for (;;) {
+			uint32_t head = seg * 2 + (tail ^ 1);
+			visited[seg] = 1;
+			if (segmentOrder)
+				segmentOrder->push_back(seg);
+			p = pointOf(head);
+			points.push_back(p[0]);
+			points.push_back(p[1]);
+			uint32_t other = across(head);
+			if (other == NONE || visited[other / 2])
+				break;
+			seg = other / 2;
+			tail = other & 1;
+		}
+		offsets.push_back(static_cast<uint32_t>(points.size() / 2));
+		chainPens.push_back(pens[s]);
+	}
+}
+
+} // namespace
+
+void chainSegments(const std::vector<double>& xy, const std::vector<uint32_t>& pens,
+                   std::vector<double>& points, std::vector<uint32_t>& offsets,
+                   std::vector<uint32_t>& chainPens)
+{
+	chain(xy, pens, 0.0, points, offsets, chainPens, nullptr);
+}
+
+void chainSegments(const std::vector<double>& xy, const std::vector<uint32_t>& pens,
+                   double tolerance, std::vector<double>& points,
+                   std::vector<uint32_t>& offsets, std::vector<uint32_t>& chainPens,
+                   std::vector<uint32_t>& segmentOrder)
+{
+	chain(xy, pens, tolerance, points, offsets, chainPens, &segmentOrder);
+}
+
+void significance(const double* xy, size_t count, double minTolerance, std::vector<double>& out)
+{
+	out.assign(count, 0.0);
+	if (count == 0)
+		return;
+	out[0] = out[count - 1] = HUGE_VAL;
+	if (count < 3)
+		return;
+	const double min2 = minTolerance * minTolerance;
+	// Each range carries the significance of the split that created it; a
+	// point is only kept when everything above it in the recursion is kept
+	struct Range { uint32_t first, last; double limit; };
+	std::vector<Range> stack;
+	stack.push_back(Range{0, static_cast<uint32_t>(count - 1), HUGE_VAL});
+	while (!stack.empty()) {
+		Range r = stack.back();
+		stack.pop_back();
+		double worst = -1.0;
+		uint32_t split = r.first;
+		for (uint32_t i = r.first + 1; i < r.last; i++) {
+			double d = distanceSq(xy + i * 2, xy + r.first * 2, xy + r.last * 2);
+			if (d > worst) {
+				worst = d;
+				split = i;
+			}
+		}
+		if (worst <= min2)
+			continue;
+		double limit = std::min(r.limit, std::sqrt(worst));
+		out[split] = limit;
+		if (split - r.first > 1)
+			stack.push_back(Range{r.first, split, limit});
+		if (r.last - split > 1)
+			stack.push_back(Range{split, r.last, limit});
+	}
+}
+
+void simplify(const double* xy, size_t count, double tolerance, std::vector<uint32_t>& keep)
+{
+	std::vector<double> sig;
+	significance(xy, count, tolerance, sig);
+	for (size_t i = 0; i < count; i++) {
+		if (sig[i] > tolerance)
+			keep.push_back(static_cast<uint32_t>(i));
+	}
+}
+
+void Pyramid::addSegment(double x1, double y1, double x2, double y2, uint32_t pen)
+{
+	segmentXY.push_back(x1);
+	segmentXY.push_back(y1);
+	segmentXY.push_back(x2);
+	segmentXY.push_back(y2);
+	segmentPens.push_back(pen);
+}
+
+void Pyramid::addArc(double cx, double cy, double rx, double ry, double rotation,
+                     double start, double sweep, uint32_t pen)
+{
+	Arc a = {cx, cy, std::fabs(rx), std::fabs(ry), rotation, start, sweep, pen};
+	arcs.push_back(a);
+}
+
+void Pyramid::addText(uint32_t id, double height)
+{
+	texts.push_back(std::make_pair(std::fabs(height), id));
+}
+
+void Pyramid::clear()
+{
+	segmentXY.clear();
+	segmentPens.clear();
+	arcs.clear();
+	texts.clear();
+	levels.clear();
+	originX = originY = 0.0;
+}
+
+void Pyramid::build(double baseTolerance, int levelCount, double ox, double oy)
+{
+	levels.clear();
+	originX = ox;
+	originY = oy;
+	levelCount = std::max(1, std::min(MAX_LEVELS, levelCount));
+	if (!(baseTolerance > 0.0))
+		baseTolerance = 1e-9;
+
+	std::vector<double> points;
+	std::vector<uint32_t> offsets, chainPens;
+	chainSegments(segmentXY, segmentPens, points, offsets, chainPens);
+	std::vector<double>().swap(segmentXY);
+	std::vector<uint32_t>().swap(segmentPens);
+
+	// Douglas-Peucker once at the finest tolerance; each level then keeps
+	// the points whose significance exceeds its tolerance
+	const size_t pointCount = points.size() / 2;
+	std::vector<double> pointSig(pointCount);
+	std::vector<double> sig;
+	const size_t chainCount = chainPens.size();
+	for (size_t c = 0; c < chainCount; c++) {
+		significance(points.data() + offsets[c] * 2, offsets[c + 1] - offsets[c], baseTolerance, sig);
+		std::copy(sig.begin(), sig.end(), pointSig.begin() + offsets[c]);
+	}
+
+	// Largest side of each chain's box, to drop chains smaller than a level
+	std::vector<double> chainSize(chainCount);
+	for (size_t c = 0; c < chainCount; c++) {
+		const double* p = points.data() + offsets[c] * 2;
+		double minX = p[0], maxX = p[0], minY = p[1], maxY = p[1];
+		for (uint32_t i = 1; i < offsets[c + 1] - offsets[c]; i++) {
+			minX = std::min(minX, p[i * 2]);
+			maxX = std::max(maxX, p[i * 2]);
+			minY = std::min(minY, p[i * 2 + 1]);
+			maxY = std::max(maxY, p[i * 2 + 1]);
+		}
+		chainSize[c] = std::max(maxX - minX, maxY - minY);
+	}
+
+	// Chains and arcs in pen order, so each level's groups come out contiguous
+	std::vector<uint32_t> chainOrder(chainCount), arcOrder(arcs.size());
+	for (size_t i = 0; i < chainCount; i++)
+		chainOrder[i] = static_cast<uint32_t>(i);
+	for (size_t i = 0; i < arcs.size(); i++)
+		arcOrder[i] = static_cast<uint32_t>(i);
+	std::stable_sort(chainOrder.begin(), chainOrder.end(),
+		[&](uint32_t a, uint32_t b) { return chainPens[a] < chainPens[b]; });
+	std::stable_sort(arcOrder.begin(), arcOrder.end(),
+		[&](uint32_t a, uint32_t b) { return arcs[a].pen < arcs[b].pen; });
+	std::sort(texts.begin(), texts.end());
+
+	levels.resize(levelCount);
+	for (int l = 0; l < levelCount; l++) {
+		Level& level = levels[l];
+		const double tol = baseTolerance * std::ldexp(1.0, l);
+		level.tolerance = tol;
+		if (l > 0)
+			level.vertices.reserve(levels[l - 1].vertices.size());
+
+		size_t ci = 0, ai = 0;
+		while (ci < chainCount || ai < arcOrder.size()) {
+			uint32_t pen = ci < chainCount ? chainPens[chainOrder[ci]] : NONE;
+			if (ai < arcOrder.size())
+				pen = std::min(pen, arcs[arcOrder[ai]].pen);
+			const size_t groupStart = level.vertices.size();
+
+			for (; ci < chainCount && chainPens[chainOrder[ci]] == pen; ci++) {
+				uint32_t c = chainOrder[ci];
+				if (chainSize[c] < tol)
+					continue;
+				const double* a = points.data() + offsets[c] * 2;
+				for (uint32_t i = offsets[c] + 1; i < offsets[c + 1]; i++) {
+					if (!(pointSig[i] > tol))
+						continue;
+					const double* b = points.data() + i * 2;
+					level.vertices.push_back(static_cast<float>(a[0] - ox));
+					level.vertices.push_back(static_cast<float>(a[1] - oy));
+					level.vertices.push_back(static_cast<float>(b[0] - ox));
+					level.vertices.push_back(static_cast<float>(b[1] - oy));
+					a = b;
+				}
+			}
+			for (; ai < arcOrder.size() && arcs[arcOrder[ai]].pen == pen; ai++) {
+				const Arc& a = arcs[arcOrder[ai]];
+				double r = std::max(a.rx, a.ry);
+				double size = a.sweep >= M_PI ? 2.0 * r : 2.0 * r * std::sin(a.sweep * 0.5);
+				if (size < tol)
+					continue;
+				int segments = JWWTessellate::segmentCount(r, a.sweep, tol);
+				size_t at = level.vertices.size();
+				level.vertices.resize(at + segments * 4);
+				JWWTessellate::emitArc(level.vertices.data() + at, a.cx, a.cy, a.rx, a.ry,
+				                       a.rotation, a.start, a.sweep, segments, ox, oy);
+			}
+
+			size_t end = level.vertices.size();
+			if (end > groupStart) {
+				Group g = {pen, static_cast<uint32_t>(groupStart / 2),
+				           static_cast<uint32_t>((end - groupStart) / 2)};
+				level.groups.push_back(g);
+			}
+		}
+
+		// Texts sorted by height: everything from the first tall enough one
+		std::vector<std::pair<double, uint32_t> >::const_iterator from =
+			std::lower_bound(texts.begin(), texts.end(), std::make_pair(tol, 0u));
+		for (; from != texts.end(); ++from)
+			level.texts.push_back(from->second);
+		std::sort(level.texts.begin(), level.texts.end());
+	}
+	std::vector<Arc>().swap(arcs);
+	std::vector<std::pair<double, uint32_t> >().swap(texts);
+}
+
+int Pyramid::levelFor(double unitsPerPixel) const
+{
+	for (int i = levelCount() - 1; i > 0; i--) {
+		if (levels[i].tolerance <= unitsPerPixel)
+			return i;
+	}
+	return 0;
+}
+
+size_t Pyramid::reservedBytes() const
+{
+	size_t total = segmentXY.capacity() * sizeof(double) + segmentPens.capacity() * sizeof(uint32_t) +
+	               arcs.capacity() * sizeof(Arc) + texts.capacity() * sizeof(texts[0]) +
+	               levels.capacity() * sizeof(Level);
+	for (size_t i = 0; i < levels.size(); i++) {
+		total += levels[i].vertices.capacity() * sizeof(float) +
+		         levels[i].groups.capacity() * sizeof(Group) +
+		         levels[i].texts.capacity() * sizeof(uint32_t);
+	}
+	return total;
+}
+
+} // namespace JWWLod
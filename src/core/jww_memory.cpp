@@ -0,0 +1,244 @@
+// Heap accounting for jwwlib-wasm
+
+#include "jww_memory.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace JWWMemory {
+
+struct Account {
+	std::atomic<size_t> liveBytes;
+	std::atomic<size_t> peakBytes;
+	// One for the Owner plus one per live block charged to it
+	std::atomic<size_t> refs;
+};
+
+namespace {
+
+struct Counters {
+	std::atomic<size_t> liveBytes[CategoryCount];
+	std::atomic<size_t> allocations[CategoryCount];
+	std::atomic<size_t> frees[CategoryCount];
+	std::atomic<size_t> totalBytes;
+	std::atomic<size_t> peakBytes;
+};
+
+// Zero-initialized static storage, usable before any constructor runs
+Counters counters;
+
+thread_local Category currentCategory = Other;
+thread_local Account* currentAccount = NULL;
+
+// Accounts live in malloc'ed memory so creating one is never counted
+void releaseAccount(Account* account)
+{
+	if (account->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		account->~Account();
+		std::free(account);
+	}
+}
+
+} // namespace
+
+const char* categoryName(Category category)
+{
+	switch (category) {
+	case Input:    return "input";
+	case Document: return "document";
+	case Entities: return "entities";
+	case Index:    return "index";
+	default:       return "other";
+	}
+}
+
+Scope::Scope(Category category) : previous(currentCategory)
+{
+	currentCategory = category;
+}
+
+Scope::~Scope()
+{
+	currentCategory = previous;
+}
+
+Owner::Owner()
+{
+	void* p = std::malloc(sizeof(Account));
+	if (!p) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+		throw std::bad_alloc();
+#else
+		std::abort();
+#endif
+	}
+	account = new (p) Account();
+	account->refs.store(1, std::memory_order_relaxed);
+}
+
+Owner::~Owner()
+{
+	releaseAccount(account);
+}
+
+size_t Owner::liveBytes() const
+{
+	return account->liveBytes.load(std::memory_order_relaxed);
+}
+
+size_t Owner::peakBytes() const
+{
+	size_t peak = account->peakBytes.load(std::memory_order_relaxed);
+	size_t live = liveBytes();
+	return peak > live ? peak : live;
+}
+
+void Owner::resetPeak()
+{
+	account->peakBytes.store(liveBytes(), std::memory_order_relaxed);
+}
+
+Charge::Charge(const Owner* owner) : previous(currentAccount)
+{
+	if (owner)
+		currentAccount = owner->account;
+}
+
+Charge::~Charge()
+{
+	currentAccount = previous;
+}
+
+#ifdef JWW_MEMORY_TRACKING
+
+bool enabled()
+{
+	return true;
+}
+
+namespace {
+
+// Prefix in front of every block: requested size, owning category and
+// account. A multiple of 16 bytes keeps the payload at the alignment
+// malloc guarantees.
+struct alignas(16) BlockHeader {
+	size_t size;
+	Account* account;
+	unsigned int category;
+};
+
+void raisePeak(std::atomic<size_t>& peak, size_t value)
+{
+	size_t current = peak.load(std::memory_order_relaxed);
+	while (value > current &&
+	       !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+void* trackedAlloc(size_t size)
+{
+	BlockHeader* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+	if (!header)
+		return NULL;
+	Category category = currentCategory;
+	Account* account = currentAccount;
+	header->size = size;
+	header->account = account;
+	header->category = category;
+	counters.liveBytes[category].fetch_add(size, std::memory_order_relaxed);
+	counters.allocations[category].fetch_add(1, std::memory_order_relaxed);
+	size_t total = counters.totalBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	raisePeak(counters.peakBytes, total);
+	if (account) {
+		account->refs.fetch_add(1, std::memory_order_relaxed);
+		raisePeak(account->peakBytes,
+		          account->liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+	}
+	return header + 1;
+}
+
+void trackedFree(void* p)
+{
+	if (!p)
+		return;
+	BlockHeader* header = static_cast<BlockHeader*>(p) - 1;
+	counters.liveBytes[header->category].fetch_sub(header->size, std::memory_order_relaxed);
+	counters.frees[header->category].fetch_add(1, std::memory_order_relaxed);
+	counters.totalBytes.fetch_sub(header->size, std::memory_order_relaxed);
+	if (header->account) {
+		header->account->liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+		releaseAccount(header->account);
+	}
+	std::free(header);
+}
+
+void* trackedNew(size_t size)
+{
+	void* p = trackedAlloc(size ? size : 1);
+	if (!p) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+		throw std::bad_alloc();
+#else
+		std::abort();
+#endif
+	}
+	return p;
+}
+
+} // namespace
+
+#else
+
+bool enabled()
+{
+	return false;
+}
+
+#endif // JWW_MEMORY_TRACKING
+
+Stats snapshot()
+{
+	Stats stats;
+	stats.enabled = enabled();
+	stats.liveBytes = 0;
+	stats.allocations = 0;
+	stats.frees = 0;
+	for (int i = 0; i < CategoryCount; i++) {
+		CategoryStats& c = stats.category[i];
+		c.liveBytes = counters.liveBytes[i].load(std::memory_order_relaxed);
+		c.allocations = counters.allocations[i].load(std::memory_order_relaxed);
+		c.frees = counters.frees[i].load(std::memory_order_relaxed);
+		stats.liveBytes += c.liveBytes;
+		stats.allocations += c.allocations;
+		stats.frees += c.frees;
+	}
+	stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	if (stats.peakBytes < stats.liveBytes)
+		stats.peakBytes = stats.liveBytes;
+	return stats;
+}
+
+void resetPeak()
+{
+	counters.peakBytes.store(counters.totalBytes.load(std::memory_order_relaxed),
+	                         std::memory_order_relaxed);
+}
+
+} // namespace JWWMemory
+
+#ifdef JWW_MEMORY_TRACKING
+
+// Replacement global allocation functions. Over-aligned new/delete are left
+// to the runtime; they never reach these overloads.
+void* operator new(size_t size) { return JWWMemory::trackedNew(size); }
+void* operator new[](size_t size) { return JWWMemory::trackedNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return JWWMemory::trackedAlloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return JWWMemory::trackedAlloc(size ? size : 1); }
+void operator delete(void* p) noexcept { JWWMemory::trackedFree(p); }
+void operator delete[](void* p) noexcept { JWWMemory::trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { JWWMemory::trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { JWWMemory::trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { JWWMemory::trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { JWWMemory::trackedFree(p); }
+
+#endif // JWW_MEMORY_TRACKING
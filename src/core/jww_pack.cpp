@@ -0,0 +1,170 @@
+// Packed geometry columns for jwwlib-wasm
+
+#include "jww_pack.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace JWWPack {
+
+namespace {
+
+// Largest quantized magnitude; keeps deltas of two of them in int64
+const double MAX_STEPS = 4611686018427387904.0;	// 2^62
+
+inline uint64_t zigzag(uint64_t d) { return (d << 1) ^ (0 - (d >> 63)); }
+inline uint64_t unzigzag(uint64_t z) { return (z >> 1) ^ (0 - (z & 1)); }
+
+inline uint64_t load64(const uint8_t* p)
+{
+	uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+
+int bitWidth(uint64_t v)
+{
+	int w = 0;
+	while (v) {
+		w++;
+		v >>= 1;
+	}
+	return w;
+}
+
+} // namespace
+
+void pack(const int64_t* values, size_t count, size_t stride, std::vector<uint8_t>& out)
+{
+	if (stride == 0)
+		stride = 1;
+	uint64_t z[BLOCK];
+	for (size_t first = 0; first < count; first += BLOCK) {
+		const size_t n = std::min(BLOCK, count - first);
+		uint64_t any = 0;
+		for (size_t k = 0; k < n; k++) {
+			size_t i = first + k;
+			uint64_t prev = i >= stride ? static_cast<uint64_t>(values[i - stride]) : 0;
+			z[k] = zigzag(static_cast<uint64_t>(values[i]) - prev);
+			any |= z[k];
+		}
+		const int width = bitWidth(any);
+		out.push_back(static_cast<uint8_t>(width));
+		if (width == 0)
+			continue;
+		// LSB first through a 64-bit accumulator
+		uint64_t acc = 0;
+		int bits = 0;
+		for (size_t k = 0; k < n; k++) {
+			acc |= z[k] << bits;
+			int taken = 64 - bits;
+			bits += width;
+			if (bits >= 64) {
+				for (int b = 0; b < 8; b++)
+					out.push_back(static_cast<uint8_t>(acc >> (b * 8)));
+				bits -= 64;
+				acc = taken < 64 ? z[k] >> taken : 0;
+			}
+		}
+		for (int b = 0; b < bits; b += 8)
+			out.push_back(static_cast<uint8_t>(acc >> b));
+	}
+}
+
+size_t unpack(const uint8_t* data, size_t size, size_t count, size_t stride, int64_t* out)
+{
+	if (stride == 0)
+		stride = 1;
+	// A block copied with room for the last value's 64-bit load
+	uint8_t block[BLOCK * 8 + 16];
+	size_t pos = 0;
+	for (size_t first = 0; first < count; first += BLOCK) {
+		const size_t n = std::min(BLOCK, count - first);
+		if (pos >= size)
+			return 0;
+		const int width = data[pos++];
+		if (width > 64)
+			return 0;
+		const size_t bytes = (n * width + 7) / 8;
+		if (size - pos < bytes)
+			return 0;
+		std::memcpy(block, data + pos, bytes);
+		std::memset(block + bytes, 0, sizeof(block) - bytes);
+		pos += bytes;
+
+		int64_t* o = out + first;
+		const uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+		if (width <= 56) {
+			// A value starts at most 7 bits into its byte, so one load holds it
+			for (size_t k = 0; k < n; k++) {
+				size_t bit = k * width;
+				o[k] = static_cast<int64_t>((load64(block + (bit >> 3)) >> (bit & 7)) & mask);
+			}
+		} else {
+			for (size_t k = 0; k < n; k++) {
+				size_t bit = k * width;
+				unsigned shift = bit & 7;
+				uint64_t v = load64(block + (bit >> 3)) >> shift;
+				if (shift)
+					v |= static_cast<uint64_t>(block[(bit >> 3) + 8]) << (64 - shift);
+				o[k] = static_cast<int64_t>(v & mask);
+			}
+		}
+		// Undo the zigzag and the deltas
+		for (size_t k = 0; k < n; k++) {
+			size_t i = first + k;
+			uint64_t prev = i >= stride ? static_cast<uint64_t>(out[i - stride]) : 0;
+			out[i] = static_cast<int64_t>(prev + unzigzag(static_cast<uint64_t>(o[k])));
+		}
+	}
+	return pos;
+}
+
+double packReals(const double* values, size_t count, size_t stride, double step, std::vector<uint8_t>& out)
+{
+	std::vector<int64_t> q(count);
+	if (!(step > 0.0)) {
+		// Neighbouring values share sign, exponent and the top of the
+		// mantissa, so their bit patterns still give small deltas
+		if (count)
+			std::memcpy(q.data(), values, count * sizeof(double));
+		pack(q.data(), count, stride, out);
+		return 0.0;
+	}
+	double maxError = 0.0;
+	const double inverse = 1.0 / step;
+	for (size_t i = 0; i < count; i++) {
+		double steps = std::floor(values[i] * inverse + 0.5);
+		if (!(steps == steps)) {
+			// No multiple of step is close to NaN
+			q[i] = 0;
+			maxError = HUGE_VAL;
+			continue;
+		}
+		steps = std::max(-MAX_STEPS, std::min(MAX_STEPS, steps));
+		q[i] = static_cast<int64_t>(steps);
+		double err = std::fabs(static_cast<double>(q[i]) * step - values[i]);
+		if (err > maxError)
+			maxError = err;
+	}
+	pack(q.data(), count, stride, out);
+	return maxError;
+}
+
+size_t unpackReals(const uint8_t* data, size_t size, size_t count, size_t stride, double step, double* out)
+{
+	std::vector<int64_t> q(count);
+	size_t used = unpack(data, size, count, stride, q.data());
+	if (used == 0 && count > 0)
+		return 0;
+	if (!(step > 0.0)) {
+		if (count)
+			std::memcpy(out, q.data(), count * sizeof(double));
+		return used;
+	}
+	for (size_t i = 0; i < count; i++)
+		out[i] = static_cast<double>(q[i]) * step;
+	return used;
+}
+
+} // namespace JWWPack
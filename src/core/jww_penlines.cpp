@@ -0,0 +1,100 @@
+// Pen-bucketed line lists for jwwlib-wasm
+
+#include "jww_penlines.h"
+#include "jww_tessellate.h"
+#include <algorithm>
+
+namespace JWWPenLines {
+
+uint32_t Builder::newPen(const Pen& pen)
+{
+	std::map<Pen, uint32_t>::iterator it = penIds.find(pen);
+	if (it == penIds.end())
+		it = penIds.insert(std::make_pair(pen, static_cast<uint32_t>(penIds.size()))).first;
+	lastPen = pen;
+	lastId = it->second;
+	return lastId;
+}
+
+void Builder::addArc(double cx, double cy, double rx, double ry, double rotation,
+                     double start, double sweep, const Pen& pen)
+{
+	Item item = {NULL, static_cast<uint32_t>(arcs.size()), penId(pen)};
+	items.push_back(item);
+	Arc a = {cx, cy, rx, ry, rotation, start, sweep};
+	arcs.push_back(a);
+}
+
+void Builder::reserve(size_t itemCount, size_t arcCount)
+{
+	items.reserve(itemCount);
+	arcs.reserve(arcCount);
+}
+
+void Builder::build(double tolerance, double originX, double originY,
+                    std::vector<float>& vertices, std::vector<Group>& groups) const
+{
+	// Pass 1: rank the pens, and count every item's segments into its bucket
+	std::vector<uint32_t> rank(penIds.size());
+	groups.clear();
+	for (std::map<Pen, uint32_t>::const_iterator it = penIds.begin(); it != penIds.end(); ++it) {
+		rank[it->second] = static_cast<uint32_t>(groups.size());
+		Group g = {it->first, 0, 0};
+		groups.push_back(g);
+	}
+	std::vector<int> arcSegments(arcs.size());
+	for (size_t i = 0; i < items.size(); i++) {
+		const Item& item = items[i];
+		uint32_t count = item.index;
+		if (!item.xy) {
+			const Arc& a = arcs[item.index];
+			arcSegments[item.index] = JWWTessellate::segmentCount(std::max(a.rx, a.ry), a.sweep, tolerance);
+			count = arcSegments[item.index];
+		}
+		groups[rank[item.pen]].count += count * 2;
+	}
+
+	// Pass 2: lay the buckets out back to back
+	std::vector<size_t> cursor(groups.size());
+	size_t vertexCount = 0;
+	for (size_t g = 0; g < groups.size(); g++) {
+		groups[g].first = static_cast<uint32_t>(vertexCount);
+		cursor[g] = vertexCount;
+		vertexCount += groups[g].count;
+	}
+	vertices.resize(vertexCount * 2);
+
+	// Pass 3: write each item straight into its bucket
+	float* base = vertices.empty() ? NULL : &vertices[0];
+	for (size_t i = 0; i < items.size(); i++) {
+		const Item& item = items[i];
+		size_t& at = cursor[rank[item.pen]];
+		float* v = base + at * 2;
+		if (item.xy) {
+			const double* s = item.xy;
+			for (uint32_t k = 0; k < item.index; k++, s += 4, v += 4) {
+				v[0] = static_cast<float>(s[0] - originX);
+				v[1] = static_cast<float>(s[1] - originY);
+				v[2] = static_cast<float>(s[2] - originX);
+				v[3] = static_cast<float>(s[3] - originY);
+			}
+			at += item.index * 2;
+		} else {
+			const Arc& a = arcs[item.index];
+			int n = arcSegments[item.index];
+			JWWTessellate::emitArc(v, a.cx, a.cy, a.rx, a.ry, a.rotation, a.start, a.sweep,
+			                       n, originX, originY);
+			at += n * 2;
+		}
+	}
+}
+
+void Builder::clear()
+{
+	arcs.clear();
+	items.clear();
+	penIds.clear();
+	lastId = 0;
+}
+
+} // namespace JWWPenLines
@@ -0,0 +1,75 @@
+// Quantized coordinate buffers for jwwlib-wasm
+
+#include "jww_quant.h"
+#include <algorithm>
+#include <cmath>
+
+namespace JWWQuant {
+
+namespace {
+
+// Steps the half extent is spread over, short of INT32_MAX so values on
+// the edge still round inside the range
+const double INT32_STEPS = 2147483000.0;
+
+} // namespace
+
+Frame fit(double minX, double minY, double maxX, double maxY, Format format)
+{
+	Frame frame;
+	frame.format = format;
+	if (!(minX <= maxX) || !(minY <= maxY))
+		return frame;
+	frame.originX = minX + (maxX - minX) * 0.5;
+	frame.originY = minY + (maxY - minY) * 0.5;
+	if (format == INT32) {
+		double half = std::max(maxX - minX, maxY - minY) * 0.5;
+		frame.scale = (half > 0.0 ? half : 1.0) / INT32_STEPS;
+	}
+	return frame;
+}
+
+void Store::reset(const Frame& frame)
+{
+	frm = frame;
+	maxErr = 0;
+	floats.clear();
+	ints.clear();
+}
+
+void Store::reserve(size_t values)
+{
+	if (frm.format == INT32)
+		ints.reserve(values);
+	else
+		floats.reserve(values);
+}
+
+void Store::release()
+{
+	std::vector<float>().swap(floats);
+	std::vector<int32_t>().swap(ints);
+	maxErr = 0;
+}
+
+void Store::add(double v, double origin)
+{
+	double decoded;
+	if (frm.format == INT32) {
+		double steps = std::floor((v - origin) / frm.scale + 0.5);
+		steps = std::max(-2147483647.0, std::min(2147483647.0, steps));
+		int32_t q = static_cast<int32_t>(steps);
+		ints.push_back(q);
+		decoded = origin + q * frm.scale;
+	} else {
+		float q = static_cast<float>(v - origin);
+		floats.push_back(q);
+		decoded = origin + static_cast<double>(q);
+	}
+	// NaN input compares false and leaves the error alone
+	double err = std::fabs(decoded - v);
+	if (err > maxErr)
+		maxErr = err;
+}
+
+} // namespace JWWQuant
@@ -0,0 +1,694 @@
+// Software rasterizer for jwwlib-wasm
+
+#include "jww_raster.h"
+#include "jww_tessellate.h"
+#include "dl_creationadapter.h"
+#include "dl_jww.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace JWWRaster {
+
+namespace {
+
+inline double fpart(double v) { return v - std::floor(v); }
+
+// Clip the segment to the rectangle (Liang-Barsky); false when nothing is left
+bool clipSegment(double& x0, double& y0, double& x1, double& y1,
+                 double minX, double minY, double maxX, double maxY)
+{
+	double t0 = 0.0, t1 = 1.0;
+	const double dx = x1 - x0, dy = y1 - y0;
+	const double p[4] = {-dx, dx, -dy, dy};
+	const double q[4] = {x0 - minX, maxX - x0, y0 - minY, maxY - y0};
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0)
+				return false;
+			continue;
+		}
+		double t = q[i] / p[i];
+		if (p[i] < 0.0) {
+			if (t > t1)
+				return false;
+			t0 = std::max(t0, t);
+		} else {
+			if (t < t0)
+				return false;
+			t1 = std::min(t1, t);
+		}
+	}
+	double sx = x0, sy = y0;
+	x0 = sx + t0 * dx;
+	y0 = sy + t0 * dy;
+	x1 = sx + t1 * dx;
+	y1 = sy + t1 * dy;
+	return true;
+}
+
+} // namespace
+
+void Canvas::resize(int width, int height, uint32_t background)
+{
+	w = std::max(width, 0);
+	h = std::max(height, 0);
+	rgba.resize(static_cast<size_t>(w) * h * 4);
+	clear(background);
+}
+
+void Canvas::clear(uint32_t background)
+{
+	const uint8_t c[4] = {
+		static_cast<uint8_t>(background >> 24), static_cast<uint8_t>(background >> 16),
+		static_cast<uint8_t>(background >> 8), static_cast<uint8_t>(background)
+	};
+	for (size_t i = 0; i < rgba.size(); i += 4)
+		std::memcpy(&rgba[i], c, 4);
+}
+
+uint32_t Canvas::pixel(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= w || y >= h)
+		return 0;
+	const uint8_t* p = &rgba[(static_cast<size_t>(y) * w + x) * 4];
+	return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+void Canvas::blend(int x, int y, uint32_t color, double cover)
+{
+	if (x < 0 || y < 0 || x >= w || y >= h || !(cover > 0.0))
+		return;
+	// Non-premultiplied "over"
+	double a = (color & 0xFF) / 255.0 * std::min(cover, 1.0);
+	uint8_t* p = &rgba[(static_cast<size_t>(y) * w + x) * 4];
+	double keep = p[3] / 255.0 * (1.0 - a);
+	double out = a + keep;
+	if (!(out > 0.0))
+		return;
+	for (int i = 0; i < 3; i++) {
+		double src = (color >> (24 - 8 * i)) & 0xFF;
+		p[i] = static_cast<uint8_t>((src * a + p[i] * keep) / out + 0.5);
+	}
+	p[3] = static_cast<uint8_t>(out * 255.0 + 0.5);
+}
+
+void Canvas::drawLine(double x0, double y0, double x1, double y1, uint32_t color)
+{
+	if (w == 0 || h == 0)
+		return;
+	if (!clipSegment(x0, y0, x1, y1, -1.0, -1.0, w + 1.0, h + 1.0))
+		return;
+
+	// Xiaolin Wu with integer coordinates at pixel centers
+	x0 -= 0.5;
+	y0 -= 0.5;
+	x1 -= 0.5;
+	y1 -= 0.5;
+	const bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+	if (steep) {
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+	if (x0 > x1) {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+	}
+	const double dx = x1 - x0;
+	const double gradient = dx > 0.0 ? (y1 - y0) / dx : 0.0;
+
+#define JWW_PLOT(px, py, c) \
+	(steep ? blend((py), (px), color, (c)) : blend((px), (py), color, (c)))
+
+	double xend = std::floor(x0 + 0.5);
+	double yend = y0 + gradient * (xend - x0);
+	const int xpxl1 = static_cast<int>(xend);
+	const double xend2 = std::floor(x1 + 0.5);
+	const int xpxl2 = static_cast<int>(xend2);
+	if (xpxl1 == xpxl2) {
+		// Shorter than a pixel: one column weighted by the length
+		double ym = (y0 + y1) * 0.5;
+		int ypxl = static_cast<int>(std::floor(ym));
+		JWW_PLOT(xpxl1, ypxl, (1.0 - fpart(ym)) * dx);
+		JWW_PLOT(xpxl1, ypxl + 1, fpart(ym) * dx);
+		return;
+	}
+
+	double xgap = 1.0 - fpart(x0 + 0.5);
+	int ypxl = static_cast<int>(std::floor(yend));
+	JWW_PLOT(xpxl1, ypxl, (1.0 - fpart(yend)) * xgap);
+	JWW_PLOT(xpxl1, ypxl + 1, fpart(yend) * xgap);
+	double intery = yend + gradient;
+
+	yend = y1 + gradient * (xend2 - x1);
+	xgap = fpart(x1 + 0.5);
+	ypxl = static_cast<int>(std::floor(yend));
+	JWW_PLOT(xpxl2, ypxl, (1.0 - fpart(yend)) * xgap);
+	JWW_PLOT(xpxl2, ypxl + 1, fpart(yend) * xgap);
+
+	for (int x = xpxl1 + 1; x < xpxl2; x++) {
+		int y = static_cast<int>(std::floor(intery));
+		double f = intery - y;
+		JWW_PLOT(x, y, 1.0 - f);
+		JWW_PLOT(x, y + 1, f);
+		intery += gradient;
+	}
+#undef JWW_PLOT
+}
+
+void Canvas::drawArc(double cx, double cy, double rx, double ry, double rotation,
+                     double start, double sweep, uint32_t color)
+{
+	int segments = JWWTessellate::segmentCount(std::max(std::fabs(rx), std::fabs(ry)), sweep, 0.25);
+	arcPoints.resize(static_cast<size_t>(segments) * 4);
+	JWWTessellate::emitArc(arcPoints.data(), cx, cy, rx, ry, rotation, start, sweep, segments, 0.0, 0.0);
+	for (size_t i = 0; i < arcPoints.size(); i += 4)
+		drawLine(arcPoints[i], arcPoints[i + 1], arcPoints[i + 2], arcPoints[i + 3], color);
+}
+
+void Canvas::fillPolygon(const double* xy, int count, uint32_t color)
+{
+	if (count < 3 || w == 0 || h == 0)
+		return;
+	double minX = xy[0], maxX = xy[0], minY = xy[1], maxY = xy[1];
+	for (int i = 1; i < count; i++) {
+		minX = std::min(minX, xy[i * 2]);
+		maxX = std::max(maxX, xy[i * 2]);
+		minY = std::min(minY, xy[i * 2 + 1]);
+		maxY = std::max(maxY, xy[i * 2 + 1]);
+	}
+	if (!(maxX > 0.0) || !(maxY > 0.0) || !(minX < w) || !(minY < h))
+		return;
+	const int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+	const int x1 = std::min(w - 1, static_cast<int>(std::floor(maxX)));
+	const int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+	const int y1 = std::min(h - 1, static_cast<int>(std::floor(maxY)));
+	coverage.assign(static_cast<size_t>(w) + 1, 0.0f);
+
+	// Four sub-scanlines per row; along each, spans add their exact
+	// horizontal coverage
+	const int SUB = 4;
+	const float weight = 1.0f / SUB;
+	for (int y = y0; y <= y1; y++) {
+		for (int s = 0; s < SUB; s++) {
+			const double sy = y + (s + 0.5) / SUB;
+			crossings.clear();
+			for (int i = 0; i < count; i++) {
+				const double* a = xy + i * 2;
+				const double* b = xy + ((i + 1) % count) * 2;
+				int dir;
+				if (a[1] <= sy && b[1] > sy)
+					dir = 1;
+				else if (b[1] <= sy && a[1] > sy)
+					dir = -1;
+				else
+					continue;
+				double x = a[0] + (sy - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+				crossings.push_back(std::make_pair(x, dir));
+			}
+			std::sort(crossings.begin(), crossings.end());
+			int winding = 0;
+			double spanStart = 0.0;
+			for (size_t c = 0; c < crossings.size(); c++) {
+				int before = winding;
+				winding += crossings[c].second;
+				if (before == 0 && winding != 0) {
+					spanStart = crossings[c].first;
+				} else if (before != 0 && winding == 0) {
+					double a = std::max(spanStart, 0.0);
+					double b = std::min(crossings[c].first, static_cast<double>(w));
+					if (!(b > a))
+						continue;
+					int ia = static_cast<int>(a), ib = static_cast<int>(b);
+					if (ia == ib) {
+						coverage[ia] += static_cast<float>(b - a) * weight;
+						continue;
+					}
+					coverage[ia] += static_cast<float>(ia + 1 - a) * weight;
+					for (int i = ia + 1; i < ib; i++)
+						coverage[i] += weight;
+					coverage[ib] += static_cast<float>(b - ib) * weight;
+				}
+			}
+		}
+		for (int x = x0; x <= x1; x++) {
+			if (coverage[x] > 0.0f) {
+				blend(x, y, color, coverage[x]);
+				coverage[x] = 0.0f;
+			}
+		}
+	}
+}
+
+uint32_t aciToRGBA(int color, uint32_t background)
+{
+	if (color < 1 || color > 255 || color == 7) {
+		// Pick black or white against the background
+		double luma = 0.299 * (background >> 24) + 0.587 * ((background >> 16) & 0xFF)
+		            + 0.114 * ((background >> 8) & 0xFF);
+		return luma >= 128.0 || (background & 0xFF) < 128 ? BLACK : WHITE;
+	}
+	uint32_t rgba = 0xFF;
+	for (int i = 0; i < 3; i++)
+		rgba |= static_cast<uint32_t>(dxfColors[color][i] * 255.0 + 0.5) << (24 - 8 * i);
+	return rgba;
+}
+
+namespace {
+
+// Geometry of a drawing in drawing units, with its bounds
+class Scene : public DL_CreationAdapter {
+public:
+	struct Stroke {
+		double cx, cy, rx, ry, rotation, start, sweep;	// sweep 0: line from (cx, cy) to (rx, ry)
+		int color;
+	};
+	struct Fill {
+		double xy[8];
+		int color;
+	};
+
+	std::vector<Stroke> strokes;
+	std::vector<Fill> solids;
+	std::vector<Fill> texts;
+	double minX, minY, maxX, maxY;
+
+	Scene() : minX(HUGE_VAL), minY(HUGE_VAL), maxX(-HUGE_VAL), maxY(-HUGE_VAL) {}
+
+	bool empty() const { return !(maxX >= minX) || !(maxY >= minY); }
+
+	void addLine(const DL_LineData& d) override {
+		Stroke s = {d.x1, d.y1, d.x2, d.y2, 0.0, 0.0, 0.0, attributes.getColor()};
+		strokes.push_back(s);
+		include(d.x1, d.y1);
+		include(d.x2, d.y2);
+	}
+	void addArc(const DL_ArcData& d) override {
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 360.0;
+		addCurve(d.cx, d.cy, d.radius, d.radius, 0.0, d.angle1 * M_PI / 180.0, sweep * M_PI / 180.0);
+	}
+	void addCircle(const DL_CircleData& d) override {
+		addCurve(d.cx, d.cy, d.radius, d.radius, 0.0, 0.0, 2.0 * M_PI);
+	}
+	void addEllipse(const DL_EllipseData& d) override {
+		// Major axis end point relative to the center
+		double rx = std::hypot(d.mx, d.my);
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 2.0 * M_PI;
+		addCurve(d.cx, d.cy, rx, rx * d.ratio, std::atan2(d.my, d.mx), d.angle1, sweep);
+	}
+	void addSolid(const DL_SolidData& d) override {
+		// DXF order 1, 2, 4, 3 walks the outline
+		static const int order[4] = {0, 1, 3, 2};
+		Fill f;
+		for (int i = 0; i < 4; i++) {
+			f.xy[i * 2] = d.x[order[i]];
+			f.xy[i * 2 + 1] = d.y[order[i]];
+			include(f.xy[i * 2], f.xy[i * 2 + 1]);
+		}
+		f.color = attributes.getColor();
+		solids.push_back(f);
+	}
+	void addText(const DL_TextData& d) override {
+		// Shift-JIS bytes are half-width cells: bytes * height / 2 long
+		double tw = d.text.size() * d.height * 0.5 * (d.xScaleFactor > 0.0 ? d.xScaleFactor : 1.0);
+		double th = d.height;
+		if (!(tw > 0.0) || !(th > 0.0))
+			return;
+		double c = std::cos(d.angle), s = std::sin(d.angle);
+		Fill f;
+		const double bx[4] = {0.0, tw, tw, 0.0};
+		const double by[4] = {0.0, 0.0, th, th};
+		for (int i = 0; i < 4; i++) {
+			f.xy[i * 2] = d.ipx + bx[i] * c - by[i] * s;
+			f.xy[i * 2 + 1] = d.ipy + bx[i] * s + by[i] * c;
+			include(f.xy[i * 2], f.xy[i * 2 + 1]);
+		}
+		f.color = attributes.getColor();
+		texts.push_back(f);
+	}
+
+private:
+	void include(double x, double y) {
+		if (!std::isfinite(x) || !std::isfinite(y))
+			return;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+
+	void addCurve(double cx, double cy, double rx, double ry, double rotation,
+	              double start, double sweep) {
+		Stroke s = {cx, cy, rx, ry, rotation, start, sweep, attributes.getColor()};
+		strokes.push_back(s);
+		double box[4];
+		JWWTessellate::arcBounds(cx, cy, rx, ry, rotation, start, sweep, box);
+		include(box[0], box[1]);
+		include(box[2], box[3]);
+	}
+};
+
+} // namespace
+
+bool renderThumbnail(const char* data, size_t size, const Options& options, Canvas& canvas)
+{
+	canvas.resize(options.width, options.height, options.background);
+	Scene scene;
+	DL_Jww reader;
+	if (!reader.in(data, size, &scene))
+		return false;
+	if (scene.empty() || canvas.width() == 0 || canvas.height() == 0)
+		return true;
+
+	// Fit the bounds inside the margin, centered, y up
+	const double bw = scene.maxX - scene.minX, bh = scene.maxY - scene.minY;
+	const double aw = std::max(1, canvas.width() - 2 * options.margin);
+	const double ah = std::max(1, canvas.height() - 2 * options.margin);
+	double scale = 1.0;
+	if (bw > 0.0 && bh > 0.0)
+		scale = std::min(aw / bw, ah / bh);
+	else if (bw > 0.0)
+		scale = aw / bw;
+	else if (bh > 0.0)
+		scale = ah / bh;
+	const double midX = (scene.minX + scene.maxX) * 0.5, midY = (scene.minY + scene.maxY) * 0.5;
+	const double ox = canvas.width() * 0.5, oy = canvas.height() * 0.5;
+	std::vector<double> xy(8);
+	auto fill = [&](const Scene::Fill& f, uint32_t color) {
+		for (int i = 0; i < 4; i++) {
+			xy[i * 2] = ox + (f.xy[i * 2] - midX) * scale;
+			xy[i * 2 + 1] = oy - (f.xy[i * 2 + 1] - midY) * scale;
+		}
+		canvas.fillPolygon(xy.data(), 4, color);
+	};
+
+	for (size_t i = 0; i < scene.solids.size(); i++)
+		fill(scene.solids[i], aciToRGBA(scene.solids[i].color, options.background));
+	if (options.drawTexts) {
+		for (size_t i = 0; i < scene.texts.size(); i++)
+			fill(scene.texts[i], (aciToRGBA(scene.texts[i].color, options.background) & 0xFFFFFF00u) | 0x60);
+	}
+	for (size_t i = 0; i < scene.strokes.size(); i++) {
+		const Scene::Stroke& s = scene.strokes[i];
+		uint32_t color = aciToRGBA(s.color, options.background);
+		double cx = ox + (s.cx - midX) * scale, cy = oy - (s.cy - midY) * scale;
+		if (s.sweep == 0.0) {
+			canvas.drawLine(cx, cy, ox + (s.rx - midX) * scale, oy - (s.ry - midY) * scale, color);
+		} else {
+			// Flipping y mirrors the angles
+			canvas.drawArc(cx, cy, s.rx * scale, s.ry * scale, -s.rotation, -s.start, -s.sweep, color);
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// PNG
+
+namespace {
+
+struct CrcTable {
+	uint32_t t[256];
+	CrcTable() {
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+	}
+};
+
+// Deflate fixed Huffman codes, bit-reversed for LSB-first output
+struct FixedCodes {
+	uint16_t lit[288];
+	uint8_t litLen[288];
+	uint8_t dist[30];
+
+	static uint16_t reverse(uint32_t code, int len) {
+		uint32_t r = 0;
+		for (int i = 0; i < len; i++)
+			r |= ((code >> i) & 1) << (len - 1 - i);
+		return static_cast<uint16_t>(r);
+	}
+
+	FixedCodes() {
+		for (int v = 0; v < 288; v++) {
+			uint32_t code;
+			int len;
+			if (v < 144) {
+				code = 0x30 + v;
+				len = 8;
+			} else if (v < 256) {
+				code = 0x190 + (v - 144);
+				len = 9;
+			} else if (v < 280) {
+				code = v - 256;
+				len = 7;
+			} else {
+				code = 0xC0 + (v - 280);
+				len = 8;
+			}
+			lit[v] = reverse(code, len);
+			litLen[v] = static_cast<uint8_t>(len);
+		}
+		for (int d = 0; d < 30; d++)
+			dist[d] = static_cast<uint8_t>(reverse(d, 5));
+	}
+};
+
+const uint16_t LENGTH_BASE[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t LENGTH_EXTRA[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DIST_BASE[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DIST_EXTRA[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+class BitWriter {
+public:
+	explicit BitWriter(std::vector<uint8_t>& o) : out(o), bits(0), count(0) {}
+	void put(uint32_t value, int n) {
+		bits |= static_cast<uint64_t>(value) << count;
+		count += n;
+		while (count >= 8) {
+			out.push_back(static_cast<uint8_t>(bits));
+			bits >>= 8;
+			count -= 8;
+		}
+	}
+	void flush() {
+		if (count > 0)
+			out.push_back(static_cast<uint8_t>(bits));
+		bits = 0;
+		count = 0;
+	}
+private:
+	std::vector<uint8_t>& out;
+	uint64_t bits;
+	int count;
+};
+
+// One final fixed-Huffman block; greedy LZ77 over a 32 KiB window with
+// short hash chains, which suits the long runs of filtered thumbnails
+void deflateFixed(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	static const FixedCodes codes;
+	const int WINDOW = 32768, HASH_BITS = 15, MAX_CHAIN = 32, MIN_MATCH = 3, MAX_MATCH = 258;
+	std::vector<int32_t> head(1 << HASH_BITS, -1);
+	std::vector<int32_t> prev(WINDOW, -1);
+	BitWriter bw(out);
+	bw.put(1, 1);	// BFINAL
+	bw.put(1, 2);	// fixed Huffman
+
+	auto hash = [&](size_t i) {
+		uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+		return (v * 2654435761u) >> (32 - HASH_BITS);
+	};
+	auto insert = [&](size_t i) {
+		if (i + MIN_MATCH > size)
+			return;
+		uint32_t hv = hash(i);
+		prev[i & (WINDOW - 1)] = head[hv];
+		head[hv] = static_cast<int32_t>(i);
+	};
+	auto literal = [&](int v) { bw.put(codes.lit[v], codes.litLen[v]); };
+
+	size_t i = 0;
+	while (i < size) {
+		int bestLen = 0;
+		size_t bestDist = 0;
+		if (i + MIN_MATCH <= size) {
+			const size_t maxLen = std::min<size_t>(MAX_MATCH, size - i);
+			int32_t cand = head[hash(i)];
+			for (int chain = 0; cand >= 0 && chain < MAX_CHAIN; chain++) {
+				size_t dist = i - cand;
+				if (dist > static_cast<size_t>(WINDOW - 1) || dist == 0)
+					break;
+				const uint8_t* a = data + cand;
+				const uint8_t* b = data + i;
+				if (a[bestLen] == b[bestLen]) {
+					size_t len = 0;
+					while (len < maxLen && a[len] == b[len])
+						len++;
+					if (static_cast<int>(len) > bestLen) {
+						bestLen = static_cast<int>(len);
+						bestDist = dist;
+						if (len == maxLen)
+							break;
+					}
+				}
+				int32_t next = prev[cand & (WINDOW - 1)];
+				if (next >= cand)
+					break;
+				cand = next;
+			}
+		}
+		if (bestLen >= MIN_MATCH) {
+			int lc = 28;
+			while (LENGTH_BASE[lc] > bestLen)
+				lc--;
+			literal(257 + lc);
+			bw.put(bestLen - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+			int dc = 29;
+			while (DIST_BASE[dc] > bestDist)
+				dc--;
+			bw.put(codes.dist[dc], 5);
+			bw.put(static_cast<uint32_t>(bestDist - DIST_BASE[dc]), DIST_EXTRA[dc]);
+			for (int k = 0; k < bestLen; k++)
+				insert(i + k);
+			i += bestLen;
+		} else {
+			literal(data[i]);
+			insert(i);
+			i++;
+		}
+	}
+	literal(256);
+	bw.flush();
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t v)
+{
+	out.push_back(static_cast<uint8_t>(v >> 24));
+	out.push_back(static_cast<uint8_t>(v >> 16));
+	out.push_back(static_cast<uint8_t>(v >> 8));
+	out.push_back(static_cast<uint8_t>(v));
+}
+
+void putChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+{
+	putU32(out, static_cast<uint32_t>(size));
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data, data + size);
+	putU32(out, crc32(&out[start], out.size() - start));
+}
+
+inline int paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+	static const CrcTable table;
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table.t[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+	uint32_t a = adler & 0xFFFF, b = adler >> 16;
+	while (size > 0) {
+		// 5552 bytes keep the sums below 2^32 between reductions
+		size_t n = std::min<size_t>(size, 5552);
+		size -= n;
+		while (n--) {
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+void encodePNG(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& out)
+{
+	out.clear();
+	static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	out.insert(out.end(), SIGNATURE, SIGNATURE + 8);
+
+	std::vector<uint8_t> ihdr;
+	putU32(ihdr, static_cast<uint32_t>(width));
+	putU32(ihdr, static_cast<uint32_t>(height));
+	const uint8_t rest[5] = {8, 6, 0, 0, 0};	// 8-bit RGBA, deflate, adaptive filters, no interlace
+	ihdr.insert(ihdr.end(), rest, rest + 5);
+	putChunk(out, "IHDR", ihdr.data(), ihdr.size());
+
+	// Per row, the filter with the smallest sum of absolute residuals
+	const size_t stride = static_cast<size_t>(width) * 4;
+	std::vector<uint8_t> filtered;
+	filtered.reserve((stride + 1) * height);
+	std::vector<uint8_t> trial[5];
+	for (int f = 0; f < 5; f++)
+		trial[f].resize(stride);
+	for (int y = 0; y < height; y++) {
+		const uint8_t* row = rgba + y * stride;
+		const uint8_t* up = y > 0 ? row - stride : nullptr;
+		int best = 0;
+		uint64_t bestSum = UINT64_MAX;
+		for (int f = 0; f < 5; f++) {
+			if (y == 0 && (f == 2 || f == 4))
+				continue;
+			uint64_t sum = 0;
+			for (size_t x = 0; x < stride; x++) {
+				int a = x >= 4 ? row[x - 4] : 0;
+				int b = up ? up[x] : 0;
+				int c = up && x >= 4 ? up[x - 4] : 0;
+				int p = f == 0 ? 0 : f == 1 ? a : f == 2 ? b : f == 3 ? (a + b) >> 1 : paeth(a, b, c);
+				uint8_t r = static_cast<uint8_t>(row[x] - p);
+				trial[f][x] = r;
+				sum += r < 128 ? r : 256 - r;
+			}
+			if (sum < bestSum) {
+				bestSum = sum;
+				best = f;
+			}
+		}
+		filtered.push_back(static_cast<uint8_t>(best));
+		filtered.insert(filtered.end(), trial[best].begin(), trial[best].end());
+	}
+
+	std::vector<uint8_t> z;
+	z.push_back(0x78);
+	z.push_back(0x01);
+	deflateFixed(filtered.data(), filtered.size(), z);
+	putU32(z, adler32(filtered.data(), filtered.size()));
+	putChunk(out, "IDAT", z.data(), z.size());
+	putChunk(out, "IEND", nullptr, 0);
+}
+
+} // namespace JWWRaster
@@ -0,0 +1,531 @@
+// Vectorized geometry kernels for jwwlib-wasm
+// Backend is chosen at compile time:
+//   -msimd128 (Emscripten)  -> wasm_simd128.h
+//   -mavx (native)          -> 256-bit AVX
+//   x86-64 default          -> 128-bit SSE2; the angle kernels use the
+//                              SSE4.1 floor, picked at run time unless
+//                              -msse4.1 makes it the baseline
+//   otherwise               -> scalar reference code
+
+#include "jww_simd.h"
+
+#include <cmath>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define JWW_SIMD_WASM 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define JWW_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JWW_SIMD_SSE2 1
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#define JWW_SSE41_TARGET
+#elif defined(__GNUC__)
+#include <smmintrin.h>
+#define JWW_SSE41_TARGET __attribute__((target("sse4.1")))
+#define JWW_SSE41_DISPATCH 1
+#endif
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace JWWSimd {
+
+static const double TWO_PI = M_PI * 2.0;
+
+/////////////////////////////////////////////////////////////////////////////
+// Scalar reference
+/////////////////////////////////////////////////////////////////////////////
+namespace scalar {
+
+void computeBounds(const double* xy, size_t count, Bounds& bounds)
+{
+	if (count == 0)
+		return;
+	size_t i = 0;
+	if (!bounds.valid) {
+		bounds.minX = bounds.maxX = xy[0];
+		bounds.minY = bounds.maxY = xy[1];
+		bounds.valid = true;
+		i = 1;
+	}
+	for (; i < count; i++) {
+		double x = xy[i * 2];
+		double y = xy[i * 2 + 1];
+		if (x < bounds.minX) bounds.minX = x;
+		if (x > bounds.maxX) bounds.maxX = x;
+		if (y < bounds.minY) bounds.minY = y;
+		if (y > bounds.maxY) bounds.maxY = y;
+	}
+}
+
+void transformPoints(const double* in, double* out, size_t count, const double m[6])
+{
+	for (size_t i = 0; i < count; i++) {
+		double x = in[i * 2];
+		double y = in[i * 2 + 1];
+		out[i * 2]     = m[0] * x + m[2] * y + m[4];
+		out[i * 2 + 1] = m[1] * x + m[3] * y + m[5];
+	}
+}
+
+void normalizeAngles(double* angles, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		angles[i] = angles[i] - std::floor(angles[i] / TWO_PI) * TWO_PI;
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	normalizeAngles(start, count);
+	normalizeAngles(end, count);
+	for (size_t i = 0; i < count; i++) {
+		if (end[i] <= start[i])
+			start[i] = start[i] - TWO_PI;
+	}
+}
+
+void toFloat(const double* in, float* out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = static_cast<float>(in[i]);
+}
+
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale)
+{
+	for (size_t i = 0; i < count; i++) {
+		out[i * 2]     = static_cast<float>((xy[i * 2] - originX) * scale);
+		out[i * 2 + 1] = static_cast<float>((xy[i * 2 + 1] - originY) * scale);
+	}
+}
+
+} // namespace scalar
+
+/////////////////////////////////////////////////////////////////////////////
+// WebAssembly SIMD128
+/////////////////////////////////////////////////////////////////////////////
+#if defined(JWW_SIMD_WASM)
+
+const char* backend() { return "wasm-simd128"; }
+
+void computeBounds(const double* xy, size_t count, Bounds& bounds)
+{
+	if (count < 4) {
+		scalar::computeBounds(xy, count, bounds);
+		return;
+	}
+	v128_t mn0, mx0;
+	if (bounds.valid) {
+		mn0 = wasm_f64x2_make(bounds.minX, bounds.minY);
+		mx0 = wasm_f64x2_make(bounds.maxX, bounds.maxY);
+	} else {
+		mn0 = mx0 = wasm_v128_load(xy);
+	}
+	v128_t mn1 = mn0, mx1 = mx0;
+	size_t i = 0;
+	// Each vector holds one (x, y) point; two accumulators hide latency.
+	for (; i + 2 <= count; i += 2) {
+		v128_t p0 = wasm_v128_load(xy + i * 2);
+		v128_t p1 = wasm_v128_load(xy + i * 2 + 2);
+		mn0 = wasm_f64x2_pmin(mn0, p0);
+		mx0 = wasm_f64x2_pmax(mx0, p0);
+		mn1 = wasm_f64x2_pmin(mn1, p1);
+		mx1 = wasm_f64x2_pmax(mx1, p1);
+	}
+	mn0 = wasm_f64x2_pmin(mn0, mn1);
+	mx0 = wasm_f64x2_pmax(mx0, mx1);
+	bounds.minX = wasm_f64x2_extract_lane(mn0, 0);
+	bounds.minY = wasm_f64x2_extract_lane(mn0, 1);
+	bounds.maxX = wasm_f64x2_extract_lane(mx0, 0);
+	bounds.maxY = wasm_f64x2_extract_lane(mx0, 1);
+	bounds.valid = true;
+	scalar::computeBounds(xy + i * 2, count - i, bounds);
+}
+
+void transformPoints(const double* in, double* out, size_t count, const double m[6])
+{
+	const v128_t a = wasm_f64x2_splat(m[0]), b = wasm_f64x2_splat(m[1]);
+	const v128_t c = wasm_f64x2_splat(m[2]), d = wasm_f64x2_splat(m[3]);
+	const v128_t e = wasm_f64x2_splat(m[4]), f = wasm_f64x2_splat(m[5]);
+	size_t i = 0;
+	// Deinterleave two points into (x0, x1) / (y0, y1), transform, re-interleave
+	for (; i + 2 <= count; i += 2) {
+		v128_t p0 = wasm_v128_load(in + i * 2);
+		v128_t p1 = wasm_v128_load(in + i * 2 + 2);
+		v128_t xx = wasm_i64x2_shuffle(p0, p1, 0, 2);
+		v128_t yy = wasm_i64x2_shuffle(p0, p1, 1, 3);
+		v128_t rx = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(a, xx), wasm_f64x2_mul(c, yy)), e);
+		v128_t ry = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(b, xx), wasm_f64x2_mul(d, yy)), f);
+		wasm_v128_store(out + i * 2, wasm_i64x2_shuffle(rx, ry, 0, 2));
+		wasm_v128_store(out + i * 2 + 2, wasm_i64x2_shuffle(rx, ry, 1, 3));
+	}
+	scalar::transformPoints(in + i * 2, out + i * 2, count - i, m);
+}
+
+static inline v128_t wrapAngles(v128_t a, v128_t twoPi)
+{
+	v128_t turns = wasm_f64x2_floor(wasm_f64x2_div(a, twoPi));
+	return wasm_f64x2_sub(a, wasm_f64x2_mul(turns, twoPi));
+}
+
+void normalizeAngles(double* angles, size_t count)
+{
+	const v128_t twoPi = wasm_f64x2_splat(TWO_PI);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+		wasm_v128_store(angles + i, wrapAngles(wasm_v128_load(angles + i), twoPi));
+	scalar::normalizeAngles(angles + i, count - i);
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	const v128_t twoPi = wasm_f64x2_splat(TWO_PI);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		v128_t s = wrapAngles(wasm_v128_load(start + i), twoPi);
+		v128_t e = wrapAngles(wasm_v128_load(end + i), twoPi);
+		v128_t back = wasm_v128_and(wasm_f64x2_le(e, s), twoPi);
+		wasm_v128_store(start + i, wasm_f64x2_sub(s, back));
+		wasm_v128_store(end + i, e);
+	}
+	scalar::normalizeArcAngles(start + i, end + i, count - i);
+}
+
+void toFloat(const double* in, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		v128_t lo = wasm_f32x4_demote_f64x2_zero(wasm_v128_load(in + i));
+		v128_t hi = wasm_f32x4_demote_f64x2_zero(wasm_v128_load(in + i + 2));
+		wasm_v128_store(out + i, wasm_i32x4_shuffle(lo, hi, 0, 1, 4, 5));
+	}
+	scalar::toFloat(in + i, out + i, count - i);
+}
+
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale)
+{
+	const v128_t origin = wasm_f64x2_make(originX, originY);
+	const v128_t s = wasm_f64x2_splat(scale);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		v128_t p0 = wasm_f64x2_mul(wasm_f64x2_sub(wasm_v128_load(xy + i * 2), origin), s);
+		v128_t p1 = wasm_f64x2_mul(wasm_f64x2_sub(wasm_v128_load(xy + i * 2 + 2), origin), s);
+		v128_t lo = wasm_f32x4_demote_f64x2_zero(p0);
+		v128_t hi = wasm_f32x4_demote_f64x2_zero(p1);
+		wasm_v128_store(out + i * 2, wasm_i32x4_shuffle(lo, hi, 0, 1, 4, 5));
+	}
+	scalar::toFloatRelative(xy + i * 2, out + i * 2, count - i, originX, originY, scale);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AVX (256-bit, two points per register)
+/////////////////////////////////////////////////////////////////////////////
+#elif defined(JWW_SIMD_AVX)
+
+const char* backend() { return "avx"; }
+
+void computeBounds(const double* xy, size_t count, Bounds& bounds)
+{
+	if (count < 4) {
+		scalar::computeBounds(xy, count, bounds);
+		return;
+	}
+	__m128d seedMin, seedMax;
+	if (bounds.valid) {
+		seedMin = _mm_set_pd(bounds.minY, bounds.minX);
+		seedMax = _mm_set_pd(bounds.maxY, bounds.maxX);
+	} else {
+		seedMin = seedMax = _mm_loadu_pd(xy);
+	}
+	__m256d mn = _mm256_set_m128d(seedMin, seedMin);
+	__m256d mx = _mm256_set_m128d(seedMax, seedMax);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256d p = _mm256_loadu_pd(xy + i * 2);
+		mn = _mm256_min_pd(p, mn);
+		mx = _mm256_max_pd(p, mx);
+	}
+	__m128d lo = _mm_min_pd(_mm256_extractf128_pd(mn, 1), _mm256_castpd256_pd128(mn));
+	__m128d hi = _mm_max_pd(_mm256_extractf128_pd(mx, 1), _mm256_castpd256_pd128(mx));
+	double tmp[2];
+	_mm_storeu_pd(tmp, lo);
+	bounds.minX = tmp[0];
+	bounds.minY = tmp[1];
+	_mm_storeu_pd(tmp, hi);
+	bounds.maxX = tmp[0];
+	bounds.maxY = tmp[1];
+	bounds.valid = true;
+	scalar::computeBounds(xy + i * 2, count - i, bounds);
+}
+
+void transformPoints(const double* in, double* out, size_t count, const double m[6])
+{
+	const __m256d ab = _mm256_set_pd(m[1], m[0], m[1], m[0]);
+	const __m256d cd = _mm256_set_pd(m[3], m[2], m[3], m[2]);
+	const __m256d ef = _mm256_set_pd(m[5], m[4], m[5], m[4]);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256d p = _mm256_loadu_pd(in + i * 2);
+		__m256d xx = _mm256_movedup_pd(p);
+		__m256d yy = _mm256_permute_pd(p, 0xF);
+		__m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ab, xx), _mm256_mul_pd(cd, yy)), ef);
+		_mm256_storeu_pd(out + i * 2, r);
+	}
+	scalar::transformPoints(in + i * 2, out + i * 2, count - i, m);
+}
+
+static inline __m256d wrapAngles(__m256d a, __m256d twoPi)
+{
+	__m256d turns = _mm256_floor_pd(_mm256_div_pd(a, twoPi));
+	return _mm256_sub_pd(a, _mm256_mul_pd(turns, twoPi));
+}
+
+void normalizeAngles(double* angles, size_t count)
+{
+	const __m256d twoPi = _mm256_set1_pd(TWO_PI);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm256_storeu_pd(angles + i, wrapAngles(_mm256_loadu_pd(angles + i), twoPi));
+	scalar::normalizeAngles(angles + i, count - i);
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	const __m256d twoPi = _mm256_set1_pd(TWO_PI);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256d s = wrapAngles(_mm256_loadu_pd(start + i), twoPi);
+		__m256d e = wrapAngles(_mm256_loadu_pd(end + i), twoPi);
+		__m256d back = _mm256_and_pd(_mm256_cmp_pd(e, s, _CMP_LE_OQ), twoPi);
+		_mm256_storeu_pd(start + i, _mm256_sub_pd(s, back));
+		_mm256_storeu_pd(end + i, e);
+	}
+	scalar::normalizeArcAngles(start + i, end + i, count - i);
+}
+
+void toFloat(const double* in, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+	scalar::toFloat(in + i, out + i, count - i);
+}
+
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale)
+{
+	const __m256d origin = _mm256_set_pd(originY, originX, originY, originX);
+	const __m256d s = _mm256_set1_pd(scale);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256d p = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(xy + i * 2), origin), s);
+		_mm_storeu_ps(out + i * 2, _mm256_cvtpd_ps(p));
+	}
+	scalar::toFloatRelative(xy + i * 2, out + i * 2, count - i, originX, originY, scale);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SSE2 (128-bit, one point per register)
+/////////////////////////////////////////////////////////////////////////////
+#elif defined(JWW_SIMD_SSE2)
+
+const char* backend() { return "sse2"; }
+
+void computeBounds(const double* xy, size_t count, Bounds& bounds)
+{
+	if (count < 4) {
+		scalar::computeBounds(xy, count, bounds);
+		return;
+	}
+	__m128d mn0, mx0;
+	if (bounds.valid) {
+		mn0 = _mm_set_pd(bounds.minY, bounds.minX);
+		mx0 = _mm_set_pd(bounds.maxY, bounds.maxX);
+	} else {
+		mn0 = mx0 = _mm_loadu_pd(xy);
+	}
+	__m128d mn1 = mn0, mx1 = mx0;
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128d p0 = _mm_loadu_pd(xy + i * 2);
+		__m128d p1 = _mm_loadu_pd(xy + i * 2 + 2);
+		mn0 = _mm_min_pd(p0, mn0);
+		mx0 = _mm_max_pd(p0, mx0);
+		mn1 = _mm_min_pd(p1, mn1);
+		mx1 = _mm_max_pd(p1, mx1);
+	}
+	mn0 = _mm_min_pd(mn1, mn0);
+	mx0 = _mm_max_pd(mx1, mx0);
+	double tmp[2];
+	_mm_storeu_pd(tmp, mn0);
+	bounds.minX = tmp[0];
+	bounds.minY = tmp[1];
+	_mm_storeu_pd(tmp, mx0);
+	bounds.maxX = tmp[0];
+	bounds.maxY = tmp[1];
+	bounds.valid = true;
+	scalar::computeBounds(xy + i * 2, count - i, bounds);
+}
+
+void transformPoints(const double* in, double* out, size_t count, const double m[6])
+{
+	const __m128d a = _mm_set1_pd(m[0]), b = _mm_set1_pd(m[1]);
+	const __m128d c = _mm_set1_pd(m[2]), d = _mm_set1_pd(m[3]);
+	const __m128d e = _mm_set1_pd(m[4]), f = _mm_set1_pd(m[5]);
+	size_t i = 0;
+	// Deinterleave two points into (x0, x1) / (y0, y1), transform, re-interleave
+	for (; i + 2 <= count; i += 2) {
+		__m128d p0 = _mm_loadu_pd(in + i * 2);
+		__m128d p1 = _mm_loadu_pd(in + i * 2 + 2);
+		__m128d xx = _mm_unpacklo_pd(p0, p1);
+		__m128d yy = _mm_unpackhi_pd(p0, p1);
+		__m128d rx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, xx), _mm_mul_pd(c, yy)), e);
+		__m128d ry = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b, xx), _mm_mul_pd(d, yy)), f);
+		_mm_storeu_pd(out + i * 2, _mm_unpacklo_pd(rx, ry));
+		_mm_storeu_pd(out + i * 2 + 2, _mm_unpackhi_pd(rx, ry));
+	}
+	scalar::transformPoints(in + i * 2, out + i * 2, count - i, m);
+}
+
+#if defined(JWW_SSE41_TARGET)
+JWW_SSE41_TARGET static inline __m128d wrapAngles(__m128d a, __m128d twoPi)
+{
+	__m128d turns = _mm_floor_pd(_mm_div_pd(a, twoPi));
+	return _mm_sub_pd(a, _mm_mul_pd(turns, twoPi));
+}
+
+JWW_SSE41_TARGET static void normalizeAnglesSse41(double* angles, size_t count)
+{
+	const __m128d twoPi = _mm_set1_pd(TWO_PI);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+		_mm_storeu_pd(angles + i, wrapAngles(_mm_loadu_pd(angles + i), twoPi));
+	scalar::normalizeAngles(angles + i, count - i);
+}
+
+JWW_SSE41_TARGET static void normalizeArcAnglesSse41(double* start, double* end, size_t count)
+{
+	const __m128d twoPi = _mm_set1_pd(TWO_PI);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128d s = wrapAngles(_mm_loadu_pd(start + i), twoPi);
+		__m128d e = wrapAngles(_mm_loadu_pd(end + i), twoPi);
+		__m128d back = _mm_and_pd(_mm_cmple_pd(e, s), twoPi);
+		_mm_storeu_pd(start + i, _mm_sub_pd(s, back));
+		_mm_storeu_pd(end + i, e);
+	}
+	scalar::normalizeArcAngles(start + i, end + i, count - i);
+}
+
+// SSE2 has no packed floor; without SSE4.1 the scalar loop is what the
+// compiler would emit anyway
+static bool hasSse41()
+{
+#if defined(JWW_SSE41_DISPATCH)
+	static const bool has = __builtin_cpu_supports("sse4.1");
+	return has;
+#else
+	return true;
+#endif
+}
+
+void normalizeAngles(double* angles, size_t count)
+{
+	if (hasSse41())
+		normalizeAnglesSse41(angles, count);
+	else
+		scalar::normalizeAngles(angles, count);
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	if (hasSse41())
+		normalizeArcAnglesSse41(start, end, count);
+	else
+		scalar::normalizeArcAngles(start, end, count);
+}
+#else
+void normalizeAngles(double* angles, size_t count)
+{
+	scalar::normalizeAngles(angles, count);
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	scalar::normalizeArcAngles(start, end, count);
+}
+#endif
+
+void toFloat(const double* in, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+		_mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+	}
+	scalar::toFloat(in + i, out + i, count - i);
+}
+
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale)
+{
+	const __m128d origin = _mm_set_pd(originY, originX);
+	const __m128d s = _mm_set1_pd(scale);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(xy + i * 2), origin), s));
+		__m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(xy + i * 2 + 2), origin), s));
+		_mm_storeu_ps(out + i * 2, _mm_movelh_ps(lo, hi));
+	}
+	scalar::toFloatRelative(xy + i * 2, out + i * 2, count - i, originX, originY, scale);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// No vector ISA
+/////////////////////////////////////////////////////////////////////////////
+#else
+
+const char* backend() { return "scalar"; }
+
+void computeBounds(const double* xy, size_t count, Bounds& bounds)
+{
+	scalar::computeBounds(xy, count, bounds);
+}
+
+void transformPoints(const double* in, double* out, size_t count, const double m[6])
+{
+	scalar::transformPoints(in, out, count, m);
+}
+
+void normalizeAngles(double* angles, size_t count)
+{
+	scalar::normalizeAngles(angles, count);
+}
+
+void normalizeArcAngles(double* start, double* end, size_t count)
+{
+	scalar::normalizeArcAngles(start, end, count);
+}
+
+void toFloat(const double* in, float* out, size_t count)
+{
+	scalar::toFloat(in, out, count);
+}
+
+void toFloatRelative(const double* xy, float* out, size_t count,
+                     double originX, double originY, double scale)
+{
+	scalar::toFloatRelative(xy, out, count, originX, originY, scale);
+}
+
+#endif
+
+} // namespace JWWSimd
@@ -0,0 +1,79 @@
+// Shift_JIS to UTF-8 for jwwlib-wasm
+
+#include "jww_sjis.h"
+#include <stdint.h>
+
+namespace JWWSjis {
+
+namespace {
+
+#include "jww_sjis_table.inc"
+
+const uint32_t REPLACEMENT = 0xFFFD;
+
+// Row of CP932_TABLE for a lead byte, or -1 when it has none
+inline int leadRow(unsigned char lead)
+{
+	if (lead >= 0x81 && lead <= 0x9F)
+		return lead - 0x81;
+	if (lead >= 0xE0 && lead <= 0xEF)
+		return lead - 0xE0 + 31;
+	if (lead >= 0xFA && lead <= 0xFC)
+		return lead - 0xFA + 47;
+	return -1;
+}
+
+inline bool isLead(unsigned char c)
+{
+	return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC);
+}
+
+inline bool isTrail(unsigned char c)
+{
+	return c >= 0x40 && c <= 0xFC && c != 0x7F;
+}
+
+inline void putUtf8(uint32_t c, std::string& out)
+{
+	if (c < 0x80) {
+		out.push_back(static_cast<char>(c));
+	} else if (c < 0x800) {
+		out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+		out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+	} else {
+		out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+	}
+}
+
+} // namespace
+
+void appendUtf8(const char* data, size_t size, std::string& out)
+{
+	const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		unsigned char c = s[i];
+		if (c < 0x80) {
+			out.push_back(static_cast<char>(c));
+		} else if (c >= 0xA1 && c <= 0xDF) {
+			// Half-width katakana
+			putUtf8(0xFF61 + (c - 0xA1), out);
+		} else if (isLead(c) && i + 1 < size && isTrail(s[i + 1])) {
+			unsigned char t = s[++i];
+			uint32_t code;
+			int row = leadRow(c);
+			if (row >= 0) {
+				code = CP932_TABLE[row][t - 0x40];
+			} else {
+				// User-defined characters 0xF040-0xF9FC: private use area
+				code = 0xE000 + (c - 0xF0) * 188 + (t - 0x40) - (t > 0x7F ? 1 : 0);
+			}
+			putUtf8(code ? code : REPLACEMENT, out);
+		} else {
+			putUtf8(REPLACEMENT, out);
+		}
+	}
+}
+
+} // namespace JWWSjis
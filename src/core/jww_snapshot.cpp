@@ -0,0 +1,556 @@
+// Columnar binary snapshot of a parsed JWW document for jwwlib-wasm
+
+#include "jww_snapshot.h"
+#include "jww_sjis.h"
+#include "jww_stream.h"
+#include "jwwdoc.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace JWWSnapshot {
+
+static_assert(sizeof(FileHeader) == 64, "snapshot header must stay 64 bytes");
+static_assert(sizeof(SectionEntry) == 16, "snapshot directory entries must stay 16 bytes");
+
+namespace {
+
+const char* const SFIG_FLAG = "@@SfigorgFlag@@";
+const int MAX_COLUMNS = 20;
+const size_t ALIGN = 8;
+
+struct ColumnSpec {
+	Kind kind;
+	int column;
+	Type type;
+};
+
+#define PEN_COLUMNS(kind) \
+	{ kind, PEN_LAYER, TYPE_U8 }, { kind, PEN_COLOR, TYPE_U16 }, { kind, PEN_STYLE, TYPE_U8 }, \
+	{ kind, PEN_WIDTH, TYPE_U16 }, { kind, PEN_BLOCK, TYPE_U32 }
+
+// Every column a snapshot contains, in file order
+const ColumnSpec SCHEMA[] = {
+	PEN_COLUMNS(KIND_LINE),
+	{ KIND_LINE, LINE_X1, TYPE_F64 }, { KIND_LINE, LINE_Y1, TYPE_F64 },
+	{ KIND_LINE, LINE_X2, TYPE_F64 }, { KIND_LINE, LINE_Y2, TYPE_F64 },
+
+	PEN_COLUMNS(KIND_ARC),
+	{ KIND_ARC, ARC_X, TYPE_F64 }, { KIND_ARC, ARC_Y, TYPE_F64 }, { KIND_ARC, ARC_RADIUS, TYPE_F64 },
+	{ KIND_ARC, ARC_START, TYPE_F64 }, { KIND_ARC, ARC_SWEEP, TYPE_F64 }, { KIND_ARC, ARC_TILT, TYPE_F64 },
+	{ KIND_ARC, ARC_RATIO, TYPE_F64 }, { KIND_ARC, ARC_FULL, TYPE_U8 },
+
+	PEN_COLUMNS(KIND_POINT),
+	{ KIND_POINT, POINT_X, TYPE_F64 }, { KIND_POINT, POINT_Y, TYPE_F64 },
+	{ KIND_POINT, POINT_ANGLE, TYPE_F64 }, { KIND_POINT, POINT_SCALE, TYPE_F64 },
+	{ KIND_POINT, POINT_CODE, TYPE_U32 }, { KIND_POINT, POINT_TEMPORARY, TYPE_U8 },
+
+	PEN_COLUMNS(KIND_TEXT),
+	{ KIND_TEXT, TEXT_X1, TYPE_F64 }, { KIND_TEXT, TEXT_Y1, TYPE_F64 },
+	{ KIND_TEXT, TEXT_X2, TYPE_F64 }, { KIND_TEXT, TEXT_Y2, TYPE_F64 },
+	{ KIND_TEXT, TEXT_WIDTH, TYPE_F64 }, { KIND_TEXT, TEXT_HEIGHT, TYPE_F64 },
+	{ KIND_TEXT, TEXT_SPACING, TYPE_F64 }, { KIND_TEXT, TEXT_ANGLE, TYPE_F64 },
+	{ KIND_TEXT, TEXT_KIND, TYPE_U32 }, { KIND_TEXT, TEXT_FONT, TYPE_U32 }, { KIND_TEXT, TEXT_STRING, TYPE_U32 },
+
+	PEN_COLUMNS(KIND_SOLID),
+	{ KIND_SOLID, SOLID_X1, TYPE_F64 }, { KIND_SOLID, SOLID_Y1, TYPE_F64 },
+	{ KIND_SOLID, SOLID_X2, TYPE_F64 }, { KIND_SOLID, SOLID_Y2, TYPE_F64 },
+	{ KIND_SOLID, SOLID_X3, TYPE_F64 }, { KIND_SOLID, SOLID_Y3, TYPE_F64 },
+	{ KIND_SOLID, SOLID_X4, TYPE_F64 }, { KIND_SOLID, SOLID_Y4, TYPE_F64 },
+	{ KIND_SOLID, SOLID_RGB, TYPE_U32 },
+
+	PEN_COLUMNS(KIND_DIMENSION),
+	{ KIND_DIMENSION, DIMENSION_X1, TYPE_F64 }, { KIND_DIMENSION, DIMENSION_Y1, TYPE_F64 },
+	{ KIND_DIMENSION, DIMENSION_X2, TYPE_F64 }, { KIND_DIMENSION, DIMENSION_Y2, TYPE_F64 },
+	{ KIND_DIMENSION, DIMENSION_LABEL_X, TYPE_F64 }, { KIND_DIMENSION, DIMENSION_LABEL_Y, TYPE_F64 },
+	{ KIND_DIMENSION, DIMENSION_LABEL_HEIGHT, TYPE_F64 }, { KIND_DIMENSION, DIMENSION_LABEL_ANGLE, TYPE_F64 },
+	{ KIND_DIMENSION, DIMENSION_LABEL, TYPE_U32 },
+
+	PEN_COLUMNS(KIND_INSERT),
+	{ KIND_INSERT, INSERT_X, TYPE_F64 }, { KIND_INSERT, INSERT_Y, TYPE_F64 },
+	{ KIND_INSERT, INSERT_SCALE_X, TYPE_F64 }, { KIND_INSERT, INSERT_SCALE_Y, TYPE_F64 },
+	{ KIND_INSERT, INSERT_ANGLE, TYPE_F64 }, { KIND_INSERT, INSERT_NUMBER, TYPE_U32 },
+
+	{ KIND_BLOCK, BLOCK_NUMBER, TYPE_U32 }, { KIND_BLOCK, BLOCK_NAME, TYPE_U32 }, { KIND_BLOCK, BLOCK_COUNT, TYPE_U32 },
+
+	{ KIND_LAYER, LAYER_NAME, TYPE_U32 }, { KIND_LAYER, LAYER_STATE, TYPE_U32 },
+	{ KIND_LAYER, LAYER_GROUP_NAME, TYPE_U32 }, { KIND_LAYER, LAYER_GROUP_STATE, TYPE_U32 },
+	{ KIND_LAYER, LAYER_GROUP_SCALE, TYPE_F64 },
+
+	{ KIND_STRING, STRING_OFFSETS, TYPE_U32 }, { KIND_STRING, STRING_BYTES, TYPE_U8 },
+};
+
+#undef PEN_COLUMNS
+
+const size_t SECTION_COUNT = sizeof(SCHEMA) / sizeof(SCHEMA[0]);
+
+size_t typeSize(uint8_t type) {
+	switch (type) {
+	case TYPE_U8: return 1;
+	case TYPE_U16: return 2;
+	case TYPE_U32: return 4;
+	case TYPE_F64: return 8;
+	default: return 0;
+	}
+}
+
+size_t padded(size_t n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+
+bool littleEndian() {
+	const uint16_t one = 1;
+	unsigned char first;
+	std::memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t read64(const unsigned char* p) {
+	uint64_t v;
+	std::memcpy(&v, p, 8);
+	return v;
+}
+
+uint32_t read32(const unsigned char* p) {
+	uint32_t v;
+	std::memcpy(&v, p, 4);
+	return v;
+}
+
+const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t round64(uint64_t acc, uint64_t input) {
+	acc += input * PRIME2;
+	acc = rotl(acc, 31);
+	return acc * PRIME1;
+}
+
+uint64_t merge64(uint64_t acc, uint64_t v) {
+	acc ^= round64(0, v);
+	return acc * PRIME1 + PRIME4;
+}
+
+// One growing array per column
+struct Column {
+	std::string bytes;
+	size_t rows;
+
+	Column() : rows(0) {}
+
+	template<class T>
+	void push(T v) {
+		bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+		rows++;
+	}
+};
+
+// Collects the records into columns as they are decoded
+class Builder : public JWWRecordHandler {
+public:
+	Builder() : records(0), blocks(0), jwwVersion(0), paper(0), memo(0), block(NO_BLOCK) {
+		// String 0 is ""
+		columns[KIND_STRING][STRING_OFFSETS].push(static_cast<uint32_t>(0));
+		ids[std::string()] = 0;
+	}
+
+	jwBOOL WantsBlockLists() override { return true; }
+
+	void OnHeader(JWWHead& h) override;
+	void OnBlockList(CDataList& d) override;
+	// A record past the end of a definition belongs to the drawing again
+	void OnBlockListEnd() override { block = NO_BLOCK; }
+	void OnSen(CDataSen& d) override {
+		Column* c = entity(KIND_LINE, d);
+		c[LINE_X1].push(d.m_start.x);
+		c[LINE_Y1].push(d.m_start.y);
+		c[LINE_X2].push(d.m_end.x);
+		c[LINE_Y2].push(d.m_end.y);
+	}
+	void OnEnko(CDataEnko& d) override {
+		Column* c = entity(KIND_ARC, d);
+		c[ARC_X].push(d.m_start.x);
+		c[ARC_Y].push(d.m_start.y);
+		c[ARC_RADIUS].push(d.m_dHankei);
+		c[ARC_START].push(d.m_radKaishiKaku);
+		c[ARC_SWEEP].push(d.m_radEnkoKaku);
+		c[ARC_TILT].push(d.m_radKatamukiKaku);
+		c[ARC_RATIO].push(d.m_dHenpeiRitsu);
+		c[ARC_FULL].push(static_cast<uint8_t>(d.m_bZenEnFlg != 0));
+	}
+	void OnTen(CDataTen& d) override {
+		Column* c = entity(KIND_POINT, d);
+		c[POINT_X].push(d.m_start.x);
+		c[POINT_Y].push(d.m_start.y);
+		c[POINT_ANGLE].push(d.m_radKaitenKaku);
+		c[POINT_SCALE].push(d.m_dBairitsu);
+		c[POINT_CODE].push(static_cast<uint32_t>(d.m_nCode));
+		c[POINT_TEMPORARY].push(static_cast<uint8_t>(d.m_bKariten != 0));
+	}
+	void OnMoji(CDataMoji& d) override {
+		Column* c = entity(KIND_TEXT, d);
+		c[TEXT_X1].push(d.m_start.x);
+		c[TEXT_Y1].push(d.m_start.y);
+		c[TEXT_X2].push(d.m_end.x);
+		c[TEXT_Y2].push(d.m_end.y);
+		c[TEXT_WIDTH].push(d.m_dSizeX);
+		c[TEXT_HEIGHT].push(d.m_dSizeY);
+		c[TEXT_SPACING].push(d.m_dKankaku);
+		c[TEXT_ANGLE].push(d.m_degKakudo);
+		c[TEXT_KIND].push(static_cast<uint32_t>(d.m_nMojiShu));
+		c[TEXT_FONT].push(intern(d.m_strFontName));
+		c[TEXT_STRING].push(intern(d.m_string));
+	}
+	void OnSolid(CDataSolid& d) override {
+		Column* c = entity(KIND_SOLID, d);
+		c[SOLID_X1].push(d.m_start.x);
+		c[SOLID_Y1].push(d.m_start.y);
+		c[SOLID_X2].push(d.m_DPoint2.x);
+		c[SOLID_Y2].push(d.m_DPoint2.y);
+		c[SOLID_X3].push(d.m_DPoint3.x);
+		c[SOLID_Y3].push(d.m_DPoint3.y);
+		c[SOLID_X4].push(d.m_end.x);
+		c[SOLID_Y4].push(d.m_end.y);
+		c[SOLID_RGB].push(static_cast<uint32_t>(d.m_nPenColor == 10 ? d.m_Color : 0));
+	}
+	void OnSunpou(CDataSunpou& d) override {
+		Column* c = entity(KIND_DIMENSION, d);
+		c[DIMENSION_X1].push(d.m_Sen.m_start.x);
+		c[DIMENSION_Y1].push(d.m_Sen.m_start.y);
+		c[DIMENSION_X2].push(d.m_Sen.m_end.x);
+		c[DIMENSION_Y2].push(d.m_Sen.m_end.y);
+		c[DIMENSION_LABEL_X].push(d.m_Moji.m_start.x);
+		c[DIMENSION_LABEL_Y].push(d.m_Moji.m_start.y);
+		c[DIMENSION_LABEL_HEIGHT].push(d.m_Moji.m_dSizeY);
+		c[DIMENSION_LABEL_ANGLE].push(d.m_Moji.m_degKakudo);
+		c[DIMENSION_LABEL].push(intern(d.m_Moji.m_string));
+	}
+	void OnBlock(CDataBlock& d) override {
+		Column* c = entity(KIND_INSERT, d);
+		c[INSERT_X].push(d.m_DPKijunTen.x);
+		c[INSERT_Y].push(d.m_DPKijunTen.y);
+		c[INSERT_SCALE_X].push(d.m_dBairitsuX);
+		c[INSERT_SCALE_Y].push(d.m_dBairitsuY);
+		c[INSERT_ANGLE].push(d.m_radKaitenKaku);
+		c[INSERT_NUMBER].push(static_cast<uint32_t>(d.m_n_Number));
+	}
+
+	// Lay the columns out after the header and directory
+	void serialize(uint64_t sourceHash, uint64_t sourceSize, std::string& out);
+
+	size_t strings() const { return ids.size(); }
+
+	size_t records;
+	size_t blocks;
+
+private:
+	// Pen columns of a new record; the columns of its kind are returned
+	Column* entity(Kind kind, const CData& d) {
+		Column* c = columns[kind];
+		c[PEN_LAYER].push(static_cast<uint8_t>((d.m_nGLayer & 0xF) * 16 + (d.m_nLayer & 0xF)));
+		c[PEN_COLOR].push(static_cast<uint16_t>(d.m_nPenColor));
+		c[PEN_STYLE].push(static_cast<uint8_t>(d.m_nPenStyle));
+		c[PEN_WIDTH].push(static_cast<uint16_t>(d.m_nPenWidth));
+		c[PEN_BLOCK].push(block);
+		records++;
+		return c;
+	}
+
+	// Id of a Shift_JIS string, converted and added on first use
+	uint32_t intern(const std::string& sjis) {
+		std::unordered_map<std::string, uint32_t>::const_iterator it = ids.find(sjis);
+		if (it != ids.end())
+			return it->second;
+		Column* s = columns[KIND_STRING];
+		uint32_t id = static_cast<uint32_t>(s[STRING_OFFSETS].rows - 1);
+		JWWSjis::appendUtf8(sjis.data(), sjis.size(), s[STRING_BYTES].bytes);
+		s[STRING_BYTES].rows = s[STRING_BYTES].bytes.size();
+		s[STRING_OFFSETS].push(static_cast<uint32_t>(s[STRING_BYTES].rows));
+		ids[sjis] = id;
+		return id;
+	}
+
+	Column columns[KIND_COUNT][MAX_COLUMNS];
+	std::unordered_map<std::string, uint32_t> ids;
+	uint32_t jwwVersion;
+	uint32_t paper;
+	uint32_t memo;
+	uint32_t block;
+};
+
+void Builder::OnHeader(JWWHead& h)
+{
+	jwwVersion = h.JW_DATA_VERSION;
+	paper = h.m_nZumen;
+	memo = intern(h.m_strMemo);
+	Column* c = columns[KIND_LAYER];
+	for (int g = 0; g < 16; g++) {
+		for (int l = 0; l < 16; l++) {
+			c[LAYER_NAME].push(intern(h.m_aStrLayName[g][l]));
+			c[LAYER_STATE].push(static_cast<uint32_t>(h.GLay[g].m_nLay[l].m_aanLay));
+		}
+		c[LAYER_GROUP_NAME].push(intern(h.m_aStrGLayName[g]));
+		c[LAYER_GROUP_STATE].push(static_cast<uint32_t>(h.GLay[g].m_anGLay));
+		c[LAYER_GROUP_SCALE].push(h.GLay[g].m_adScale);
+	}
+}
+
+void Builder::OnBlockList(CDataList& d)
+{
+	const std::string& name = d.m_strName;
+	size_t at = name.find(SFIG_FLAG);
+	Column* c = columns[KIND_BLOCK];
+	c[BLOCK_NUMBER].push(static_cast<uint32_t>(d.m_nNumber));
+	c[BLOCK_NAME].push(intern(at == std::string::npos ? name : name.substr(0, at)));
+	c[BLOCK_COUNT].push(static_cast<uint32_t>(d.Count));
+	blocks++;
+	block = static_cast<uint32_t>(d.m_nNumber);
+}
+
+void Builder::serialize(uint64_t sourceHash, uint64_t sourceSize, std::string& out)
+{
+	size_t offset = padded(sizeof(FileHeader) + SECTION_COUNT * sizeof(SectionEntry));
+	SectionEntry directory[SECTION_COUNT];
+	for (size_t i = 0; i < SECTION_COUNT; i++) {
+		const ColumnSpec& spec = SCHEMA[i];
+		const Column& c = columns[spec.kind][spec.column];
+		SectionEntry& e = directory[i];
+		e.id = static_cast<uint16_t>(spec.kind << 8 | spec.column);
+		e.type = static_cast<uint8_t>(spec.type);
+		e.reserved = 0;
+		e.count = static_cast<uint32_t>(c.rows);
+		e.offset = offset;
+		offset += padded(c.bytes.size());
+	}
+
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sectionCount = static_cast<uint32_t>(SECTION_COUNT);
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.fileSize = offset;
+	header.jwwVersion = jwwVersion;
+	header.paper = paper;
+	header.memo = memo;
+
+	out.assign(offset, '\0');
+	char* p = &out[0];
+	std::memcpy(p, &header, sizeof(header));
+	std::memcpy(p + sizeof(header), directory, sizeof(directory));
+	for (size_t i = 0; i < SECTION_COUNT; i++) {
+		const std::string& bytes = columns[SCHEMA[i].kind][SCHEMA[i].column].bytes;
+		if (!bytes.empty())
+			std::memcpy(p + directory[i].offset, bytes.data(), bytes.size());
+	}
+}
+
+} // namespace
+
+uint64_t hash(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* const end = p + size;
+	uint64_t h;
+	if (size >= 32) {
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+		const unsigned char* const limit = end - 32;
+		do {
+			v1 = round64(v1, read64(p));
+			v2 = round64(v2, read64(p + 8));
+			v3 = round64(v3, read64(p + 16));
+			v4 = round64(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge64(h, v1);
+		h = merge64(h, v2);
+		h = merge64(h, v3);
+		h = merge64(h, v4);
+	} else {
+		h = seed + PRIME5;
+	}
+	h += static_cast<uint64_t>(size);
+
+	for (; p + 8 <= end; p += 8) {
+		h ^= round64(0, read64(p));
+		h = rotl(h, 27) * PRIME1 + PRIME4;
+	}
+	if (p + 4 <= end) {
+		h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+		h = rotl(h, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= (*p) * PRIME5;
+		h = rotl(h, 11) * PRIME1;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+bool write(const char* data, size_t size, std::string& out, Stats* stats)
+{
+	out.clear();
+	if (!littleEndian())
+		return false;
+	std::string ifile(""), ofile("");
+	JWWMemoryBuf input(data, size);
+	JWWDocument doc(ifile, ofile);
+	doc.AttachInput(&input);
+	Builder builder;
+	doc.pHandler = &builder;
+	// Read() succeeds once the header parses; a cut or corrupt record list
+	// writes no snapshot
+	bool ok = doc.Read() && doc.RecordsComplete() && !doc.ReadState.Corrupt;
+	doc.pHandler = NULL;
+	if (!ok)
+		return false;
+	builder.serialize(hash(data, size), size, out);
+	if (stats) {
+		stats->records = builder.records;
+		stats->blocks = builder.blocks;
+		stats->strings = builder.strings();
+		stats->bytes = out.size();
+	}
+	return true;
+}
+
+bool writeFile(const std::string& input, const std::string& output, Stats* stats)
+{
+	std::ifstream in(input.c_str(), std::ios::binary);
+	if (!in)
+		return false;
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	std::string snapshot;
+	if (!write(data.data(), data.size(), snapshot, stats))
+		return false;
+	std::ofstream out(output.c_str(), std::ios::binary);
+	if (!out)
+		return false;
+	out.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+	if (!out.flush()) {
+		out.close();
+		std::remove(output.c_str());
+		return false;
+	}
+	return true;
+}
+
+View::View() : base(NULL), sections(NULL), offsets(NULL), bytes(NULL), strings(0) {}
+
+bool View::open(const void* data, size_t size)
+{
+	*this = View();
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	if (!p || !littleEndian() || reinterpret_cast<uintptr_t>(p) % ALIGN != 0 || size < sizeof(FileHeader))
+		return false;
+	const FileHeader& h = *reinterpret_cast<const FileHeader*>(p);
+	if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION || h.fileSize > size)
+		return false;
+	if (h.sectionCount > (size - sizeof(FileHeader)) / sizeof(SectionEntry))
+		return false;
+	const SectionEntry* dir = reinterpret_cast<const SectionEntry*>(p + sizeof(FileHeader));
+	for (uint32_t i = 0; i < h.sectionCount; i++) {
+		size_t width = typeSize(dir[i].type);
+		if (width == 0 || dir[i].offset % ALIGN != 0 || dir[i].offset > h.fileSize ||
+		    dir[i].count > (h.fileSize - dir[i].offset) / width)
+			return false;
+	}
+
+	base = p;
+	sections = dir;
+	// The string table must be consistent for string() to stay in bounds
+	size_t rows = 0, byteCount = 0;
+	const uint32_t* o = column<uint32_t>(KIND_STRING, STRING_OFFSETS, &rows);
+	const uint8_t* b = column<uint8_t>(KIND_STRING, STRING_BYTES, &byteCount);
+	if (!o || !b || rows == 0 || o[0] != 0) {
+		*this = View();
+		return false;
+	}
+	for (size_t i = 1; i < rows; i++) {
+		if (o[i] < o[i - 1] || o[i] > byteCount) {
+			*this = View();
+			return false;
+		}
+	}
+	offsets = o;
+	bytes = reinterpret_cast<const char*>(b);
+	strings = rows - 1;
+	return true;
+}
+
+const void* View::find(Kind kind, int column, Type type, size_t* rows) const
+{
+	if (rows)
+		*rows = 0;
+	if (!base)
+		return NULL;
+	const uint16_t id = static_cast<uint16_t>(kind << 8 | column);
+	for (uint32_t i = 0; i < header().sectionCount; i++) {
+		if (sections[i].id != id)
+			continue;
+		if (sections[i].type != type)
+			return NULL;
+		if (rows)
+			*rows = sections[i].count;
+		return base + sections[i].offset;
+	}
+	return NULL;
+}
+
+size_t View::count(Kind kind) const
+{
+	int first;
+	switch (kind) {
+	case KIND_BLOCK: first = BLOCK_NUMBER; break;
+	case KIND_LAYER: first = LAYER_NAME; break;
+	case KIND_STRING: return strings;
+	default: first = PEN_LAYER; break;
+	}
+	if (!base)
+		return 0;
+	const uint16_t id = static_cast<uint16_t>(kind << 8 | first);
+	for (uint32_t i = 0; i < header().sectionCount; i++) {
+		if (sections[i].id == id)
+			return sections[i].count;
+	}
+	return 0;
+}
+
+size_t View::stringCount() const
+{
+	return strings;
+}
+
+const char* View::string(uint32_t id, size_t* length) const
+{
+	if (id >= strings) {
+		*length = 0;
+		return "";
+	}
+	*length = offsets[id + 1] - offsets[id];
+	return bytes + offsets[id];
+}
+
+std::string View::string(uint32_t id) const
+{
+	size_t n;
+	const char* s = string(id, &n);
+	return std::string(s, n);
+}
+
+} // namespace JWWSnapshot
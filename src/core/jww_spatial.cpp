@@ -0,0 +1,312 @@
+// Spatial index for jwwlib-wasm
+
+#include "jww_spatial.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace JWWSpatial {
+
+// Branch-free Hilbert index (rawrunprotected, "2D Hilbert curves in O(1)")
+uint32_t hilbertIndex(uint32_t x, uint32_t y)
+{
+	uint32_t a = x ^ y;
+	uint32_t b = 0xFFFF ^ a;
+	uint32_t c = 0xFFFF ^ (x | y);
+	uint32_t d = x & (y ^ 0xFFFF);
+
+	uint32_t A = a | (b >> 1);
+	uint32_t B = (a >> 1) ^ a;
+	uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+	uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+	a = A; b = B; c = C; d = D;
+	A = (a & (a >> 2)) ^ (b & (b >> 2));
+	B = (a & (b >> 2)) ^ (b & ((a ^ b) >> 2));
+	C ^= (a & (c >> 2)) ^ (b & (d >> 2));
+	D ^= (b & (c >> 2)) ^ ((a ^ b) & (d >> 2));
+
+	a = A; b = B; c = C; d = D;
+	A = (a & (a >> 4)) ^ (b & (b >> 4));
+	B = (a & (b >> 4)) ^ (b & ((a ^ b) >> 4));
+	C ^= (a & (c >> 4)) ^ (b & (d >> 4));
+	D ^= (b & (c >> 4)) ^ ((a ^ b) & (d >> 4));
+
+	a = A; b = B; c = C; d = D;
+	C ^= (a & (c >> 8)) ^ (b & (d >> 8));
+	D ^= (b & (c >> 8)) ^ ((a ^ b) & (d >> 8));
+
+	a = C ^ (C >> 1);
+	b = D ^ (D >> 1);
+
+	uint32_t i0 = x ^ y;
+	uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+	i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+	i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+	i0 = (i0 | (i0 << 2)) & 0x33333333;
+	i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+	i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+	i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+	i1 = (i1 | (i1 << 2)) & 0x33333333;
+	i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+	return (i1 << 1) | i0;
+}
+
+void PackedRTree::clear()
+{
+	itemCount = 0;
+	bounds = Box();
+	nodes.clear();
+	links.clear();
+	levelEnd.clear();
+	itemPosition.clear();
+}
+
+void PackedRTree::build(const std::vector<Box>& items)
+{
+	clear();
+	itemCount = items.size();
+	if (itemCount == 0)
+		return;
+
+	bounds = items[0];
+	for (size_t i = 1; i < itemCount; i++) {
+		bounds.minX = std::min(bounds.minX, items[i].minX);
+		bounds.minY = std::min(bounds.minY, items[i].minY);
+		bounds.maxX = std::max(bounds.maxX, items[i].maxX);
+		bounds.maxY = std::max(bounds.maxY, items[i].maxY);
+	}
+
+	// Sort items by the Hilbert index of their centers
+	const double scaleX = bounds.maxX > bounds.minX ? 65535.0 / (bounds.maxX - bounds.minX) : 0.0;
+	const double scaleY = bounds.maxY > bounds.minY ? 65535.0 / (bounds.maxY - bounds.minY) : 0.0;
+	std::vector<std::pair<uint32_t, uint32_t> > order(itemCount);
+	for (size_t i = 0; i < itemCount; i++) {
+		const Box& b = items[i];
+		uint32_t hx = static_cast<uint32_t>(((b.minX + b.maxX) * 0.5 - bounds.minX) * scaleX);
+		uint32_t hy = static_cast<uint32_t>(((b.minY + b.maxY) * 0.5 - bounds.minY) * scaleY);
+		order[i] = std::make_pair(hilbertIndex(hx, hy), static_cast<uint32_t>(i));
+	}
+	std::sort(order.begin(), order.end());
+
+	// Total node count: leaves plus every packed level above them
+	size_t total = itemCount;
+	for (size_t n = itemCount; n > 1; ) {
+		n = (n + NODE_SIZE - 1) / NODE_SIZE;
+		total += n;
+	}
+	nodes.resize(total);
+	links.resize(total);
+	itemPosition.resize(itemCount);
+
+	for (size_t i = 0; i < itemCount; i++) {
+		uint32_t id = order[i].second;
+		nodes[i] = items[id];
+		links[i] = id;
+		itemPosition[id] = static_cast<uint32_t>(i);
+	}
+	levelEnd.push_back(itemCount);
+
+	// Pack each level into parents of NODE_SIZE children
+	size_t levelStart = 0;
+	size_t pos = itemCount;
+	while (levelEnd.back() - levelStart > 1) {
+		size_t end = levelEnd.back();
+		for (size_t child = levelStart; child < end; child += NODE_SIZE) {
+			size_t last = std::min(child + NODE_SIZE, end);
+			Box box = nodes[child];
+			for (size_t k = child + 1; k < last; k++) {
+				box.minX = std::min(box.minX, nodes[k].minX);
+				box.minY = std::min(box.minY, nodes[k].minY);
+				box.maxX = std::max(box.maxX, nodes[k].maxX);
+				box.maxY = std::max(box.maxY, nodes[k].maxY);
+			}
+			nodes[pos] = box;
+			links[pos] = static_cast<uint32_t>(child);
+			pos++;
+		}
+		levelStart = end;
+		levelEnd.push_back(pos);
+	}
+}
+
+void PackedRTree::query(double minX, double minY, double maxX, double maxY,
+                        std::vector<uint32_t>& out) const
+{
+	if (itemCount == 0)
+		return;
+	const Box q(minX, minY, maxX, maxY);
+
+	struct Range { size_t start, end, level; };
+	Range stack[NODE_SIZE * 16];
+	size_t top = 0;
+	size_t rootLevel = levelEnd.size() - 1;
+	stack[top++] = Range{rootLevel == 0 ? 0 : levelEnd[rootLevel - 1], levelEnd[rootLevel], rootLevel};
+
+	while (top > 0) {
+		Range r = stack[--top];
+		for (size_t pos = r.start; pos < r.end; pos++) {
+			if (!q.intersects(nodes[pos]))
+				continue;
+			if (r.level == 0) {
+				out.push_back(links[pos]);
+			} else {
+				size_t first = links[pos];
+				size_t last = std::min(first + NODE_SIZE, levelEnd[r.level - 1]);
+				stack[top++] = Range{first, last, r.level - 1};
+			}
+		}
+	}
+}
+
+void PointKDTree::clear()
+{
+	ids.clear();
+	coords.clear();
+}
+
+namespace {
+
+struct KDPoint {
+	double v[2];
+	uint32_t id;
+};
+
+// Order [first, last) into an implicit KD-tree: the median of each range on
+// the current axis, then both halves on the other axis
+void sortKD(KDPoint* first, KDPoint* last, int axis)
+{
+	if (last - first < 2)
+		return;
+	KDPoint* mid = first + (last - first - 1) / 2;
+	std::nth_element(first, mid, last,
+		[axis](const KDPoint& a, const KDPoint& b) { return a.v[axis] < b.v[axis]; });
+	sortKD(first, mid, 1 - axis);
+	sortKD(mid + 1, last, 1 - axis);
+}
+
+} // namespace
+
+void PointKDTree::build(const std::vector<double>& xy)
+{
+	size_t n = xy.size() / 2;
+	// Sort copies of the points rather than ids, so comparisons stay in cache
+	std::vector<KDPoint> points(n);
+	for (size_t i = 0; i < n; i++) {
+		points[i].v[0] = xy[i * 2];
+		points[i].v[1] = xy[i * 2 + 1];
+		points[i].id = static_cast<uint32_t>(i);
+	}
+	sortKD(points.data(), points.data() + n, 0);
+
+	ids.resize(n);
+	coords.resize(n * 2);
+	for (size_t i = 0; i < n; i++) {
+		ids[i] = points[i].id;
+		coords[i * 2] = points[i].v[0];
+		coords[i * 2 + 1] = points[i].v[1];
+	}
+}
+
+long PointKDTree::nearest(double x, double y, double maxDistance, double* distance) const
+{
+	if (ids.empty())
+		return -1;
+
+	struct Range { size_t left, right; int axis; };
+	Range stack[128];
+	size_t top = 0;
+	stack[top++] = Range{0, ids.size() - 1, 0};
+
+	long best = -1;
+	double bestSq = maxDistance * maxDistance;
+	while (top > 0) {
+		Range r = stack[--top];
+		if (r.right < r.left)
+			continue;
+		size_t m = (r.left + r.right) / 2;
+		double dx = coords[m * 2] - x;
+		double dy = coords[m * 2 + 1] - y;
+		double d = dx * dx + dy * dy;
+		if (d <= bestSq) {
+			bestSq = d;
+			best = static_cast<long>(m);
+		}
+		if (r.left == r.right)
+			continue;
+
+		double diff = r.axis == 0 ? x - coords[m * 2] : y - coords[m * 2 + 1];
+		Range lower = Range{r.left, m == 0 ? 0 : m - 1, 1 - r.axis};
+		Range upper = Range{m + 1, r.right, 1 - r.axis};
+		bool lowerValid = m > r.left;
+		// Far side first so the near side is popped (and tightens bestSq) first
+		if (diff < 0) {
+			if (diff * diff <= bestSq)
+				stack[top++] = upper;
+			if (lowerValid)
+				stack[top++] = lower;
+		} else {
+			if (lowerValid && diff * diff <= bestSq)
+				stack[top++] = lower;
+			stack[top++] = upper;
+		}
+	}
+	if (best < 0)
+		return -1;
+	if (distance)
+		*distance = std::sqrt(bestSq);
+	return ids[best];
+}
+
+double distanceToSegment(double px, double py, double x1, double y1,
+                         double x2, double y2, double& qx, double& qy)
+{
+	double dx = x2 - x1, dy = y2 - y1;
+	double len2 = dx * dx + dy * dy;
+	double t = len2 > 0.0 ? ((px - x1) * dx + (py - y1) * dy) / len2 : 0.0;
+	t = std::max(0.0, std::min(1.0, t));
+	qx = x1 + t * dx;
+	qy = y1 + t * dy;
+	return std::hypot(px - qx, py - qy);
+}
+
+double distanceToArc(double px, double py, double cx, double cy, double r,
+                     double start, double end, double& qx, double& qy)
+{
+	const double twoPi = 6.283185307179586;
+	double a = std::atan2(py - cy, px - cx);
+	bool inside = end - start >= twoPi;
+	if (!inside) {
+		// Bring a into [start, start + 2PI) and test against the span
+		double t = a - start;
+		t -= std::floor(t / twoPi) * twoPi;
+		inside = t <= end - start;
+	}
+	if (inside) {
+		double d = std::hypot(px - cx, py - cy);
+		if (d > 0.0) {
+			qx = cx + (px - cx) * r / d;
+			qy = cy + (py - cy) * r / d;
+		} else {
+			qx = cx + r * std::cos(start);
+			qy = cy + r * std::sin(start);
+		}
+		return std::fabs(d - r);
+	}
+	// Outside the span the closest point is an end point
+	double sx = cx + r * std::cos(start), sy = cy + r * std::sin(start);
+	double ex = cx + r * std::cos(end), ey = cy + r * std::sin(end);
+	double ds = std::hypot(px - sx, py - sy);
+	double de = std::hypot(px - ex, py - ey);
+	if (ds <= de) {
+		qx = sx; qy = sy;
+		return ds;
+	}
+	qx = ex; qy = ey;
+	return de;
+}
+
+} // namespace JWWSpatial
@@ -0,0 +1,202 @@
+// Push-style JWW parser for jwwlib-wasm
+
+#include "jww_stream.h"
+#include "jww_memory.h"
+#include <algorithm>
+#include <cstring>
+
+JWWChunkBuf::JWWChunkBuf()
+{
+	resetPointers(0);
+}
+
+void JWWChunkBuf::resetPointers(size_t offset)
+{
+	char* base = data.empty() ? NULL : &data[0];
+	setg(base, base + offset, base + data.size());
+}
+
+void JWWChunkBuf::append(const char* bytes, size_t len)
+{
+	if( len == 0 )
+		return;
+	size_t offset = tell();
+	data.insert(data.end(), bytes, bytes + len);
+	resetPointers(offset);
+}
+
+size_t JWWChunkBuf::tell() const
+{
+	return gptr() - eback();
+}
+
+void JWWChunkBuf::rewind(size_t offset)
+{
+	resetPointers(offset);
+}
+
+void JWWChunkBuf::compact()
+{
+	size_t offset = tell();
+	if( offset == 0 )
+		return;
+	data.erase(data.begin(), data.begin() + offset);
+	resetPointers(0);
+}
+
+JWWChunkBuf::int_type JWWChunkBuf::underflow()
+{
+	if( gptr() < egptr() )
+		return traits_type::to_int_type(*gptr());
+	return traits_type::eof();
+}
+
+JWWOutputBuf::JWWOutputBuf()
+{
+	setp(NULL, NULL);
+}
+
+void JWWOutputBuf::reserve(size_t capacity)
+{
+	if( capacity > bytes.size() )
+		grow(capacity - size());
+}
+
+void JWWOutputBuf::clear()
+{
+	char* base = bytes.empty() ? NULL : &bytes[0];
+	setp(base, base + bytes.size());
+}
+
+void JWWOutputBuf::release()
+{
+	std::vector<char>().swap(bytes);
+	setp(NULL, NULL);
+}
+
+// Room for at least needed more bytes; the capacity at least doubles so
+// a long run of small writes stays linear
+void JWWOutputBuf::grow(size_t needed)
+{
+	size_t used = size();
+	size_t capacity = std::max(bytes.size() * 2, used + needed);
+	capacity = std::max(capacity, (size_t)4096);
+	bytes.resize(capacity);
+	char* base = &bytes[0];
+	setp(base, base + capacity);
+	// pbump() takes an int; move in steps for outputs past 2 GiB
+	while( used > 0 ){
+		int step = (int)std::min(used, (size_t)0x40000000);
+		pbump(step);
+		used -= step;
+	}
+}
+
+JWWOutputBuf::int_type JWWOutputBuf::overflow(int_type c)
+{
+	if( traits_type::eq_int_type(c, traits_type::eof()) )
+		return traits_type::not_eof(c);
+	if( pptr() == epptr() )
+		grow(1);
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+	return c;
+}
+
+std::streamsize JWWOutputBuf::xsputn(const char* s, std::streamsize n)
+{
+	if( n <= 0 )
+		return 0;
+	if( epptr() - pptr() < n )
+		grow((size_t)n);
+	memcpy(pptr(), s, (size_t)n);
+	pbump((int)n);
+	return n;
+}
+
+JWWStreamParser::JWWStreamParser(JWWRecordHandler* handler)
+	: phase(Header), state(NeedMore), consumed(0), headerRetryAt(0)
+{
+	string in(""), out("");
+	doc = new JWWDocument(in, out);
+	doc->pHandler = handler;
+	doc->AttachInput(&buf);
+}
+
+JWWStreamParser::~JWWStreamParser()
+{
+	delete doc;
+}
+
+JWWStreamParser::Status JWWStreamParser::feed(const char* data, size_t len)
+{
+	if( state != NeedMore )
+		return state;
+	{
+		JWWMemory::Scope memoryScope(JWWMemory::Input);
+		buf.append(data, len);
+	}
+	return pump(false);
+}
+
+JWWStreamParser::Status JWWStreamParser::finish()
+{
+	if( state != NeedMore )
+		return state;
+	return pump(true);
+}
+
+JWWStreamParser::Status JWWStreamParser::pump(bool final)
+{
+	JWWMemory::Scope memoryScope(JWWMemory::Document);
+	ifstream& ifs = *doc->ifs;
+
+	if( phase == Header )
+	{
+		// The header is read in one go and restarted until it is complete.
+		// Each retry waits for the buffer to double so tiny chunks stay linear.
+		if( !final && buf.buffered() < headerRetryAt )
+			return state;
+		ifs.clear();
+		if( !doc->ReadHeader() || !doc->BeginRecords() )
+		{
+			bool starved = ifs.fail();
+			buf.rewind(0);
+			headerRetryAt = buf.buffered() * 2;
+			if( !starved || final )
+				state = Error;
+			return state;
+		}
+		phase = Records;
+	}
+
+	while( phase == Records )
+	{
+		size_t mark = buf.tell();
+		ifs.clear();
+		if( doc->ReadRecord() )
+			continue;
+		if( doc->RecordsComplete() )
+		{
+			phase = Trailer;
+			break;
+		}
+		// Only a record cut off by the end of the buffered bytes waits for
+		// the next chunk; anything else would buffer the rest of the stream
+		if( doc->ReadState.Corrupt || !ifs.eof() )
+		{
+			state = Error;
+			return state;
+		}
+		buf.rewind(mark);
+		break;
+	}
+	// Data after the block definitions (embedded images) is not decoded
+	if( phase == Trailer )
+		buf.rewind(buf.buffered());
+	consumed += buf.tell();
+	buf.compact();
+	if( final )
+		state = phase == Trailer && buf.buffered() == 0 ? Done : Error;
+	return state;
+}
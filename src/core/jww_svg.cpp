@@ -0,0 +1,543 @@
+// JWW to SVG conversion for jwwlib-wasm
+
+#include "jww_svg.h"
+#include "jww_raster.h"
+#include "jww_sjis.h"
+#include "jww_stream.h"
+#include "jww_tessellate.h"
+#include "dl_creationadapter.h"
+#include "dl_jww.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace JWWSvg {
+
+namespace {
+
+// Fixed-point values beyond this are clamped (about 1e15 at 2 decimals)
+const double FIXED_LIMIT = 1e17;
+// Inserts nested deeper than this are left out of the bounds
+const int MAX_NESTING = 64;
+
+struct Box {
+	double minX, minY, maxX, maxY;
+
+	Box() : minX(HUGE_VAL), minY(HUGE_VAL), maxX(-HUGE_VAL), maxY(-HUGE_VAL) {}
+
+	bool empty() const { return !(maxX >= minX) || !(maxY >= minY); }
+
+	void include(double x, double y) {
+		if (!std::isfinite(x) || !std::isfinite(y))
+			return;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+};
+
+// Write n / 10^decimals without trailing zeros in the fraction
+void appendFixed(std::string& out, long long n, int decimals)
+{
+	char buf[32];
+	char* const end = buf + sizeof(buf);
+	char* p = end;
+	const bool negative = n < 0;
+	unsigned long long u = negative ? 0ull - static_cast<unsigned long long>(n) : static_cast<unsigned long long>(n);
+	int d = decimals;
+	while (d > 0 && u % 10 == 0) {
+		u /= 10;
+		d--;
+	}
+	for (int i = 0; i < d; i++) {
+		*--p = static_cast<char>('0' + u % 10);
+		u /= 10;
+	}
+	if (d > 0)
+		*--p = '.';
+	do {
+		*--p = static_cast<char>('0' + u % 10);
+		u /= 10;
+	} while (u);
+	if (negative)
+		*--p = '-';
+	out.append(p, static_cast<size_t>(end - p));
+}
+
+void appendUnsigned(std::string& out, unsigned long n)
+{
+	appendFixed(out, static_cast<long long>(n), 0);
+}
+
+// Coordinates as integers in units of 10^-precision, snapped to the
+// quantum first. Equal integers print equal text, so paths compare end
+// points on them.
+class Format {
+public:
+	explicit Format(const Options& options)
+		: decimals(std::max(0, std::min(options.precision, 9))),
+		  quantum(options.quantum > 0.0 ? options.quantum : 0.0),
+		  scale(std::pow(10.0, decimals)) {}
+
+	long long fixed(double v) const {
+		if (quantum > 0.0)
+			v = std::floor(v / quantum + 0.5) * quantum;
+		double s = v * scale;
+		if (!(s == s))
+			return 0;
+		return std::llround(std::max(-FIXED_LIMIT, std::min(FIXED_LIMIT, s)));
+	}
+	void put(std::string& out, long long n) const { appendFixed(out, n, decimals); }
+	void number(std::string& out, double v) const { put(out, fixed(v)); }
+
+	// Degrees with three decimals whatever the precision
+	static void angle(std::string& out, double degrees) {
+		appendFixed(out, std::llround(std::fmod(degrees, 360.0) * 1000.0), 3);
+	}
+
+private:
+	int decimals;
+	double quantum;
+	double scale;
+};
+
+void appendColor(std::string& out, uint32_t rgba)
+{
+	static const char HEX[] = "0123456789abcdef";
+	out.push_back('#');
+	for (int shift = 28; shift >= 8; shift -= 4)
+		out.push_back(HEX[(rgba >> shift) & 0xF]);
+}
+
+// Text content: '&', '<' and '>' escaped and control characters XML does
+// not allow dropped
+void appendEscaped(std::string& out, const std::string& utf8)
+{
+	for (size_t i = 0; i < utf8.size(); i++) {
+		char c = utf8[i];
+		switch (c) {
+		case '&': out += "&amp;"; break;
+		case '<': out += "&lt;"; break;
+		case '>': out += "&gt;"; break;
+		default:
+			if (static_cast<unsigned char>(c) >= 0x20 || c == '\t')
+				out.push_back(c);
+			break;
+		}
+	}
+}
+
+// Path data of one color; (lastX, lastY) is where it ends, so a line that
+// continues from there needs no moveto
+struct Path {
+	std::string d;
+	long long lastX, lastY;
+
+	Path() : lastX(0), lastY(0) {}
+};
+
+struct Insert {
+	unsigned long number;
+	double x, y, scaleX, scaleY, angle;	// angle in radians
+};
+
+// The drawing or one block definition
+struct Group {
+	std::map<int, Path> strokes;		// by DXF color number
+	std::map<int, std::string> fills;
+	std::string texts;
+	std::vector<Insert> inserts;
+	Box bounds;
+};
+
+// Appends what DL_Jww creates to the current group
+class Scene : public DL_CreationAdapter {
+public:
+	explicit Scene(const Options& options)
+		: options(options), format(options), group(&drawing), elements(0), texts(0) {}
+
+	void addLine(const DL_LineData& d) override {
+		Path& p = stroke();
+		moveTo(p, d.x1, d.y1);
+		lineTo(p, d.x2, d.y2);
+		group->bounds.include(d.x1, d.y1);
+		group->bounds.include(d.x2, d.y2);
+		elements++;
+	}
+	void addArc(const DL_ArcData& d) override {
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 360.0;
+		addCurve(d.cx, d.cy, d.radius, d.radius, 0.0, d.angle1 * M_PI / 180.0, sweep * M_PI / 180.0);
+	}
+	void addCircle(const DL_CircleData& d) override {
+		addCurve(d.cx, d.cy, d.radius, d.radius, 0.0, 0.0, 2.0 * M_PI);
+	}
+	void addEllipse(const DL_EllipseData& d) override {
+		// Major axis end point relative to the center
+		double rx = std::hypot(d.mx, d.my);
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 2.0 * M_PI;
+		addCurve(d.cx, d.cy, rx, rx * d.ratio, std::atan2(d.my, d.mx), d.angle1, sweep);
+	}
+	void addSolid(const DL_SolidData& d) override {
+		// DXF order 1, 2, 4, 3 walks the outline
+		static const int order[4] = {0, 1, 3, 2};
+		std::string& f = group->fills[attributes.getColor()];
+		for (int i = 0; i < 4; i++) {
+			f.push_back(i == 0 ? 'M' : 'L');
+			point(f, d.x[order[i]], d.y[order[i]]);
+			group->bounds.include(d.x[order[i]], d.y[order[i]]);
+		}
+		f.push_back('Z');
+		elements++;
+	}
+	void addText(const DL_TextData& d) override;
+
+	void addInsert(const CDataBlock& b) {
+		Insert ins = {b.m_n_Number, b.m_DPKijunTen.x, b.m_DPKijunTen.y,
+		              b.m_dBairitsuX, b.m_dBairitsuY, b.m_radKaitenKaku};
+		group->inserts.push_back(ins);
+	}
+
+	void beginDefinition(unsigned long number) { group = &definitions[number]; }
+	void endDefinition() { group = &drawing; }
+
+	bool write(std::string& out, Stats* stats);
+
+	const Options& options;
+	Format format;
+	Group drawing;
+	std::map<unsigned long, Group> definitions;
+	Group* group;
+	size_t elements;
+	size_t texts;
+
+private:
+	Path& stroke() { return group->strokes[attributes.getColor()]; }
+
+	void point(std::string& out, double x, double y) const {
+		format.number(out, x);
+		out.push_back(' ');
+		format.number(out, -y);
+	}
+	void moveTo(Path& p, double x, double y) {
+		long long fx = format.fixed(x), fy = format.fixed(-y);
+		if (!p.d.empty() && fx == p.lastX && fy == p.lastY)
+			return;
+		p.d.push_back('M');
+		format.put(p.d, fx);
+		p.d.push_back(' ');
+		format.put(p.d, fy);
+		p.lastX = fx;
+		p.lastY = fy;
+	}
+	void lineTo(Path& p, double x, double y) {
+		p.lastX = format.fixed(x);
+		p.lastY = format.fixed(-y);
+		p.d.push_back('L');
+		format.put(p.d, p.lastX);
+		p.d.push_back(' ');
+		format.put(p.d, p.lastY);
+	}
+	// Elliptic arc from the current point to (x, y). Counterclockwise in
+	// the drawing is clockwise once y is flipped: sweep-flag 0.
+	void arcTo(Path& p, double rx, double ry, double rotation, bool large, double x, double y) {
+		p.d.push_back('A');
+		format.number(p.d, rx);
+		p.d.push_back(' ');
+		format.number(p.d, ry);
+		p.d.push_back(' ');
+		Format::angle(p.d, -rotation * 180.0 / M_PI);
+		p.d += large ? " 1 0 " : " 0 0 ";
+		p.lastX = format.fixed(x);
+		p.lastY = format.fixed(-y);
+		format.put(p.d, p.lastX);
+		p.d.push_back(' ');
+		format.put(p.d, p.lastY);
+	}
+
+	// Elliptic arc as in JWWTessellate::emitArc. A full turn is two halves:
+	// an SVG arc cannot end where it starts.
+	void addCurve(double cx, double cy, double rx, double ry, double rotation,
+	              double start, double sweep) {
+		if (!(rx > 0.0) || !(ry > 0.0) || !(sweep > 0.0))
+			return;
+		const double c = std::cos(rotation), s = std::sin(rotation);
+		double x, y;
+		pointAt(cx, cy, rx, ry, c, s, start, x, y);
+		Path& p = stroke();
+		moveTo(p, x, y);
+		if (sweep >= 2.0 * M_PI - 1e-9) {
+			double hx, hy;
+			pointAt(cx, cy, rx, ry, c, s, start + M_PI, hx, hy);
+			arcTo(p, rx, ry, rotation, false, hx, hy);
+			arcTo(p, rx, ry, rotation, false, x, y);
+		} else {
+			pointAt(cx, cy, rx, ry, c, s, start + sweep, x, y);
+			arcTo(p, rx, ry, rotation, sweep > M_PI, x, y);
+		}
+		double box[4];
+		JWWTessellate::arcBounds(cx, cy, rx, ry, rotation, start, sweep, box);
+		group->bounds.include(box[0], box[1]);
+		group->bounds.include(box[2], box[3]);
+		elements++;
+	}
+	static void pointAt(double cx, double cy, double rx, double ry, double c, double s,
+	                    double t, double& x, double& y) {
+		double u = rx * std::cos(t), v = ry * std::sin(t);
+		x = cx + u * c - v * s;
+		y = cy + u * s + v * c;
+	}
+
+	Box resolve(const Group& g, std::set<unsigned long>& open, int depth) const;
+	void writeGroup(std::string& out, const Group& g, Stats& stats) const;
+
+	std::string utf8;
+};
+
+void Scene::addText(const DL_TextData& d)
+{
+	if (!options.texts || !(d.height > 0.0) || d.text.empty())
+		return;
+	// Shift-JIS bytes are half-width cells: bytes * height / 2 long
+	const double width = d.text.size() * d.height * 0.5 * (d.xScaleFactor > 0.0 ? d.xScaleFactor : 1.0);
+	std::string& t = group->texts;
+	t += "<text x=\"";
+	format.number(t, d.ipx);
+	t += "\" y=\"";
+	format.number(t, -d.ipy);
+	t += "\" font-size=\"";
+	format.number(t, d.height);
+	t += "\" textLength=\"";
+	format.number(t, width);
+	t += "\" lengthAdjust=\"spacingAndGlyphs\" fill=\"";
+	appendColor(t, JWWRaster::aciToRGBA(attributes.getColor(), options.background));
+	if (d.angle != 0.0) {
+		t += "\" transform=\"rotate(";
+		Format::angle(t, -d.angle * 180.0 / M_PI);
+		t.push_back(' ');
+		point(t, d.ipx, d.ipy);
+		t.push_back(')');
+	}
+	t += "\">";
+	utf8.clear();
+	JWWSjis::appendUtf8(d.text.data(), d.text.size(), utf8);
+	appendEscaped(t, utf8);
+	t += "</text>\n";
+
+	const double c = std::cos(d.angle), s = std::sin(d.angle);
+	const double bx[4] = {0.0, width, width, 0.0};
+	const double by[4] = {0.0, 0.0, d.height, d.height};
+	for (int i = 0; i < 4; i++)
+		group->bounds.include(d.ipx + bx[i] * c - by[i] * s, d.ipy + bx[i] * s + by[i] * c);
+	elements++;
+	texts++;
+}
+
+// Bounds of a group with its inserts, in its own coordinates
+Box Scene::resolve(const Group& g, std::set<unsigned long>& open, int depth) const
+{
+	Box box = g.bounds;
+	if (depth >= MAX_NESTING)
+		return box;
+	for (size_t i = 0; i < g.inserts.size(); i++) {
+		const Insert& ins = g.inserts[i];
+		std::map<unsigned long, Group>::const_iterator def = definitions.find(ins.number);
+		if (def == definitions.end() || open.count(ins.number))
+			continue;
+		open.insert(ins.number);
+		Box inner = resolve(def->second, open, depth + 1);
+		open.erase(ins.number);
+		if (inner.empty())
+			continue;
+		const double c = std::cos(ins.angle), s = std::sin(ins.angle);
+		const double xs[2] = {inner.minX * ins.scaleX, inner.maxX * ins.scaleX};
+		const double ys[2] = {inner.minY * ins.scaleY, inner.maxY * ins.scaleY};
+		for (int k = 0; k < 4; k++) {
+			double x = xs[k & 1], y = ys[k >> 1];
+			box.include(ins.x + x * c - y * s, ins.y + x * s + y * c);
+		}
+	}
+	return box;
+}
+
+void Scene::writeGroup(std::string& out, const Group& g, Stats& stats) const
+{
+	for (std::map<int, std::string>::const_iterator it = g.fills.begin(); it != g.fills.end(); ++it) {
+		out += "<path fill=\"";
+		appendColor(out, JWWRaster::aciToRGBA(it->first, options.background));
+		out += "\" d=\"";
+		out += it->second;
+		out += "\"/>\n";
+		stats.paths++;
+	}
+	for (std::map<int, Path>::const_iterator it = g.strokes.begin(); it != g.strokes.end(); ++it) {
+		out += "<path fill=\"none\" stroke=\"";
+		appendColor(out, JWWRaster::aciToRGBA(it->first, options.background));
+		if (options.strokeWidth > 0.0) {
+			out += "\" stroke-width=\"";
+			format.number(out, options.strokeWidth);
+		} else {
+			out += "\" stroke-width=\"1\" vector-effect=\"non-scaling-stroke";
+		}
+		out += "\" stroke-linecap=\"round\" stroke-linejoin=\"round\" d=\"";
+		out += it->second.d;
+		out += "\"/>\n";
+		stats.paths++;
+	}
+	for (size_t i = 0; i < g.inserts.size(); i++) {
+		const Insert& ins = g.inserts[i];
+		if (!definitions.count(ins.number))
+			continue;
+		out += "<use xlink:href=\"#jww-b";
+		appendUnsigned(out, ins.number);
+		out += "\" transform=\"translate(";
+		point(out, ins.x, ins.y);
+		out += ") rotate(";
+		Format::angle(out, -ins.angle * 180.0 / M_PI);
+		out += ") scale(";
+		appendFixed(out, std::llround(ins.scaleX * 1e6), 6);
+		out.push_back(' ');
+		appendFixed(out, std::llround(ins.scaleY * 1e6), 6);
+		out += ")\"/>\n";
+		stats.inserts++;
+	}
+	out += g.texts;
+}
+
+bool Scene::write(std::string& out, Stats* stats)
+{
+	Stats counts;
+	const size_t before = out.size();
+	size_t estimate = 512 + drawing.texts.size();
+	for (std::map<int, Path>::const_iterator it = drawing.strokes.begin(); it != drawing.strokes.end(); ++it)
+		estimate += it->second.d.size() + 160;
+	out.reserve(before + estimate);
+
+	std::set<unsigned long> open;
+	Box box = resolve(drawing, open, 0);
+	if (box.empty())
+		box.minX = box.minY = box.maxX = box.maxY = 0.0;
+	// A small margin so lines on the extents are not cut in half
+	double margin = std::max(box.maxX - box.minX, box.maxY - box.minY) * 0.005;
+	if (!(margin > 0.0))
+		margin = 0.5;
+	out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	       "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" viewBox=\"";
+	std::string view;
+	format.number(view, box.minX - margin);
+	view.push_back(' ');
+	format.number(view, -box.maxY - margin);
+	view.push_back(' ');
+	format.number(view, box.maxX - box.minX + 2.0 * margin);
+	view.push_back(' ');
+	format.number(view, box.maxY - box.minY + 2.0 * margin);
+	out += view;
+	out += "\">\n";
+	if ((options.background & 0xFF) != 0) {
+		out += "<rect x=\"";
+		format.number(out, box.minX - margin);
+		out += "\" y=\"";
+		format.number(out, -box.maxY - margin);
+		out += "\" width=\"";
+		format.number(out, box.maxX - box.minX + 2.0 * margin);
+		out += "\" height=\"";
+		format.number(out, box.maxY - box.minY + 2.0 * margin);
+		out += "\" fill=\"";
+		appendColor(out, options.background);
+		if ((options.background & 0xFF) != 0xFF) {
+			out += "\" fill-opacity=\"";
+			appendFixed(out, std::llround((options.background & 0xFF) / 255.0 * 1000.0), 3);
+		}
+		out += "\"/>\n";
+	}
+	if (!definitions.empty()) {
+		out += "<defs>\n";
+		for (std::map<unsigned long, Group>::const_iterator it = definitions.begin(); it != definitions.end(); ++it) {
+			out += "<g id=\"jww-b";
+			appendUnsigned(out, it->first);
+			out += "\">\n";
+			writeGroup(out, it->second, counts);
+			out += "</g>\n";
+		}
+		out += "</defs>\n";
+	}
+	writeGroup(out, drawing, counts);
+	out += "</svg>\n";
+
+	if (stats) {
+		counts.elements = elements;
+		counts.texts = texts;
+		counts.bytes = out.size() - before;
+		*stats = counts;
+	}
+	return true;
+}
+
+// Routes records: the drawing to the scene's drawing group, each
+// definition to a group of its own
+class Handler : public DL_JwwRecordHandler {
+public:
+	Handler(DL_Jww& jww, Scene& scene)
+		: DL_JwwRecordHandler(&jww, &scene), scene(scene) {}
+
+	jwBOOL WantsBlockLists() override { return true; }
+
+	void OnBlockList(CDataList& list) override {
+		scene.beginDefinition(list.m_nNumber);
+	}
+
+	// A record past the end of a definition belongs to the drawing again
+	void OnBlockListEnd() override { scene.endDefinition(); }
+
+	void OnBlock(CDataBlock& d) override { scene.addInsert(d); }
+
+private:
+	Scene& scene;
+};
+
+bool read(JWWDocument& doc, Scene& scene)
+{
+	DL_Jww jww;
+	Handler handler(jww, scene);
+	doc.pHandler = &handler;
+	// Read() succeeds once the header parses; a cut or corrupt record list
+	// fails the conversion before anything is appended to out
+	bool ok = doc.Read() && doc.RecordsComplete() && !doc.ReadState.Corrupt;
+	doc.pHandler = NULL;
+	return ok;
+}
+
+} // namespace
+
+bool convert(const char* data, size_t size, std::string& out, const Options& options, Stats* stats)
+{
+	std::string ifile(""), ofile("");
+	JWWMemoryBuf input(data, size);
+	JWWDocument doc(ifile, ofile);
+	doc.AttachInput(&input);
+	Scene scene(options);
+	return read(doc, scene) && scene.write(out, stats);
+}
+
+bool convertFile(const std::string& input, const std::string& output, const Options& options, Stats* stats)
+{
+	std::string ifile(input), ofile("");
+	JWWDocument doc(ifile, ofile);
+	Scene scene(options);
+	if (!read(doc, scene))
+		return false;
+	std::string svg;
+	if (!scene.write(svg, stats))
+		return false;
+	std::ofstream out(output.c_str(), std::ios::binary);
+	return out && out.write(svg.data(), static_cast<std::streamsize>(svg.size())) && static_cast<bool>(out.flush());
+}
+
+} // namespace JWWSvg
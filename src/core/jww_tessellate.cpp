@@ -0,0 +1,96 @@
+// Curve tessellation for jwwlib-wasm
+
+#include "jww_tessellate.h"
+#include <algorithm>
+#include <cmath>
+
+namespace JWWTessellate {
+
+int segmentCount(double radius, double sweep, double tolerance)
+{
+	radius = std::fabs(radius);
+	sweep = std::fabs(sweep);
+	if (!(radius > 0.0) || !(sweep > 0.0))
+		return MIN_SEGMENTS;
+	if (!(tolerance > 0.0) || tolerance >= radius)
+		return std::max(MIN_SEGMENTS, static_cast<int>(std::ceil(sweep / 2.0943951023931953)));	// 120 degrees
+
+	// Sagitta of a chord spanning angle a: radius * (1 - cos(a / 2))
+	double step = 2.0 * std::acos(1.0 - tolerance / radius);
+	double n = std::ceil(sweep / step);
+	if (n > MAX_SEGMENTS)
+		return MAX_SEGMENTS;
+	return std::max(MIN_SEGMENTS, static_cast<int>(n));
+}
+
+float* emitArc(float* out, double cx, double cy, double rx, double ry,
+               double rotation, double start, double sweep, int segments,
+               double originX, double originY)
+{
+	if (segments < 1)
+		return out;
+	const double cr = std::cos(rotation), sr = std::sin(rotation);
+	const double step = sweep / segments;
+	const double dc = std::cos(step), ds = std::sin(step);
+	const double ox = cx - originX, oy = cy - originY;
+
+	// Advance (cos t, sin t) by rotation instead of calling cos/sin per vertex
+	double c = std::cos(start), s = std::sin(start);
+	float px = static_cast<float>(ox + rx * c * cr - ry * s * sr);
+	float py = static_cast<float>(oy + rx * c * sr + ry * s * cr);
+	for (int k = 1; k <= segments; k++) {
+		if (k == segments) {
+			// Close exactly on the end angle so neighbours meet without drift
+			c = std::cos(start + sweep);
+			s = std::sin(start + sweep);
+		} else {
+			double nc = c * dc - s * ds;
+			s = s * dc + c * ds;
+			c = nc;
+		}
+		float x = static_cast<float>(ox + rx * c * cr - ry * s * sr);
+		float y = static_cast<float>(oy + rx * c * sr + ry * s * cr);
+		out[0] = px;
+		out[1] = py;
+		out[2] = x;
+		out[3] = y;
+		out += 4;
+		px = x;
+		py = y;
+	}
+	return out;
+}
+
+void arcBounds(double cx, double cy, double rx, double ry, double rotation,
+               double start, double sweep, double box[4])
+{
+	const double cr = std::cos(rotation), sr = std::sin(rotation);
+	// x'(t) = 0 and y'(t) = 0, each twice per turn
+	double ts[6] = {start, start + sweep,
+	                std::atan2(-ry * sr, rx * cr), 0.0,
+	                std::atan2(ry * cr, rx * sr), 0.0};
+	ts[3] = ts[2] + M_PI;
+	ts[5] = ts[4] + M_PI;
+	const double turn = 2.0 * M_PI;
+	box[0] = box[1] = HUGE_VAL;
+	box[2] = box[3] = -HUGE_VAL;
+	for (int i = 0; i < 6; i++) {
+		if (i >= 2 && std::fabs(sweep) < turn) {
+			// Offset from the start in the sweep direction
+			double d = std::fmod((ts[i] - start) * (sweep < 0.0 ? -1.0 : 1.0), turn);
+			if (d < 0.0)
+				d += turn;
+			if (d > std::fabs(sweep))
+				continue;
+		}
+		double c = std::cos(ts[i]), s = std::sin(ts[i]);
+		double x = cx + rx * c * cr - ry * s * sr;
+		double y = cy + rx * c * sr + ry * s * cr;
+		box[0] = std::min(box[0], x);
+		box[1] = std::min(box[1], y);
+		box[2] = std::max(box[2], x);
+		box[3] = std::max(box[3], y);
+	}
+}
+
+} // namespace JWWTessellate
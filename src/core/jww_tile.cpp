@@ -0,0 +1,493 @@
+// Vector tile pyramid for jwwlib-wasm
+
+#include "jww_tile.h"
+#include "jww_tessellate.h"
+#include "dl_creationadapter.h"
+#include "dl_jww.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#ifndef __EMSCRIPTEN__
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace JWWTile {
+
+namespace {
+
+const uint8_t MAGIC[4] = {'J', 'W', 'T', '1'};
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+	while (v >= 0x80) {
+		out.push_back(static_cast<uint8_t>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(v));
+}
+
+inline uint64_t zigzag(int64_t v)
+{
+	return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+void putDouble(std::vector<uint8_t>& out, double v)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &v, sizeof(bits));
+	for (int i = 0; i < 8; i++)
+		out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+}
+
+class Reader {
+public:
+	Reader(const uint8_t* d, size_t n) : p(d), end(d + n), ok(true) {}
+
+	uint64_t varint() {
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (p >= end)
+				break;
+			uint8_t b = *p++;
+			v |= static_cast<uint64_t>(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		ok = false;
+		return 0;
+	}
+	int64_t signedVarint() {
+		uint64_t v = varint();
+		return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+	}
+	double real() {
+		if (end - p < 8) {
+			ok = false;
+			return 0.0;
+		}
+		uint64_t bits = 0;
+		for (int i = 0; i < 8; i++)
+			bits |= static_cast<uint64_t>(p[i]) << (8 * i);
+		p += 8;
+		double v;
+		std::memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+	bool magic() {
+		if (end - p < 4 || std::memcmp(p, MAGIC, 4) != 0)
+			return false;
+		p += 4;
+		return true;
+	}
+	size_t left() const { return static_cast<size_t>(end - p); }
+
+	const uint8_t* p;
+	const uint8_t* end;
+	bool ok;
+};
+
+// Spread the low 16 bits to the even bit positions
+inline uint32_t spread(uint32_t v)
+{
+	v &= 0xFFFF;
+	v = (v | (v << 8)) & 0x00FF00FF;
+	v = (v | (v << 4)) & 0x0F0F0F0F;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+// Clip the segment to the rectangle (Liang-Barsky); false when nothing is left
+bool clipSegment(double& x0, double& y0, double& x1, double& y1, const double box[4])
+{
+	double t0 = 0.0, t1 = 1.0;
+	const double dx = x1 - x0, dy = y1 - y0;
+	const double p[4] = {-dx, dx, -dy, dy};
+	const double q[4] = {x0 - box[0], box[2] - x0, y0 - box[1], box[3] - y0};
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0)
+				return false;
+			continue;
+		}
+		double t = q[i] / p[i];
+		if (p[i] < 0.0) {
+			if (t > t1)
+				return false;
+			t0 = std::max(t0, t);
+		} else {
+			if (t < t0)
+				return false;
+			t1 = std::min(t1, t);
+		}
+	}
+	double sx = x0, sy = y0;
+	x0 = sx + t0 * dx;
+	y0 = sy + t0 * dy;
+	x1 = sx + t1 * dx;
+	y1 = sy + t1 * dy;
+	return true;
+}
+
+class Collector : public DL_CreationAdapter {
+public:
+	explicit Collector(Tiler& t) : tiler(t) {}
+
+	void addLine(const DL_LineData& d) override {
+		tiler.addSegment(d.x1, d.y1, d.x2, d.y2, pen());
+	}
+	void addArc(const DL_ArcData& d) override {
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 360.0;
+		tiler.addArc(d.cx, d.cy, d.radius, d.radius, 0.0, d.angle1 * M_PI / 180.0, sweep * M_PI / 180.0, pen());
+	}
+	void addCircle(const DL_CircleData& d) override {
+		tiler.addArc(d.cx, d.cy, d.radius, d.radius, 0.0, 0.0, 2.0 * M_PI, pen());
+	}
+	void addEllipse(const DL_EllipseData& d) override {
+		// Major axis end point relative to the center
+		double rx = std::hypot(d.mx, d.my);
+		double sweep = d.angle2 - d.angle1;
+		if (sweep <= 0.0)
+			sweep += 2.0 * M_PI;
+		tiler.addArc(d.cx, d.cy, rx, rx * d.ratio, std::atan2(d.my, d.mx), d.angle1, sweep, pen());
+	}
+
+private:
+	uint32_t pen() const {
+		return static_cast<uint32_t>(attributes.getColor() & 0xFFFF) |
+		       (static_cast<uint32_t>(attributes.getWidth() & 0xFFFF) << 16);
+	}
+
+	Tiler& tiler;
+};
+
+} // namespace
+
+void Tiler::addSegment(double x1, double y1, double x2, double y2, uint32_t pen)
+{
+	if (!std::isfinite(x1) || !std::isfinite(y1) || !std::isfinite(x2) || !std::isfinite(y2))
+		return;
+	refs.push_back(static_cast<uint32_t>(segments.size() / 4));
+	const double s[4] = {x1, y1, x2, y2};
+	segments.insert(segments.end(), s, s + 4);
+	pens.push_back(pen);
+	const double b[4] = {std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)};
+	boxes.insert(boxes.end(), b, b + 4);
+}
+
+void Tiler::addArc(double cx, double cy, double rx, double ry, double rotation,
+                   double start, double sweep, uint32_t pen)
+{
+	double b[4];
+	JWWTessellate::arcBounds(cx, cy, rx, ry, rotation, start, sweep, b);
+	if (!std::isfinite(b[0]) || !std::isfinite(b[1]) || !std::isfinite(b[2]) || !std::isfinite(b[3]))
+		return;
+	refs.push_back(ARC_BIT | static_cast<uint32_t>(arcs.size()));
+	Arc a = {cx, cy, rx, ry, rotation, start, sweep};
+	arcs.push_back(a);
+	pens.push_back(pen);
+	boxes.insert(boxes.end(), b, b + 4);
+}
+
+bool Tiler::load(const char* data, size_t size)
+{
+	Collector collector(*this);
+	DL_Jww reader;
+	return reader.in(data, size, &collector);
+}
+
+void Tiler::clear()
+{
+	segments.clear();
+	arcs.clear();
+	refs.clear();
+	pens.clear();
+	boxes.clear();
+	tileList.clear();
+	minX = minY = rootSize = 0.0;
+}
+
+const Tile* Tiler::find(int z, int x, int y) const
+{
+	Tile key;
+	key.z = z;
+	key.x = x;
+	key.y = y;
+	auto less = [](const Tile& a, const Tile& b) {
+		if (a.z != b.z)
+			return a.z < b.z;
+		return a.y != b.y ? a.y < b.y : a.x < b.x;
+	};
+	auto it = std::lower_bound(tileList.begin(), tileList.end(), key, less);
+	if (it == tileList.end() || it->z != z || it->x != x || it->y != y)
+		return nullptr;
+	return &*it;
+}
+
+void Tiler::runTask(const Task& task, const Options& options, std::vector<Task>& children,
+                    std::vector<Segment>& scratch, std::vector<float>& arcPoints, Tile& tile) const
+{
+	const double size = std::ldexp(rootSize, -task.z);
+	const double x0 = minX + task.x * size, y0 = minY + task.y * size;
+	const double pad = size * BUFFER / EXTENT;
+	const double clip[4] = {x0 - pad, y0 - pad, x0 + size + pad, y0 + size + pad};
+	const double scale = EXTENT / size;
+
+	// Clip and quantize; shorter than a unit is dropped
+	scratch.clear();
+	auto emit = [&](double ax, double ay, double bx, double by, uint32_t pen) {
+		if (!clipSegment(ax, ay, bx, by, clip))
+			return;
+		Segment s;
+		s.pen = pen;
+		s.x0 = static_cast<int32_t>(std::floor((ax - x0) * scale + 0.5));
+		s.y0 = static_cast<int32_t>(std::floor((ay - y0) * scale + 0.5));
+		s.x1 = static_cast<int32_t>(std::floor((bx - x0) * scale + 0.5));
+		s.y1 = static_cast<int32_t>(std::floor((by - y0) * scale + 0.5));
+		if (s.x0 == s.x1 && s.y0 == s.y1)
+			return;
+		// One direction per segment so duplicates meet in the sort
+		if (s.x1 < s.x0 || (s.x1 == s.x0 && s.y1 < s.y0)) {
+			std::swap(s.x0, s.x1);
+			std::swap(s.y0, s.y1);
+		}
+		s.order = spread(static_cast<uint32_t>(s.x0 + BUFFER)) |
+		          (spread(static_cast<uint32_t>(s.y0 + BUFFER)) << 1);
+		scratch.push_back(s);
+	};
+	for (size_t k = 0; k < task.items.size(); k++) {
+		const uint32_t item = task.items[k];
+		const uint32_t ref = refs[item];
+		if (!(ref & ARC_BIT)) {
+			const double* s = &segments[ref * 4];
+			emit(s[0], s[1], s[2], s[3], pens[item]);
+			continue;
+		}
+		// Chords within half a unit at this zoom
+		const Arc& a = arcs[ref & ~ARC_BIT];
+		int n = JWWTessellate::segmentCount(std::max(std::fabs(a.rx), std::fabs(a.ry)), a.sweep, 0.5 / scale);
+		arcPoints.resize(static_cast<size_t>(n) * 4);
+		JWWTessellate::emitArc(arcPoints.data(), a.cx, a.cy, a.rx, a.ry, a.rotation, a.start, a.sweep, n, x0, y0);
+		for (size_t i = 0; i < arcPoints.size(); i += 4)
+			emit(x0 + arcPoints[i], y0 + arcPoints[i + 1], x0 + arcPoints[i + 2], y0 + arcPoints[i + 3], pens[item]);
+	}
+	std::sort(scratch.begin(), scratch.end(), [](const Segment& a, const Segment& b) {
+		if (a.pen != b.pen)
+			return a.pen < b.pen;
+		if (a.order != b.order)
+			return a.order < b.order;
+		if (a.x0 != b.x0)
+			return a.x0 < b.x0;
+		if (a.y0 != b.y0)
+			return a.y0 < b.y0;
+		return a.x1 != b.x1 ? a.x1 < b.x1 : a.y1 < b.y1;
+	});
+	scratch.erase(std::unique(scratch.begin(), scratch.end(), [](const Segment& a, const Segment& b) {
+		return a.pen == b.pen && a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+	}), scratch.end());
+
+	tile.z = task.z;
+	tile.x = task.x;
+	tile.y = task.y;
+	tile.segments = static_cast<uint32_t>(scratch.size());
+	std::vector<uint8_t>& out = tile.blob;
+	out.assign(MAGIC, MAGIC + 4);
+	putVarint(out, task.z);
+	putVarint(out, task.x);
+	putVarint(out, task.y);
+	putDouble(out, x0);
+	putDouble(out, y0);
+	putDouble(out, size);
+	putVarint(out, EXTENT);
+	size_t groups = 0;
+	for (size_t i = 0; i < scratch.size(); i++)
+		if (i == 0 || scratch[i].pen != scratch[i - 1].pen)
+			groups++;
+	putVarint(out, groups);
+	for (size_t i = 0; i < scratch.size(); ) {
+		size_t j = i;
+		while (j < scratch.size() && scratch[j].pen == scratch[i].pen)
+			j++;
+		putVarint(out, scratch[i].pen);
+		putVarint(out, j - i);
+		int64_t cx = 0, cy = 0;
+		for (; i < j; i++) {
+			const Segment& s = scratch[i];
+			putVarint(out, zigzag(s.x0 - cx));
+			putVarint(out, zigzag(s.y0 - cy));
+			putVarint(out, zigzag(static_cast<int64_t>(s.x1) - s.x0));
+			putVarint(out, zigzag(static_cast<int64_t>(s.y1) - s.y0));
+			cx = s.x1;
+			cy = s.y1;
+		}
+	}
+
+	// Split crowded tiles; items go to every child their box reaches
+	children.clear();
+	tile.leaf = true;
+	if (scratch.empty() || task.z >= std::min(options.maxZoom, MAX_ZOOM) || task.items.size() <= options.maxItems)
+		return;
+	const double half = size * 0.5;
+	const double childPad = half * BUFFER / EXTENT;
+	for (int c = 0; c < 4; c++) {
+		Task child;
+		child.z = task.z + 1;
+		child.x = task.x * 2 + (c & 1);
+		child.y = task.y * 2 + (c >> 1);
+		const double bx0 = x0 + (c & 1) * half - childPad, by0 = y0 + (c >> 1) * half - childPad;
+		const double bx1 = bx0 + half + 2 * childPad, by1 = by0 + half + 2 * childPad;
+		for (size_t k = 0; k < task.items.size(); k++) {
+			const double* b = &boxes[task.items[k] * 4];
+			if (b[0] <= bx1 && b[2] >= bx0 && b[1] <= by1 && b[3] >= by0)
+				child.items.push_back(task.items[k]);
+		}
+		if (!child.items.empty()) {
+			children.push_back(Task());
+			std::swap(children.back(), child);
+		}
+	}
+	tile.leaf = children.empty();
+}
+
+void Tiler::build(const Options& options)
+{
+	tileList.clear();
+	if (refs.empty())
+		return;
+
+	// Root square over all items
+	double maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+	minX = minY = HUGE_VAL;
+	for (size_t i = 0; i < boxes.size(); i += 4) {
+		minX = std::min(minX, boxes[i]);
+		minY = std::min(minY, boxes[i + 1]);
+		maxX = std::max(maxX, boxes[i + 2]);
+		maxY = std::max(maxY, boxes[i + 3]);
+	}
+	rootSize = std::max(maxX - minX, maxY - minY);
+	if (!(rootSize > 0.0))
+		rootSize = 1.0;
+
+	std::deque<Task> queue;
+	queue.push_back(Task());
+	queue.back().z = queue.back().x = queue.back().y = 0;
+	queue.back().items.resize(refs.size());
+	for (size_t i = 0; i < refs.size(); i++)
+		queue.back().items[i] = static_cast<uint32_t>(i);
+
+#ifdef __EMSCRIPTEN__
+	std::vector<Task> children;
+	std::vector<Segment> scratch;
+	std::vector<float> arcPoints;
+	while (!queue.empty()) {
+		Task task;
+		std::swap(task, queue.front());
+		queue.pop_front();
+		tileList.push_back(Tile());
+		runTask(task, options, children, scratch, arcPoints, tileList.back());
+		if (tileList.back().segments == 0)
+			tileList.pop_back();
+		for (size_t c = 0; c < children.size(); c++) {
+			queue.push_back(Task());
+			std::swap(queue.back(), children[c]);
+		}
+	}
+#else
+	// Tiles are independent: workers take tasks from a shared queue and
+	// queue the children of tiles they split
+	std::mutex mutex;
+	std::condition_variable wake;
+	int active = 0;
+	auto worker = [&]() {
+		std::vector<Task> children;
+		std::vector<Segment> scratch;
+		std::vector<float> arcPoints;
+		Tile tile;
+		for (;;) {
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]() { return !queue.empty() || active == 0; });
+				if (queue.empty())
+					return;
+				std::swap(task, queue.front());
+				queue.pop_front();
+				active++;
+			}
+			runTask(task, options, children, scratch, arcPoints, tile);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (tile.segments > 0) {
+					tileList.push_back(Tile());
+					std::swap(tileList.back(), tile);
+				}
+				for (size_t c = 0; c < children.size(); c++) {
+					queue.push_back(Task());
+					std::swap(queue.back(), children[c]);
+				}
+				active--;
+			}
+			wake.notify_all();
+		}
+	};
+	int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; t++)
+		pool.push_back(std::thread(worker));
+	worker();
+	for (size_t t = 0; t < pool.size(); t++)
+		pool[t].join();
+#endif
+
+	std::sort(tileList.begin(), tileList.end(), [](const Tile& a, const Tile& b) {
+		if (a.z != b.z)
+			return a.z < b.z;
+		return a.y != b.y ? a.y < b.y : a.x < b.x;
+	});
+}
+
+bool decodeTile(const uint8_t* data, size_t size, DecodedTile& out)
+{
+	Reader r(data, size);
+	if (!r.magic())
+		return false;
+	out.z = static_cast<int>(r.varint());
+	out.x = static_cast<int>(r.varint());
+	out.y = static_cast<int>(r.varint());
+	out.minX = r.real();
+	out.minY = r.real();
+	out.size = r.real();
+	out.extent = static_cast<int>(r.varint());
+	uint64_t groups = r.varint();
+	out.vertices.clear();
+	out.groups.clear();
+	for (uint64_t g = 0; g < groups && r.ok; g++) {
+		Group group;
+		group.pen = static_cast<uint32_t>(r.varint());
+		uint64_t count = r.varint();
+		// Each segment takes at least four bytes
+		if (count > r.left() / 4)
+			return false;
+		group.first = static_cast<uint32_t>(out.vertices.size() / 2);
+		group.count = static_cast<uint32_t>(count * 2);
+		int64_t cx = 0, cy = 0;
+		for (uint64_t i = 0; i < count; i++) {
+			int64_t x0 = cx + r.signedVarint();
+			int64_t y0 = cy + r.signedVarint();
+			cx = x0 + r.signedVarint();
+			cy = y0 + r.signedVarint();
+			const int32_t v[4] = {static_cast<int32_t>(x0), static_cast<int32_t>(y0),
+			                      static_cast<int32_t>(cx), static_cast<int32_t>(cy)};
+			out.vertices.insert(out.vertices.end(), v, v + 4);
+		}
+		out.groups.push_back(group);
+	}
+	return r.ok;
+}
+
+} // namespace JWWTile
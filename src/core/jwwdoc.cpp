@@ -1,4 +1,11 @@
 #include "jwwdoc.h"
+#include "jww_stream.h"
+#include <memory>
+#include <cassert>
+#ifndef __EMSCRIPTEN__
+#include <atomic>
+#include <thread>
+#endif
 #define	LINEBUF_SIZE	1024
 
 void JWWDocument::WriteString(string s){
@@ -947,29 +954,32 @@ jwBOOL JWWDocument::Read()
     if(!ifs)
         return false;
 
-    jwDWORD dw;
-    string s, t;
-    jwWORD wd;
-    int	i,j;
-
-    jwBOOL ListFlag;
-    int ListCount;
-    int ListLength;
-    CDataSen	DSen;
-    CDataEnko	DEnko;
-    CDataTen	DTen;
-    CDataMoji	DMoji;
-    CDataSolid	DSolid;
-    CDataSunpou	DSunpou;
-    CDataBlock	DBlock;
-    CDataList	DList;
-
-    pBlockList->Init();
-    ListFlag = false;
-    ListLength = 0;
-    ListCount = 0;
     if(!ReadHeader())
         return false;
+    BeginRecords();
+
+    while( ReadRecord() )
+        ;
+//exitloop:
+    return true;
+}
+
+//図形データ読み込みの初期化
+//ヘッダーに続く図形データ数まで読み込む
+jwBOOL JWWDocument::BeginRecords()
+{
+    pList->Init();
+    pBlockList->Init();
+    ReadState.ListFlag = false;
+    ReadState.ListLength = 0;
+    ReadState.ListCount = 0;
+    ReadState.Index = 1;
+    ReadState.RecordCount = 0;
+    ReadState.ReadCount = 0;
+    ReadState.DefinitionPart = false;
+    ReadState.DefinitionCount = 0;
+    ReadState.DefinitionsRead = 0;
+    ReadState.Corrupt = false;
     SenCount = 0;
     EnkoCount = 0;
     TenCount = 0;
@@ -979,198 +989,391 @@ jwBOOL JWWDocument::Read()
     SunpouCount = 0;
 
     //バージョン毎にデータ読み書きを変える
-    DSen.SetVersion(Header.JW_DATA_VERSION);
-    DEnko.SetVersion(Header.JW_DATA_VERSION);
-    DTen.SetVersion(Header.JW_DATA_VERSION);
-    DMoji.SetVersion(Header.JW_DATA_VERSION);
-    DSolid.SetVersion(Header.JW_DATA_VERSION);
-    DSunpou.SetVersion(Header.JW_DATA_VERSION);
-    DBlock.SetVersion(Header.JW_DATA_VERSION);
-
+    ReadState.DSen.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DEnko.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DTen.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DMoji.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DSolid.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DSunpou.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DBlock.SetVersion(Header.JW_DATA_VERSION);
+    ReadState.DList.SetVersion(Header.JW_DATA_VERSION);
+
+    //図形データ数
+    jwWORD wd;
+    jwDWORD dw;
     *ifs >> wd;
     if( wd == 0xFFFF )
     {
         *ifs >> dw;
-//        j = dw;
-	}
-//	else j = wd;
+        ReadState.RecordCount = dw;
+    }
+    else
+        ReadState.RecordCount = wd;
+    if( ifs->fail() )
+        return false;
+    if( pHandler )
+        pHandler->OnHeader(Header);
+    return true;
+}
+
+//図形データを1レコード読み込む
+//レコード全体を読めた場合のみ結果を反映する(途中で入力が尽きた場合は false)
+jwBOOL JWWDocument::ReadRecord()
+{
+    jwWORD wd;
+    jwDWORD dw;
+    string s, className;
+    int j;
+    int i = ReadState.Index;
+    jwBOOL listFlag = ReadState.ListFlag;
+    int listCount = ReadState.ListCount;
+    int listLength = ReadState.ListLength;
 
-    i = 1;
+    //ブロック図形定義まで読み終えたら、続くデータ(画像など)は読まない
+    if( RecordsComplete() )
+        return false;
 
-    while( !ifs->eof() )
+    //図形データに続くブロック図形定義数(オブジェクトではないので番号は進めない)
+    if( !ReadState.DefinitionPart && ReadState.ReadCount >= ReadState.RecordCount )
     {
         *ifs >> wd;
-        switch(wd){
-        case	0x0000:
-            continue;//goto exitloop;
-            break;
-        case	0xFFFF:
-            {
-                *ifs >> wd;
-                objCode = wd;
-                *ifs >> wd;
-                s = ReadData(wd);
-                pList->AddItem(i,s);
-                j = i;
-                i++;
-            }
-            break;
-        case	0xFF7F:
-             {
-                *ifs >> dw;
-                j = dw & 0x7FFFFFFF;
-            }
-            break;
-        case	0x7FFF:
-            {
-                *ifs >> dw;
-                j = dw & 0x7FFFFFFF;
-            }
-            break;
-        default:
+        dw = wd;
+        if( !ifs->fail() && wd == 0xFFFF )
+            *ifs >> dw;
+        if( ifs->fail() )
+            return false;
+        ReadState.DefinitionPart = true;
+        ReadState.DefinitionCount = dw;
+        return true;
+    }
+
+    *ifs >> wd;
+    if( ifs->fail() )
+        return false;
+    switch(wd){
+    case	0x0000:
+        return true;
+    case	0xFFFF:
+        {
+            *ifs >> wd;
+            objCode = wd;
+            *ifs >> wd;
+            if( ifs->fail() )
+                return false;
+            //クラス名は短い。長さが不正なら壊れたデータ
+            if( wd == 0 || wd > 64 )
             {
-                if(wd & 0x8000)
-                    j = wd & 0x7FFF;
-                else
-                    j = 0;
+                ReadState.Corrupt = true;
+                return false;
             }
+            className = ReadData(wd);
+            j = i;
+            i++;
         }
-        s = pList->GetNoByItem(j).CDataString;
-#ifdef	DATA_DUMP
-cout << s << endl;
-#endif
-        if( ListCount == ListLength )
-            ListFlag = false;
-        if(s == "CDataList")
-        {
-            ListFlag = true;
-            ListCount = 0;
-            DList.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DList;
-#endif
-            pBlockList->AddBlockList(DList);
-            ListLength = DList.Count;
-        }
-        if( s == "CDataSen" )
+        break;
+    case	0xFF7F:
+    case	0x7FFF:
         {
-            DSen.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DSen;
-#endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListSen(DSen);
-                ListCount++;
-            } else
-            {
-                vSen.push_back(DSen);
-                SenCount++;
-            }
+            *ifs >> dw;
+            j = dw & 0x7FFFFFFF;
         }
-        if( s == "CDataEnko")
+        break;
+    default:
         {
-            DEnko.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DEnko;
-#endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListEnko(DEnko);
-                ListCount++;
-            }
+            if(wd & 0x8000)
+                j = wd & 0x7FFF;
             else
-            {
-                vEnko.push_back(DEnko);
-                EnkoCount++;
-            }
+                j = 0;
         }
-        if( s == "CDataTen" )
-        {
-            DTen.Serialize(*ifs);
+    }
+    if( ifs->fail() )
+        return false;
+    if( !className.empty() )
+        s = className;
+    else if( pList->GetCount() > 0 )
+        s = pList->GetNoByItem(j).CDataString;
 #ifdef	DATA_DUMP
-cout << DTen;
+cout << s << endl;
 #endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListTen(DTen);
-                ListCount++;
-            } else
-            {
-                vTen.push_back(DTen);
-                TenCount++;
-            }
-        }
-        if( s == "CDataMoji" )
-        {
-            DMoji.Serialize(*ifs);
+    if( listCount == listLength )
+        listFlag = false;
+
+    CDataType type;
+    if( s == "CDataList" )
+    {
+        ReadState.DList.Serialize(*ifs);
+        if( ifs->fail() )
+            return false;
 #ifdef	DATA_DUMP
-cout << DMoji;
+cout << ReadState.DList;
 #endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListMoji(DMoji);
-                ListCount++;
-            } else
-            {
-                vMoji.push_back(DMoji);
-                MojiCount++;
-            }
-        }
-        if( s == "CDataSolid" )
+        if( pHandler && pHandler->WantsBlockLists() )
+            pHandler->OnBlockList(ReadState.DList);
+        else
+            pBlockList->AddBlockList(ReadState.DList);
+        listFlag = true;
+        listCount = 0;
+        listLength = ReadState.DList.Count;
+        ReadState.DefinitionsRead++;
+        if( listLength == 0 && pHandler && pHandler->WantsBlockLists() )
+            pHandler->OnBlockListEnd();
+    }
+    else if( ReadRecordBody(s, type) )
+    {
+        if( listFlag )
         {
-            DSolid.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DSolid;
-#endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListSolid(DSolid);
-                ListCount++;
-            } else
-            {
-                vSolid.push_back(DSolid);
-                SolidCount++;
-            }
+            AddBlockListRecord(type);
+            listCount++;
+            if( listCount == listLength && pHandler && pHandler->WantsBlockLists() )
+                pHandler->OnBlockListEnd();
         }
-        if( s == "CDataBlock" )
+        else
         {
-            DBlock.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DBlock;
-#endif
-            if(ListFlag)
-            {
-                pBlockList->AddDataListBlock(DBlock);
-                ListCount++;
-            } else
-            {
-                vBlock.push_back(DBlock);
-                BlockCount++;
-            }
+            AddRecord(type);
+            ReadState.ReadCount++;
         }
-        if( s == "CDataSunpou" )
+    }
+    else if( ifs->fail() )
+        return false;
+    else if( !s.empty() )
+    {
+        //長さのわからない不明なクラスの先は読めない
+        ReadState.Corrupt = true;
+        return false;
+    }
+
+    if( !className.empty() )
+        pList->AddItem(j, className);
+    if( !s.empty() )
+        i++;
+    ReadState.Index = i;
+    ReadState.ListFlag = listFlag;
+    ReadState.ListCount = listCount;
+    ReadState.ListLength = listLength;
+    return true;
+}
+
+//図形データとブロック図形定義をすべて読み込んだ
+jwBOOL JWWDocument::RecordsComplete() const
+{
+    return ReadState.DefinitionPart && ReadState.DefinitionsRead >= ReadState.DefinitionCount
+        && ReadState.ListCount >= ReadState.ListLength;
+}
+
+//クラス名に応じてレコード本体を読み込む
+jwBOOL JWWDocument::ReadRecordBody(const string& s, CDataType& type)
+{
+    if( s == "CDataSen" )
+    {
+        ReadState.DSen.Serialize(*ifs);
+        type = Sen;
+    }
+    else if( s == "CDataEnko" )
+    {
+        ReadState.DEnko.Serialize(*ifs);
+        type = Enko;
+    }
+    else if( s == "CDataTen" )
+    {
+        ReadState.DTen.Serialize(*ifs);
+        type = Ten;
+    }
+    else if( s == "CDataMoji" )
+    {
+        ReadState.DMoji.Serialize(*ifs);
+        type = Moji;
+    }
+    else if( s == "CDataSolid" )
+    {
+        ReadState.DSolid.Serialize(*ifs);
+        type = Solid;
+    }
+    else if( s == "CDataBlock" )
+    {
+        ReadState.DBlock.Serialize(*ifs);
+        type = Block;
+    }
+    else if( s == "CDataSunpou" )
+    {
+        ReadState.DSunpou.Serialize(*ifs);
+        type = Sunpou;
+    }
+    else
+        return false;
+    return !ifs->fail();
+}
+
+//ブロック定義部へ追加(ブロック定義部を受け取るハンドラがあればハンドラへ渡す)
+void JWWDocument::AddBlockListRecord(CDataType type)
+{
+    if( pHandler && pHandler->WantsBlockLists() )
+    {
+        switch(type)
         {
-            DSunpou.Serialize(*ifs);
-#ifdef	DATA_DUMP
-cout << DSunpou;
-#endif
-            if( ListFlag )
-            {
-                pBlockList->AddDataListSunpou(DSunpou);
-                ListCount++;
-            } else
-            {
-                vSunpou.push_back(DSunpou);
-                SunpouCount++;
-            }
+        case	Sen :
+            pHandler->OnSen(ReadState.DSen);
+            break;
+        case	Enko:
+            pHandler->OnEnko(ReadState.DEnko);
+            break;
+        case	Ten:
+            pHandler->OnTen(ReadState.DTen);
+            break;
+        case	Moji:
+            pHandler->OnMoji(ReadState.DMoji);
+            break;
+        case	Solid:
+            pHandler->OnSolid(ReadState.DSolid);
+            break;
+        case	Sunpou:
+            pHandler->OnSunpou(ReadState.DSunpou);
+            break;
+        case	Block:
+            pHandler->OnBlock(ReadState.DBlock);
+            break;
         }
-        if( !s.empty() )
-            i++;
-        s = "";
+        return;
     }
-//exitloop:
-    return true;
+    switch(type)
+    {
+    case	Sen :
+        pBlockList->AddDataListSen(ReadState.DSen);
+        break;
+    case	Enko:
+        pBlockList->AddDataListEnko(ReadState.DEnko);
+        break;
+    case	Ten:
+        pBlockList->AddDataListTen(ReadState.DTen);
+        break;
+    case	Moji:
+        pBlockList->AddDataListMoji(ReadState.DMoji);
+        break;
+    case	Solid:
+        pBlockList->AddDataListSolid(ReadState.DSolid);
+        break;
+    case	Sunpou:
+        pBlockList->AddDataListSunpou(ReadState.DSunpou);
+        break;
+    case	Block:
+        pBlockList->AddDataListBlock(ReadState.DBlock);
+        break;
+    }
+}
+
+//図形データを格納(ハンドラがあればハンドラへ渡す)
+void JWWDocument::AddRecord(CDataType type)
+{
+    switch(type)
+    {
+    case	Sen :
+        if( pHandler ) pHandler->OnSen(ReadState.DSen);
+        else vSen.push_back(ReadState.DSen);
+        SenCount++;
+        break;
+    case	Enko:
+        if( pHandler ) pHandler->OnEnko(ReadState.DEnko);
+        else vEnko.push_back(ReadState.DEnko);
+        EnkoCount++;
+        break;
+    case	Ten:
+        if( pHandler ) pHandler->OnTen(ReadState.DTen);
+        else vTen.push_back(ReadState.DTen);
+        TenCount++;
+        break;
+    case	Moji:
+        if( pHandler ) pHandler->OnMoji(ReadState.DMoji);
+        else vMoji.push_back(ReadState.DMoji);
+        MojiCount++;
+        break;
+    case	Solid:
+        if( pHandler ) pHandler->OnSolid(ReadState.DSolid);
+        else vSolid.push_back(ReadState.DSolid);
+        SolidCount++;
+        break;
+    case	Sunpou:
+        if( pHandler ) pHandler->OnSunpou(ReadState.DSunpou);
+        else vSunpou.push_back(ReadState.DSunpou);
+        SunpouCount++;
+        break;
+    case	Block:
+        if( pHandler ) pHandler->OnBlock(ReadState.DBlock);
+        else vBlock.push_back(ReadState.DBlock);
+        BlockCount++;
+        break;
+    }
+}
+
+//読み込んだ図形データを破棄する
+//vSenなどの確保済み領域は次のファイルの読み込みに再利用する
+void JWWDocument::Clear()
+{
+    vSen.clear();
+    vEnko.clear();
+    vTen.clear();
+    vMoji.clear();
+    vSolid.clear();
+    vBlock.clear();
+    vSunpou.clear();
+    pList->Init();
+    pBlockList->Init();
+    SenCount = 0;
+    EnkoCount = 0;
+    TenCount = 0;
+    MojiCount = 0;
+    SolidCount = 0;
+    BlockCount = 0;
+    SunpouCount = 0;
+}
+
+//図形データ用に確保済みの領域(バイト数)
+size_t JWWDocument::ReservedBytes() const
+{
+    return vSen.capacity() * sizeof(CDataSen)
+        + vEnko.capacity() * sizeof(CDataEnko)
+        + vTen.capacity() * sizeof(CDataTen)
+        + vMoji.capacity() * sizeof(CDataMoji)
+        + vSolid.capacity() * sizeof(CDataSolid)
+        + vBlock.capacity() * sizeof(CDataBlock)
+        + vSunpou.capacity() * sizeof(CDataSunpou);
+}
+
+//確保済みの領域を解放する
+void JWWDocument::ReleaseMemory()
+{
+    Clear();
+    vector<CDataSen>().swap(vSen);
+    vector<CDataEnko>().swap(vEnko);
+    vector<CDataTen>().swap(vTen);
+    vector<CDataMoji>().swap(vMoji);
+    vector<CDataSolid>().swap(vSolid);
+    vector<CDataBlock>().swap(vBlock);
+    vector<CDataSunpou>().swap(vSunpou);
+}
+
+//入力元を差し替える(メモリ上のバッファやストリーム用のstreambufなど)
+//差し替え中のifsはistreamとしてのみ使うこと。ifs->rdbuf()とis_open()は
+//ifstream自身のfilebufを指したままで、差し替えたsbを返さない。
+//nullptrを渡すとifstream自身の(閉じた)filebufに戻す。
+void JWWDocument::AttachInput(std::streambuf* sb)
+{
+    if( !ifs )
+        ifs = new ifstream();
+    else if( ifs->is_open() )
+        ifs->close();
+    static_cast<std::ios&>(*ifs).rdbuf(sb ? sb : ifs->rdbuf());
+    assert(!ifs->is_open());
+}
+
+//出力先を差し替える(JWWOutputBufなどメモリ上のバッファ)
+//AttachInputと同じくofsはostreamとしてのみ使うこと。
+void JWWDocument::AttachOutput(std::streambuf* sb)
+{
+    if( !ofs )
+        ofs = new ofstream();
+    else if( ofs->is_open() )
+        ofs->close();
+    static_cast<std::ios&>(*ofs).rdbuf(sb ? sb : ofs->rdbuf());
+    assert(!ofs->is_open());
 }
 
 jwBOOL JWWDocument::SaveBich16(jwDWORD id)
@@ -1181,28 +1384,48 @@ jwBOOL JWWDocument::SaveBich16(jwDWORD id)
     return false;
 }
 
-//線
-jwBOOL JWWDocument::SaveSen(CDataSen const& DSen)
+//クラス定義(define)かクラス番号の参照
+static void EncodeClassTag(JWWRecordBuffer& rec, jwWORD objCode, jwDWORD classNo, jwBOOL define, const char* name)
 {
-    jwWORD wd;
-    string s;
-    if( SaveSenCount == 0 )
+    if( define )
     {
-        PSen=Mpoint;
-        Mpoint++;
-        wd = 0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataSen";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    }else
+        jwWORD len=strlen(name);
+        rec << (jwWORD)0xFFFF << objCode << len;
+        rec.write(name, len);
+    }
+    else if( JWWDocument::SaveBich16(classNo) )
+        rec << (jwWORD)(classNo | 0x8000);
+    else
+        rec << (jwWORD)0x7FFF << (jwDWORD)(classNo | 0x80000000);
+}
+
+//レコード本体。固定長のものはクラス番号と合わせて1回で書き出す
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataSen const& D){ D.Serialize(rec); rec.WriteTo(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataEnko const& D){ D.Serialize(rec); rec.WriteTo(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataTen const& D){ D.Serialize(rec); rec.WriteTo(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataSolid const& D){ D.Serialize(rec); rec.WriteTo(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataMoji const& D){ rec.WriteTo(os); D.Serialize(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataSunpou const& D){ rec.WriteTo(os); D.Serialize(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataBlock const& D){ rec.WriteTo(os); D.Serialize(os); }
+static void WriteBody(std::ofstream& os, JWWRecordBuffer& rec, CDataList const& D){ rec.WriteTo(os); D.Serialize(os); }
+
+//クラス定義(ファイル中で最初のレコード)かクラス番号の参照をレコードの先頭に付ける
+void JWWDocument::SaveClassTag(JWWRecordBuffer& rec, jwDWORD& classNo, jwDWORD count, const char* name)
+{
+    if( count == 0 )
     {
-        wd=PSen | 0x8000;
-        *ofs << wd;
+        classNo=Mpoint;
+        Mpoint++;
     }
-    DSen.Serialize(*ofs);
+    EncodeClassTag(rec, objCode, classNo, count == 0, name);
+}
+
+//線
+jwBOOL JWWDocument::SaveSen(CDataSen const& DSen)
+{
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PSen, SaveSenCount, "CDataSen");
+    WriteBody(*ofs, rec, DSen);
     SaveSenCount++;
     Mpoint++;
     return true;
@@ -1211,36 +1434,9 @@ jwBOOL JWWDocument::SaveSen(CDataSen const& DSen)
 // 円
 jwBOOL JWWDocument::SaveEnko(CDataEnko const& DEnko)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-    if( SaveEnkoCount == 0 )
-    {
-        PEnko=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataEnko";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    }else
-    {
-        if( SaveBich16(PEnko) )
-        {
-            wd=PEnko | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PEnko | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DEnko.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PEnko, SaveEnkoCount, "CDataEnko");
+    WriteBody(*ofs, rec, DEnko);
     SaveEnkoCount++;
     Mpoint++;
     return true;
@@ -1249,77 +1445,20 @@ jwBOOL JWWDocument::SaveEnko(CDataEnko const& DEnko)
 // 点
 jwBOOL JWWDocument::SaveTen(CDataTen const& DTen)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveTenCount == 0 )
-    {
-        PTen=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataTen";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    }else
-    {
-        if( SaveBich16(PTen) )
-        {
-            wd=PTen | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            *ofs << wd;
-            dw=PTen | 0x80000000;
-            *ofs << dw;
-        }
-    }
-    DTen.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PTen, SaveTenCount, "CDataTen");
+    WriteBody(*ofs, rec, DTen);
     SaveTenCount++;
     Mpoint++;
     return true;
-
 }
 
 // 文字
 jwBOOL JWWDocument::SaveMoji(CDataMoji const& DMoji)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveMojiCount == 0 )
-    {
-        PMoji=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataMoji";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    }else
-    {
-        if( SaveBich16(PMoji) )
-        {
-            wd=PMoji | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PMoji | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DMoji.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PMoji, SaveMojiCount, "CDataMoji");
+    WriteBody(*ofs, rec, DMoji);
     SaveMojiCount++;
     Mpoint++;
     return true;
@@ -1328,37 +1467,9 @@ jwBOOL JWWDocument::SaveMoji(CDataMoji const& DMoji)
 // 寸法
 jwBOOL JWWDocument::SaveSunpou(CDataSunpou const& DSunpou)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveSunpouCount == 0 )
-    {
-        PSunpou=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataSunpou";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    } else
-    {
-        if( SaveBich16(PSunpou) )
-        {
-            wd=PSunpou | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PSunpou | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DSunpou.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PSunpou, SaveSunpouCount, "CDataSunpou");
+    WriteBody(*ofs, rec, DSunpou);
     SaveSunpouCount++;
     Mpoint++;
     return true;
@@ -1367,37 +1478,9 @@ jwBOOL JWWDocument::SaveSunpou(CDataSunpou const& DSunpou)
 // ソリッド
 jwBOOL JWWDocument::SaveSolid(CDataSolid const& DSolid)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveSolidCount == 0 )
-    {
-        PSolid=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataSolid";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    } else
-    {
-        if( SaveBich16(PSolid) )
-        {
-            wd=PSolid | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PSolid | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DSolid.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PSolid, SaveSolidCount, "CDataSolid");
+    WriteBody(*ofs, rec, DSolid);
     SaveSolidCount++;
     Mpoint++;
     return true;
@@ -1406,37 +1489,9 @@ jwBOOL JWWDocument::SaveSolid(CDataSolid const& DSolid)
 // ブロック
 jwBOOL JWWDocument::SaveBlock(CDataBlock const& DBlock)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveBlockCount == 0 )
-    {
-        PBlock=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataBlock";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    } else
-    {
-        if( SaveBich16(PBlock) )
-        {
-            wd=PBlock | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PBlock | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DBlock.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PBlock, SaveBlockCount, "CDataBlock");
+    WriteBody(*ofs, rec, DBlock);
     SaveBlockCount++;
     Mpoint++;
     return true;
@@ -1445,50 +1500,26 @@ jwBOOL JWWDocument::SaveBlock(CDataBlock const& DBlock)
 // データリスト
 jwBOOL JWWDocument::SaveDataList(CDataList const& DList)
 {
-    jwWORD wd;
-    jwDWORD dw;
-    string s;
-
-    if( SaveDataListCount == 0 )
-    {
-        PList=Mpoint;
-        Mpoint++;
-        wd=0xFFFF;
-        *ofs << wd;
-        *ofs << objCode;
-        s="CDataList";
-        wd=s.length();
-        *ofs << wd;
-        ofs->write(s.c_str(), wd);
-    } else
-    {
-        if( SaveBich16(PList) )
-        {
-            wd=PList | 0x8000;
-            *ofs << wd;
-        }
-        else
-        {
-            wd= 0x7FFF;
-            dw=PList | 0x80000000;
-            *ofs << wd;
-            *ofs << dw;
-        }
-    }
-    DList.Serialize(*ofs);
+    JWWRecordBuffer rec;
+    SaveClassTag(rec, PList, SaveDataListCount, "CDataList");
+    WriteBody(*ofs, rec, DList);
     SaveDataListCount++;
     Mpoint++;
     return true;
 }
 
-//データファイル保存
-jwBOOL JWWDocument::Save()
+//データ数(0x8000以上なら0xFFFFに続けてDWORD)
+void JWWDocument::SaveCount(jwDWORD n)
+{
+    if( SaveBich16(n) )
+        *ofs << (jwWORD)n;
+    else
+        *ofs << (jwWORD)0xFFFF << n;
+}
+
+//書き出し前の初期化とヘッダー、図形データ数
+void JWWDocument::BeginSave()
 {
-    if(!ofs)
-        return false;
-    jwDWORD dw;
-    jwWORD wd;
-    string s;
     SaveSenCount=0;
     SaveEnkoCount=0;
     SaveTenCount=0;
@@ -1500,34 +1531,19 @@ jwBOOL JWWDocument::Save()
 
     WriteHeader();
     //データ出力
-    dw = vSen.size() + vEnko.size() + vTen.size() + vMoji.size() + vSunpou.size() + vSolid.size() + vBlock.size();// + 7;
-    if( SaveBich16(dw) )
-        ofs->write((char*)&dw,2);
-    else
-    {
-        wd= 0xFFFF;
-        *ofs << wd;
-        *ofs << dw;
-    }
+    SaveCount(vSen.size() + vEnko.size() + vTen.size() + vMoji.size() + vSunpou.size() + vSolid.size() + vBlock.size());
     Mpoint=1;
+}
+
+//ブロック図形定義数と定義データ
+void JWWDocument::SaveBlockLists()
+{
+    jwDWORD dw;
     unsigned int i;
     int j;
-    for( i=0 ; i < vSen.size(); i++ )
-        SaveSen(vSen[i]);
-    for( i=0 ; i < vEnko.size(); i++ )
-        SaveEnko(vEnko[i]);
-    for( i=0 ; i < vTen.size(); i++ )
-        SaveTen(vTen[i]);
-    for( i=0 ; i < vMoji.size(); i++ )
-        SaveMoji(vMoji[i]);
-    for( i=0 ; i < vSunpou.size(); i++ )
-        SaveSunpou(vSunpou[i]);
-    for( i=0 ; i < vSolid.size(); i++ )
-        SaveSolid(vSolid[i]);
-    for( i=0 ; i < vBlock.size(); i++)
-        SaveBlock(vBlock[i]);
+    //ブロック図形定義数(図形データ数と同じ形式)
     dw=pBlockList->getBlockListCount();
-    *ofs << dw;
+    SaveCount(dw);
     for( i=0; i < dw; i++ )
     {
         SaveDataList(pBlockList->GetBlockList(i));
@@ -1560,9 +1576,129 @@ jwBOOL JWWDocument::Save()
             }
         }
     }
+}
+
+//データファイル保存
+jwBOOL JWWDocument::Save()
+{
+    if(!ofs)
+        return false;
+    BeginSave();
+    unsigned int i;
+    for( i=0 ; i < vSen.size(); i++ )
+        SaveSen(vSen[i]);
+    for( i=0 ; i < vEnko.size(); i++ )
+        SaveEnko(vEnko[i]);
+    for( i=0 ; i < vTen.size(); i++ )
+        SaveTen(vTen[i]);
+    for( i=0 ; i < vMoji.size(); i++ )
+        SaveMoji(vMoji[i]);
+    for( i=0 ; i < vSunpou.size(); i++ )
+        SaveSunpou(vSunpou[i]);
+    for( i=0 ; i < vSolid.size(); i++ )
+        SaveSolid(vSolid[i]);
+    for( i=0 ; i < vBlock.size(); i++)
+        SaveBlock(vBlock[i]);
+    SaveBlockLists();
     return true;
 }
 
+//図形データvの[begin, end)番目を書き出す。0番目の前にクラス定義が入る
+template<class T>
+static void SaveRange(std::ofstream& os, jwWORD objCode, const vector<T>& v, size_t begin, size_t end, jwDWORD classNo, const char* name)
+{
+    for( size_t i = begin; i < end; i++ )
+    {
+        JWWRecordBuffer rec;
+        EncodeClassTag(rec, objCode, classNo, i == 0, name);
+        WriteBody(os, rec, v[i]);
+    }
+}
+
+//データファイル保存(図形データを分割して threads 本のスレッドで書き出す。0はハードウェアスレッド数)
+//クラス番号は区分ごとのデータ数から先に決まるので、各部分を別々のバッファへ書いて
+//順に連結すればSave()と同じ内容になる。ブロック定義部は続けて順に書き出す
+jwBOOL JWWDocument::SaveParallel(int threads)
+{
+#ifdef __EMSCRIPTEN__
+    (void)threads;
+    return Save();
+#else
+    if(!ofs)
+        return false;
+    BeginSave();
+
+    //区分ごとの最初のクラス番号と、書き終えた後の件数
+    enum{ SectionCount = 7 };
+    struct Section{ size_t Size; jwDWORD* ClassNo; jwDWORD* Count; } sections[SectionCount] = {
+        { vSen.size(), &PSen, &SaveSenCount },
+        { vEnko.size(), &PEnko, &SaveEnkoCount },
+        { vTen.size(), &PTen, &SaveTenCount },
+        { vMoji.size(), &PMoji, &SaveMojiCount },
+        { vSunpou.size(), &PSunpou, &SaveSunpouCount },
+        { vSolid.size(), &PSolid, &SaveSolidCount },
+        { vBlock.size(), &PBlock, &SaveBlockCount }
+    };
+    //1タスクが受け持つ図形データ数
+    const size_t chunk = 16384;
+    struct Task{ int Section; size_t Begin, End; };
+    vector<Task> tasks;
+    for( int k = 0; k < SectionCount; k++ )
+    {
+        if( sections[k].Size == 0 )
+            continue;
+        *sections[k].ClassNo = Mpoint;
+        Mpoint += sections[k].Size + 1;
+        *sections[k].Count = sections[k].Size;
+        for( size_t b = 0; b < sections[k].Size; b += chunk )
+        {
+            Task t = { k, b, std::min(b + chunk, sections[k].Size) };
+            tasks.push_back(t);
+        }
+    }
+
+    vector<std::unique_ptr<JWWOutputBuf> > parts(tasks.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for( size_t t; (t = next++) < tasks.size(); )
+        {
+            const Task& task = tasks[t];
+            parts[t].reset(new JWWOutputBuf());
+            //SaveRangeはjwtype.hの演算子に合わせてofstream&を取るので、
+            //閉じたofstreamをpartsのバッファに向けてostreamとしてのみ使う
+            std::ofstream os;
+            static_cast<std::ios&>(os).rdbuf(parts[t].get());
+            switch( task.Section )
+            {
+            case 0: SaveRange(os, objCode, vSen, task.Begin, task.End, PSen, "CDataSen"); break;
+            case 1: SaveRange(os, objCode, vEnko, task.Begin, task.End, PEnko, "CDataEnko"); break;
+            case 2: SaveRange(os, objCode, vTen, task.Begin, task.End, PTen, "CDataTen"); break;
+            case 3: SaveRange(os, objCode, vMoji, task.Begin, task.End, PMoji, "CDataMoji"); break;
+            case 4: SaveRange(os, objCode, vSunpou, task.Begin, task.End, PSunpou, "CDataSunpou"); break;
+            case 5: SaveRange(os, objCode, vSolid, task.Begin, task.End, PSolid, "CDataSolid"); break;
+            case 6: SaveRange(os, objCode, vBlock, task.Begin, task.End, PBlock, "CDataBlock"); break;
+            }
+        }
+    };
+    size_t n = threads > 0 ? threads : std::thread::hardware_concurrency();
+    n = std::max((size_t)1, std::min(n, tasks.size()));
+    vector<std::thread> pool;
+    for( size_t t = 1; t < n; t++ )
+        pool.push_back(std::thread(worker));
+    worker();
+    for( size_t t = 0; t < pool.size(); t++ )
+        pool[t].join();
+
+    for( size_t t = 0; t < parts.size(); t++ )
+    {
+        ofs->write(parts[t]->data(), parts[t]->size());
+        parts[t].reset();
+    }
+    SaveBlockLists();
+    return true;
+#endif
+}
+
 void JWWList::AddItem(int No, string& str)
 {
     PNoList	nList = new NoList;
@@ -1586,6 +1722,17 @@ JWWList::~JWWList()
     FList.clear();
 }
 
+//登録済みクラス名を破棄してNULLデータのみに戻す
+void JWWList::Init()
+{
+    for( unsigned int i=0; i < FList.size(); i++)
+        if(FList[i])
+            delete FList[i];
+    FList.clear();
+    string str = "";
+    AddItem(0, str);
+}
+
 int JWWList::GetCount()
 {
     return FList.size();
@@ -1641,7 +1788,7 @@ JWWBlockList::~JWWBlockList()
 CDataList JWWBlockList::GetBlockList(unsigned int i)
 {
     for(unsigned int k=0; k < FBlockList.size(); k++)
-        if(i == FBlockList[k]->m_n_Number)
+        if(i == PCDataList(FBlockList[k])->m_nNumber)
             return *(PCDataList)FBlockList[k];
     return {};
 }
@@ -20,6 +20,25 @@ export interface JSLayerData {
 export interface JWWDocumentWASM {
 	loadFromMemory(dataPtr: number, size: number): boolean;
 	getEntities(): JSEntityData[];
+	// Lines and curves bucketed by pen; views valid until the next call
+	getRenderCommands(
+		tolerance: number,
+		originX: number,
+		originY: number,
+	): {
+		vertices: Float32Array;
+		groups: Array<{
+			color: number;
+			rgb: number;
+			width: number;
+			lineType: number;
+			layer: number;
+			first: number;
+			count: number;
+		}>;
+		layers: string[];
+		lineTypes: string[];
+	};
 	getLayers(): JSLayerData[];
 	getEntityCount(): number;
 	getLayerCount(): number;
@@ -49,6 +68,24 @@ export interface WASMModule {
 		unlink(path: string): void;
 	};
 
+	// Module-wide heap accounting (live bytes per category, peak since a
+	// reader last started parsing)
+	getModuleMemoryStats(): {
+		enabled: boolean;
+		liveBytes: number;
+		peakBytes: number;
+		allocations: number;
+		frees: number;
+		inputBytes: number;
+		documentBytes: number;
+		entityBytes: number;
+		indexBytes: number;
+		otherBytes: number;
+	};
+
+	// Instruction set of the geometry kernels ("wasm-simd128" or "scalar")
+	getSimdBackend(): string;
+
 	// Classes
 	JWWDocumentWASM: new () => JWWDocumentWASM;
 
@@ -5,99 +5,896 @@ import { fileURLToPath } from "node:url";
 
 let moduleInstance = null;
 
-async function init() {
+// Smallest module using a v128 instruction (i8x16.splat + i8x16.popcnt).
+// It only validates on engines with WebAssembly SIMD support.
+const SIMD_PROBE = new Uint8Array([
+	0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8,
+	0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+// Module flavors, preferred first. Import paths stay literal for bundlers.
+const FLAVORS = {
+	simd: {
+		cjs: "../../wasm/jwwlib.simd.cjs",
+		wasm: "../../wasm/jwwlib.simd.wasm",
+		importBrowser: () => import("../../wasm/jwwlib.simd.js"),
+	},
+	baseline: {
+		cjs: "../../wasm/jwwlib.cjs",
+		wasm: "../../wasm/jwwlib.wasm",
+		importBrowser: () => import("../../wasm/jwwlib.js"),
+	},
+};
+
+/**
+ * Whether the running engine can execute the SIMD128 build.
+ */
+export function isSimdSupported() {
+	try {
+		return (
+			typeof WebAssembly === "object" &&
+			typeof WebAssembly.validate === "function" &&
+			WebAssembly.validate(SIMD_PROBE)
+		);
+	} catch (_e) {
+		return false;
+	}
+}
+
+function isNode() {
+	return (
+		typeof process !== "undefined" && process.versions && process.versions.node
+	);
+}
+
+// Node.js environment - use require with CommonJS wrapper
+async function loadNode(flavor) {
+	const __filename = fileURLToPath(import.meta.url);
+	const __dirname = dirname(__filename);
+	const require = createRequire(import.meta.url);
+	const createJWWModule = require(join(__dirname, flavor.cjs));
+
+	// Read WASM file for Node.js
+	const fs = await import("node:fs");
+	const wasmPath = join(__dirname, flavor.wasm);
+	const wasmBinary = fs.readFileSync(wasmPath);
+
+	return createJWWModule({
+		wasmBinary: wasmBinary,
+	});
+}
+
+function verifyInstance(instance) {
+	// Verify the module was initialized properly
+	if (!instance || !instance._malloc || !instance.JWWReader) {
+		throw new Error("WASM module initialized but required exports are missing");
+	}
+	return instance;
+}
+
+// Browser/bundler environment - use dynamic import
+async function loadBrowser(flavor) {
+	const module = await flavor.importBrowser();
+	// The module exports createJWWModule directly
+	const createJWWModule = module.default || module.createJWWModule || module;
+
+	if (typeof createJWWModule === "function") {
+		return verifyInstance(await createJWWModule());
+	}
+	// If createJWWModule is not a function, the module might be the factory itself
+	if (typeof module === "function") {
+		return verifyInstance(await module());
+	}
+	throw new Error("Invalid WASM module format");
+}
+
+/**
+ * Load the WASM module.
+ *
+ * @param {{ simd?: boolean }} [options] Pass `simd: false` to force the
+ *   baseline build. By default the SIMD128 build is used when the engine
+ *   supports it, falling back to the baseline build if it fails to load.
+ */
+async function init(options = {}) {
 	if (moduleInstance) {
 		return moduleInstance;
 	}
 
-	// Node.js environment - use require with CommonJS wrapper
+	const load = isNode() ? loadNode : loadBrowser;
+	const flavors =
+		options.simd !== false && isSimdSupported()
+			? [FLAVORS.simd, FLAVORS.baseline]
+			: [FLAVORS.baseline];
+
+	let lastError = null;
+	for (const flavor of flavors) {
+		try {
+			moduleInstance = await load(flavor);
+			return moduleInstance;
+		} catch (e) {
+			lastError = e;
+		}
+	}
+	throw new Error(`Failed to load WASM module: ${lastError.message}`);
+}
+
+/**
+ * Instruction set of the loaded module's geometry kernels
+ * ("wasm-simd128" or "scalar").
+ */
+export function getSimdBackend() {
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	return moduleInstance.getSimdBackend();
+}
+
+/**
+ * The JWW file in `buffer` as an SVG string, converted in one pass in WASM:
+ * one <path> per pen color, arcs as SVG arcs, blocks as <use> and texts in
+ * UTF-8. Options: `precision` (decimal places, default 2), `quantum` (snap
+ * coordinates to multiples of it, default 0 = off), `strokeWidth` (drawing
+ * units; default 0 = 1 pixel at any zoom) and `texts` (default true).
+ */
+export function toSVG(buffer, options = {}) {
+	const { precision = 2, quantum = 0, strokeWidth = 0, texts = true } = options;
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	const dataPtr = moduleInstance._malloc(bytes.byteLength);
+	let svg;
+	try {
+		moduleInstance.HEAPU8.set(bytes, dataPtr);
+		svg = moduleInstance.jwwToSVG(dataPtr, bytes.byteLength, precision, quantum, strokeWidth, texts);
+	} finally {
+		moduleInstance._free(dataPtr);
+	}
+	if (!svg) {
+		throw new Error("Input is not a valid JWW file");
+	}
+	return svg;
+}
+
+/**
+ * The JWW file in `buffer` as NDJSON, one record per line, written in WASM
+ * straight from the decoded records (see include/jww_json.h for the
+ * fields). With `onChunk` the output is streamed: it is called with
+ * Uint8Array views of UTF-8 text, each ending on a line boundary and valid
+ * only during the call. Without it the whole text is returned. Options:
+ * `chunkSize` (bytes, default 65536), `header` and `texts` (default true).
+ */
+export function toNDJSON(buffer, options = {}) {
+	const { chunkSize = 65536, header = true, texts = true, onChunk } = options;
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	const dataPtr = moduleInstance._malloc(bytes.byteLength);
+	let result;
+	try {
+		moduleInstance.HEAPU8.set(bytes, dataPtr);
+		result = moduleInstance.jwwToNDJSON(dataPtr, bytes.byteLength, chunkSize, header, texts, onChunk);
+	} finally {
+		moduleInstance._free(dataPtr);
+	}
+	if (result === false) {
+		throw new Error("Input is not a valid JWW file");
+	}
+	return onChunk ? undefined : result;
+}
+
+/**
+ * A columnar snapshot of the JWW file in `buffer` (see
+ * include/jww_snapshot.h) as a Uint8Array, for storing and reopening with
+ * openSnapshot() without parsing the drawing again.
+ */
+export function toSnapshot(buffer) {
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	const dataPtr = moduleInstance._malloc(bytes.byteLength);
+	let snapshot;
+	try {
+		moduleInstance.HEAPU8.set(bytes, dataPtr);
+		snapshot = moduleInstance.jwwToSnapshot(dataPtr, bytes.byteLength);
+	} finally {
+		moduleInstance._free(dataPtr);
+	}
+	if (snapshot === false) {
+		throw new Error("Input is not a valid JWW file");
+	}
+	return snapshot;
+}
+
+// Default export that initializes and returns the module
+export default init;
+
+/**
+ * Module-wide heap accounting, summed over every reader: live bytes per
+ * category (input, document, entities, index, other), allocation counts, and
+ * the peak since a reader last started parsing. `enabled` is false for builds
+ * without JWW_MEMORY_TRACKING.
+ */
+export function getModuleMemoryStats() {
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	return moduleInstance.getModuleMemoryStats();
+}
+
+/** `kind` values reported by JWWReader.nearestSnap() */
+export const SnapKind = Object.freeze({
+	ENDPOINT: 0,
+	MIDPOINT: 1,
+	CENTER: 2,
+	QUADRANT: 3,
+});
+
+/**
+ * Decode a vector tile written by the native tiler (`jww2tiles`, see
+ * include/jww_tile.h): { z, x, y, minX, minY, size, extent, vertices,
+ * groups }. vertices is a line list in tile units, so a point is
+ * (minX + vx * size / extent, minY + vy * size / extent) in the drawing;
+ * groups hold { pen, first, count } in vertices. Needs no init().
+ */
+export function decodeTile(buffer) {
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+	let pos = 0;
+	const varint = () => {
+		let value = 0;
+		let scale = 1;
+		for (;;) {
+			if (pos >= bytes.length) throw new Error("Truncated tile");
+			const b = bytes[pos++];
+			value += (b & 0x7f) * scale;
+			if (b < 0x80) return value;
+			scale *= 128;
+		}
+	};
+	const zigzag = () => {
+		const v = varint();
+		return v % 2 ? -(v + 1) / 2 : v / 2;
+	};
+	const real = () => {
+		if (pos + 8 > bytes.length) throw new Error("Truncated tile");
+		const v = view.getFloat64(pos, true);
+		pos += 8;
+		return v;
+	};
+
+	if (
+		bytes.length < 4 ||
+		String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]) !== "JWT1"
+	) {
+		throw new Error("Not a JWW tile");
+	}
+	pos = 4;
+	const z = varint();
+	const x = varint();
+	const y = varint();
+	const minX = real();
+	const minY = real();
+	const size = real();
+	const extent = varint();
+	const groupCount = varint();
+	const coords = [];
+	const groups = [];
+	for (let g = 0; g < groupCount; g++) {
+		const pen = varint();
+		const count = varint();
+		const first = coords.length / 2;
+		let cx = 0;
+		let cy = 0;
+		for (let i = 0; i < count; i++) {
+			const x0 = cx + zigzag();
+			const y0 = cy + zigzag();
+			cx = x0 + zigzag();
+			cy = y0 + zigzag();
+			coords.push(x0, y0, cx, cy);
+		}
+		groups.push({ pen, first, count: count * 2 });
+	}
+	return {
+		z,
+		x,
+		y,
+		minX,
+		minY,
+		size,
+		extent,
+		vertices: new Float32Array(coords),
+		groups,
+	};
+}
+
+// Snapshot column names by kind, in the order of include/jww_snapshot.h.
+// Entity kinds start with the pen columns; their own columns start at 8.
+const SNAPSHOT_PEN = ["layer", "color", "style", "width", "block"];
+const SNAPSHOT_KINDS = [
+	["lines", ["x1", "y1", "x2", "y2"]],
+	["arcs", ["x", "y", "radius", "start", "sweep", "tilt", "ratio", "full"]],
+	["points", ["x", "y", "angle", "scale", "code", "temporary"]],
+	["texts", ["x1", "y1", "x2", "y2", "charWidth", "charHeight", "spacing", "angle", "kind", "font", "text"]],
+	["solids", ["x1", "y1", "x2", "y2", "x3", "y3", "x4", "y4", "rgb"]],
+	["dimensions", ["x1", "y1", "x2", "y2", "labelX", "labelY", "labelHeight", "labelAngle", "label"]],
+	["inserts", ["x", "y", "scaleX", "scaleY", "angle", "number"]],
+	["blocks", ["number", "name", "count"]],
+	["layers", ["name", "state", "groupName", "groupState", "groupScale"]],
+	["strings", ["offsets", "bytes"]],
+];
+const SNAPSHOT_ENTITY_KINDS = 7;
+const SNAPSHOT_ARRAYS = [null, Uint8Array, Uint16Array, Uint32Array, Float64Array];
+
+/**
+ * Open a snapshot written by toSnapshot() or `jww2snap` in place: every
+ * column is a typed-array view of `buffer`, nothing is decoded per entity.
+ * Returns { sourceHash (16 hex digits), sourceSize, jwwVersion, paper,
+ * memo, lines, arcs, points, texts, solids, dimensions, inserts, blocks,
+ * layers, string(id) }. Entity kinds hold `count`, the pen columns
+ * (layer = group * 16 + layer, color, style, width, block) and their own
+ * columns, e.g. lines.x1 (texts name their size charWidth and charHeight,
+ * apart from the pen width); string columns hold ids for string(). A buffer
+ * not on an 8-byte boundary is copied once. Needs no init().
+ */
+export function openSnapshot(buffer) {
+	let bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	if (bytes.byteOffset % 8) {
+		bytes = bytes.slice();
+	}
+	const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
 	if (
-		typeof process !== "undefined" &&
-		process.versions &&
-		process.versions.node
+		bytes.length < 64 ||
+		String.fromCharCode(...bytes.subarray(0, 8)) !== "JWWSNAP1" ||
+		view.getUint32(8, true) !== 1
 	) {
-		const __filename = fileURLToPath(import.meta.url);
-		const __dirname = dirname(__filename);
-		const require = createRequire(import.meta.url);
-		const createJWWModule = require(join(__dirname, "../../wasm/jwwlib.cjs"));
+		throw new Error("Not a JWW snapshot of this version");
+	}
+	const u64 = (pos) => view.getUint32(pos, true) + view.getUint32(pos + 4, true) * 2 ** 32;
+	const hex = (pos) => view.getUint32(pos, true).toString(16).padStart(8, "0");
+	const sectionCount = view.getUint32(12, true);
+	const fileSize = u64(32);
+	if (fileSize > bytes.length || 64 + sectionCount * 16 > fileSize) {
+		throw new Error("Truncated snapshot");
+	}
 
-		// Read WASM file for Node.js
-		const fs = await import("node:fs");
-		const wasmPath = join(__dirname, "../../wasm/jwwlib.wasm");
-		const wasmBinary = fs.readFileSync(wasmPath);
+	const snapshot = {
+		sourceHash: hex(20) + hex(16),
+		sourceSize: u64(24),
+		jwwVersion: view.getUint32(40, true),
+		paper: view.getUint32(44, true),
+	};
+	SNAPSHOT_KINDS.forEach(([name], kind) => {
+		snapshot[name] = kind < SNAPSHOT_ENTITY_KINDS ? { count: 0 } : {};
+	});
+	for (let i = 0; i < sectionCount; i++) {
+		const pos = 64 + i * 16;
+		const id = view.getUint16(pos, true);
+		const Type = SNAPSHOT_ARRAYS[view.getUint8(pos + 2)];
+		const count = view.getUint32(pos + 4, true);
+		const offset = u64(pos + 8);
+		const kind = id >> 8;
+		const column = id & 0xff;
+		if (!Type || offset % 8 || offset + count * Type.BYTES_PER_ELEMENT > fileSize) {
+			throw new Error("Damaged snapshot");
+		}
+		if (kind >= SNAPSHOT_KINDS.length) {
+			continue;
+		}
+		const [name, columns] = SNAPSHOT_KINDS[kind];
+		const key =
+			kind < SNAPSHOT_ENTITY_KINDS
+				? column < 8
+					? SNAPSHOT_PEN[column]
+					: columns[column - 8]
+				: columns[column];
+		if (key) {
+			snapshot[name][key] = new Type(bytes.buffer, bytes.byteOffset + offset, count);
+			if (column === 0 && kind < SNAPSHOT_ENTITY_KINDS) {
+				snapshot[name].count = count;
+			}
+		}
+	}
 
-		moduleInstance = await createJWWModule({
-			wasmBinary: wasmBinary,
-		});
-		return moduleInstance;
+	const { offsets, bytes: utf8 } = snapshot.strings;
+	delete snapshot.strings;
+	if (!offsets || !utf8) {
+		throw new Error("Damaged snapshot");
 	}
+	const decoder = new TextDecoder();
+	const cache = new Map();
+	snapshot.string = (id) => {
+		if (!(id >= 0 && id + 1 < offsets.length)) {
+			return "";
+		}
+		let s = cache.get(id);
+		if (s === undefined) {
+			s = decoder.decode(utf8.subarray(offsets[id], offsets[id + 1]));
+			cache.set(id, s);
+		}
+		return s;
+	};
+	snapshot.memo = snapshot.string(view.getUint32(48, true));
+	return snapshot;
+}
 
-	// Browser/bundler environment - use dynamic import
+/**
+ * XXH64 of `buffer` as 16 hex digits, computed in WASM. Snapshots carry
+ * the hash of their source, and caches key them by it.
+ */
+export function hashJWW(buffer) {
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+	const dataPtr = moduleInstance._malloc(bytes.byteLength);
 	try {
-		const module = await import("../../wasm/jwwlib.js");
-		// The module exports createJWWModule directly
-		const createJWWModule = module.default || module.createJWWModule || module;
-
-		if (typeof createJWWModule === "function") {
-			const instance = await createJWWModule();
-			moduleInstance = instance;
-			// Verify the module was initialized properly
-			if (
-				!moduleInstance ||
-				!moduleInstance._malloc ||
-				!moduleInstance.JWWReader
-			) {
-				throw new Error(
-					"WASM module initialized but required exports are missing",
-				);
+		moduleInstance.HEAPU8.set(bytes, dataPtr);
+		return moduleInstance.jwwHash(dataPtr, bytes.byteLength);
+	} finally {
+		moduleInstance._free(dataPtr);
+	}
+}
+
+/**
+ * Snapshot cache kept in memory, least recently used entries dropped
+ * first once `maxBytes` or `maxEntries` is exceeded. Works anywhere.
+ * Backends for openCached() implement async get(key) returning a
+ * Uint8Array or undefined, and async set(key, bytes).
+ */
+export class MemoryCache {
+	constructor({ maxBytes = 256 * 1024 * 1024, maxEntries = 64 } = {}) {
+		this.maxBytes = maxBytes;
+		this.maxEntries = maxEntries;
+		this.bytes = 0;
+		// Map iteration order is insertion order: oldest use first
+		this.entries = new Map();
+	}
+
+	async get(key) {
+		const bytes = this.entries.get(key);
+		if (bytes !== undefined) {
+			this.entries.delete(key);
+			this.entries.set(key, bytes);
+		}
+		return bytes;
+	}
+
+	async set(key, bytes) {
+		this.delete(key);
+		if (bytes.byteLength > this.maxBytes) {
+			return;
+		}
+		this.entries.set(key, bytes);
+		this.bytes += bytes.byteLength;
+		for (const [oldest, old] of this.entries) {
+			if (this.bytes <= this.maxBytes && this.entries.size <= this.maxEntries) {
+				break;
 			}
-			return moduleInstance;
-		} else {
-			// If createJWWModule is not a function, the module might be the factory itself
-			if (typeof module === "function") {
-				const instance = await module();
-				moduleInstance = instance;
-				// Verify the module was initialized properly
-				if (
-					!moduleInstance ||
-					!moduleInstance._malloc ||
-					!moduleInstance.JWWReader
-				) {
-					throw new Error(
-						"WASM module initialized but required exports are missing",
-					);
+			this.entries.delete(oldest);
+			this.bytes -= old.byteLength;
+		}
+	}
+
+	delete(key) {
+		const bytes = this.entries.get(key);
+		if (bytes !== undefined) {
+			this.entries.delete(key);
+			this.bytes -= bytes.byteLength;
+		}
+	}
+
+	clear() {
+		this.entries.clear();
+		this.bytes = 0;
+	}
+
+	get size() {
+		return this.entries.size;
+	}
+}
+
+/**
+ * Snapshot cache in a directory, one `<hash>.jwws` file per drawing (the
+ * files jww2snap writes). Node only. Files are written under a temporary
+ * name and renamed, so concurrent processes never read a partial one.
+ */
+export class FileCache {
+	constructor(directory) {
+		if (!isNode()) {
+			throw new Error("FileCache needs Node.js");
+		}
+		this.directory = directory;
+	}
+
+	async get(key) {
+		const fs = await import("node:fs/promises");
+		try {
+			const file = await fs.readFile(join(this.directory, `${key}.jwws`));
+			return new Uint8Array(file.buffer, file.byteOffset, file.byteLength);
+		} catch (e) {
+			if (e.code === "ENOENT") {
+				return undefined;
+			}
+			throw e;
+		}
+	}
+
+	async set(key, bytes) {
+		const fs = await import("node:fs/promises");
+		await fs.mkdir(this.directory, { recursive: true });
+		const path = join(this.directory, `${key}.jwws`);
+		const temporary = `${path}.${process.pid}.tmp`;
+		await fs.writeFile(temporary, bytes);
+		await fs.rename(temporary, path);
+	}
+}
+
+// Resolves an IDBRequest
+function idbRequest(request) {
+	return new Promise((resolve, reject) => {
+		request.onsuccess = () => resolve(request.result);
+		request.onerror = () => reject(request.error);
+	});
+}
+
+/**
+ * Snapshot cache in an IndexedDB object store, for browsers and workers.
+ * The database is opened on first use.
+ */
+export class IndexedDBCache {
+	constructor({ name = "jwwlib-wasm", store = "snapshots" } = {}) {
+		if (typeof indexedDB === "undefined") {
+			throw new Error("IndexedDBCache needs IndexedDB");
+		}
+		this.name = name;
+		this.store = store;
+		this.db = null;
+	}
+
+	async open() {
+		if (!this.db) {
+			const request = indexedDB.open(this.name, 1);
+			request.onupgradeneeded = () => request.result.createObjectStore(this.store);
+			this.db = await idbRequest(request);
+		}
+		return this.db;
+	}
+
+	async get(key) {
+		const db = await this.open();
+		const value = await idbRequest(
+			db.transaction(this.store, "readonly").objectStore(this.store).get(key),
+		);
+		return value === undefined ? undefined : new Uint8Array(value);
+	}
+
+	async set(key, bytes) {
+		const db = await this.open();
+		// Store an ArrayBuffer of exactly the snapshot
+		const copy = bytes.slice().buffer;
+		await idbRequest(
+			db.transaction(this.store, "readwrite").objectStore(this.store).put(copy, key),
+		);
+	}
+}
+
+let defaultCache = null;
+
+/**
+ * Open the JWW file in `buffer` as a snapshot (see openSnapshot()),
+ * looked up by the XXH64 hash of its bytes in `options.cache` first. On a
+ * miss the drawing is parsed in WASM and its snapshot stored in the cache.
+ * The default cache is a MemoryCache shared by all calls. The result has
+ * `cached: true` when it came from the cache. Entries that do not open or
+ * belong to other bytes are replaced; a cache that fails to store does not
+ * fail the call.
+ */
+export async function openCached(buffer, options = {}) {
+	if (!moduleInstance) {
+		throw new Error("Module not initialized. Call init() first.");
+	}
+	let { cache } = options;
+	if (!cache) {
+		if (!defaultCache) {
+			defaultCache = new MemoryCache();
+		}
+		cache = defaultCache;
+	}
+	const bytes = ArrayBuffer.isView(buffer)
+		? new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength)
+		: new Uint8Array(buffer);
+
+	// One copy into the heap serves the hash and, on a miss, the parse
+	const dataPtr = moduleInstance._malloc(bytes.byteLength);
+	let key;
+	let fresh;
+	try {
+		moduleInstance.HEAPU8.set(bytes, dataPtr);
+		key = moduleInstance.jwwHash(dataPtr, bytes.byteLength);
+		const hit = await cache.get(key);
+		if (hit) {
+			try {
+				const snapshot = openSnapshot(hit);
+				if (snapshot.sourceHash === key && snapshot.sourceSize === bytes.byteLength) {
+					snapshot.cached = true;
+					return snapshot;
 				}
-				return moduleInstance;
+			} catch (_e) {
+				// Another format version or a damaged entry: parse again
 			}
-			throw new Error("Invalid WASM module format");
 		}
-	} catch (e) {
-		throw new Error(`Failed to load WASM module: ${e.message}`);
+		fresh = moduleInstance.jwwToSnapshot(dataPtr, bytes.byteLength);
+	} finally {
+		moduleInstance._free(dataPtr);
+	}
+	if (fresh === false) {
+		throw new Error("Input is not a valid JWW file");
+	}
+	try {
+		await cache.set(key, fresh);
+	} catch (_e) {
+		// Quota or I/O errors only cost the next open a parse
 	}
+	const snapshot = openSnapshot(fresh);
+	snapshot.cached = false;
+	return snapshot;
 }
 
-// Default export that initializes and returns the module
-export default init;
+// JWWReader.feed() status for a stream that is not JWW data
+const STREAM_ERROR = 2;
 
 export class JWWReader {
+	/**
+	 * @param {ArrayBuffer} [buffer] JWW file to parse. Omit it to create an
+	 *   empty reader for load().
+	 */
 	constructor(buffer) {
 		if (!moduleInstance) {
 			throw new Error("Module not initialized. Call init() first.");
 		}
 
+		this.stagingPtr = 0;
+		this.stagingSize = 0;
+		if (buffer === undefined) {
+			this.reader = new moduleInstance.JWWReader();
+			this.dataPtr = 0;
+			return;
+		}
+
 		// Allocate memory and copy buffer
 		const dataPtr = moduleInstance._malloc(buffer.byteLength);
 		moduleInstance.HEAPU8.set(new Uint8Array(buffer), dataPtr);
 
-		// Create reader instance
-		this.reader = new moduleInstance.JWWReader(dataPtr, buffer.byteLength);
-		this.dataPtr = dataPtr;
+		// Create reader instance. The parsed entities are copies, so the
+		// input is released right away instead of living until dispose().
+		try {
+			this.reader = new moduleInstance.JWWReader(dataPtr, buffer.byteLength);
+		} finally {
+			moduleInstance._free(dataPtr);
+		}
+		this.dataPtr = 0;
+	}
+
+	/**
+	 * Parse a file of `size` bytes that `fill(view)` writes directly into
+	 * WASM memory, e.g. `(view) => fs.readSync(fd, view, 0, size, 0)`.
+	 * `fill` must be synchronous: the view is only valid during the call.
+	 * The input region is released as soon as decoding completes.
+	 */
+	static fromFill(size, fill) {
+		if (!moduleInstance) {
+			throw new Error("Module not initialized. Call init() first.");
+		}
+
+		const instance = new JWWReader();
+		try {
+			const ptr = instance.reader.allocateInput(size);
+			fill(moduleInstance.HEAPU8.subarray(ptr, ptr + size));
+			if (!instance.reader.parseInput()) {
+				throw new Error("Input is not a valid JWW file");
+			}
+		} catch (e) {
+			instance.dispose();
+			throw e;
+		}
+		return instance;
+	}
+
+	/**
+	 * Node.js: read a file from disk straight into WASM memory.
+	 */
+	static async fromFile(path) {
+		const fs = await import("node:fs");
+		const fd = fs.openSync(path, "r");
+		try {
+			const size = fs.fstatSync(fd).size;
+			return JWWReader.fromFill(size, (view) => {
+				let offset = 0;
+				while (offset < size) {
+					const n = fs.readSync(fd, view, offset, size - offset, offset);
+					if (n === 0) throw new Error(`Unexpected end of file: ${path}`);
+					offset += n;
+				}
+			});
+		} finally {
+			fs.closeSync(fd);
+		}
+	}
+
+	/**
+	 * Browser: parse a File/Blob chunk by chunk without materializing an
+	 * ArrayBuffer copy of the whole file.
+	 */
+	static fromBlob(blob) {
+		return JWWReader.fromStream(blob.stream());
+	}
+
+	/**
+	 * Parse a JWW file while it downloads, e.g.
+	 * `await JWWReader.fromStream((await fetch(url)).body)`.
+	 * Accepts a ReadableStream or any async iterable of Uint8Array chunks.
+	 * Each chunk is parsed as it arrives; only an unfinished record is kept
+	 * between chunks.
+	 */
+	static async fromStream(stream) {
+		if (!moduleInstance) {
+			throw new Error("Module not initialized. Call init() first.");
+		}
+
+		const instance = new JWWReader();
+		instance.reader.beginStream();
+
+		// One staging buffer in WASM memory, grown to the largest chunk
+		let stagingPtr = 0;
+		let stagingSize = 0;
+		const feed = (chunk) => {
+			const bytes =
+				chunk instanceof Uint8Array ? chunk : new Uint8Array(chunk);
+			if (bytes.byteLength > stagingSize) {
+				if (stagingPtr) moduleInstance._free(stagingPtr);
+				stagingSize = bytes.byteLength;
+				stagingPtr = moduleInstance._malloc(stagingSize);
+			}
+			moduleInstance.HEAPU8.set(bytes, stagingPtr);
+			return instance.reader.feed(stagingPtr, bytes.byteLength);
+		};
+
+		try {
+			if (typeof stream.getReader === "function") {
+				const source = stream.getReader();
+				try {
+					for (;;) {
+						const { done, value } = await source.read();
+						if (done) break;
+						if (feed(value) === STREAM_ERROR) {
+							await source.cancel();
+							break;
+						}
+					}
+				} finally {
+					source.releaseLock();
+				}
+			} else {
+				for await (const chunk of stream) {
+					if (feed(chunk) === STREAM_ERROR) break;
+				}
+			}
+		} finally {
+			if (stagingPtr) moduleInstance._free(stagingPtr);
+		}
+
+		if (!instance.reader.finishStream()) {
+			instance.dispose();
+			throw new Error("Stream does not contain a valid JWW file");
+		}
+		return instance;
+	}
+
+	/**
+	 * Parse another file with this reader, reusing the buffers of the
+	 * previous one. Meant for batch jobs that convert many files; the input
+	 * is copied through a staging buffer that is also reused.
+	 */
+	load(buffer) {
+		const size = buffer.byteLength;
+		if (size > this.stagingSize) {
+			if (this.stagingPtr) moduleInstance._free(this.stagingPtr);
+			this.stagingPtr = moduleInstance._malloc(size);
+			this.stagingSize = size;
+		}
+		moduleInstance.HEAPU8.set(new Uint8Array(buffer), this.stagingPtr);
+		return this.reader.load(this.stagingPtr, size);
+	}
+
+	/**
+	 * Drop the current drawing but keep buffer capacity for the next load().
+	 */
+	reset() {
+		this.reader.reset();
+	}
+
+	/**
+	 * Release the reader's buffers (and the current drawing) when they hold
+	 * more than maxBytes. Returns the bytes still reserved.
+	 */
+	shrink(maxBytes = 0) {
+		const reserved = this.reader.getReservedBytes() + this.stagingSize;
+		if (reserved <= maxBytes) {
+			return reserved;
+		}
+		if (this.stagingPtr) moduleInstance._free(this.stagingPtr);
+		this.stagingPtr = 0;
+		this.stagingSize = 0;
+		return this.reader.shrink(0);
+	}
+
+	/**
+	 * Shrink a drawing that stays open but is not being shown. Lines,
+	 * circles, arcs, ellipses, points and solids are delta coded and
+	 * bit-packed, and everything built from them (vertex buffers, render
+	 * commands, LOD, snap points) is freed. With the default tolerance of 0
+	 * every value expands exactly as parsed. A larger `tolerance` rounds
+	 * coordinates to within that many drawing units, and angles and
+	 * parameters to within 1e-9, for smaller packing. The first getter that
+	 * needs the geometry expands it again, as does expand().
+	 * Returns { bytesBefore, bytesAfter, maxError, maxParamError }.
+	 */
+	compact(tolerance = 0) {
+		if (!(tolerance >= 0)) {
+			throw new Error(`Invalid compaction tolerance: ${tolerance}`);
+		}
+		const result = this.reader.compact(tolerance);
+		if (result === false) {
+			throw new Error("Cannot compact while a stream is being parsed");
+		}
+		return result;
+	}
+
+	/** Unpack geometry packed by compact() */
+	expand() {
+		this.reader.expandGeometry();
+	}
+
+	isCompacted() {
+		return this.reader.isCompacted();
 	}
 
 	getEntities() {
 		return this.reader.getEntities();
 	}
 
+	/**
+	 * Heap bytes held by this reader: counted with JWW_MEMORY_TRACKING,
+	 * otherwise estimated from its entity buffers. Module-wide totals come
+	 * from getModuleMemoryStats().
+	 */
+	getMemoryUsage() {
+		return this.reader.getMemoryUsage();
+	}
+
+	/**
+	 * Highest getMemoryUsage() during the last parse or stream, including
+	 * the indexes built after it; 0 without JWW_MEMORY_TRACKING.
+	 */
+	getLastParsePeakBytes() {
+		return this.reader.getLastParsePeakBytes();
+	}
+
 	getLines() {
 		return this.reader.getLines();
 	}
@@ -122,10 +919,189 @@ export class JWWReader {
 		return this.reader.getHeader();
 	}
 
+	/**
+	 * Drawing extents, accumulated while decoding: no pass over the
+	 * entities. Arcs and ellipses count with their exact extents and texts
+	 * with their rotated box.
+	 */
+	getBounds() {
+		return this.reader.getBounds();
+	}
+
+	/**
+	 * Per-entity boxes as a Float64Array ([minX, minY, maxX, maxY] per
+	 * getEntities() entry), recorded while decoding. The array is a view into
+	 * WASM memory, valid until the next call or dispose().
+	 */
+	getEntityBounds() {
+		return this.reader.getEntityBounds();
+	}
+
+	/**
+	 * Keep per-entity boxes from the next load() on (the default), or only
+	 * the extents. Without them getEntityBounds() recomputes the boxes.
+	 */
+	setEntityBounds(enabled) {
+		this.reader.setEntityBounds(enabled);
+	}
+
+	/**
+	 * Keep the file's records from the next load() on so saveToBuffer() can
+	 * write the drawing back. Off by default: the records take about as much
+	 * memory again as the entities.
+	 */
+	setKeepRecords(enabled) {
+		this.reader.setKeepRecords(enabled);
+	}
+
+	/**
+	 * The drawing as a JWW file, written in memory without the filesystem.
+	 * The Uint8Array is a view into WASM memory, valid until the next save,
+	 * load() or dispose(); copy it (e.g. `new Blob([bytes])`) to keep it.
+	 * Returns null unless setKeepRecords(true) was on for the parse.
+	 */
+	saveToBuffer() {
+		return this.reader.saveToBuffer();
+	}
+
+	/**
+	 * Line endpoints as a Float32Array ([x1, y1, x2, y2] per line) after the
+	 * affine transform x' = a*x + c*y + e, y' = b*x + d*y + f. The array is a
+	 * view into WASM memory, valid until the next call or dispose().
+	 */
+	getLineVertices(a = 1, b = 0, c = 0, d = 1, e = 0, f = 0) {
+		return this.reader.getLineVertices(a, b, c, d, e, f);
+	}
+
+	/**
+	 * Circles, arcs and ellipses as a WebGL line list in one call:
+	 * { vertices: Float32Array (x, y per vertex), colors: Uint8Array (RGBA
+	 * per vertex), groups: [{ color, width, first, count }] }. Each curve gets
+	 * just enough segments to stay within `tolerance` (drawing units, e.g. one
+	 * pixel divided by the zoom), and each group's vertices are contiguous so
+	 * it takes one drawArrays(LINES, first, count). Coordinates are relative
+	 * to (originX, originY). The arrays are views into WASM memory, valid
+	 * until the next call or dispose().
+	 */
+	tessellateCurves(tolerance, originX = 0, originY = 0) {
+		return this.reader.tessellateCurves(tolerance, originX, originY);
+	}
+
+	/**
+	 * Render command list: lines, circles, arcs and ellipses as one line
+	 * list bucketed by pen, { vertices, groups, layers, lineTypes }. Each
+	 * group is { color, rgb, width, lineType, layer, first, count } with its
+	 * vertices contiguous, ordered by layer, line type, width and color, so a
+	 * canvas or WebGL renderer sets pen state once per group instead of once
+	 * per entity. group.layer and group.lineType index the name lists. Curves
+	 * are tessellated within `tolerance` as in tessellateCurves().
+	 *
+	 * With `scale` (screen pixels per drawing unit) dashed, dotted and random
+	 * pen styles are expanded into their dashes using the pattern tables in
+	 * the file header. Expansions are cached per entity and zoom step, so
+	 * redrawing at a similar zoom only copies vertices.
+	 */
+	getRenderCommands(tolerance, originX = 0, originY = 0, scale = 0) {
+		return this.reader.getRenderCommands(tolerance, originX, originY, scale);
+	}
+
+	/**
+	 * Level-of-detail geometry for overview renders. Level 0 keeps every
+	 * segment; each level above doubles the tolerance: connected lines are
+	 * chained and simplified (Douglas-Peucker), curves are tessellated more
+	 * coarsely, and arcs and texts smaller than the tolerance are dropped.
+	 * Returns { level, tolerance, originX, originY, vertices, groups, texts,
+	 * layers, lineTypes }; vertices are a line list relative to the origin
+	 * and texts are getEntities() indices. Built on first use.
+	 */
+	getLOD(level) {
+		return this.reader.getLOD(level);
+	}
+
+	/**
+	 * A copy of the entity coordinates as compact typed arrays for GPU upload.
+	 * The reader keeps its parsed doubles, so the copy adds to its memory
+	 * until shrink() or compactGeometry() frees it. Values are offsets from
+	 * the middle of the drawing's extents, as Float32Array
+	 * (`format` "float32", the default) or as Int32Array steps of `scale`
+	 * ("int32"). The origin and scale stay doubles; a coordinate is
+	 * `originX + v * scale` (y likewise, lengths `v * scale`). `maxError` is
+	 * the largest difference from the parsed doubles, in drawing units.
+	 * Returns { format, originX, originY, scale, maxError, bytes, lines
+	 * (x1, y1, x2, y2), circles and arcs (cx, cy, radius), arcAngles
+	 * (Float32Array, degrees), ellipses (cx, cy, majorAxis), ellipseParams
+	 * (ratio, angle, startParam, endParam), points (x, y), solids (4 x, y
+	 * corners), texts (x, y) }. Views into WASM memory, valid until the next
+	 * call, load() or dispose().
+	 */
+	exportQuantizedGeometry(format = "float32") {
+		if (format !== "float32" && format !== "int32") {
+			throw new Error(`Unknown quantization format: ${format}`);
+		}
+		return this.reader.exportQuantizedGeometry(format);
+	}
+
+	/**
+	 * Lines of one pen (color, width, line type, pen style and layer) joined
+	 * into polylines where exactly two line ends meet within `tolerance`.
+	 * Every line lands in one polyline. `sources` is a Uint32Array of
+	 * getLines() indices: polyline i's edges, in order, came from
+	 * `sources[p.firstSource .. p.firstSource + p.sourceCount)`. It is a
+	 * view into WASM memory, valid until the next call or dispose().
+	 */
+	chainLines(tolerance = 0) {
+		const polylines = this.reader.chainLines(tolerance);
+		return { polylines, sources: this.reader.getChainSources() };
+	}
+
+	/** Number of getLOD() levels */
+	getLODLevelCount() {
+		return this.reader.getLODLevelCount();
+	}
+
+	/**
+	 * Coarsest getLOD() level whose tolerance stays under a pixel at `scale`
+	 * (pixels per drawing unit).
+	 */
+	getLODLevelForScale(scale) {
+		return this.reader.getLODLevelForScale(scale);
+	}
+
+	/**
+	 * Indices into getEntities() of the entities whose bounding boxes overlap
+	 * the rectangle, from a packed Hilbert R-tree built after parsing. The
+	 * Uint32Array is a view into WASM memory, valid until the next query or
+	 * dispose().
+	 */
+	queryRect(minX, minY, maxX, maxY) {
+		return this.reader.queryRect(minX, minY, maxX, maxY);
+	}
+
+	/**
+	 * Entity closest to (x, y) within tolerance, measured exactly against
+	 * segments and arcs: { index, distance, x, y } with the closest point on
+	 * the entity, or index -1 when nothing is in range.
+	 */
+	pick(x, y, tolerance) {
+		return this.reader.pick(x, y, tolerance);
+	}
+
+	/**
+	 * Nearest snap point (end point, midpoint, center or quadrant point)
+	 * within maxDistance: { found, x, y, kind, index, distance }. The
+	 * KD-tree behind it is built on the first call after each parse.
+	 */
+	nearestSnap(x, y, maxDistance = Infinity) {
+		return this.reader.nearestSnap(x, y, maxDistance);
+	}
+
 	dispose() {
 		if (this.reader) {
 			this.reader.delete();
-			moduleInstance._free(this.dataPtr);
+			if (this.dataPtr) moduleInstance._free(this.dataPtr);
+			if (this.stagingPtr) moduleInstance._free(this.stagingPtr);
+			this.stagingPtr = 0;
+			this.stagingSize = 0;
 			this.reader = null;
 			this.dataPtr = null;
 		}
@@ -0,0 +1,74 @@
+// jww2dxf: convert JWW drawings to DXF
+//
+//   jww2dxf [-t TOLERANCE] [-o out.dxf] input.jww...
+//
+// Each input is written next to it with a .dxf extension unless -o names
+// the output of a single input. Records are written out as they are
+// decoded (see include/jww_dxf.h), so a batch run is bound by the disk.
+
+#include "jww_dxf.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2dxf [-t TOLERANCE] [-o out.dxf] input.jww...\n";
+}
+
+std::string dxfPath(const std::string& input)
+{
+	size_t slash = input.find_last_of("/\\");
+	size_t dot = input.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return input + ".dxf";
+	return input.substr(0, dot) + ".dxf";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	JWWDxf::Options options;
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "-t" || arg == "-o") && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-t") {
+			options.curveTolerance = std::atof(argv[++i]);
+			if (!(options.curveTolerance > 0.0)) {
+				std::cerr << "jww2dxf: bad tolerance " << argv[i] << "\n";
+				return 2;
+			}
+		} else if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+		usage();
+		return 2;
+	}
+
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		const std::string& input = inputs[i];
+		std::string path = output.empty() ? dxfPath(input) : output;
+		if (!JWWDxf::convertFile(input, path, options)) {
+			std::cerr << "jww2dxf: cannot convert " << input << " to " << path << "\n";
+			failures++;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
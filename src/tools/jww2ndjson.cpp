@@ -0,0 +1,97 @@
+// jww2ndjson: convert JWW drawings to NDJSON
+//
+//   jww2ndjson [-H] [-n] [-o out.ndjson] input.jww...
+//
+// The records of every input are written to standard output (or to -o) one
+// JSON object per line, as described in include/jww_json.h. -H leaves the
+// header lines out, -n the texts. Output is written in chunks as the
+// records are decoded, so it can be piped straight into a loader.
+
+#include "jww_json.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2ndjson [-H] [-n] [-o out.ndjson] input.jww...\n";
+}
+
+class StreamSink : public JWWJson::Sink {
+public:
+	explicit StreamSink(std::ostream& out) : out(out) {}
+	void write(const char* data, size_t size) override { out.write(data, static_cast<std::streamsize>(size)); }
+
+private:
+	std::ostream& out;
+};
+
+std::vector<char> readFile(const std::string& path, bool& ok)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	ok = static_cast<bool>(in);
+	return std::vector<char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	JWWJson::Options options;
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-H") {
+			options.header = false;
+		} else if (arg == "-n") {
+			options.texts = false;
+		} else if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty()) {
+		usage();
+		return 2;
+	}
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str(), std::ios::binary);
+		if (!file) {
+			std::cerr << "jww2ndjson: cannot write " << output << "\n";
+			return 1;
+		}
+	}
+	std::ios::sync_with_stdio(false);
+	StreamSink sink(output.empty() ? std::cout : file);
+
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		bool ok;
+		std::vector<char> data = readFile(inputs[i], ok);
+		if (!ok || !JWWJson::convert(data.data(), data.size(), sink, options)) {
+			std::cerr << "jww2ndjson: cannot convert " << inputs[i] << "\n";
+			failures++;
+		}
+	}
+	std::ostream& out = output.empty() ? std::cout : file;
+	if (!out.flush()) {
+		std::cerr << "jww2ndjson: write error\n";
+		return 1;
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// jww2png: render JWW drawings to PNG thumbnails
+//
+//   jww2png [-s WIDTHxHEIGHT] [-m MARGIN] [--no-text] [-o out.png] input.jww...
+//
+// Each input is written next to it with a .png extension unless -o names
+// the output of a single input. Many files per run keep process start-up
+// out of the way when thumbnailing a whole archive.
+
+#include "jww_raster.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2png [-s WIDTHxHEIGHT] [-m MARGIN] [--no-text] [-o out.png] input.jww...\n";
+}
+
+bool readFile(const std::string& path, std::vector<char>& data)
+{
+	std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+	if (!in)
+		return false;
+	std::streamoff size = in.tellg();
+	if (size < 0)
+		return false;
+	data.resize(static_cast<size_t>(size));
+	in.seekg(0);
+	return size == 0 || static_cast<bool>(in.read(&data[0], size));
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream out(path.c_str(), std::ios::binary);
+	out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	return static_cast<bool>(out);
+}
+
+std::string pngPath(const std::string& input)
+{
+	size_t slash = input.find_last_of("/\\");
+	size_t dot = input.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return input + ".png";
+	return input.substr(0, dot) + ".png";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	JWWRaster::Options options;
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "-s" || arg == "-m" || arg == "-o") && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-s") {
+			int w = 0, h = 0;
+			if (std::sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0 || w > 16384 || h > 16384) {
+				std::cerr << "jww2png: bad size " << argv[i] << "\n";
+				return 2;
+			}
+			options.width = w;
+			options.height = h;
+		} else if (arg == "-m") {
+			options.margin = std::max(0, std::atoi(argv[++i]));
+		} else if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "--no-text") {
+			options.drawTexts = false;
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+		usage();
+		return 2;
+	}
+
+	// Buffers are reused from file to file
+	JWWRaster::Canvas canvas;
+	std::vector<char> data;
+	std::vector<uint8_t> png;
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		const std::string& input = inputs[i];
+		if (!readFile(input, data)) {
+			std::cerr << "jww2png: cannot read " << input << "\n";
+			failures++;
+			continue;
+		}
+		if (!JWWRaster::renderThumbnail(data.data(), data.size(), options, canvas)) {
+			std::cerr << "jww2png: " << input << " is not a JWW file\n";
+			failures++;
+			continue;
+		}
+		JWWRaster::encodePNG(canvas, png);
+		std::string path = output.empty() ? pngPath(input) : output;
+		if (!writeFile(path, png)) {
+			std::cerr << "jww2png: cannot write " << path << "\n";
+			failures++;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
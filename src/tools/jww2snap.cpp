@@ -0,0 +1,77 @@
+// jww2snap: write columnar snapshots of JWW drawings
+//
+//   jww2snap [-o out.jwws] input.jww...
+//
+// Each input is written next to it with a .jwws extension unless -o names
+// the output of a single input. For every snapshot the XXH64 hash of its
+// source is printed with the output path, as the key a cache would use.
+// See include/jww_snapshot.h for the layout of the output.
+
+#include "jww_snapshot.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2snap [-o out.jwws] input.jww...\n";
+}
+
+std::string snapPath(const std::string& input)
+{
+	size_t slash = input.find_last_of("/\\");
+	size_t dot = input.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return input + ".jwws";
+	return input.substr(0, dot) + ".jwws";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+		usage();
+		return 2;
+	}
+
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		const std::string& input = inputs[i];
+		std::string path = output.empty() ? snapPath(input) : output;
+		if (!JWWSnapshot::writeFile(input, path)) {
+			std::cerr << "jww2snap: cannot convert " << input << " to " << path << "\n";
+			failures++;
+			continue;
+		}
+		// The hash is in the header just written; reading it back keeps the
+		// source from being loaded twice
+		FILE* f = std::fopen(path.c_str(), "rb");
+		JWWSnapshot::FileHeader header;
+		if (f && std::fread(&header, sizeof(header), 1, f) == 1)
+			std::printf("%016llx  %s\n", static_cast<unsigned long long>(header.sourceHash), path.c_str());
+		if (f)
+			std::fclose(f);
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// jww2svg: convert JWW drawings to SVG
+//
+//   jww2svg [-p PRECISION] [-q QUANTUM] [-w WIDTH] [-n] [-o out.svg] input.jww...
+//
+// Each input is written next to it with a .svg extension unless -o names
+// the output of a single input. -n leaves the texts out. See
+// include/jww_svg.h for the layout of the output.
+
+#include "jww_svg.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2svg [-p PRECISION] [-q QUANTUM] [-w WIDTH] [-n] [-o out.svg] input.jww...\n";
+}
+
+std::string svgPath(const std::string& input)
+{
+	size_t slash = input.find_last_of("/\\");
+	size_t dot = input.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return input + ".svg";
+	return input.substr(0, dot) + ".svg";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	JWWSvg::Options options;
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "-p" || arg == "-q" || arg == "-w" || arg == "-o") && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-p") {
+			options.precision = std::atoi(argv[++i]);
+			if (options.precision < 0 || options.precision > 9) {
+				std::cerr << "jww2svg: bad precision " << argv[i] << "\n";
+				return 2;
+			}
+		} else if (arg == "-q") {
+			options.quantum = std::atof(argv[++i]);
+			if (options.quantum < 0.0) {
+				std::cerr << "jww2svg: bad quantum " << argv[i] << "\n";
+				return 2;
+			}
+		} else if (arg == "-w") {
+			options.strokeWidth = std::atof(argv[++i]);
+			if (options.strokeWidth < 0.0) {
+				std::cerr << "jww2svg: bad stroke width " << argv[i] << "\n";
+				return 2;
+			}
+		} else if (arg == "-n") {
+			options.texts = false;
+		} else if (arg == "-o") {
+			output = argv[++i];
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty() || (!output.empty() && inputs.size() > 1)) {
+		usage();
+		return 2;
+	}
+
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		const std::string& input = inputs[i];
+		std::string path = output.empty() ? svgPath(input) : output;
+		if (!JWWSvg::convertFile(input, path, options)) {
+			std::cerr << "jww2svg: cannot convert " << input << " to " << path << "\n";
+			failures++;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
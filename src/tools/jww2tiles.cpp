@@ -0,0 +1,130 @@
+// jww2tiles: cut a JWW drawing into vector tiles
+//
+//   jww2tiles [-z MAXZOOM] [-n MAXITEMS] [-j THREADS] input.jww outdir
+//
+// Writes outdir/<z>/<x>/<y>.jwt (format in include/jww_tile.h) and
+// outdir/index.json with the root square and the list of tiles, so a
+// viewer can request only the tiles it shows.
+
+#include "jww_tile.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+void usage()
+{
+	std::cerr << "usage: jww2tiles [-z MAXZOOM] [-n MAXITEMS] [-j THREADS] input.jww outdir\n";
+}
+
+bool readFile(const std::string& path, std::vector<char>& data)
+{
+	std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+	if (!in)
+		return false;
+	std::streamoff size = in.tellg();
+	if (size < 0)
+		return false;
+	data.resize(static_cast<size_t>(size));
+	in.seekg(0);
+	return size == 0 || static_cast<bool>(in.read(&data[0], size));
+}
+
+bool makeDir(const std::string& path)
+{
+	return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool writeFile(const std::string& path, const char* data, size_t size)
+{
+	std::ofstream out(path.c_str(), std::ios::binary);
+	out.write(data, static_cast<std::streamsize>(size));
+	return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	JWWTile::Options options;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "-z" || arg == "-n" || arg == "-j") && i + 1 >= argc) {
+			usage();
+			return 2;
+		}
+		if (arg == "-z") {
+			options.maxZoom = std::atoi(argv[++i]);
+			if (options.maxZoom < 0 || options.maxZoom > JWWTile::MAX_ZOOM) {
+				std::cerr << "jww2tiles: zoom must be 0.." << JWWTile::MAX_ZOOM << "\n";
+				return 2;
+			}
+		} else if (arg == "-n") {
+			options.maxItems = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "-j") {
+			options.threads = std::atoi(argv[++i]);
+		} else if (arg == "-h" || arg == "--help") {
+			usage();
+			return 0;
+		} else {
+			args.push_back(arg);
+		}
+	}
+	if (args.size() != 2) {
+		usage();
+		return 2;
+	}
+
+	std::vector<char> data;
+	if (!readFile(args[0], data)) {
+		std::cerr << "jww2tiles: cannot read " << args[0] << "\n";
+		return 1;
+	}
+	JWWTile::Tiler tiler;
+	if (!tiler.load(data.data(), data.size())) {
+		std::cerr << "jww2tiles: " << args[0] << " is not a JWW file\n";
+		return 1;
+	}
+	std::vector<char>().swap(data);
+	tiler.build(options);
+
+	const std::string& dir = args[1];
+	if (!makeDir(dir)) {
+		std::cerr << "jww2tiles: cannot create " << dir << "\n";
+		return 1;
+	}
+	std::ostringstream index;
+	index.precision(17);
+	index << "{\"minX\":" << tiler.getMinX() << ",\"minY\":" << tiler.getMinY()
+	      << ",\"size\":" << tiler.getSize() << ",\"extent\":" << JWWTile::EXTENT << ",\"tiles\":[";
+	const std::vector<JWWTile::Tile>& tiles = tiler.tiles();
+	for (size_t i = 0; i < tiles.size(); i++) {
+		const JWWTile::Tile& t = tiles[i];
+		std::ostringstream zdir, xdir, path;
+		zdir << dir << "/" << t.z;
+		xdir << zdir.str() << "/" << t.x;
+		path << xdir.str() << "/" << t.y << ".jwt";
+		if (!makeDir(zdir.str()) || !makeDir(xdir.str()) ||
+		    !writeFile(path.str(), reinterpret_cast<const char*>(t.blob.data()), t.blob.size())) {
+			std::cerr << "jww2tiles: cannot write " << path.str() << "\n";
+			return 1;
+		}
+		index << (i ? "," : "") << "[" << t.z << "," << t.x << "," << t.y << "," << (t.leaf ? 1 : 0) << "]";
+	}
+	index << "]}\n";
+	std::string json = index.str();
+	if (!writeFile(dir + "/index.json", json.data(), json.size())) {
+		std::cerr << "jww2tiles: cannot write " << dir << "/index.json\n";
+		return 1;
+	}
+	return 0;
+}
@@ -238,7 +238,11 @@ public:
                 std::get<1>(data), // y1
                 std::get<2>(data), // x2
                 std::get<3>(data), // y2
-                std::get<4>(data)  // color
+                std::get<4>(data), // color
+                0,                 // width
+                0,                 // line type
+                0,                 // layer
+                0                  // pen style
             });
         }
     }
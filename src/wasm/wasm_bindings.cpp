@@ -9,11 +9,27 @@
 #include "dl_jww.h"
 #include "dl_creationinterface.h"
 #include "batch_processing.h"
+#include "jww_simd.h"
+#include "jww_stream.h"
+#include "jww_memory.h"
+#include "jww_spatial.h"
+#include "jww_tessellate.h"
+#include "jww_penlines.h"
+#include "jww_linetype.h"
+#include "jww_lod.h"
+#include "jww_svg.h"
+#include "jww_json.h"
+#include "jww_snapshot.h"
+#include "jww_quant.h"
+#include "jww_pack.h"
 #include <vector>
 #include <memory>
 #include <cmath>
+#include <limits>
 #include <map>
+#include <tuple>
 #include <sstream>
+#include <cstdio>
 #include <emscripten/console.h>
 
 // Error types for parsing
@@ -25,7 +41,8 @@ enum class ParseErrorType {
     INVALID_LEADER_PATH,
     INVALID_DIMENSION_DATA,
     MEMORY_ALLOCATION_FAILED,
-    UNKNOWN_ENTITY_TYPE
+    UNKNOWN_ENTITY_TYPE,
+    INVALID_FILE_FORMAT
 };
 
 // Error information structure
@@ -69,23 +86,36 @@ struct JSLayerData {
 struct JSLineData {
     double x1, y1, x2, y2;
     int color;
+    int width;               // Pen width number (0 = default)
+    int lineType;            // Index into the reader's line type names
+    int layer;               // Index into the reader's layer names
+    int penStyle;            // JWW pen style number (dash pattern)
 };
 
 struct JSCircleData {
     double cx, cy, radius;
     int color;
+    int width;
+    int lineType;
+    int layer;
+    int penStyle;
 };
 
 struct JSArcData {
     double cx, cy, radius;
     double angle1, angle2;
     int color;
+    int width;
+    int lineType;
+    int layer;
+    int penStyle;
 };
 
 struct JSTextData {
     double x, y;             // Text position
     double height;           // Text height
     double angle;            // Rotation angle in radians
+    double widthFactor;      // Character width over height (m_dSizeX / m_dSizeY)
     std::string text;        // Text content (UTF-8)
     std::vector<uint8_t> textBytes;  // Original text bytes (Shift-JIS)
     int color;
@@ -96,7 +126,13 @@ struct JSEllipseData {
     double majorAxis;        // Major axis length
     double ratio;            // Ratio of minor to major axis
     double angle;            // Rotation angle in radians
+    double startParam;       // Elliptic arc start/end parameters in radians
+    double endParam;         // (endParam - startParam = 2PI for a full ellipse)
     int color;
+    int width;
+    int lineType;
+    int layer;
+    int penStyle;
 };
 
 struct JSPointData {
@@ -113,6 +149,13 @@ struct JSPolylineData {
     std::vector<JSVertexData> vertices;  // Vertex list
     bool closed;                         // Is polyline closed
     int color;
+    int width;
+    int lineType;
+    int layer;
+    int penStyle;
+    // Lines joined by JWWReader::chainLines(): entries of its source list
+    int firstSource;
+    int sourceCount;
 };
 
 struct JSSolidData {
@@ -283,19 +326,178 @@ struct JSHeader {
     int entityCount;
 };
 
+// Drawing extents
+// Heap accounting (see jww_memory.h). Bytes are module-wide live bytes per
+// category, summed over every reader; peakBytes is the high-water mark since
+// a reader last started parsing.
+struct JSMemoryStats {
+    bool enabled;
+    double liveBytes;
+    double peakBytes;
+    double allocations;
+    double frees;
+    double inputBytes;
+    double documentBytes;
+    double entityBytes;
+    double indexBytes;
+    double otherBytes;
+};
+
+static JSMemoryStats makeMemoryStats(const JWWMemory::Stats& stats) {
+    JSMemoryStats result;
+    result.enabled = stats.enabled;
+    result.liveBytes = stats.liveBytes;
+    result.peakBytes = stats.peakBytes;
+    result.allocations = stats.allocations;
+    result.frees = stats.frees;
+    result.inputBytes = stats.category[JWWMemory::Input].liveBytes;
+    result.documentBytes = stats.category[JWWMemory::Document].liveBytes;
+    result.entityBytes = stats.category[JWWMemory::Entities].liveBytes;
+    result.indexBytes = stats.category[JWWMemory::Index].liveBytes;
+    result.otherBytes = stats.category[JWWMemory::Other].liveBytes;
+    return result;
+}
+
+struct JSBounds {
+    double minX, minY, maxX, maxY;
+    bool valid;
+};
+
+// Result of pick(): the entity closest to the query point
+struct JSPickResult {
+    int index;               // getEntities() index, -1 when nothing is in range
+    double distance;         // Distance to the entity
+    double x, y;             // Closest point on the entity
+};
+
+// Snap point kinds reported by nearestSnap()
+enum SnapKind {
+    SNAP_ENDPOINT = 0,
+    SNAP_MIDPOINT = 1,
+    SNAP_CENTER = 2,
+    SNAP_QUADRANT = 3
+};
+
+struct JSSnapPoint {
+    bool found;
+    double x, y;
+    int kind;                // SnapKind
+    int index;               // getEntities() index of the source entity
+    double distance;
+};
+
+// One draw call of a line-list vertex buffer: all vertices share a pen
+struct JSDrawGroup {
+    int color;               // DXF color number
+    int rgb;                 // Color as 0xRRGGBB
+    int width;               // Pen width number
+    int lineType;            // Line type index, -1 when not part of the key
+    int layer;               // Layer index, -1 when not part of the key
+    int first;               // First vertex
+    int count;               // Vertex count (two per line segment)
+};
+
+// RGBA bytes of a DXF color number; BYBLOCK, BYLAYER and out-of-range
+// numbers use color 7 (the foreground color)
+static void colorToRGBA(int color, uint8_t rgba[4]) {
+    if (color < 1 || color > 255) {
+        color = 7;
+    }
+    for (int i = 0; i < 3; i++) {
+        rgba[i] = static_cast<uint8_t>(dxfColors[color][i] * 255.0 + 0.5);
+    }
+    rgba[3] = 255;
+}
+
 // JavaScript-friendly creation interface
+// Approximate box of a text: Shift-JIS bytes are half-width cells, so the
+// run is bytes * height / 2 long, rotated about the insertion point.
+static double textWidth(const JSTextData& t) {
+    size_t cells = t.textBytes.size();
+    if (cells == 0) {
+        for (unsigned char ch : t.text) {
+            if ((ch & 0xC0) != 0x80) {
+                cells += 2;
+            }
+        }
+    }
+    return cells * t.height * t.widthFactor * 0.5;
+}
+
+static JWWSpatial::Box textBox(const JSTextData& t) {
+    double w = textWidth(t);
+    double h = t.height;
+    double c = std::cos(t.angle), s = std::sin(t.angle);
+    double xs[4] = {0.0, w * c, w * c - h * s, -h * s};
+    double ys[4] = {0.0, w * s, w * s + h * c, h * c};
+    JWWSpatial::Box box(t.x, t.y, t.x, t.y);
+    for (int i = 0; i < 4; i++) {
+        box.minX = std::min(box.minX, t.x + xs[i]);
+        box.minY = std::min(box.minY, t.y + ys[i]);
+        box.maxX = std::max(box.maxX, t.x + xs[i]);
+        box.maxY = std::max(box.maxY, t.y + ys[i]);
+    }
+    return box;
+}
+
+// Arc span in radians with end > start
+static void arcSpan(const JSArcData& a, double& start, double& end) {
+    start = a.angle1 * M_PI / 180.0;
+    end = a.angle2 * M_PI / 180.0;
+    while (end <= start) {
+        end += 2.0 * M_PI;
+    }
+}
+
+// Exact box of an elliptic arc (JWWTessellate::emitArc parameters)
+static JWWSpatial::Box arcBox(double cx, double cy, double rx, double ry, double rotation,
+                              double start, double sweep) {
+    double b[4];
+    JWWTessellate::arcBounds(cx, cy, rx, ry, rotation, start, sweep, b);
+    return JWWSpatial::Box(b[0], b[1], b[2], b[3]);
+}
+
+static JWWSpatial::Box arcBox(const JSArcData& a) {
+    double start, end;
+    arcSpan(a, start, end);
+    return arcBox(a.cx, a.cy, a.radius, a.radius, 0.0, start, end - start);
+}
+
+static JWWSpatial::Box ellipseBox(const JSEllipseData& e) {
+    return arcBox(e.cx, e.cy, e.majorAxis, e.majorAxis * e.ratio, e.angle,
+                  e.startParam, e.endParam - e.startParam);
+}
+
+static JWWSpatial::Box solidBox(const JSSolidData& s) {
+    JWWSpatial::Box box(s.x[0], s.y[0], s.x[0], s.y[0]);
+    for (int i = 1; i < 4; i++) {
+        box.minX = std::min(box.minX, s.x[i]);
+        box.minY = std::min(box.minY, s.y[i]);
+        box.maxX = std::max(box.maxX, s.x[i]);
+        box.maxY = std::max(box.maxY, s.y[i]);
+    }
+    return box;
+}
+
+// Entity kinds in getEntities() order, one box list each
+enum BoxKind {
+    BOX_LINE, BOX_CIRCLE, BOX_ARC, BOX_TEXT, BOX_ELLIPSE, BOX_POINT, BOX_SOLID, BOX_SPLINE,
+    BOX_KIND_COUNT
+};
+
 class JSCreationInterface : public DL_CreationInterface {
 private:
-    // Entity storage with pre-allocated capacity
-    std::vector<JSLineData> lines;
-    std::vector<JSCircleData> circles;
-    std::vector<JSArcData> arcs;
+    // Entity storage with pre-allocated capacity. The plain-data kinds are
+    // mutable so const getters can unpack them (see packGeometry()).
+    mutable std::vector<JSLineData> lines;
+    mutable std::vector<JSCircleData> circles;
+    mutable std::vector<JSArcData> arcs;
     std::vector<JSTextData> texts;
-    std::vector<JSEllipseData> ellipses;
-    std::vector<JSPointData> points;
+    mutable std::vector<JSEllipseData> ellipses;
+    mutable std::vector<JSPointData> points;
     std::vector<JSPolylineData> polylines;
     JSPolylineData* currentPolyline = nullptr;
-    std::vector<JSSolidData> solids;
+    mutable std::vector<JSSolidData> solids;
     std::vector<JSMTextData> mtexts;
     std::vector<JSDimensionData> dimensions;
     std::vector<JSSplineData> splines;
@@ -313,6 +515,187 @@ private:
     std::map<std::string, int> imageDefHandleToIndex;
     std::vector<JSParseError> parseErrors;
     int currentColor = 256;  // Default to BYLAYER
+    int currentWidth = 0;
+    int currentLineType = 0;
+    int currentLayer = 0;
+    int currentPenStyle = 0;
+    // Layer and line type names, interned so entities carry small indices
+    std::vector<std::string> layerNames;
+    std::vector<std::string> lineTypeNames;
+    std::map<std::string, int> layerNameToIndex;
+    std::map<std::string, int> lineTypeNameToIndex;
+    // Drawing extents and per-entity boxes, accumulated as entities are
+    // decoded so neither needs another pass over the drawing
+    JWWSpatial::Box extents;
+    bool hasExtents = false;
+    bool recordEntityBoxes = true;
+    bool boxesRecorded = true;   // entityBoxes cover the current drawing
+    std::vector<JWWSpatial::Box> entityBoxes[BOX_KIND_COUNT];
+    // Lines, circles, arcs, ellipses, points and solids packed by
+    // packGeometry(), in that order; the vectors stay empty meanwhile
+    enum PackedKind {
+        PACKED_LINES,
+        PACKED_CIRCLES,
+        PACKED_ARCS,
+        PACKED_ELLIPSES,
+        PACKED_POINTS,
+        PACKED_SOLIDS,
+        PACKED_KIND_COUNT
+    };
+    mutable std::vector<uint8_t> packedGeometry;
+    mutable bool geometryPacked = false;
+    // Charged for geometry expanded by a const getter (see setMemoryOwner())
+    const JWWMemory::Owner* memoryOwner = nullptr;
+    double packedStep = 1.0;
+    size_t packedCounts[PACKED_KIND_COUNT] = {};
+    
+    void extend(const JWWSpatial::Box& box) {
+        if (!hasExtents) {
+            extents = box;
+            hasExtents = true;
+            return;
+        }
+        extents.minX = std::min(extents.minX, box.minX);
+        extents.minY = std::min(extents.minY, box.minY);
+        extents.maxX = std::max(extents.maxX, box.maxX);
+        extents.maxY = std::max(extents.maxY, box.maxY);
+    }
+    
+    void addBox(BoxKind kind, const JWWSpatial::Box& box) {
+        extend(box);
+        if (boxesRecorded) {
+            entityBoxes[kind].push_back(box);
+        }
+    }
+    
+    // Index of name, adding it when new. Consecutive entities usually share
+    // a pen, so the current index is checked before the map.
+    static int internName(std::vector<std::string>& names, std::map<std::string, int>& index,
+                          int current, const std::string& name) {
+        if (current >= 0 && current < static_cast<int>(names.size()) && names[current] == name) {
+            return current;
+        }
+        auto it = index.find(name);
+        if (it != index.end()) {
+            return it->second;
+        }
+        int id = static_cast<int>(names.size());
+        names.push_back(name);
+        index.emplace(name, id);
+        return id;
+    }
+    
+    size_t countOf(size_t size, PackedKind kind) const {
+        return geometryPacked ? packedCounts[kind] : size;
+    }
+    
+    // One packGeometry() column: stride values per entity taken by get
+    template<typename T, typename Get>
+    double packReals(const std::vector<T>& items, size_t stride, double step, Get get) {
+        std::vector<double> values(items.size() * stride);
+        for (size_t i = 0; i < items.size(); i++) {
+            get(items[i], &values[i * stride]);
+        }
+        return JWWPack::packReals(values.data(), values.size(), stride, step, packedGeometry);
+    }
+    
+    template<typename T, typename Get>
+    void packInts(const std::vector<T>& items, size_t stride, Get get) {
+        std::vector<int64_t> values(items.size() * stride);
+        for (size_t i = 0; i < items.size(); i++) {
+            get(items[i], &values[i * stride]);
+        }
+        JWWPack::pack(values.data(), values.size(), stride, packedGeometry);
+    }
+    
+    template<typename T, typename Set>
+    void unpackReals(std::vector<T>& items, size_t stride, double step, size_t& pos, Set set) const {
+        std::vector<double> values(items.size() * stride);
+        pos += JWWPack::unpackReals(packedGeometry.data() + pos, packedGeometry.size() - pos,
+                                    values.size(), stride, step, values.data());
+        for (size_t i = 0; i < items.size(); i++) {
+            set(items[i], &values[i * stride]);
+        }
+    }
+    
+    template<typename T, typename Set>
+    void unpackInts(std::vector<T>& items, size_t stride, size_t& pos, Set set) const {
+        std::vector<int64_t> values(items.size() * stride);
+        pos += JWWPack::unpack(packedGeometry.data() + pos, packedGeometry.size() - pos,
+                               values.size(), stride, values.data());
+        for (size_t i = 0; i < items.size(); i++) {
+            set(items[i], &values[i * stride]);
+        }
+    }
+    
+    template<typename T>
+    static void getPen(const T& e, int64_t* v) {
+        v[0] = e.color;
+        v[1] = e.width;
+        v[2] = e.lineType;
+        v[3] = e.layer;
+        v[4] = e.penStyle;
+    }
+    
+    template<typename T>
+    static void setPen(T& e, const int64_t* v) {
+        e.color = static_cast<int>(v[0]);
+        e.width = static_cast<int>(v[1]);
+        e.lineType = static_cast<int>(v[2]);
+        e.layer = static_cast<int>(v[3]);
+        e.penStyle = static_cast<int>(v[4]);
+    }
+    
+    // Inverse of packGeometry(), same column order
+    void unpackAll() const {
+        JWWMemory::Charge charge(memoryOwner);
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
+        const double step = packedStep;
+        const double paramStep = step > 0.0 ? PARAM_STEP : 0.0;
+        size_t pos = 0;
+        lines.resize(packedCounts[PACKED_LINES]);
+        unpackReals(lines, 4, step, pos, [](JSLineData& l, const double* v) {
+            l.x1 = v[0]; l.y1 = v[1]; l.x2 = v[2]; l.y2 = v[3];
+        });
+        unpackInts(lines, 5, pos, setPen<JSLineData>);
+        circles.resize(packedCounts[PACKED_CIRCLES]);
+        unpackReals(circles, 3, step, pos, [](JSCircleData& c, const double* v) {
+            c.cx = v[0]; c.cy = v[1]; c.radius = v[2];
+        });
+        unpackInts(circles, 5, pos, setPen<JSCircleData>);
+        arcs.resize(packedCounts[PACKED_ARCS]);
+        unpackReals(arcs, 3, step, pos, [](JSArcData& a, const double* v) {
+            a.cx = v[0]; a.cy = v[1]; a.radius = v[2];
+        });
+        unpackReals(arcs, 2, paramStep, pos, [](JSArcData& a, const double* v) {
+            a.angle1 = v[0]; a.angle2 = v[1];
+        });
+        unpackInts(arcs, 5, pos, setPen<JSArcData>);
+        ellipses.resize(packedCounts[PACKED_ELLIPSES]);
+        unpackReals(ellipses, 3, step, pos, [](JSEllipseData& e, const double* v) {
+            e.cx = v[0]; e.cy = v[1]; e.majorAxis = v[2];
+        });
+        unpackReals(ellipses, 4, paramStep, pos, [](JSEllipseData& e, const double* v) {
+            e.ratio = v[0]; e.angle = v[1]; e.startParam = v[2]; e.endParam = v[3];
+        });
+        unpackInts(ellipses, 5, pos, setPen<JSEllipseData>);
+        points.resize(packedCounts[PACKED_POINTS]);
+        unpackReals(points, 3, step, pos, [](JSPointData& p, const double* v) {
+            p.x = v[0]; p.y = v[1]; p.z = v[2];
+        });
+        unpackInts(points, 1, pos, [](JSPointData& p, const int64_t* v) { p.color = static_cast<int>(v[0]); });
+        solids.resize(packedCounts[PACKED_SOLIDS]);
+        unpackReals(solids, 12, step, pos, [](JSSolidData& sd, const double* v) {
+            for (int k = 0; k < 4; k++) {
+                sd.x[k] = v[k];
+                sd.y[k] = v[4 + k];
+                sd.z[k] = v[8 + k];
+            }
+        });
+        unpackInts(solids, 1, pos, [](JSSolidData& sd, const int64_t* v) { sd.color = static_cast<int>(v[0]); });
+        std::vector<uint8_t>().swap(packedGeometry);
+        geometryPacked = false;
+    }
     
     // Memory optimization
     static constexpr size_t INITIAL_CAPACITY = 1000;
@@ -327,6 +710,7 @@ private:
 public:
     // Public method to reserve capacity
     void reserveCapacity(size_t capacity) {
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
         if (capacity > lines.capacity()) {
             lines.reserve(capacity);
         }
@@ -338,6 +722,7 @@ public:
     }
     // Constructor with memory pre-allocation
     JSCreationInterface() : progressiveLoader(10000) {
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
         // Pre-allocate memory for common entity types
         lines.reserve(INITIAL_CAPACITY);
         circles.reserve(INITIAL_CAPACITY / 4);
@@ -354,6 +739,7 @@ public:
     
     // Constructor with file size hint for better pre-allocation
     JSCreationInterface(size_t fileSize) : progressiveLoader(10000) {
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
         // Estimate entity counts based on file size
         size_t estimatedEntities = fileSize / 100; // Rough estimate
         
@@ -394,18 +780,22 @@ public:
         total += leaders.capacity() * sizeof(JSLeaderData);
         total += images.capacity() * sizeof(JSImageData);
         total += imageDefs.capacity() * sizeof(JSImageDefData);
+        for (const auto& boxes : entityBoxes) {
+            total += boxes.capacity() * sizeof(JWWSpatial::Box);
+        }
+        total += packedGeometry.capacity();
         return total;
     }
     
     // Getters for JavaScript
-    const std::vector<JSLineData>& getLines() const { return lines; }
-    const std::vector<JSCircleData>& getCircles() const { return circles; }
-    const std::vector<JSArcData>& getArcs() const { return arcs; }
+    const std::vector<JSLineData>& getLines() const { unpackGeometry(); return lines; }
+    const std::vector<JSCircleData>& getCircles() const { unpackGeometry(); return circles; }
+    const std::vector<JSArcData>& getArcs() const { unpackGeometry(); return arcs; }
     const std::vector<JSTextData>& getTexts() const { return texts; }
-    const std::vector<JSEllipseData>& getEllipses() const { return ellipses; }
-    const std::vector<JSPointData>& getPoints() const { return points; }
+    const std::vector<JSEllipseData>& getEllipses() const { unpackGeometry(); return ellipses; }
+    const std::vector<JSPointData>& getPoints() const { unpackGeometry(); return points; }
     const std::vector<JSPolylineData>& getPolylines() const { return polylines; }
-    const std::vector<JSSolidData>& getSolids() const { return solids; }
+    const std::vector<JSSolidData>& getSolids() const { unpackGeometry(); return solids; }
     const std::vector<JSMTextData>& getMTexts() const { return mtexts; }
     const std::vector<JSDimensionData>& getDimensions() const { return dimensions; }
     const std::vector<JSSplineData>& getSplines() const { return splines; }
@@ -415,8 +805,126 @@ public:
     const std::vector<JSLeaderData>& getLeaders() const { return leaders; }
     const std::vector<JSImageData>& getImages() const { return images; }
     const std::vector<JSImageDefData>& getImageDefs() const { return imageDefs; }
+    const std::vector<std::string>& getLayerNames() const { return layerNames; }
+    const std::vector<std::string>& getLineTypeNames() const { return lineTypeNames; }
     const std::vector<JSParseError>& getParseErrors() const { return parseErrors; }
     
+    // Extents of everything decoded so far; false when nothing was
+    bool getExtents(JWWSpatial::Box& box) const {
+        box = extents;
+        return hasExtents;
+    }
+    
+    // Pack lines, circles, arcs, ellipses, points and solids (see
+    // include/jww_pack.h) and free their vectors. With step 0 every value
+    // is kept exactly; otherwise coordinates, radii and axes are rounded to
+    // multiples of step, angles, ratios and parameters to PARAM_STEP.
+    // Per-entity boxes are dropped too; they are recomputed from the
+    // entities when needed. Returns the largest coordinate error;
+    // *paramError gets the largest angle and parameter error.
+    static constexpr double PARAM_STEP = 1e-9;
+    
+    double packGeometry(double step, double* paramError) {
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
+        unpackGeometry();
+        packedGeometry.clear();
+        if (!(step > 0.0)) {
+            step = 0.0;
+        }
+        const double paramStep = step > 0.0 ? PARAM_STEP : 0.0;
+        double err = 0.0;
+        double paramErr = 0.0;
+        
+        err = std::max(err, packReals(lines, 4, step, [](const JSLineData& l, double* v) {
+            v[0] = l.x1; v[1] = l.y1; v[2] = l.x2; v[3] = l.y2;
+        }));
+        packInts(lines, 5, getPen<JSLineData>);
+        err = std::max(err, packReals(circles, 3, step, [](const JSCircleData& c, double* v) {
+            v[0] = c.cx; v[1] = c.cy; v[2] = c.radius;
+        }));
+        packInts(circles, 5, getPen<JSCircleData>);
+        err = std::max(err, packReals(arcs, 3, step, [](const JSArcData& a, double* v) {
+            v[0] = a.cx; v[1] = a.cy; v[2] = a.radius;
+        }));
+        paramErr = std::max(paramErr, packReals(arcs, 2, paramStep, [](const JSArcData& a, double* v) {
+            v[0] = a.angle1; v[1] = a.angle2;
+        }));
+        packInts(arcs, 5, getPen<JSArcData>);
+        err = std::max(err, packReals(ellipses, 3, step, [](const JSEllipseData& e, double* v) {
+            v[0] = e.cx; v[1] = e.cy; v[2] = e.majorAxis;
+        }));
+        paramErr = std::max(paramErr, packReals(ellipses, 4, paramStep, [](const JSEllipseData& e, double* v) {
+            v[0] = e.ratio; v[1] = e.angle; v[2] = e.startParam; v[3] = e.endParam;
+        }));
+        packInts(ellipses, 5, getPen<JSEllipseData>);
+        err = std::max(err, packReals(points, 3, step, [](const JSPointData& p, double* v) {
+            v[0] = p.x; v[1] = p.y; v[2] = p.z;
+        }));
+        packInts(points, 1, [](const JSPointData& p, int64_t* v) { v[0] = p.color; });
+        err = std::max(err, packReals(solids, 12, step, [](const JSSolidData& sd, double* v) {
+            for (int k = 0; k < 4; k++) {
+                v[k] = sd.x[k];
+                v[4 + k] = sd.y[k];
+                v[8 + k] = sd.z[k];
+            }
+        }));
+        packInts(solids, 1, [](const JSSolidData& sd, int64_t* v) { v[0] = sd.color; });
+        
+        packedCounts[PACKED_LINES] = lines.size();
+        packedCounts[PACKED_CIRCLES] = circles.size();
+        packedCounts[PACKED_ARCS] = arcs.size();
+        packedCounts[PACKED_ELLIPSES] = ellipses.size();
+        packedCounts[PACKED_POINTS] = points.size();
+        packedCounts[PACKED_SOLIDS] = solids.size();
+        packedStep = step;
+        geometryPacked = true;
+        std::vector<uint8_t>(packedGeometry).swap(packedGeometry);
+        std::vector<JSLineData>().swap(lines);
+        std::vector<JSCircleData>().swap(circles);
+        std::vector<JSArcData>().swap(arcs);
+        std::vector<JSEllipseData>().swap(ellipses);
+        std::vector<JSPointData>().swap(points);
+        std::vector<JSSolidData>().swap(solids);
+        boxesRecorded = false;
+        for (auto& boxes : entityBoxes) {
+            std::vector<JWWSpatial::Box>().swap(boxes);
+        }
+        if (paramError) {
+            *paramError = paramErr;
+        }
+        return err;
+    }
+    
+    // Decode packed geometry back into the entity vectors; every getter of
+    // a packed kind calls this first
+    void unpackGeometry() const {
+        if (geometryPacked) {
+            unpackAll();
+        }
+    }
+    
+    bool isGeometryPacked() const { return geometryPacked; }
+    
+    // Getters may expand packed geometry outside any caller's Charge; the
+    // reader owning this interface passes its Owner so it pays for that too
+    void setMemoryOwner(const JWWMemory::Owner* owner) { memoryOwner = owner; }
+    
+    // Boxes of one entity kind in decode order, empty unless recorded
+    const std::vector<JWWSpatial::Box>& getEntityBoxes(BoxKind kind) const { return entityBoxes[kind]; }
+    bool hasEntityBoxes() const { return boxesRecorded; }
+    
+    // Keep per-entity boxes from the next parse on (the default) or only
+    // the extents
+    void setRecordEntityBoxes(bool record) {
+        recordEntityBoxes = record;
+        if (!record) {
+            boxesRecorded = false;
+            for (auto& boxes : entityBoxes) {
+                std::vector<JWWSpatial::Box>().swap(boxes);
+            }
+        }
+    }
+    
     // Clear all data
     void clear() {
         lines.clear();
@@ -446,11 +954,58 @@ public:
         parseErrors.clear();
         blockIndexBuilder.clear();
         imageIndexBuilder.clear();
+        layerNames.clear();
+        lineTypeNames.clear();
+        layerNameToIndex.clear();
+        lineTypeNameToIndex.clear();
+        currentLayer = 0;
+        currentLineType = 0;
+        currentPenStyle = 0;
+        hasExtents = false;
+        boxesRecorded = recordEntityBoxes;
+        for (auto& boxes : entityBoxes) {
+            boxes.clear();
+        }
+        packedGeometry.clear();
+        geometryPacked = false;
+    }
+    
+    // Clear all data and return the reserved storage to the heap
+    void releaseMemory() {
+        clear();
+        std::vector<JSLineData>().swap(lines);
+        std::vector<JSCircleData>().swap(circles);
+        std::vector<JSArcData>().swap(arcs);
+        std::vector<JSTextData>().swap(texts);
+        std::vector<JSEllipseData>().swap(ellipses);
+        std::vector<JSPointData>().swap(points);
+        std::vector<JSPolylineData>().swap(polylines);
+        std::vector<JSSolidData>().swap(solids);
+        std::vector<JSMTextData>().swap(mtexts);
+        std::vector<JSDimensionData>().swap(dimensions);
+        std::vector<JSSplineData>().swap(splines);
+        std::vector<JSBlockData>().swap(blocks);
+        std::vector<JSInsertData>().swap(inserts);
+        std::vector<JSHatchData>().swap(hatches);
+        std::vector<JSLeaderData>().swap(leaders);
+        std::vector<JSImageData>().swap(images);
+        std::vector<JSImageDefData>().swap(imageDefs);
+        std::vector<JSParseError>().swap(parseErrors);
+        for (auto& boxes : entityBoxes) {
+            std::vector<JWWSpatial::Box>().swap(boxes);
+        }
+        std::vector<uint8_t>().swap(packedGeometry);
     }
     
     // Batch processing methods
     void processBatchedLines(const std::vector<std::tuple<double, double, double, double, int>>& lineData) {
+        size_t first = lines.size();
         BatchedJSOperations::addLinesBatch(lines, lineData);
+        for (size_t i = first; i < lines.size(); i++) {
+            const JSLineData& l = lines[i];
+            addBox(BOX_LINE, JWWSpatial::Box(std::min(l.x1, l.x2), std::min(l.y1, l.y2),
+                                             std::max(l.x1, l.x2), std::max(l.y1, l.y2)));
+        }
     }
     
     // Set progress callback for large file processing
@@ -460,6 +1015,7 @@ public:
     
     // Build indexes in batch mode
     void buildIndexes() {
+        JWWMemory::Scope memoryScope(JWWMemory::Index);
         // Build block name index
         std::vector<std::pair<std::string, int>> blockPairs;
         for (size_t i = 0; i < blocks.size(); ++i) {
@@ -478,14 +1034,14 @@ public:
     // Get entity statistics with batch counting
     std::map<std::string, size_t> getEntityStats() const {
         std::vector<std::pair<std::string, size_t>> typeCounts = {
-            {"lines", lines.size()},
-            {"circles", circles.size()},
-            {"arcs", arcs.size()},
+            {"lines", countOf(lines.size(), PACKED_LINES)},
+            {"circles", countOf(circles.size(), PACKED_CIRCLES)},
+            {"arcs", countOf(arcs.size(), PACKED_ARCS)},
             {"texts", texts.size()},
-            {"ellipses", ellipses.size()},
-            {"points", points.size()},
+            {"ellipses", countOf(ellipses.size(), PACKED_ELLIPSES)},
+            {"points", countOf(points.size(), PACKED_POINTS)},
             {"polylines", polylines.size()},
-            {"solids", solids.size()},
+            {"solids", countOf(solids.size(), PACKED_SOLIDS)},
             {"mtexts", mtexts.size()},
             {"dimensions", dimensions.size()},
             {"splines", splines.size()},
@@ -501,8 +1057,12 @@ public:
     }
     
     // DL_CreationInterface implementation
-    void setAttributes(const DL_Attributes& attrib) {
+    void setAttributes(const DL_Attributes& attrib) override {
         currentColor = attrib.getColor();
+        currentWidth = attrib.getWidth();
+        currentPenStyle = attrib.getPenStyle();
+        currentLayer = internName(layerNames, layerNameToIndex, currentLayer, attrib.getLayer());
+        currentLineType = internName(lineTypeNames, lineTypeNameToIndex, currentLineType, attrib.getLineType());
         // Call parent implementation
         DL_CreationInterface::setAttributes(attrib);
     }
@@ -534,18 +1094,27 @@ public:
     virtual void endBlock() override {}
     virtual void addPoint(const DL_PointData& data) override {
         points.push_back({data.x, data.y, data.z, currentColor});
+        addBox(BOX_POINT, JWWSpatial::Box(data.x, data.y, data.x, data.y));
     }
     
     virtual void addLine(const DL_LineData& data) override {
-        lines.push_back({data.x1, data.y1, data.x2, data.y2, currentColor});
+        lines.push_back({data.x1, data.y1, data.x2, data.y2, currentColor, currentWidth,
+                         currentLineType, currentLayer, currentPenStyle});
+        addBox(BOX_LINE, JWWSpatial::Box(std::min(data.x1, data.x2), std::min(data.y1, data.y2),
+                                         std::max(data.x1, data.x2), std::max(data.y1, data.y2)));
     }
     
     virtual void addArc(const DL_ArcData& data) override {
-        arcs.push_back({data.cx, data.cy, data.radius, data.angle1, data.angle2, currentColor});
+        arcs.push_back({data.cx, data.cy, data.radius, data.angle1, data.angle2, currentColor, currentWidth,
+                        currentLineType, currentLayer, currentPenStyle});
+        addBox(BOX_ARC, arcBox(arcs.back()));
     }
     
     virtual void addCircle(const DL_CircleData& data) override {
-        circles.push_back({data.cx, data.cy, data.radius, currentColor});
+        circles.push_back({data.cx, data.cy, data.radius, currentColor, currentWidth,
+                           currentLineType, currentLayer, currentPenStyle});
+        addBox(BOX_CIRCLE, JWWSpatial::Box(data.cx - data.radius, data.cy - data.radius,
+                                           data.cx + data.radius, data.cy + data.radius));
     }
     
     virtual void addEllipse(const DL_EllipseData& data) override {
@@ -554,12 +1123,21 @@ public:
         double dy = data.my - data.cy;
         double majorAxis = sqrt(dx * dx + dy * dy);
         double angle = atan2(dy, dx);
-        ellipses.push_back({data.cx, data.cy, majorAxis, data.ratio, angle, currentColor});
+        double endParam = data.angle2 > data.angle1 ? data.angle2 : data.angle1 + 2.0 * M_PI;
+        ellipses.push_back({data.cx, data.cy, majorAxis, data.ratio, angle,
+                            data.angle1, endParam, currentColor, currentWidth,
+                            currentLineType, currentLayer, currentPenStyle});
+        addBox(BOX_ELLIPSE, ellipseBox(ellipses.back()));
     }
     virtual void addPolyline(const DL_PolylineData& data) override {
         JSPolylineData polyline;
         polyline.closed = (data.flags & 0x01) != 0;  // Check if closed
         polyline.color = currentColor;
+        polyline.width = currentWidth;
+        polyline.lineType = currentLineType;
+        polyline.layer = currentLayer;
+        polyline.penStyle = currentPenStyle;
+        polyline.firstSource = polyline.sourceCount = 0;
         polylines.push_back(polyline);
         currentPolyline = &polylines.back();
     }
@@ -578,10 +1156,28 @@ public:
         spline.controlPoints.reserve(data.nControl);
         splines.push_back(spline);
         currentSpline = &splines.back();
+        // Grows with the control points; an empty spline matches nothing
+        if (boxesRecorded) {
+            entityBoxes[BOX_SPLINE].push_back(JWWSpatial::Box(1.0, 1.0, -1.0, -1.0));
+        }
     }
     virtual void addControlPoint(const DL_ControlPointData& data) override {
         if (currentSpline) {
             currentSpline->controlPoints.push_back({data.x, data.y, data.z, 1.0});
+            // A spline lies inside the hull of its control points
+            JWWSpatial::Box point(data.x, data.y, data.x, data.y);
+            extend(point);
+            if (boxesRecorded && !entityBoxes[BOX_SPLINE].empty()) {
+                JWWSpatial::Box& box = entityBoxes[BOX_SPLINE].back();
+                if (box.minX > box.maxX) {
+                    box = point;
+                } else {
+                    box.minX = std::min(box.minX, data.x);
+                    box.minY = std::min(box.minY, data.y);
+                    box.maxX = std::max(box.maxX, data.x);
+                    box.maxY = std::max(box.maxY, data.y);
+                }
+            }
         }
     }
     virtual void addKnot(const DL_KnotData& data) override {
@@ -627,6 +1223,7 @@ public:
         }
         solid.color = currentColor;
         solids.push_back(solid);
+        addBox(BOX_SOLID, solidBox(solid));
     }
     virtual void addMText(const DL_MTextData& data) override {
         // Store both the text string and original bytes
@@ -654,7 +1251,11 @@ public:
     virtual void addText(const DL_TextData& data) override {
         // Store both the text string and original bytes
         std::vector<uint8_t> bytes(data.text.begin(), data.text.end());
-        texts.push_back({data.ipx, data.ipy, data.height, data.angle * M_PI / 180.0, data.text, bytes, currentColor});
+        // DL_TextData carries the angle in radians and the character width
+        // as the x scale factor
+        double widthFactor = data.xScaleFactor > 0.0 ? data.xScaleFactor : 1.0;
+        texts.push_back({data.ipx, data.ipy, data.height, data.angle, widthFactor, data.text, bytes, currentColor});
+        addBox(BOX_TEXT, textBox(texts.back()));
     }
     virtual void addDimAlign(const DL_DimensionData& data, const DL_DimAlignedData& edata) override {
         dimensions.push_back({
@@ -877,14 +1478,344 @@ public:
     virtual void endEntity() override {}
 };
 
+// Line-list vertices bucketed by pen, each bucket contiguous
+struct PenLineList {
+    std::vector<float> vertices;       // x, y per vertex
+    std::vector<uint8_t> colors;       // RGBA per vertex (PEN_VERTEX_COLORS)
+    std::vector<JSDrawGroup> groups;   // In key order
+    
+    void clear() {
+        vertices.clear();
+        colors.clear();
+        groups.clear();
+    }
+    
+    void release() {
+        std::vector<float>().swap(vertices);
+        std::vector<uint8_t>().swap(colors);
+        std::vector<JSDrawGroup>().swap(groups);
+    }
+    
+    size_t reservedBytes() const {
+        return vertices.capacity() * sizeof(float) + colors.capacity() +
+               groups.capacity() * sizeof(JSDrawGroup);
+    }
+};
+
+// Entity coordinates in one quantized frame (see include/jww_quant.h):
+// lines x1, y1, x2, y2; circles and arcs cx, cy, radius; ellipses cx, cy,
+// majorAxis; points x, y; solids four x, y corners; texts x, y. Values
+// that are not coordinates stay float32 beside them.
+struct QuantizedGeometry {
+    JWWQuant::Store lines, circles, arcs, ellipses, points, solids, texts;
+    std::vector<float> arcAngles;       // angle1, angle2 per arc (degrees)
+    std::vector<float> ellipseParams;   // ratio, angle, startParam, endParam
+    bool built = false;
+    
+    JWWQuant::Store* stores[7] = {&lines, &circles, &arcs, &ellipses, &points, &solids, &texts};
+    
+    QuantizedGeometry() {}
+    QuantizedGeometry(const QuantizedGeometry&) = delete;
+    QuantizedGeometry& operator=(const QuantizedGeometry&) = delete;
+    
+    void clear() {
+        for (JWWQuant::Store* s : stores) {
+            s->reset(JWWQuant::Frame());
+        }
+        arcAngles.clear();
+        ellipseParams.clear();
+        built = false;
+    }
+    
+    void release() {
+        for (JWWQuant::Store* s : stores) {
+            s->release();
+        }
+        std::vector<float>().swap(arcAngles);
+        std::vector<float>().swap(ellipseParams);
+        built = false;
+    }
+    
+    double maxError() const {
+        double e = 0.0;
+        for (const JWWQuant::Store* s : stores) {
+            e = std::max(e, s->maxError());
+        }
+        return e;
+    }
+    
+    size_t reservedBytes() const {
+        size_t total = (arcAngles.capacity() + ellipseParams.capacity()) * sizeof(float);
+        for (const JWWQuant::Store* s : stores) {
+            total += s->bytes();
+        }
+        return total;
+    }
+};
+
+enum PenLineListFlags {
+    PEN_INCLUDE_LINES = 1,   // Lines as well as circles, arcs and ellipses
+    PEN_FULL_KEY = 2,        // Key on line type and layer, not only color and width
+    PEN_VERTEX_COLORS = 4    // Fill PenLineList::colors
+};
+
+// Quantize the coordinates of everything decoded into a frame fitted to
+// the drawing's extents
+void buildQuantizedGeometry(const JSCreationInterface& ci, JWWQuant::Format format, QuantizedGeometry& out) {
+    JWWMemory::Scope memoryScope(JWWMemory::Index);
+    JWWSpatial::Box b;
+    JWWQuant::Frame frame;
+    if (ci.getExtents(b)) {
+        frame = JWWQuant::fit(b.minX, b.minY, b.maxX, b.maxY, format);
+    } else {
+        frame.format = format;
+    }
+    out.clear();
+    for (JWWQuant::Store* s : out.stores) {
+        s->reset(frame);
+    }
+    out.built = true;
+    
+    out.lines.reserve(ci.getLines().size() * 4);
+    for (const auto& l : ci.getLines()) {
+        out.lines.point(l.x1, l.y1);
+        out.lines.point(l.x2, l.y2);
+    }
+    out.circles.reserve(ci.getCircles().size() * 3);
+    for (const auto& c : ci.getCircles()) {
+        out.circles.point(c.cx, c.cy);
+        out.circles.length(c.radius);
+    }
+    out.arcs.reserve(ci.getArcs().size() * 3);
+    out.arcAngles.reserve(ci.getArcs().size() * 2);
+    for (const auto& a : ci.getArcs()) {
+        out.arcs.point(a.cx, a.cy);
+        out.arcs.length(a.radius);
+        out.arcAngles.push_back(static_cast<float>(a.angle1));
+        out.arcAngles.push_back(static_cast<float>(a.angle2));
+    }
+    out.ellipses.reserve(ci.getEllipses().size() * 3);
+    out.ellipseParams.reserve(ci.getEllipses().size() * 4);
+    for (const auto& e : ci.getEllipses()) {
+        out.ellipses.point(e.cx, e.cy);
+        out.ellipses.length(e.majorAxis);
+        out.ellipseParams.push_back(static_cast<float>(e.ratio));
+        out.ellipseParams.push_back(static_cast<float>(e.angle));
+        out.ellipseParams.push_back(static_cast<float>(e.startParam));
+        out.ellipseParams.push_back(static_cast<float>(e.endParam));
+    }
+    out.points.reserve(ci.getPoints().size() * 2);
+    for (const auto& p : ci.getPoints()) {
+        out.points.point(p.x, p.y);
+    }
+    out.solids.reserve(ci.getSolids().size() * 8);
+    for (const auto& sd : ci.getSolids()) {
+        for (int k = 0; k < 4; k++) {
+            out.solids.point(sd.x[k], sd.y[k]);
+        }
+    }
+    out.texts.reserve(ci.getTexts().size() * 2);
+    for (const auto& t : ci.getTexts()) {
+        out.texts.point(t.x, t.y);
+    }
+}
+
+#ifdef EMSCRIPTEN
+// Float32Array or Int32Array view of a store's values
+emscripten::val quantizedToJS(const JWWQuant::Store& s) {
+    if (s.frame().format == JWWQuant::INT32) {
+        return emscripten::val(emscripten::typed_memory_view(s.int32().size(), s.int32().data()));
+    }
+    return emscripten::val(emscripten::typed_memory_view(s.float32().size(), s.float32().data()));
+}
+#endif
+
+// Dash patterns for buildPenLineList: lines, circles and arcs whose pen
+// style has a pattern are expanded at `scale` (dots per drawing unit) and
+// the expansions are kept in the cache per getEntities() index
+struct PenLinetypes {
+    const JWWLinetype::PatternTable* table;
+    JWWLinetype::SegmentCache* cache;
+    double scale;
+};
+
+// Build a pen-bucketed line list (see JWWPenLines::Builder): groups are
+// ordered by (layer, line type, width, color), each contiguous, and
+// coordinates are relative to (originX, originY)
+static void buildPenLineList(const JSCreationInterface& ci, double tolerance,
+                             double originX, double originY, int flags, PenLineList& out,
+                             const PenLinetypes* linetypes = nullptr) {
+    const bool withLines = (flags & PEN_INCLUDE_LINES) != 0;
+    const bool fullKey = (flags & PEN_FULL_KEY) != 0;
+    const auto& lines = ci.getLines();
+    const auto& circles = ci.getCircles();
+    const auto& arcs = ci.getArcs();
+    const auto& ellipses = ci.getEllipses();
+    
+    // Dashed entities: segments from the cache, expanded on a miss at the
+    // bucket's scale so every zoom within the bucket reuses them
+    const bool dashed = linetypes && linetypes->scale > 0.0;
+    const int bucket = dashed ? JWWLinetype::scaleBucket(linetypes->scale) : 0;
+    const double bucketScale = JWWLinetype::bucketScale(bucket);
+    std::vector<double> scratch;
+    if (dashed) {
+        linetypes->cache->trim();
+    }
+    // (x, y) is an arc's center or a line's start point
+    auto expansion = [&](size_t entity, int penStyle, bool arc, double x, double y,
+                         double r, double start, double sweep, double x2, double y2)
+            -> const std::vector<double>* {
+        const JWWLinetype::Pattern& pattern = linetypes->table->get(penStyle);
+        if (pattern.kind == JWWLinetype::Pattern::Solid) {
+            return nullptr;
+        }
+        uint32_t id = static_cast<uint32_t>(entity);
+        if (const std::vector<double>* hit = linetypes->cache->find(id, bucket)) {
+            return hit;
+        }
+        scratch.clear();
+        if (arc) {
+            JWWLinetype::expandArc(pattern, bucketScale, x, y, r, start, sweep, scratch);
+        } else {
+            JWWLinetype::expandLine(pattern, bucketScale, x, y, x2, y2, scratch);
+        }
+        return &linetypes->cache->insert(id, bucket, scratch);
+    };
+    auto penOf = [fullKey](int color, int width, int lineType, int layer) {
+        JWWPenLines::Pen pen = {fullKey ? layer : -1, fullKey ? lineType : -1, width, color};
+        return pen;
+    };
+    
+    JWWPenLines::Builder builder;
+    const size_t curveCount = circles.size() + arcs.size() + ellipses.size();
+    builder.reserve((withLines ? lines.size() : 0) + curveCount, curveCount);
+    if (withLines) {
+        for (size_t i = 0; i < lines.size(); i++) {
+            const JSLineData& l = lines[i];
+            JWWPenLines::Pen pen = penOf(l.color, l.width, l.lineType, l.layer);
+            const std::vector<double>* d = dashed ?
+                expansion(i, l.penStyle, false, l.x1, l.y1, 0.0, 0.0, 0.0, l.x2, l.y2) : nullptr;
+            // Cached expansions stay put until the next trim(), and lines
+            // until the entities change, so the builder can point at both
+            if (d) {
+                builder.addSegments(d->data(), d->size() / 4, pen);
+            } else {
+                builder.addSegments(&l.x1, 1, pen);
+            }
+        }
+    }
+    // Cache ids are getEntities() indices whether or not lines are included
+    size_t entity = lines.size();
+    for (const auto& c : circles) {
+        JWWPenLines::Pen pen = penOf(c.color, c.width, c.lineType, c.layer);
+        const std::vector<double>* d = dashed ?
+            expansion(entity, c.penStyle, true, c.cx, c.cy, c.radius, 0.0, 2.0 * M_PI, 0.0, 0.0) : nullptr;
+        if (d) {
+            builder.addSegments(d->data(), d->size() / 4, pen);
+        } else {
+            builder.addArc(c.cx, c.cy, c.radius, c.radius, 0.0, 0.0, 2.0 * M_PI, pen);
+        }
+        entity++;
+    }
+    for (const auto& a : arcs) {
+        JWWPenLines::Pen pen = penOf(a.color, a.width, a.lineType, a.layer);
+        double start, end;
+        arcSpan(a, start, end);
+        const std::vector<double>* d = dashed ?
+            expansion(entity, a.penStyle, true, a.cx, a.cy, a.radius, start, end - start, 0.0, 0.0) : nullptr;
+        if (d) {
+            builder.addSegments(d->data(), d->size() / 4, pen);
+        } else {
+            builder.addArc(a.cx, a.cy, a.radius, a.radius, 0.0, start, end - start, pen);
+        }
+        entity++;
+    }
+    for (const auto& e : ellipses) {
+        builder.addArc(e.cx, e.cy, e.majorAxis, e.majorAxis * e.ratio, e.angle,
+                       e.startParam, e.endParam - e.startParam,
+                       penOf(e.color, e.width, e.lineType, e.layer));
+    }
+    
+    std::vector<JWWPenLines::Group> groups;
+    builder.build(tolerance, originX, originY, out.vertices, groups);
+    out.groups.clear();
+    out.groups.reserve(groups.size());
+    for (const auto& g : groups) {
+        uint8_t rgba[4];
+        colorToRGBA(g.pen.color, rgba);
+        int rgb = (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+        out.groups.push_back({g.pen.color, rgb, g.pen.width, g.pen.lineType, g.pen.layer,
+                              static_cast<int>(g.first), static_cast<int>(g.count)});
+    }
+    
+    if (flags & PEN_VERTEX_COLORS) {
+        out.colors.resize(out.vertices.size() * 2);
+        for (const auto& g : out.groups) {
+            uint8_t rgba[4];
+            colorToRGBA(g.color, rgba);
+            uint8_t* c = out.colors.data() + static_cast<size_t>(g.first) * 4;
+            for (int v = 0; v < g.count; v++, c += 4) {
+                c[0] = rgba[0];
+                c[1] = rgba[1];
+                c[2] = rgba[2];
+                c[3] = rgba[3];
+            }
+        }
+    } else {
+        out.colors.clear();
+    }
+}
+
+#ifdef EMSCRIPTEN
+// { vertices: Float32Array, groups: [...] } for a PenLineList; colors are
+// added when present. The arrays are views into WASM memory.
+static emscripten::val penLineListToJS(const PenLineList& list) {
+    emscripten::val result = emscripten::val::object();
+    result.set("vertices", emscripten::val(emscripten::typed_memory_view(list.vertices.size(), list.vertices.data())));
+    if (!list.colors.empty()) {
+        result.set("colors", emscripten::val(emscripten::typed_memory_view(list.colors.size(), list.colors.data())));
+    }
+    emscripten::val groups = emscripten::val::array();
+    for (size_t i = 0; i < list.groups.size(); i++) {
+        groups.set(i, list.groups[i]);
+    }
+    result.set("groups", groups);
+    return result;
+}
+
+// Layer and line type names that group layer/lineType indices refer to
+static void setPenNames(emscripten::val& result, const JSCreationInterface& ci) {
+    emscripten::val layers = emscripten::val::array();
+    for (size_t i = 0; i < ci.getLayerNames().size(); i++) {
+        layers.set(i, ci.getLayerNames()[i]);
+    }
+    emscripten::val lineTypes = emscripten::val::array();
+    for (size_t i = 0; i < ci.getLineTypeNames().size(); i++) {
+        lineTypes.set(i, ci.getLineTypeNames()[i]);
+    }
+    result.set("layers", layers);
+    result.set("lineTypes", lineTypes);
+}
+
+// Render command list plus the layer and line type names its indices refer to
+static emscripten::val renderCommandsToJS(const PenLineList& list, const JSCreationInterface& ci) {
+    emscripten::val result = penLineListToJS(list);
+    setPenNames(result, ci);
+    return result;
+}
+#endif
+
 // JWW Document class for new WASM interface
 class JWWDocumentWASM {
 private:
+    // Heap bytes this document allocated (see getMemoryUsage())
+    JWWMemory::Owner memoryOwner;
     std::unique_ptr<JSCreationInterface> creationInterface;
     std::vector<JSEntityData> entities;
     std::vector<JSLayerData> layers;
     std::string lastError;
     bool hasErrorFlag;
+    PenLineList renderBuffers;
     
     // Convert existing entity types to new JSEntityData format
     void convertEntitiesToNewFormat() {
@@ -934,39 +1865,25 @@ private:
     
 public:
     JWWDocumentWASM() : hasErrorFlag(false) {
+        JWWMemory::Charge charge(&memoryOwner);
         creationInterface = std::make_unique<JSCreationInterface>();
+        creationInterface->setMemoryOwner(&memoryOwner);
+        // No spatial index here; only the extents are needed
+        creationInterface->setRecordEntityBoxes(false);
     }
     
     // Load JWW file from memory
     bool loadFromMemory(uintptr_t dataPtr, size_t size) {
+        JWWMemory::Charge charge(&memoryOwner);
         hasErrorFlag = false;
         lastError.clear();
         
         creationInterface->clear();
         
-        // Use existing JWWReader logic
-        const uint8_t* data = reinterpret_cast<const uint8_t*>(dataPtr);
-        std::string tempFile = "/tmp/jww_temp.jww";
-        FILE* fp = fopen(tempFile.c_str(), "wb");
-        if (!fp) {
-            lastError = "Failed to create temporary file";
-            hasErrorFlag = true;
-            return false;
-        }
-        
-        size_t written = fwrite(data, 1, size, fp);
-        fclose(fp);
-        
-        if (written != size) {
-            remove(tempFile.c_str());
-            lastError = "Failed to write temporary file";
-            hasErrorFlag = true;
-            return false;
-        }
-        
+        // Parse straight from the caller's memory; no MEMFS temporary file
+        const char* data = reinterpret_cast<const char*>(dataPtr);
         DL_Jww jww;
-        bool result = jww.in(tempFile, creationInterface.get());
-        remove(tempFile.c_str());
+        bool result = jww.in(data, size, creationInterface.get());
         
         if (result) {
             convertEntitiesToNewFormat();
@@ -996,6 +1913,28 @@ public:
         return entities;
     }
     
+    // Drawing extents accumulated while decoding (see JWWReader::getBounds)
+    JSBounds getBounds() const {
+        JWWSpatial::Box b;
+        bool valid = creationInterface && creationInterface->getExtents(b);
+        return {b.minX, b.minY, b.maxX, b.maxY, valid};
+    }
+    
+#ifdef EMSCRIPTEN
+    // Lines, circles, arcs and ellipses bucketed by pen (see
+    // JWWReader::getRenderCommands); views valid until the next call
+    emscripten::val getRenderCommands(double tolerance, double originX, double originY) {
+        JWWMemory::Charge charge(&memoryOwner);
+        if (!creationInterface) {
+            renderBuffers.clear();
+            return penLineListToJS(renderBuffers);
+        }
+        buildPenLineList(*creationInterface, tolerance, originX, originY,
+                         PEN_INCLUDE_LINES | PEN_FULL_KEY, renderBuffers);
+        return renderCommandsToJS(renderBuffers, *creationInterface);
+    }
+#endif
+    
     // Get all layers
     std::vector<JSLayerData> getLayers() const {
         return layers;
@@ -1025,6 +1964,7 @@ public:
         // Clear vectors first
         entities.clear();
         layers.clear();
+        renderBuffers.release();
         
         // Then reset the creation interface
         if (creationInterface) {
@@ -1036,8 +1976,12 @@ public:
         hasErrorFlag = false;
     }
     
-    // Get memory usage
+    // Heap bytes held by this document: counted when built with
+    // JWW_MEMORY_TRACKING, otherwise estimated from buffer capacities
     size_t getMemoryUsage() const {
+        if (JWWMemory::enabled()) {
+            return memoryOwner.liveBytes();
+        }
         size_t usage = sizeof(*this);
         usage += entities.capacity() * sizeof(JSEntityData);
         usage += layers.capacity() * sizeof(JSLayerData);
@@ -1051,20 +1995,453 @@ public:
 // JWW Reader wrapper class
 class JWWReader {
 private:
+    // Heap bytes this reader allocated, whichever buffer holds them; every
+    // public method that allocates runs under a Charge for it. Declared
+    // first so it exists before anything is charged.
+    JWWMemory::Owner memoryOwner;
+    size_t lastParsePeakBytes = 0;
     std::unique_ptr<DL_Jww> jww;
     std::unique_ptr<JSCreationInterface> creationInterface;
+    std::vector<float> lineVertexBuffer;
+    std::vector<double> entityBoundsBuffer;
+    // Not a vector: resize() would zero every byte JS overwrites anyway
+    std::unique_ptr<char[]> inputBuffer;
+    size_t inputSize = 0;
+    size_t inputCapacity = 0;
+    // Packed Hilbert R-tree over getEntities() indices, built after parsing
+    JWWSpatial::PackedRTree spatialIndex;
+    std::vector<uint32_t> queryBuffer;
+    // Tessellated circles, arcs and ellipses, and the render command list
+    PenLineList curveBuffers;
+    PenLineList renderBuffers;
+    // Dash patterns from the file header and their expansions per
+    // (entity, scale bucket)
+    JWWLinetype::PatternTable linetypeTable;
+    JWWLinetype::SegmentCache linetypeCache;
+    // Level-of-detail pyramid, built on first use; lodPens maps its pen ids
+    // to color, width, line type and layer
+    JWWLod::Pyramid lodPyramid;
+    // Lines joined into polylines by chainLines(), and per polyline edge
+    // the getLines() index it came from
+    std::vector<JSPolylineData> lineChains;
+    std::vector<uint32_t> chainSources;
+    std::vector<JSDrawGroup> lodPens;
+    std::vector<JSDrawGroup> lodGroups;
+    bool lodBuilt = false;
+    // Coordinates copied out by exportQuantizedGeometry()
+    QuantizedGeometry quantized;
+    // Snap points (end/mid points, centers, quadrants), built on first use
+    JWWSpatial::PointKDTree snapIndex;
+    std::vector<double> snapXY;
+    std::vector<uint8_t> snapKind;
+    std::vector<uint32_t> snapEntity;
+    bool snapIndexBuilt = false;
+    // Parse-side record storage, kept across load() calls so its vectors
+    // are reused instead of regrown for every file
+    std::unique_ptr<JWWDocument> document;
+    std::unique_ptr<DL_JwwRecordHandler> streamHandler;
+    std::unique_ptr<JWWStreamParser> streamParser;
+    // With keepRecords the records of the last readFile() stay in document
+    // so saveToBuffer() can write them back into saveBuffer
+    bool keepRecords = false;
+    bool recordsKept = false;
+    size_t keptInputSize = 0;
+    JWWOutputBuf saveBuffer;
+    
+    // One box per entity, in getEntities() order. Taken from the boxes
+    // recorded while decoding unless that was turned off.
+    void gatherEntityBoxes(std::vector<JWWSpatial::Box>& boxes) const {
+        boxes.clear();
+        if (creationInterface->hasEntityBoxes()) {
+            for (int kind = 0; kind < BOX_KIND_COUNT; kind++) {
+                const auto& kindBoxes = creationInterface->getEntityBoxes(static_cast<BoxKind>(kind));
+                boxes.insert(boxes.end(), kindBoxes.begin(), kindBoxes.end());
+            }
+            return;
+        }
+        for (const auto& l : creationInterface->getLines()) {
+            boxes.push_back(JWWSpatial::Box(std::min(l.x1, l.x2), std::min(l.y1, l.y2),
+                                            std::max(l.x1, l.x2), std::max(l.y1, l.y2)));
+        }
+        for (const auto& c : creationInterface->getCircles()) {
+            boxes.push_back(JWWSpatial::Box(c.cx - c.radius, c.cy - c.radius, c.cx + c.radius, c.cy + c.radius));
+        }
+        for (const auto& a : creationInterface->getArcs()) {
+            boxes.push_back(arcBox(a));
+        }
+        for (const auto& t : creationInterface->getTexts()) {
+            boxes.push_back(textBox(t));
+        }
+        for (const auto& e : creationInterface->getEllipses()) {
+            boxes.push_back(ellipseBox(e));
+        }
+        for (const auto& p : creationInterface->getPoints()) {
+            boxes.push_back(JWWSpatial::Box(p.x, p.y, p.x, p.y));
+        }
+        for (const auto& s : creationInterface->getSolids()) {
+            boxes.push_back(solidBox(s));
+        }
+        for (const auto& sp : creationInterface->getSplines()) {
+            // A spline lies inside the hull of its control points
+            JWWSpatial::Box box;
+            bool first = true;
+            for (const auto& cp : sp.controlPoints) {
+                if (first) {
+                    box = JWWSpatial::Box(cp.x, cp.y, cp.x, cp.y);
+                    first = false;
+                    continue;
+                }
+                box.minX = std::min(box.minX, cp.x);
+                box.minY = std::min(box.minY, cp.y);
+                box.maxX = std::max(box.maxX, cp.x);
+                box.maxY = std::max(box.maxY, cp.y);
+            }
+            // Keep indices aligned with getEntities(); an empty spline matches nothing
+            if (first) {
+                box = JWWSpatial::Box(1.0, 1.0, -1.0, -1.0);
+            }
+            boxes.push_back(box);
+        }
+    }
+    
+    // The interface reserves its initial capacity, so it is created under
+    // the reader's Charge
+    void createInterface(size_t fileSize) {
+        JWWMemory::Charge charge(&memoryOwner);
+        creationInterface = fileSize > 0 ? std::make_unique<JSCreationInterface>(fileSize)
+                                         : std::make_unique<JSCreationInterface>();
+        creationInterface->setMemoryOwner(&memoryOwner);
+    }
+    
+    void buildSpatialIndex() {
+        JWWMemory::Scope memoryScope(JWWMemory::Index);
+        std::vector<JWWSpatial::Box> boxes;
+        gatherEntityBoxes(boxes);
+        spatialIndex.build(boxes);
+        clearSnapIndex();
+    }
+    
+    // Free everything built from the entities on demand; the next use
+    // rebuilds it. The spatial index is kept.
+    void releaseDerived() {
+        std::vector<float>().swap(lineVertexBuffer);
+        std::vector<double>().swap(entityBoundsBuffer);
+        std::vector<JSPolylineData>().swap(lineChains);
+        std::vector<uint32_t>().swap(chainSources);
+        curveBuffers.release();
+        renderBuffers.release();
+        linetypeCache.clear();
+        std::vector<uint32_t>().swap(queryBuffer);
+        clearSnapIndex();
+        snapIndex = JWWSpatial::PointKDTree();
+        std::vector<double>().swap(snapXY);
+        std::vector<uint8_t>().swap(snapKind);
+        std::vector<uint32_t>().swap(snapEntity);
+        clearLOD();
+        lodPyramid = JWWLod::Pyramid();
+        std::vector<JSDrawGroup>().swap(lodPens);
+        std::vector<JSDrawGroup>().swap(lodGroups);
+        quantized.release();
+    }
+    
+    void clearLOD() {
+        lodPyramid.clear();
+        lodPens.clear();
+        lodGroups.clear();
+        lodBuilt = false;
+    }
+    
+    // Levels start at 1/LOD_BASE_DIVISOR of the drawing's diagonal (finer
+    // than a pixel on any screen) and double LOD_LEVELS - 1 times
+    static const int LOD_LEVELS = 8;
+    static constexpr double LOD_BASE_DIVISOR = 16384.0;
+    
+    void buildLOD() {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::Scope memoryScope(JWWMemory::Index);
+        clearLOD();
+        lodBuilt = true;
+        const auto& lines = creationInterface->getLines();
+        const auto& circles = creationInterface->getCircles();
+        const auto& arcs = creationInterface->getArcs();
+        const auto& ellipses = creationInterface->getEllipses();
+        const auto& texts = creationInterface->getTexts();
+        
+        // Pen ids in (layer, line type, width, color) order, as in
+        // getRenderCommands(), so levels draw in the same order
+        typedef std::tuple<int, int, int, int> PenKey;
+        std::map<PenKey, uint32_t> pens;
+        auto collect = [&](int color, int width, int lineType, int layer) {
+            pens.emplace(PenKey(layer, lineType, width, color), 0);
+        };
+        for (const auto& l : lines) collect(l.color, l.width, l.lineType, l.layer);
+        for (const auto& c : circles) collect(c.color, c.width, c.lineType, c.layer);
+        for (const auto& a : arcs) collect(a.color, a.width, a.lineType, a.layer);
+        for (const auto& e : ellipses) collect(e.color, e.width, e.lineType, e.layer);
+        for (auto& entry : pens) {
+            entry.second = static_cast<uint32_t>(lodPens.size());
+            int color = std::get<3>(entry.first);
+            uint8_t rgba[4];
+            colorToRGBA(color, rgba);
+            int rgb = (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+            lodPens.push_back({color, rgb, std::get<2>(entry.first), std::get<1>(entry.first),
+                               std::get<0>(entry.first), 0, 0});
+        }
+        PenKey last;
+        uint32_t lastPen = 0;
+        bool haveLast = false;
+        auto penOf = [&](int color, int width, int lineType, int layer) {
+            PenKey key(layer, lineType, width, color);
+            if (!haveLast || key != last) {
+                last = key;
+                lastPen = pens[key];
+                haveLast = true;
+            }
+            return lastPen;
+        };
+        
+        for (const auto& l : lines) {
+            lodPyramid.addSegment(l.x1, l.y1, l.x2, l.y2, penOf(l.color, l.width, l.lineType, l.layer));
+        }
+        for (const auto& c : circles) {
+            lodPyramid.addArc(c.cx, c.cy, c.radius, c.radius, 0.0, 0.0, 2.0 * M_PI,
+                              penOf(c.color, c.width, c.lineType, c.layer));
+        }
+        for (const auto& a : arcs) {
+            double start, end;
+            arcSpan(a, start, end);
+            lodPyramid.addArc(a.cx, a.cy, a.radius, a.radius, 0.0, start, end - start,
+                              penOf(a.color, a.width, a.lineType, a.layer));
+        }
+        for (const auto& e : ellipses) {
+            lodPyramid.addArc(e.cx, e.cy, e.majorAxis, e.majorAxis * e.ratio, e.angle,
+                              e.startParam, e.endParam - e.startParam,
+                              penOf(e.color, e.width, e.lineType, e.layer));
+        }
+        const size_t firstText = lines.size() + circles.size() + arcs.size();
+        for (size_t i = 0; i < texts.size(); i++) {
+            lodPyramid.addText(static_cast<uint32_t>(firstText + i), texts[i].height);
+        }
+        
+        JSBounds b = getBounds();
+        double diagonal = b.valid ? std::hypot(b.maxX - b.minX, b.maxY - b.minY) : 0.0;
+        double base = diagonal > 0.0 ? diagonal / LOD_BASE_DIVISOR : 1e-6;
+        lodPyramid.build(base, LOD_LEVELS,
+                         b.valid ? (b.minX + b.maxX) * 0.5 : 0.0,
+                         b.valid ? (b.minY + b.maxY) * 0.5 : 0.0);
+    }
+    
+    const JWWLod::Level& lodLevel(int level) {
+        if (!lodBuilt) {
+            buildLOD();
+        }
+        level = std::max(0, std::min(lodPyramid.levelCount() - 1, level));
+        return lodPyramid.level(level);
+    }
+    
+    void clearSnapIndex() {
+        snapIndex.clear();
+        snapXY.clear();
+        snapKind.clear();
+        snapEntity.clear();
+        snapIndexBuilt = false;
+    }
+    
+    void addSnap(double x, double y, SnapKind kind, size_t entity) {
+        snapXY.push_back(x);
+        snapXY.push_back(y);
+        snapKind.push_back(static_cast<uint8_t>(kind));
+        snapEntity.push_back(static_cast<uint32_t>(entity));
+    }
+    
+    void buildSnapIndex() {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::Scope memoryScope(JWWMemory::Index);
+        clearSnapIndex();
+        size_t index = 0;
+        for (const auto& l : creationInterface->getLines()) {
+            addSnap(l.x1, l.y1, SNAP_ENDPOINT, index);
+            addSnap(l.x2, l.y2, SNAP_ENDPOINT, index);
+            addSnap((l.x1 + l.x2) * 0.5, (l.y1 + l.y2) * 0.5, SNAP_MIDPOINT, index);
+            index++;
+        }
+        for (const auto& c : creationInterface->getCircles()) {
+            addSnap(c.cx, c.cy, SNAP_CENTER, index);
+            addSnap(c.cx + c.radius, c.cy, SNAP_QUADRANT, index);
+            addSnap(c.cx, c.cy + c.radius, SNAP_QUADRANT, index);
+            addSnap(c.cx - c.radius, c.cy, SNAP_QUADRANT, index);
+            addSnap(c.cx, c.cy - c.radius, SNAP_QUADRANT, index);
+            index++;
+        }
+        for (const auto& a : creationInterface->getArcs()) {
+            double start, end;
+            arcSpan(a, start, end);
+            addSnap(a.cx, a.cy, SNAP_CENTER, index);
+            addSnap(a.cx + a.radius * cos(start), a.cy + a.radius * sin(start), SNAP_ENDPOINT, index);
+            addSnap(a.cx + a.radius * cos(end), a.cy + a.radius * sin(end), SNAP_ENDPOINT, index);
+            double mid = (start + end) * 0.5;
+            addSnap(a.cx + a.radius * cos(mid), a.cy + a.radius * sin(mid), SNAP_MIDPOINT, index);
+            // Quadrant points that lie on the arc
+            for (int q = static_cast<int>(ceil(start / (M_PI * 0.5))); q * M_PI * 0.5 <= end; q++) {
+                double t = q * M_PI * 0.5;
+                addSnap(a.cx + a.radius * cos(t), a.cy + a.radius * sin(t), SNAP_QUADRANT, index);
+            }
+            index++;
+        }
+        index += creationInterface->getTexts().size();
+        for (const auto& e : creationInterface->getEllipses()) {
+            // Quadrant points of an ellipse are its axis end points
+            double ux = e.majorAxis * cos(e.angle), uy = e.majorAxis * sin(e.angle);
+            double vx = -uy * e.ratio, vy = ux * e.ratio;
+            addSnap(e.cx, e.cy, SNAP_CENTER, index);
+            addSnap(e.cx + ux, e.cy + uy, SNAP_QUADRANT, index);
+            addSnap(e.cx + vx, e.cy + vy, SNAP_QUADRANT, index);
+            addSnap(e.cx - ux, e.cy - uy, SNAP_QUADRANT, index);
+            addSnap(e.cx - vx, e.cy - vy, SNAP_QUADRANT, index);
+            index++;
+        }
+        for (const auto& p : creationInterface->getPoints()) {
+            addSnap(p.x, p.y, SNAP_ENDPOINT, index);
+            index++;
+        }
+        snapIndex.build(snapXY);
+        snapIndexBuilt = true;
+    }
+    
+    // Exact distance from (x, y) to entity `index` (getEntities() order).
+    // Ellipses are measured against a 64-gon (per full turn), splines against their control
+    // polygon and texts against their box.
+    double entityDistance(size_t index, double x, double y, double& qx, double& qy) const {
+        const auto& lines = creationInterface->getLines();
+        if (index < lines.size()) {
+            const JSLineData& l = lines[index];
+            return JWWSpatial::distanceToSegment(x, y, l.x1, l.y1, l.x2, l.y2, qx, qy);
+        }
+        index -= lines.size();
+        const auto& circles = creationInterface->getCircles();
+        if (index < circles.size()) {
+            const JSCircleData& c = circles[index];
+            return JWWSpatial::distanceToArc(x, y, c.cx, c.cy, c.radius, 0.0, 2.0 * M_PI, qx, qy);
+        }
+        index -= circles.size();
+        const auto& arcs = creationInterface->getArcs();
+        if (index < arcs.size()) {
+            const JSArcData& a = arcs[index];
+            double start, end;
+            arcSpan(a, start, end);
+            return JWWSpatial::distanceToArc(x, y, a.cx, a.cy, a.radius, start, end, qx, qy);
+        }
+        index -= arcs.size();
+        const auto& texts = creationInterface->getTexts();
+        if (index < texts.size()) {
+            const JSTextData& t = texts[index];
+            // Clamp into the text rectangle in its own rotated frame
+            double c = cos(t.angle), s = sin(t.angle);
+            double u = (x - t.x) * c + (y - t.y) * s;
+            double v = -(x - t.x) * s + (y - t.y) * c;
+            u = std::max(0.0, std::min(textWidth(t), u));
+            v = std::max(0.0, std::min(t.height, v));
+            qx = t.x + u * c - v * s;
+            qy = t.y + u * s + v * c;
+            return hypot(x - qx, y - qy);
+        }
+        index -= texts.size();
+        const auto& ellipses = creationInterface->getEllipses();
+        if (index < ellipses.size()) {
+            const JSEllipseData& e = ellipses[index];
+            double c = cos(e.angle), s = sin(e.angle);
+            double best = std::numeric_limits<double>::infinity();
+            double sweep = e.endParam - e.startParam;
+            int steps = std::max(1, static_cast<int>(ceil(64.0 * sweep / (2.0 * M_PI))));
+            double u0 = e.majorAxis * cos(e.startParam), v0 = e.majorAxis * e.ratio * sin(e.startParam);
+            double px = e.cx + u0 * c - v0 * s, py = e.cy + u0 * s + v0 * c;
+            for (int i = 1; i <= steps; i++) {
+                double t = e.startParam + i * sweep / steps;
+                double u = e.majorAxis * cos(t), v = e.majorAxis * e.ratio * sin(t);
+                double nx = e.cx + u * c - v * s, ny = e.cy + u * s + v * c;
+                double sx, sy;
+                double d = JWWSpatial::distanceToSegment(x, y, px, py, nx, ny, sx, sy);
+                if (d < best) {
+                    best = d;
+                    qx = sx;
+                    qy = sy;
+                }
+                px = nx;
+                py = ny;
+            }
+            return best;
+        }
+        index -= ellipses.size();
+        const auto& points = creationInterface->getPoints();
+        if (index < points.size()) {
+            qx = points[index].x;
+            qy = points[index].y;
+            return hypot(x - qx, y - qy);
+        }
+        index -= points.size();
+        const auto& solids = creationInterface->getSolids();
+        if (index < solids.size()) {
+            // DXF vertex order: the outline is 0, 1, 3, 2
+            const JSSolidData& sd = solids[index];
+            static const int order[4] = {0, 1, 3, 2};
+            bool inside = false;
+            double best = std::numeric_limits<double>::infinity();
+            for (int i = 0; i < 4; i++) {
+                int a = order[i], b = order[(i + 1) % 4];
+                if ((sd.y[a] > y) != (sd.y[b] > y) &&
+                    x < sd.x[a] + (y - sd.y[a]) * (sd.x[b] - sd.x[a]) / (sd.y[b] - sd.y[a])) {
+                    inside = !inside;
+                }
+                double sx, sy;
+                double d = JWWSpatial::distanceToSegment(x, y, sd.x[a], sd.y[a], sd.x[b], sd.y[b], sx, sy);
+                if (d < best) {
+                    best = d;
+                    qx = sx;
+                    qy = sy;
+                }
+            }
+            if (inside) {
+                qx = x;
+                qy = y;
+                return 0.0;
+            }
+            return best;
+        }
+        index -= solids.size();
+        const auto& splines = creationInterface->getSplines();
+        if (index < splines.size()) {
+            const auto& cps = splines[index].controlPoints;
+            double best = std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < cps.size(); i++) {
+                const JSControlPointData& a = cps[i];
+                const JSControlPointData& b = cps[i + 1 < cps.size() ? i + 1 : i];
+                double sx, sy;
+                double d = JWWSpatial::distanceToSegment(x, y, a.x, a.y, b.x, b.y, sx, sy);
+                if (d < best) {
+                    best = d;
+                    qx = sx;
+                    qy = sy;
+                }
+            }
+            return best;
+        }
+        return std::numeric_limits<double>::infinity();
+    }
     
 public:
-    JWWReader() : creationInterface(std::make_unique<JSCreationInterface>()) {}
+    JWWReader() {
+        createInterface(0);
+    }
     
     // Constructor with data pointer and size
-    JWWReader(uintptr_t dataPtr, size_t size) : creationInterface(std::make_unique<JSCreationInterface>(size)) {
+    JWWReader(uintptr_t dataPtr, size_t size) {
+        createInterface(size);
         readFile(dataPtr, size);
     }
     
     // Constructor with progress callback support
-    JWWReader(uintptr_t dataPtr, size_t size, emscripten::val progressCallback) 
-        : creationInterface(std::make_unique<JSCreationInterface>(size)) {
+    JWWReader(uintptr_t dataPtr, size_t size, emscripten::val progressCallback) {
+        createInterface(size);
         if (!progressCallback.isNull() && !progressCallback.isUndefined()) {
             creationInterface->setProgressCallback([progressCallback](size_t current, size_t total) {
                 progressCallback(current, total);
@@ -1074,7 +2451,14 @@ public:
     }
     
     bool readFile(uintptr_t dataPtr, size_t size) {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::resetPeak();
+        memoryOwner.resetPeak();
         creationInterface->clear();
+        linetypeTable.reset();
+        linetypeCache.clear();
+        clearLOD();
+        quantized.clear();
         
         // Estimate entity count based on file size (rough heuristic)
         size_t estimatedEntities = size / 100;  // Average ~100 bytes per entity
@@ -1083,48 +2467,225 @@ public:
             creationInterface->reserveCapacity(estimatedEntities);
         }
         
-        // Read data from memory
-        const uint8_t* data = reinterpret_cast<const uint8_t*>(dataPtr);
-        
-        // Write buffer to temporary file in MEMFS
-        // Note: This is required by DL_Jww API, but MEMFS keeps it in memory
-        std::string tempFile = "/tmp/jww_temp.jww";
-        FILE* fp = fopen(tempFile.c_str(), "wb");
-        if (!fp) {
-            creationInterface->addParseError(JSParseError(
-                ParseErrorType::MEMORY_ALLOCATION_FAILED,
-                "Failed to create temporary file",
-                "FILE"
-            ));
-            return false;
+        // Parse straight from the caller's memory; no MEMFS temporary file
+        if (!jww) {
+            jww = std::make_unique<DL_Jww>();
+        }
+        if (!document) {
+            std::string in(""), out("");
+            document = std::make_unique<JWWDocument>(in, out);
+        }
+        JWWMemoryBuf input(reinterpret_cast<const char*>(dataPtr), size);
+        document->AttachInput(&input);
+        bool result = jww->in(document.get(), creationInterface.get());
+        document->AttachInput(nullptr);
+        if (result) {
+            linetypeTable.load(document->Header);
+        }
+        // Records are copied into creationInterface; keep only the capacity
+        // unless saveToBuffer() is to write them back
+        recordsKept = result && keepRecords;
+        keptInputSize = recordsKept ? size : 0;
+        if (!recordsKept) {
+            document->Clear();
         }
         
-        // Direct write without intermediate buffer
-        size_t written = fwrite(data, 1, size, fp);
-        fclose(fp);
+        // Build indexes after successful parsing
+        if (result) {
+            creationInterface->buildIndexes();
+            buildSpatialIndex();
+        } else {
+            spatialIndex.clear();
+            clearSnapIndex();
+        }
+        lastParsePeakBytes = memoryOwner.peakBytes();
         
-        if (written != size) {
-            remove(tempFile.c_str());
-            creationInterface->addParseError(JSParseError(
-                ParseErrorType::MEMORY_ALLOCATION_FAILED,
-                "Failed to write temporary file",
-                "FILE"
-            ));
+        return result;
+    }
+    
+    // WASM-owned input: JS fills the region returned by allocateInput()
+    // (e.g. fs.readSync into a HEAPU8 view), then parseInput() decodes it
+    // and releases the bytes, so the file is never held twice.
+    uintptr_t allocateInput(size_t size) {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::Scope memoryScope(JWWMemory::Input);
+        if (size > inputCapacity) {
+            releaseInput();
+            inputBuffer.reset(new char[size]);
+            inputCapacity = size;
+        }
+        inputSize = size;
+        return reinterpret_cast<uintptr_t>(inputBuffer.get());
+    }
+    
+    bool parseInput() {
+        bool result = readFile(reinterpret_cast<uintptr_t>(inputBuffer.get()), inputSize);
+        releaseInput();
+        return result;
+    }
+    
+    void releaseInput() {
+        inputBuffer.reset();
+        inputSize = 0;
+        inputCapacity = 0;
+    }
+    
+    // Reuse path for batch jobs: reset() drops the current drawing but keeps
+    // every buffer's capacity, load() parses the next file into them, and
+    // shrink(maxBytes) drops the drawing and returns the buffers to the heap
+    // once they exceed the budget. Avoids regrowing (and fragmenting) the
+    // heap for every file.
+    void reset() {
+        creationInterface->clear();
+        if (document) {
+            document->Clear();
+        }
+        recordsKept = false;
+        saveBuffer.clear();
+        lineVertexBuffer.clear();
+        entityBoundsBuffer.clear();
+        lineChains.clear();
+        chainSources.clear();
+        curveBuffers.clear();
+        renderBuffers.clear();
+        linetypeTable.reset();
+        linetypeCache.clear();
+        clearLOD();
+        quantized.clear();
+        inputSize = 0;
+        spatialIndex.clear();
+        queryBuffer.clear();
+        clearSnapIndex();
+        streamParser.reset();
+        streamHandler.reset();
+    }
+    
+    bool load(uintptr_t dataPtr, size_t size) {
+        reset();
+        return readFile(dataPtr, size);
+    }
+    
+    // Bytes held for reuse by this reader, including the current drawing
+    size_t getReservedBytes() const {
+        size_t total = creationInterface->getEstimatedMemoryUsage();
+        total += lineVertexBuffer.capacity() * sizeof(float);
+        total += entityBoundsBuffer.capacity() * sizeof(double);
+        total += lineChains.capacity() * sizeof(JSPolylineData) + chainSources.capacity() * sizeof(uint32_t);
+        for (const auto& p : lineChains) {
+            total += p.vertices.capacity() * sizeof(JSVertexData);
+        }
+        total += curveBuffers.reservedBytes() + renderBuffers.reservedBytes();
+        total += linetypeCache.bytes();
+        total += lodPyramid.reservedBytes();
+        total += quantized.reservedBytes();
+        total += inputCapacity;
+        total += saveBuffer.capacity();
+        if (document) {
+            total += document->ReservedBytes();
+        }
+        return total;
+    }
+    
+    // Release reserved buffers when they exceed maxBytes (0 releases all).
+    // Returns the bytes still reserved.
+    size_t shrink(size_t maxBytes) {
+        if (getReservedBytes() <= maxBytes) {
+            return getReservedBytes();
+        }
+        reset();
+        creationInterface->releaseMemory();
+        releaseDerived();
+        releaseInput();
+        saveBuffer.release();
+        spatialIndex = JWWSpatial::PackedRTree();
+        if (document) {
+            document->ReleaseMemory();
+        }
+        return getReservedBytes();
+    }
+    
+    // Drawings kept open in the background: compactGeometry() packs the
+    // entity geometry (see JSCreationInterface::packGeometry()) and frees
+    // the buffers built from it, keeping the spatial index, and the parse
+    // buffers held for reuse unless records are kept. Any getter of
+    // a packed kind expands it again; expandGeometry() does so up front.
+    // With tolerance 0 the geometry expands to exactly the parsed values;
+    // a larger tolerance is the coordinate error allowed in exchange for
+    // smaller packing. Returns false while streaming.
+    bool compactGeometry(double tolerance, double* maxError, double* maxParamError) {
+        if (streamParser) {
             return false;
         }
-        
-        // Use DL_Jww to read the file
+        JWWMemory::Charge charge(&memoryOwner);
+        double step = tolerance > 0.0 ? tolerance * 2.0 : 0.0;
+        releaseDerived();
+        releaseInput();
+        if (document && !recordsKept) {
+            document->ReleaseMemory();
+        }
+        double err = creationInterface->packGeometry(step, maxParamError);
+        if (maxError) {
+            *maxError = err;
+        }
+        return true;
+    }
+    
+    void expandGeometry() {
+        JWWMemory::Charge charge(&memoryOwner);
+        creationInterface->unpackGeometry();
+    }
+    
+    bool isCompacted() const {
+        return creationInterface->isGeometryPacked();
+    }
+    
+    // Streaming input: beginStream(), feed() per chunk, then finishStream().
+    // Entities are created as soon as their records are complete.
+    void beginStream() {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::resetPeak();
+        memoryOwner.resetPeak();
+        creationInterface->clear();
+        linetypeTable.reset();
+        linetypeCache.clear();
+        clearLOD();
+        quantized.clear();
         jww = std::make_unique<DL_Jww>();
-        bool result = jww->in(tempFile, creationInterface.get());
-        
-        // Clean up temporary file immediately
-        remove(tempFile.c_str());
-        
-        // Build indexes after successful parsing
+        streamHandler = std::make_unique<DL_JwwRecordHandler>(jww.get(), creationInterface.get());
+        streamParser = std::make_unique<JWWStreamParser>(streamHandler.get());
+    }
+    
+    // Returns JWWStreamParser::Status (0 = need more, 1 = done, 2 = error)
+    int feed(uintptr_t dataPtr, size_t size) {
+        if (!streamParser) {
+            return JWWStreamParser::Error;
+        }
+        JWWMemory::Charge charge(&memoryOwner);
+        return streamParser->feed(reinterpret_cast<const char*>(dataPtr), size);
+    }
+    
+    bool finishStream() {
+        if (!streamParser) {
+            return false;
+        }
+        JWWMemory::Charge charge(&memoryOwner);
+        bool result = streamParser->finish() == JWWStreamParser::Done;
+        if (result) {
+            linetypeTable.load(streamParser->document()->Header);
+        }
+        streamParser.reset();
+        streamHandler.reset();
         if (result) {
             creationInterface->buildIndexes();
+            buildSpatialIndex();
+        } else {
+            creationInterface->addParseError(JSParseError(
+                ParseErrorType::INVALID_FILE_FORMAT,
+                "Stream is not a complete JWW file (truncated or damaged data)",
+                "FILE"
+            ));
         }
-        
+        lastParsePeakBytes = memoryOwner.peakBytes();
         return result;
     }
     
@@ -1200,11 +2761,22 @@ public:
         return creationInterface->getParseErrors();
     }
     
-    // Memory usage information
+    // Heap bytes held by this reader. Counted when built with
+    // JWW_MEMORY_TRACKING (the WASM default), otherwise estimated from the
+    // entity buffers' capacities. Module-wide counters: getModuleMemoryStats().
     size_t getMemoryUsage() const {
+        if (JWWMemory::enabled()) {
+            return memoryOwner.liveBytes();
+        }
         return creationInterface->getEstimatedMemoryUsage();
     }
     
+    // Highest getMemoryUsage() during the last readFile() or stream,
+    // including the indexes built after parsing; 0 without tracking
+    size_t getLastParsePeakBytes() const {
+        return lastParsePeakBytes;
+    }
+    
     // Get entity count by type for statistics
     std::map<std::string, int> getEntityStats() const {
         // Use batch counting for better performance
@@ -1218,6 +2790,7 @@ public:
     
     // Batch processing methods
     void processBatchedLines(const std::vector<std::tuple<double, double, double, double, int>>& lineData) {
+        JWWMemory::Charge charge(&memoryOwner);
         creationInterface->processBatchedLines(lineData);
     }
     
@@ -1365,6 +2938,397 @@ public:
         return entities;
     }
     
+    // Drawing extents over lines, circles, arcs, ellipses, points, texts,
+    // solids and spline control points, accumulated while decoding. Arcs
+    // and ellipses contribute their exact extents, texts their rotated box.
+    JSBounds getBounds() const {
+        JWWSpatial::Box b;
+        bool valid = creationInterface->getExtents(b);
+        return {b.minX, b.minY, b.maxX, b.maxY, valid};
+    }
+    
+    // Per-entity boxes, [minX, minY, maxX, maxY] per getEntities() entry
+    const std::vector<double>& buildEntityBounds() {
+        JWWMemory::Charge charge(&memoryOwner);
+        std::vector<JWWSpatial::Box> boxes;
+        gatherEntityBoxes(boxes);
+        entityBoundsBuffer.resize(boxes.size() * 4);
+        for (size_t i = 0; i < boxes.size(); i++) {
+            entityBoundsBuffer[i * 4] = boxes[i].minX;
+            entityBoundsBuffer[i * 4 + 1] = boxes[i].minY;
+            entityBoundsBuffer[i * 4 + 2] = boxes[i].maxX;
+            entityBoundsBuffer[i * 4 + 3] = boxes[i].maxY;
+        }
+        return entityBoundsBuffer;
+    }
+    
+    // Whether the next parse keeps per-entity boxes (on by default). Off
+    // saves 32 bytes per entity; boxes are then recomputed when needed.
+    void setEntityBounds(bool enabled) {
+        creationInterface->setRecordEntityBoxes(enabled);
+    }
+    
+    // Whether the next parse keeps the file's records for saveToBuffer()
+    // (off by default; they take about as much memory as the entities)
+    void setKeepRecords(bool enabled) {
+        keepRecords = enabled;
+    }
+    
+    // Writes the kept records as a JWW file into saveBuffer. Returns the
+    // file size, or 0 when no records were kept.
+    size_t saveRecords() {
+        if (!document || !recordsKept) {
+            return 0;
+        }
+        JWWMemory::Charge charge(&memoryOwner);
+        saveBuffer.clear();
+        saveBuffer.reserve(keptInputSize + keptInputSize / 8);
+        document->AttachOutput(&saveBuffer);
+        bool result = document->Save();
+        document->AttachOutput(nullptr);
+        if (!result) {
+            saveBuffer.clear();
+            return 0;
+        }
+        return saveBuffer.size();
+    }
+    
+    // Line endpoints transformed by the affine matrix (a, b, c, d, e, f)
+    // and narrowed to float: [x1, y1, x2, y2, ...] per line.
+    const std::vector<float>& buildLineVertices(double a, double b, double c,
+                                                double d, double e, double f) {
+        JWWMemory::Charge charge(&memoryOwner);
+        const auto& lines = creationInterface->getLines();
+        std::vector<double> xy(lines.size() * 4);
+        for (size_t i = 0; i < lines.size(); ++i) {
+            xy[i * 4] = lines[i].x1;
+            xy[i * 4 + 1] = lines[i].y1;
+            xy[i * 4 + 2] = lines[i].x2;
+            xy[i * 4 + 3] = lines[i].y2;
+        }
+        const double m[6] = {a, b, c, d, e, f};
+        JWWSimd::transformPoints(xy.data(), xy.data(), lines.size() * 2, m);
+        lineVertexBuffer.resize(xy.size());
+        JWWSimd::toFloat(xy.data(), lineVertexBuffer.data(), xy.size());
+        return lineVertexBuffer;
+    }
+    
+    // getEntities() indices of the entities whose boxes overlap the rectangle
+    const std::vector<uint32_t>& queryRectIndices(double minX, double minY,
+                                                  double maxX, double maxY) {
+        JWWMemory::Charge charge(&memoryOwner);
+        queryBuffer.clear();
+        spatialIndex.query(minX, minY, maxX, maxY, queryBuffer);
+        return queryBuffer;
+    }
+    
+    // Line-list vertices for every circle, arc and ellipse within tolerance,
+    // grouped by (color, width) with RGBA colors per vertex
+    const std::vector<JSDrawGroup>& tessellateCurveBuffers(double tolerance,
+                                                           double originX, double originY) {
+        JWWMemory::Charge charge(&memoryOwner);
+        buildPenLineList(*creationInterface, tolerance, originX, originY, PEN_VERTEX_COLORS, curveBuffers);
+        return curveBuffers.groups;
+    }
+    
+    // Render command list: lines, circles, arcs and ellipses bucketed by
+    // (layer, line type, width, color) with each bucket's geometry
+    // contiguous, so a renderer changes pen state once per bucket rather
+    // than once per entity. With scale > 0 (screen dots per drawing unit)
+    // dashed, dotted and random pen styles are expanded into their dashes.
+    const std::vector<JSDrawGroup>& buildRenderCommands(double tolerance,
+                                                        double originX, double originY,
+                                                        double scale = 0.0) {
+        JWWMemory::Charge charge(&memoryOwner);
+        PenLinetypes linetypes = {&linetypeTable, &linetypeCache, scale};
+        buildPenLineList(*creationInterface, tolerance, originX, originY,
+                         PEN_INCLUDE_LINES | PEN_FULL_KEY, renderBuffers, &linetypes);
+        return renderBuffers.groups;
+    }
+    
+    const std::vector<float>& getCurveVertexBuffer() const { return curveBuffers.vertices; }
+    const std::vector<uint8_t>& getCurveColorBuffer() const { return curveBuffers.colors; }
+    const std::vector<float>& getRenderVertexBuffer() const { return renderBuffers.vertices; }
+    
+    // Lines of one pen (color, width, line type, pen style and layer)
+    // joined end to end where exactly two ends meet within tolerance, in
+    // O(n) expected time. Every line ends up in one polyline; polyline i's
+    // edges, in order, are the lines getChainSources()[firstSource ..
+    // firstSource + sourceCount). Lines come first in getEntities(), so these
+    // are entity indices too. A loop is closed and does not repeat its
+    // first vertex.
+    const std::vector<JSPolylineData>& chainLines(double tolerance) {
+        JWWMemory::Charge charge(&memoryOwner);
+        JWWMemory::Scope memoryScope(JWWMemory::Entities);
+        const auto& lines = creationInterface->getLines();
+        typedef std::tuple<int, int, int, int, int> PenKey;
+        std::map<PenKey, uint32_t> penIds;
+        std::vector<const JSLineData*> penLines;   // a line of each pen
+        std::vector<double> xy(lines.size() * 4);
+        std::vector<uint32_t> pens(lines.size());
+        PenKey last;
+        uint32_t lastPen = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            const JSLineData& l = lines[i];
+            PenKey key(l.layer, l.lineType, l.penStyle, l.width, l.color);
+            if (penLines.empty() || key != last) {
+                auto it = penIds.emplace(key, static_cast<uint32_t>(penLines.size())).first;
+                if (it->second == penLines.size()) {
+                    penLines.push_back(&l);
+                }
+                last = key;
+                lastPen = it->second;
+            }
+            pens[i] = lastPen;
+            xy[i * 4] = l.x1;
+            xy[i * 4 + 1] = l.y1;
+            xy[i * 4 + 2] = l.x2;
+            xy[i * 4 + 3] = l.y2;
+        }
+        
+        std::vector<double> points;
+        std::vector<uint32_t> offsets, chainPens;
+        JWWLod::chainSegments(xy, pens, std::max(0.0, tolerance), points, offsets, chainPens, chainSources);
+        lineChains.clear();
+        lineChains.resize(chainPens.size());
+        for (size_t c = 0; c < chainPens.size(); c++) {
+            JSPolylineData& p = lineChains[c];
+            const JSLineData& pen = *penLines[chainPens[c]];
+            uint32_t first = offsets[c], count = offsets[c + 1] - first;
+            p.firstSource = static_cast<int>(first - c);
+            p.sourceCount = static_cast<int>(count - 1);
+            p.closed = p.sourceCount > 1 && points[first * 2] == points[(first + count - 1) * 2] &&
+                       points[first * 2 + 1] == points[(first + count - 1) * 2 + 1];
+            if (p.closed) {
+                count--;
+            }
+            p.vertices.resize(count);
+            for (uint32_t k = 0; k < count; k++) {
+                p.vertices[k] = {points[(first + k) * 2], points[(first + k) * 2 + 1], 0.0, 0.0};
+            }
+            p.color = pen.color;
+            p.width = pen.width;
+            p.lineType = pen.lineType;
+            p.layer = pen.layer;
+            p.penStyle = pen.penStyle;
+        }
+        return lineChains;
+    }
+    
+    const std::vector<uint32_t>& getChainSourceIndices() const { return chainSources; }
+    
+    // Level-of-detail pyramid: level 0 keeps everything, each level above
+    // doubles the simplification tolerance. Connected lines are chained and
+    // simplified, curves are tessellated at the level's tolerance, and arcs
+    // and texts smaller than it are dropped. Built on first use.
+    int getLODLevelCount() {
+        if (!lodBuilt) {
+            buildLOD();
+        }
+        return lodPyramid.levelCount();
+    }
+    
+    // Coarsest level that stays within a pixel at scale (pixels per unit)
+    int getLODLevelForScale(double scale) {
+        if (!lodBuilt) {
+            buildLOD();
+        }
+        return scale > 0.0 ? lodPyramid.levelFor(1.0 / scale) : lodPyramid.levelCount() - 1;
+    }
+    
+    double getLODTolerance(int level) { return lodLevel(level).tolerance; }
+    const std::vector<float>& getLODVertexBuffer(int level) { return lodLevel(level).vertices; }
+    const std::vector<uint32_t>& getLODTexts(int level) { return lodLevel(level).texts; }
+    
+    // Draw groups of a level; first/count are vertices of getLODVertexBuffer()
+    const std::vector<JSDrawGroup>& getLODGroups(int level) {
+        const JWWLod::Level& l = lodLevel(level);
+        JWWMemory::Charge charge(&memoryOwner);
+        lodGroups.clear();
+        for (const auto& g : l.groups) {
+            JSDrawGroup group = lodPens[g.pen];
+            group.first = static_cast<int>(g.first);
+            group.count = static_cast<int>(g.count);
+            lodGroups.push_back(group);
+        }
+        return lodGroups;
+    }
+    
+    std::vector<std::string> getLayerNames() const { return creationInterface->getLayerNames(); }
+    std::vector<std::string> getLineTypeNames() const { return creationInterface->getLineTypeNames(); }
+    
+    // Entity closest to (x, y) within tolerance. Candidates come from the
+    // R-tree; each is then measured exactly, so cost follows the local density.
+    JSPickResult pick(double x, double y, double tolerance) {
+        JSPickResult result = {-1, 0.0, 0.0, 0.0};
+        JWWMemory::Charge charge(&memoryOwner);
+        queryBuffer.clear();
+        spatialIndex.query(x - tolerance, y - tolerance, x + tolerance, y + tolerance, queryBuffer);
+        double best = tolerance;
+        for (uint32_t index : queryBuffer) {
+            double qx, qy;
+            double d = entityDistance(index, x, y, qx, qy);
+            // Ties go to the lower index so results do not depend on tree order
+            if (d < best || (d == best && (result.index < 0 || static_cast<int>(index) < result.index))) {
+                best = d;
+                result.index = static_cast<int>(index);
+                result.distance = d;
+                result.x = qx;
+                result.y = qy;
+            }
+        }
+        queryBuffer.clear();
+        return result;
+    }
+    
+    // Nearest snap point within maxDistance; the KD-tree is built on first use
+    JSSnapPoint nearestSnap(double x, double y, double maxDistance) {
+        JSSnapPoint result = {false, 0.0, 0.0, 0, -1, 0.0};
+        if (!snapIndexBuilt) {
+            buildSnapIndex();
+        }
+        double distance = 0.0;
+        long id = snapIndex.nearest(x, y, maxDistance, &distance);
+        if (id < 0) {
+            return result;
+        }
+        result.found = true;
+        result.x = snapXY[id * 2];
+        result.y = snapXY[id * 2 + 1];
+        result.kind = snapKind[id];
+        result.index = static_cast<int>(snapEntity[id]);
+        result.distance = distance;
+        return result;
+    }
+    
+#ifdef EMSCRIPTEN
+    // Float32Array view into WASM memory; valid until the next call or dispose
+    emscripten::val getLineVertices(double a, double b, double c,
+                                    double d, double e, double f) {
+        const auto& buf = buildLineVertices(a, b, c, d, e, f);
+        return emscripten::val(emscripten::typed_memory_view(buf.size(), buf.data()));
+    }
+    
+    // The drawing as a JWW file (see saveRecords). Uint8Array view into WASM
+    // memory, valid until the next save, load or dispose; null when the
+    // last parse did not keep its records.
+    emscripten::val saveToBuffer() {
+        if (saveRecords() == 0) {
+            return emscripten::val::null();
+        }
+        return emscripten::val(emscripten::typed_memory_view(saveBuffer.size(),
+            reinterpret_cast<const uint8_t*>(saveBuffer.data())));
+    }
+    
+    // Uint32Array view into WASM memory; valid until the next chainLines()
+    emscripten::val getChainSources() {
+        return emscripten::val(emscripten::typed_memory_view(chainSources.size(), chainSources.data()));
+    }
+    
+    // Float64Array view into WASM memory; valid until the next call or dispose
+    emscripten::val getEntityBounds() {
+        const auto& buf = buildEntityBounds();
+        return emscripten::val(emscripten::typed_memory_view(buf.size(), buf.data()));
+    }
+    
+    // Runs tessellateCurveBuffers() and returns
+    // { vertices: Float32Array, colors: Uint8Array (RGBA per vertex), groups }.
+    // The arrays are views into WASM memory, valid until the next call or dispose
+    emscripten::val tessellateCurves(double tolerance, double originX, double originY) {
+        tessellateCurveBuffers(tolerance, originX, originY);
+        return penLineListToJS(curveBuffers);
+    }
+    
+    // Runs buildRenderCommands() and returns { vertices: Float32Array,
+    // groups, layers, lineTypes }; group layer/lineType index the name lists
+    emscripten::val getRenderCommands(double tolerance, double originX, double originY,
+                                      double scale) {
+        buildRenderCommands(tolerance, originX, originY, scale);
+        return renderCommandsToJS(renderBuffers, *creationInterface);
+    }
+    
+    // { level, tolerance, originX, originY, vertices: Float32Array, groups,
+    // texts: Uint32Array of getEntities() indices, layers, lineTypes }.
+    // Vertices are relative to the origin; views are valid until dispose.
+    emscripten::val getLOD(int level) {
+        level = std::max(0, std::min(getLODLevelCount() - 1, level));
+        const JWWLod::Level& l = lodPyramid.level(level);
+        emscripten::val result = emscripten::val::object();
+        result.set("level", level);
+        result.set("tolerance", l.tolerance);
+        result.set("originX", lodPyramid.getOriginX());
+        result.set("originY", lodPyramid.getOriginY());
+        result.set("vertices", emscripten::val(emscripten::typed_memory_view(l.vertices.size(), l.vertices.data())));
+        emscripten::val groups = emscripten::val::array();
+        const auto& lg = getLODGroups(level);
+        for (size_t i = 0; i < lg.size(); i++) {
+            groups.set(i, lg[i]);
+        }
+        result.set("groups", groups);
+        result.set("texts", emscripten::val(emscripten::typed_memory_view(l.texts.size(), l.texts.data())));
+        setPenNames(result, *creationInterface);
+        return result;
+    }
+    
+    // A copy of the entity coordinates for upload, quantized to "float32" or
+    // "int32" offsets from the middle of the drawing's extents; the parsed
+    // doubles stay as they are: { format, originX, originY, scale,
+    // maxError, bytes, lines, circles, arcs, arcAngles, ellipses,
+    // ellipseParams, points, solids, texts }. A value decodes as origin +
+    // stored * scale (lengths as stored * scale); maxError is the largest
+    // difference from the doubles. Views are valid until the next call,
+    // load or dispose.
+    emscripten::val exportQuantizedGeometry(const std::string& format) {
+        JWWMemory::Charge charge(&memoryOwner);
+        buildQuantizedGeometry(*creationInterface, format == "int32" ? JWWQuant::INT32 : JWWQuant::FLOAT32,
+                               quantized);
+        const JWWQuant::Frame& frame = quantized.lines.frame();
+        emscripten::val result = emscripten::val::object();
+        result.set("format", frame.format == JWWQuant::INT32 ? "int32" : "float32");
+        result.set("originX", frame.originX);
+        result.set("originY", frame.originY);
+        result.set("scale", frame.scale);
+        result.set("maxError", quantized.maxError());
+        result.set("bytes", static_cast<double>(quantized.reservedBytes()));
+        result.set("lines", quantizedToJS(quantized.lines));
+        result.set("circles", quantizedToJS(quantized.circles));
+        result.set("arcs", quantizedToJS(quantized.arcs));
+        result.set("arcAngles", emscripten::val(emscripten::typed_memory_view(
+            quantized.arcAngles.size(), quantized.arcAngles.data())));
+        result.set("ellipses", quantizedToJS(quantized.ellipses));
+        result.set("ellipseParams", emscripten::val(emscripten::typed_memory_view(
+            quantized.ellipseParams.size(), quantized.ellipseParams.data())));
+        result.set("points", quantizedToJS(quantized.points));
+        result.set("solids", quantizedToJS(quantized.solids));
+        result.set("texts", quantizedToJS(quantized.texts));
+        return result;
+    }
+    
+    // compactGeometry() for JS: { bytesBefore, bytesAfter, maxError,
+    // maxParamError } from getReservedBytes() and the packers, or false
+    // while streaming
+    emscripten::val compact(double tolerance) {
+        double before = static_cast<double>(getReservedBytes());
+        double maxError = 0.0;
+        double maxParamError = 0.0;
+        if (!compactGeometry(tolerance, &maxError, &maxParamError)) {
+            return emscripten::val(false);
+        }
+        emscripten::val result = emscripten::val::object();
+        result.set("bytesBefore", before);
+        result.set("bytesAfter", static_cast<double>(getReservedBytes()));
+        result.set("maxError", maxError);
+        result.set("maxParamError", maxParamError);
+        return result;
+    }
+    
+    // Uint32Array view into WASM memory; valid until the next query or dispose
+    emscripten::val queryRect(double minX, double minY, double maxX, double maxY) {
+        const auto& buf = queryRectIndices(minX, minY, maxX, maxY);
+        return emscripten::val(emscripten::typed_memory_view(buf.size(), buf.data()));
+    }
+#endif
+    
     // Get header information
     JSHeader getHeader() const {
         JSHeader header;
@@ -1392,6 +3356,19 @@ public:
 // Embind bindings
 using namespace emscripten;
 
+// Hands NDJSON chunks to a JS function as Uint8Array views into WASM
+// memory, valid only during the call
+class JSChunkSink : public JWWJson::Sink {
+public:
+    explicit JSChunkSink(emscripten::val callback) : callback(callback) {}
+    void write(const char* data, size_t size) override {
+        callback(emscripten::val(emscripten::typed_memory_view(size, reinterpret_cast<const uint8_t*>(data))));
+    }
+
+private:
+    emscripten::val callback;
+};
+
 EMSCRIPTEN_BINDINGS(jwwlib_module) {
     // New unified data structures
     value_object<JSEntityData>("JSEntityData")
@@ -1418,6 +3395,8 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .constructor<>()
         .function("loadFromMemory", &JWWDocumentWASM::loadFromMemory)
         .function("getEntities", &JWWDocumentWASM::getEntities)
+        .function("getBounds", &JWWDocumentWASM::getBounds)
+        .function("getRenderCommands", &JWWDocumentWASM::getRenderCommands)
         .function("getLayers", &JWWDocumentWASM::getLayers)
         .function("getEntityCount", &JWWDocumentWASM::getEntityCount)
         .function("getLayerCount", &JWWDocumentWASM::getLayerCount)
@@ -1432,13 +3411,21 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .field("y1", &JSLineData::y1)
         .field("x2", &JSLineData::x2)
         .field("y2", &JSLineData::y2)
-        .field("color", &JSLineData::color);
+        .field("color", &JSLineData::color)
+        .field("width", &JSLineData::width)
+        .field("lineType", &JSLineData::lineType)
+        .field("layer", &JSLineData::layer)
+        .field("penStyle", &JSLineData::penStyle);
     
     value_object<JSCircleData>("CircleData")
         .field("cx", &JSCircleData::cx)
         .field("cy", &JSCircleData::cy)
         .field("radius", &JSCircleData::radius)
-        .field("color", &JSCircleData::color);
+        .field("color", &JSCircleData::color)
+        .field("width", &JSCircleData::width)
+        .field("lineType", &JSCircleData::lineType)
+        .field("layer", &JSCircleData::layer)
+        .field("penStyle", &JSCircleData::penStyle);
     
     value_object<JSArcData>("ArcData")
         .field("cx", &JSArcData::cx)
@@ -1446,13 +3433,18 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .field("radius", &JSArcData::radius)
         .field("angle1", &JSArcData::angle1)
         .field("angle2", &JSArcData::angle2)
-        .field("color", &JSArcData::color);
+        .field("color", &JSArcData::color)
+        .field("width", &JSArcData::width)
+        .field("lineType", &JSArcData::lineType)
+        .field("layer", &JSArcData::layer)
+        .field("penStyle", &JSArcData::penStyle);
     
     value_object<JSTextData>("TextData")
         .field("x", &JSTextData::x)
         .field("y", &JSTextData::y)
         .field("height", &JSTextData::height)
         .field("angle", &JSTextData::angle)
+        .field("widthFactor", &JSTextData::widthFactor)
         .field("text", &JSTextData::text)
         .field("textBytes", &JSTextData::textBytes)
         .field("color", &JSTextData::color);
@@ -1463,7 +3455,13 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .field("majorAxis", &JSEllipseData::majorAxis)
         .field("ratio", &JSEllipseData::ratio)
         .field("angle", &JSEllipseData::angle)
-        .field("color", &JSEllipseData::color);
+        .field("startParam", &JSEllipseData::startParam)
+        .field("endParam", &JSEllipseData::endParam)
+        .field("color", &JSEllipseData::color)
+        .field("width", &JSEllipseData::width)
+        .field("lineType", &JSEllipseData::lineType)
+        .field("layer", &JSEllipseData::layer)
+        .field("penStyle", &JSEllipseData::penStyle);
     
     value_object<JSPointData>("PointData")
         .field("x", &JSPointData::x)
@@ -1480,7 +3478,13 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
     value_object<JSPolylineData>("PolylineData")
         .field("vertices", &JSPolylineData::vertices)
         .field("closed", &JSPolylineData::closed)
-        .field("color", &JSPolylineData::color);
+        .field("color", &JSPolylineData::color)
+        .field("width", &JSPolylineData::width)
+        .field("lineType", &JSPolylineData::lineType)
+        .field("layer", &JSPolylineData::layer)
+        .field("penStyle", &JSPolylineData::penStyle)
+        .field("firstSource", &JSPolylineData::firstSource)
+        .field("sourceCount", &JSPolylineData::sourceCount);
     
     class_<JSSolidData>("SolidData")
         .function("getX", &JSSolidData::getX)
@@ -1635,7 +3639,8 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .value("INVALID_LEADER_PATH", ParseErrorType::INVALID_LEADER_PATH)
         .value("INVALID_DIMENSION_DATA", ParseErrorType::INVALID_DIMENSION_DATA)
         .value("MEMORY_ALLOCATION_FAILED", ParseErrorType::MEMORY_ALLOCATION_FAILED)
-        .value("UNKNOWN_ENTITY_TYPE", ParseErrorType::UNKNOWN_ENTITY_TYPE);
+        .value("UNKNOWN_ENTITY_TYPE", ParseErrorType::UNKNOWN_ENTITY_TYPE)
+        .value("INVALID_FILE_FORMAT", ParseErrorType::INVALID_FILE_FORMAT);
     
     value_object<JSParseError>("ParseError")
         .field("type", &JSParseError::type)
@@ -1675,6 +3680,115 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .field("version", &JSHeader::version)
         .field("entityCount", &JSHeader::entityCount);
     
+    value_object<JSBounds>("Bounds")
+        .field("minX", &JSBounds::minX)
+        .field("minY", &JSBounds::minY)
+        .field("maxX", &JSBounds::maxX)
+        .field("maxY", &JSBounds::maxY)
+        .field("valid", &JSBounds::valid);
+    
+    value_object<JSPickResult>("PickResult")
+        .field("index", &JSPickResult::index)
+        .field("distance", &JSPickResult::distance)
+        .field("x", &JSPickResult::x)
+        .field("y", &JSPickResult::y);
+    
+    value_object<JSDrawGroup>("DrawGroup")
+        .field("color", &JSDrawGroup::color)
+        .field("rgb", &JSDrawGroup::rgb)
+        .field("width", &JSDrawGroup::width)
+        .field("lineType", &JSDrawGroup::lineType)
+        .field("layer", &JSDrawGroup::layer)
+        .field("first", &JSDrawGroup::first)
+        .field("count", &JSDrawGroup::count);
+    
+    value_object<JSSnapPoint>("SnapPoint")
+        .field("found", &JSSnapPoint::found)
+        .field("x", &JSSnapPoint::x)
+        .field("y", &JSSnapPoint::y)
+        .field("kind", &JSSnapPoint::kind)
+        .field("index", &JSSnapPoint::index)
+        .field("distance", &JSSnapPoint::distance);
+    
+    value_object<JSMemoryStats>("MemoryStats")
+        .field("enabled", &JSMemoryStats::enabled)
+        .field("liveBytes", &JSMemoryStats::liveBytes)
+        .field("peakBytes", &JSMemoryStats::peakBytes)
+        .field("allocations", &JSMemoryStats::allocations)
+        .field("frees", &JSMemoryStats::frees)
+        .field("inputBytes", &JSMemoryStats::inputBytes)
+        .field("documentBytes", &JSMemoryStats::documentBytes)
+        .field("entityBytes", &JSMemoryStats::entityBytes)
+        .field("indexBytes", &JSMemoryStats::indexBytes)
+        .field("otherBytes", &JSMemoryStats::otherBytes);
+    
+    // Module-wide heap accounting over every reader; peakBytes covers the
+    // time since a reader last started parsing
+    emscripten::function("getModuleMemoryStats", optional_override([]() {
+        return makeMemoryStats(JWWMemory::snapshot());
+    }));
+    
+    // Instruction set the geometry kernels were built for
+    emscripten::function("getSimdBackend", optional_override([]() {
+        return std::string(JWWSimd::backend());
+    }));
+    
+    // NDJSON of the JWW file at dataPtr (see JWWJson::convert). With a
+    // callback the lines are passed to it in chunks and the result is
+    // whether the data parsed; without one the lines are returned as a
+    // string, or false when the data does not parse.
+    emscripten::function("jwwToNDJSON", optional_override([](uintptr_t dataPtr, size_t size, size_t chunkSize,
+                                                             bool header, bool texts, emscripten::val callback) {
+        JWWJson::Options options;
+        options.chunkSize = chunkSize;
+        options.header = header;
+        options.texts = texts;
+        const char* data = reinterpret_cast<const char*>(dataPtr);
+        if (callback.isUndefined() || callback.isNull()) {
+            std::string out;
+            if (!JWWJson::convert(data, size, out, options)) {
+                return emscripten::val(false);
+            }
+            return emscripten::val(out);
+        }
+        JSChunkSink sink(callback);
+        return emscripten::val(JWWJson::convert(data, size, sink, options));
+    }));
+    
+    // XXH64 of the bytes at dataPtr as 16 hex digits, the key snapshots
+    // are cached under (see JWWSnapshot::hash)
+    emscripten::function("jwwHash", optional_override([](uintptr_t dataPtr, size_t size) {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(
+            JWWSnapshot::hash(reinterpret_cast<const void*>(dataPtr), size)));
+        return std::string(hex);
+    }));
+    
+    // Columnar snapshot of the JWW file at dataPtr (see JWWSnapshot::write)
+    // as a Uint8Array copied out of the heap, or false when it does not parse
+    emscripten::function("jwwToSnapshot", optional_override([](uintptr_t dataPtr, size_t size) {
+        std::string snapshot;
+        if (!JWWSnapshot::write(reinterpret_cast<const char*>(dataPtr), size, snapshot)) {
+            return emscripten::val(false);
+        }
+        return emscripten::val(emscripten::typed_memory_view(
+            snapshot.size(), reinterpret_cast<const uint8_t*>(snapshot.data()))).call<emscripten::val>("slice");
+    }));
+    
+    // SVG of the JWW file at dataPtr (see JWWSvg::convert); empty when it
+    // does not parse
+    emscripten::function("jwwToSVG", optional_override([](uintptr_t dataPtr, size_t size, int precision,
+                                                          double quantum, double strokeWidth, bool texts) {
+        JWWSvg::Options options;
+        options.precision = precision;
+        options.quantum = quantum;
+        options.strokeWidth = strokeWidth;
+        options.texts = texts;
+        std::string svg;
+        JWWSvg::convert(reinterpret_cast<const char*>(dataPtr), size, svg, options);
+        return svg;
+    }));
+    
     // Vectors
     register_vector<JSLineData>("LineDataVector");
     register_vector<JSCircleData>("CircleDataVector");
@@ -1709,6 +3823,15 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .constructor<uintptr_t, size_t>()
         .constructor<uintptr_t, size_t, emscripten::val>()
         .function("readFile", &JWWReader::readFile)
+        .function("reset", &JWWReader::reset)
+        .function("load", &JWWReader::load)
+        .function("shrink", &JWWReader::shrink)
+        .function("getReservedBytes", &JWWReader::getReservedBytes)
+        .function("allocateInput", &JWWReader::allocateInput)
+        .function("parseInput", &JWWReader::parseInput)
+        .function("beginStream", &JWWReader::beginStream)
+        .function("feed", &JWWReader::feed)
+        .function("finishStream", &JWWReader::finishStream)
         .function("getLines", &JWWReader::getLines)
         .function("getCircles", &JWWReader::getCircles)
         .function("getArcs", &JWWReader::getArcs)
@@ -1729,7 +3852,28 @@ EMSCRIPTEN_BINDINGS(jwwlib_module) {
         .function("getParsingErrors", &JWWReader::getParsingErrors)
         .function("getEntities", &JWWReader::getEntities)
         .function("getHeader", &JWWReader::getHeader)
+        .function("getBounds", &JWWReader::getBounds)
+        .function("getEntityBounds", &JWWReader::getEntityBounds)
+        .function("chainLines", &JWWReader::chainLines)
+        .function("getChainSources", &JWWReader::getChainSources)
+        .function("setEntityBounds", &JWWReader::setEntityBounds)
+        .function("setKeepRecords", &JWWReader::setKeepRecords)
+        .function("saveToBuffer", &JWWReader::saveToBuffer)
+        .function("getLineVertices", &JWWReader::getLineVertices)
+        .function("queryRect", &JWWReader::queryRect)
+        .function("pick", &JWWReader::pick)
+        .function("tessellateCurves", &JWWReader::tessellateCurves)
+        .function("getRenderCommands", &JWWReader::getRenderCommands)
+        .function("getLOD", &JWWReader::getLOD)
+        .function("exportQuantizedGeometry", &JWWReader::exportQuantizedGeometry)
+        .function("compact", &JWWReader::compact)
+        .function("expandGeometry", &JWWReader::expandGeometry)
+        .function("isCompacted", &JWWReader::isCompacted)
+        .function("getLODLevelCount", &JWWReader::getLODLevelCount)
+        .function("getLODLevelForScale", &JWWReader::getLODLevelForScale)
+        .function("nearestSnap", &JWWReader::nearestSnap)
         .function("getMemoryUsage", &JWWReader::getMemoryUsage)
+        .function("getLastParsePeakBytes", &JWWReader::getLastParsePeakBytes)
         .function("getEntityStats", &JWWReader::getEntityStats)
         .function("processBatchedLines", &JWWReader::processBatchedLines)
         .function("setProgressCallback", &JWWReader::setProgressCallback);
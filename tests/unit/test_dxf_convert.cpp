@@ -0,0 +1,310 @@
+// JWW to DXF conversion tests for jwwlib-wasm
+// Writes JWW files with block definitions, converts them and reads the DXF
+// back as group code / value pairs
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "jww_dxf.h"
+#include "jwwdoc.h"
+
+namespace {
+
+struct Pair {
+    int code;
+    std::string value;
+};
+
+// Group code / value pairs; fails the test on a malformed file
+std::vector<Pair> parse(const std::string& dxf) {
+    std::vector<Pair> pairs;
+    std::istringstream in(dxf);
+    std::string code, value;
+    while (std::getline(in, code) && std::getline(in, value)) {
+        char* end = nullptr;
+        long c = std::strtol(code.c_str(), &end, 10);
+        EXPECT_EQ('\0', *end) << "bad group code '" << code << "'";
+        pairs.push_back(Pair{static_cast<int>(c), value});
+    }
+    return pairs;
+}
+
+template<typename T>
+void setPen(T& d, int color) {
+    d.SetVersion(600);
+    d.m_lGroup = 0; d.m_nPenStyle = 1; d.m_nPenColor = color; d.m_nPenWidth = 1;
+    d.m_nLayer = 2; d.m_nGLayer = 1; d.m_sFlg = 0;
+}
+
+CDataSen line(double x1, double y1, double x2, double y2) {
+    CDataSen s;
+    setPen(s, 2);
+    s.m_start.x = x1; s.m_start.y = y1;
+    s.m_end.x = x2; s.m_end.y = y2;
+    return s;
+}
+
+CDataBlock insert(unsigned number, double x, double y) {
+    CDataBlock b;
+    setPen(b, 1);
+    b.m_DPKijunTen.x = x; b.m_DPKijunTen.y = y;
+    b.m_dBairitsuX = 2.0; b.m_dBairitsuY = 2.0;
+    b.m_radKaitenKaku = M_PI / 2;
+    b.m_n_Number = number;
+    return b;
+}
+
+CDataList definition(unsigned number, const std::string& name, int count) {
+    CDataList list;
+    setPen(list, 1);
+    list.m_nNumber = number;
+    list.m_bReffered = 1;
+    list.m_time = 0;
+    list.m_strName = name;
+    list.Count = static_cast<jwWORD>(count);
+    return list;
+}
+
+} // namespace
+
+class DxfConvertTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "dxf_convert_test.jww";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // The file written by a JWWDocument once it has been destroyed
+    std::vector<char> load() {
+        std::ifstream f(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(DxfConvertTest, BlocksWrittenOnceBeforeEntities) {
+    std::vector<char> bytes;
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.vSen.push_back(line(0, 0, 100, 0));
+        doc.vBlock.push_back(insert(0, 10, 20));
+        doc.vBlock.push_back(insert(0, 30, 20));
+        doc.vBlock.push_back(insert(1, 50, 50));
+        // 0: a door of two lines, 1: the door twice plus a frame line
+        CDataList door = definition(0, "door@@SfigorgFlag@@4", 2);
+        doc.pBlockList->AddBlockList(door);
+        CDataSen a = line(0, 0, 1, 0), b = line(0, 0, 0, 1);
+        doc.pBlockList->AddDataListSen(a);
+        doc.pBlockList->AddDataListSen(b);
+        CDataList pair = definition(1, "a/b", 3);
+        doc.pBlockList->AddBlockList(pair);
+        CDataBlock left = insert(0, 0, 0), right = insert(0, 5, 0);
+        CDataSen frame = line(0, 0, 10, 0);
+        doc.pBlockList->AddDataListBlock(left);
+        doc.pBlockList->AddDataListBlock(right);
+        doc.pBlockList->AddDataListSen(frame);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    bytes = load();
+    ASSERT_GT(bytes.size(), 0u);
+
+    std::ostringstream out;
+    JWWDxf::Stats stats;
+    ASSERT_TRUE(JWWDxf::convert(bytes.data(), bytes.size(), out, JWWDxf::Options(), &stats));
+    const std::string dxf = out.str();
+    EXPECT_EQ(dxf.size(), stats.bytes);
+    EXPECT_EQ(2u, stats.blocks);
+    EXPECT_EQ(5u, stats.inserts);
+    EXPECT_EQ(9u, stats.entities);
+
+    std::vector<Pair> pairs = parse(dxf);
+    ASSERT_GT(pairs.size(), 4u);
+    EXPECT_EQ("EOF", pairs.back().value);
+    std::vector<std::string> sections;
+    std::string section, block;
+    std::vector<std::string> blocks, inserts, layers;
+    int blockLines = 0, entityLines = 0;
+    for (size_t i = 0; i + 1 < pairs.size(); i++) {
+        if (pairs[i].code != 0)
+            continue;
+        const std::string& type = pairs[i].value;
+        if (type == "SECTION") {
+            section = pairs[i + 1].value;
+            sections.push_back(section);
+        } else if (type == "BLOCK") {
+            block = pairs[i + 1].value;
+            blocks.push_back(block);
+        } else if (type == "ENDBLK") {
+            block.clear();
+        } else if (type == "LAYER") {
+            layers.push_back(pairs[i + 1].value);
+        } else if (type == "LINE") {
+            (section == "BLOCKS" ? blockLines : entityLines)++;
+            EXPECT_EQ(8, pairs[i + 1].code);
+            EXPECT_EQ("1-2", pairs[i + 1].value);
+        } else if (type == "INSERT") {
+            std::string name;
+            for (size_t k = i + 1; k < pairs.size() && pairs[k].code != 0; k++) {
+                if (pairs[k].code == 2)
+                    name = pairs[k].value;
+                if (pairs[k].code == 50) {
+                    EXPECT_EQ("90.0", pairs[k].value);
+                }
+            }
+            inserts.push_back(section == "BLOCKS" ? block + ">" + name : name);
+        }
+    }
+    EXPECT_EQ((std::vector<std::string>{"HEADER", "TABLES", "BLOCKS", "ENTITIES"}), sections);
+    // Every definition once, the flag cut off and '/' replaced
+    EXPECT_EQ((std::vector<std::string>{"door", "a_b"}), blocks);
+    EXPECT_EQ((std::vector<std::string>{"a_b>door", "a_b>door", "door", "door", "a_b"}), inserts);
+    EXPECT_EQ(3, blockLines);
+    EXPECT_EQ(1, entityLines);
+    EXPECT_EQ((std::vector<std::string>{"0", "1-2"}), layers);
+    EXPECT_EQ(std::string::npos, dxf.find('\x01'));
+}
+
+TEST_F(DxfConvertTest, EllipsesBecomePolylines) {
+    std::vector<char> bytes;
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        CDataEnko e;
+        setPen(e, 3);
+        e.m_start.x = 10; e.m_start.y = 20; e.m_dHankei = 8;
+        e.m_radKaishiKaku = 0; e.m_radEnkoKaku = 2 * M_PI; e.m_radKatamukiKaku = 0.3;
+        e.m_dHenpeiRitsu = 0.5; e.m_bZenEnFlg = 1;
+        doc.vEnko.push_back(e);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    bytes = load();
+
+    std::ostringstream out;
+    JWWDxf::Options options;
+    options.curveTolerance = 0.001;
+    ASSERT_TRUE(JWWDxf::convert(bytes.data(), bytes.size(), out, options));
+    std::vector<Pair> pairs = parse(out.str());
+    int flags = -1, vertices = 0;
+    bool seqend = false;
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (pairs[i].code == 0 && pairs[i].value == "POLYLINE") {
+            for (size_t k = i + 1; pairs[k].code != 0; k++)
+                if (pairs[k].code == 70)
+                    flags = std::atoi(pairs[k].value.c_str());
+        }
+        if (pairs[i].code == 0 && pairs[i].value == "VERTEX") {
+            double x = std::atof(pairs[i + 2].value.c_str()) - 10, y = std::atof(pairs[i + 3].value.c_str()) - 20;
+            // Back in the ellipse's own frame: on the unit circle
+            double u = (x * std::cos(0.3) + y * std::sin(0.3)) / 8;
+            double v = (-x * std::sin(0.3) + y * std::cos(0.3)) / 4;
+            EXPECT_NEAR(1.0, std::hypot(u, v), 1e-9);
+            vertices++;
+        }
+        seqend |= pairs[i].code == 0 && pairs[i].value == "SEQEND";
+    }
+    EXPECT_EQ(1, flags);    // closed
+    EXPECT_GT(vertices, 50);
+    EXPECT_TRUE(seqend);
+}
+
+TEST_F(DxfConvertTest, RejectsOtherData) {
+    const char junk[] = "not a jww file at all";
+    std::ostringstream out;
+    EXPECT_FALSE(JWWDxf::convert(junk, sizeof(junk), out));
+    EXPECT_TRUE(out.str().empty());
+    EXPECT_FALSE(JWWDxf::convertFile(::testing::TempDir() + "missing.jww", path + ".dxf"));
+    std::ifstream written(path + ".dxf");
+    EXPECT_FALSE(written.good());
+}
+
+TEST_F(DxfConvertTest, RejectsTruncatedData) {
+    std::vector<char> bytes;
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 100; i++)
+            doc.vSen.push_back(line(0, i, 100, i));
+        CDataList door = definition(0, "door", 2);
+        doc.pBlockList->AddBlockList(door);
+        CDataSen a = line(0, 0, 1, 0), b = line(0, 0, 0, 1);
+        doc.pBlockList->AddDataListSen(a);
+        doc.pBlockList->AddDataListSen(b);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    bytes = load();
+    std::ostringstream whole;
+    ASSERT_TRUE(JWWDxf::convert(bytes.data(), bytes.size(), whole));
+
+    // Cut inside the drawing and inside the definition: the header parses
+    // but the records do not, so nothing is written
+    for (size_t cut : {bytes.size() / 2, bytes.size() - 40}) {
+        std::ostringstream out;
+        EXPECT_FALSE(JWWDxf::convert(bytes.data(), cut, out)) << cut;
+        EXPECT_TRUE(out.str().empty()) << cut;
+    }
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 200k lines and 20k
+// arcs from memory to a DXF string
+TEST_F(DxfConvertTest, DISABLED_ConversionThroughput) {
+    std::vector<char> bytes;
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 200000; i++)
+            doc.vSen.push_back(line((i * 37) % 1000, (i * 91) % 700, (i * 37) % 1000 + 20.5, (i * 91) % 700 + 0.25));
+        CDataEnko e;
+        setPen(e, 3);
+        e.m_radKaishiKaku = 0.5; e.m_radEnkoKaku = 1.25; e.m_radKatamukiKaku = 0;
+        e.m_dHenpeiRitsu = 1; e.m_bZenEnFlg = 0;
+        for (int i = 0; i < 20000; i++) {
+            e.m_start.x = (i * 53) % 1000; e.m_start.y = (i * 29) % 700; e.m_dHankei = 2 + i % 30;
+            doc.vEnko.push_back(e);
+        }
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    bytes = load();
+
+    std::ostringstream out;
+    JWWDxf::Stats stats;
+    double ms = measureTime([&]() {
+        out.str(std::string());
+        ASSERT_TRUE(JWWDxf::convert(bytes.data(), bytes.size(), out, JWWDxf::Options(), &stats));
+    }, 3) / 3;
+    EXPECT_EQ(220000u, stats.entities);
+    std::cout << bytes.size() / 1024 << " KiB JWW -> " << stats.bytes / 1024 << " KiB DXF in " << ms
+              << " ms (" << stats.bytes / 1048.576 / ms << " MB/s)\n";
+}
@@ -0,0 +1,147 @@
+// DXF writer tests for jwwlib-wasm
+// Checks that reals are written as the shortest decimal that reads back
+// exactly and the group code layout; a disabled benchmark times the buffered
+// writer
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <iostream>
+#include "dl_writer_ascii.h"
+
+class DxfWriterTest : public ::testing::Test {
+protected:
+    static std::string format(double v) {
+        char str[32];
+        int n = DL_WriterA::formatReal(v, str);
+        EXPECT_EQ(std::strlen(str), static_cast<size_t>(n));
+        return std::string(str, n);
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(DxfWriterTest, ShortestFixedPoint) {
+    EXPECT_EQ("0.0", format(0.0));
+    EXPECT_EQ("-0.0", format(-0.0));
+    EXPECT_EQ("1.0", format(1.0));
+    EXPECT_EQ("-12.375", format(-12.375));
+    EXPECT_EQ("0.1", format(0.1));
+    EXPECT_EQ("0.3", format(0.3));
+    EXPECT_EQ("0.30000000000000004", format(0.1 + 0.2));
+    EXPECT_EQ("0.0001", format(1e-4));
+    EXPECT_EQ("123456789.125", format(123456789.125));
+    EXPECT_EQ("3.141592653589793", format(M_PI));
+    // Out of fixed-point range: exponent notation that still reads back
+    EXPECT_EQ(1e300, std::strtod(format(1e300).c_str(), nullptr));
+    EXPECT_EQ(1.5e-300, std::strtod(format(1.5e-300).c_str(), nullptr));
+    EXPECT_EQ("inf", format(HUGE_VAL));
+}
+
+TEST_F(DxfWriterTest, RandomValuesRoundTrip) {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> coord(-1e6, 1e6);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    for (int i = 0; i < 200000; i++) {
+        double v = coord(rng);
+        if (i % 4 == 1) {
+            v = std::ldexp(v, exponent(rng) * 10);
+        } else if (i % 4 == 2) {
+            v = std::round(v * 1000.0) / 1000.0;   // typical drawing values
+        }
+        std::string s = format(v);
+        ASSERT_EQ(v, std::strtod(s.c_str(), nullptr)) << s;
+        // Never longer than the 17 significant digits that always suffice
+        char g[32];
+        snprintf(g, sizeof(g), "%.17g", v);
+        if (std::fabs(v) >= 1e-5 && std::fabs(v) < 1e15) {
+            EXPECT_LE(s.size(), std::strlen(g) + 2) << s << " " << g;
+        }
+    }
+}
+
+TEST_F(DxfWriterTest, GroupCodesAndValues) {
+    std::string path = ::testing::TempDir() + "dxf_writer_codes.dxf";
+    {
+        DL_WriterA dw(path.c_str());
+        ASSERT_FALSE(dw.openFailed());
+        dw.dxfString(0, "LINE");
+        dw.dxfInt(62, -7);
+        dw.dxfReal(10, 2.5);
+        dw.dxfHex(5, 255);
+        dw.dxfInt(370, 0);
+        dw.close();
+    }
+    EXPECT_EQ("  0\nLINE\n 62\n-7\n 10\n2.5\n  5\nFF\n370\n0\n", readFile(path));
+    std::remove(path.c_str());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): a million coordinates
+// through the writer against the previous "%.16lf" formatting with a flush
+// per value
+TEST_F(DxfWriterTest, DISABLED_WriteSpeed) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(0.0, 100000.0);
+    std::vector<double> values(1000000);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = i % 2 ? std::round(coord(rng) * 100.0) / 100.0 : coord(rng);
+    }
+
+    std::string path = ::testing::TempDir() + "dxf_writer_speed.dxf";
+    double bufferedMs = measureTime([&]() {
+        DL_WriterA dw(path.c_str());
+        for (size_t i = 0; i < values.size(); i++) {
+            dw.dxfReal(10 + (i & 1) * 10, values[i]);
+        }
+        dw.close();
+    }, 1);
+    size_t bytes = readFile(path).size();
+
+    double previousMs = measureTime([&]() {
+        std::ofstream out(path.c_str());
+        char str[256];
+        for (size_t i = 0; i < values.size(); i++) {
+            snprintf(str, sizeof(str), "%.16lf", values[i]);
+            int end = -1;
+            bool dot = false;
+            for (unsigned int k = 0; k < strlen(str); ++k) {
+                if (str[k] == '.') {
+                    dot = true;
+                    end = k + 2;
+                } else if (dot && str[k] != '0') {
+                    end = k + 1;
+                }
+            }
+            if (end > 0 && end < (int)strlen(str)) {
+                str[end] = '\0';
+            }
+            out << (i & 1 ? " 20" : " 10") << "\n" << str << "\n";
+            out.flush();
+        }
+    }, 1);
+    std::remove(path.c_str());
+
+    std::cout << values.size() << " reals, " << bytes / 1024 << " KiB: buffered " << bufferedMs
+              << " ms, %.16lf with flush " << previousMs << " ms\n";
+}
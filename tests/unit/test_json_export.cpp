@@ -0,0 +1,316 @@
+// JWW to NDJSON conversion tests for jwwlib-wasm
+// Record lines, block tagging, string escaping, real round trips, chunked
+// output through a Sink; a disabled benchmark times conversion
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "jww_json.h"
+#include "jwwdoc.h"
+
+namespace {
+
+template<typename T>
+void setPen(T& d, int color) {
+    d.SetVersion(600);
+    d.m_lGroup = 0; d.m_nPenStyle = 1; d.m_nPenColor = color; d.m_nPenWidth = 1;
+    d.m_nLayer = 2; d.m_nGLayer = 1; d.m_sFlg = 0;
+}
+
+CDataSen line(double x1, double y1, double x2, double y2) {
+    CDataSen s;
+    setPen(s, 2);
+    s.m_start.x = x1; s.m_start.y = y1;
+    s.m_end.x = x2; s.m_end.y = y2;
+    return s;
+}
+
+std::vector<std::string> lines(const std::string& ndjson) {
+    std::vector<std::string> out;
+    std::istringstream in(ndjson);
+    std::string l;
+    while (std::getline(in, l))
+        out.push_back(l);
+    return out;
+}
+
+// The value of "key": in a line, up to the next ',' or '}'
+std::string field(const std::string& line, const std::string& key) {
+    size_t at = line.find("\"" + key + "\":");
+    if (at == std::string::npos)
+        return "";
+    at += key.size() + 3;
+    return line.substr(at, line.find_first_of(",}", at) - at);
+}
+
+// Collects the chunks it is given
+class Chunks : public JWWJson::Sink {
+public:
+    std::vector<std::string> chunks;
+    void write(const char* data, size_t size) override { chunks.push_back(std::string(data, size)); }
+};
+
+} // namespace
+
+class JsonExportTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "json_export_test.jww";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // The file written by a JWWDocument once it has been destroyed
+    std::vector<char> load() {
+        std::ifstream f(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(JsonExportTest, OneLinePerRecord) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.Header.m_strMemo = "\x90\x7D\x96\xCA";     // "図面"
+        doc.vSen.push_back(line(0, -2, 10.5, 0.1));
+        CDataMoji m;
+        setPen(m, 3);
+        m.m_start.x = 1; m.m_start.y = 2; m.m_end.x = 5; m.m_end.y = 2;
+        m.m_nMojiShu = 0; m.m_dSizeX = 3; m.m_dSizeY = 3; m.m_dKankaku = 0; m.m_degKakudo = 45;
+        m.m_strFontName = "MS Gothic";
+        m.m_string = "a \"q\"\\\t\x8A\xBF";
+        doc.vMoji.push_back(m);
+        CDataSolid solid;
+        setPen(solid, 10);
+        solid.m_start.x = 0; solid.m_start.y = 0; solid.m_DPoint2.x = 1; solid.m_DPoint2.y = 0;
+        solid.m_DPoint3.x = 1; solid.m_DPoint3.y = 1; solid.m_end.x = 0; solid.m_end.y = 1;
+        solid.m_Color = 0x123456;
+        doc.vSolid.push_back(solid);
+        CDataBlock b;
+        setPen(b, 1);
+        b.m_DPKijunTen.x = 5; b.m_DPKijunTen.y = 6;
+        b.m_dBairitsuX = 1; b.m_dBairitsuY = 1; b.m_radKaitenKaku = 0;
+        b.m_n_Number = 0;
+        doc.vBlock.push_back(b);
+        CDataList list;
+        setPen(list, 1);
+        list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+        list.m_strName = "door@@SfigorgFlag@@4";
+        list.Count = 1;
+        doc.pBlockList->AddBlockList(list);
+        CDataSen s = line(0, 0, 1, 0);
+        doc.pBlockList->AddDataListSen(s);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string out;
+    JWWJson::Stats stats;
+    ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), out, JWWJson::Options(), &stats));
+    EXPECT_EQ(out.size(), stats.bytes);
+    EXPECT_EQ(5u, stats.records);
+    EXPECT_EQ(1u, stats.blocks);
+    std::vector<std::string> l = lines(out);
+    ASSERT_EQ(7u, l.size());
+    EXPECT_EQ(0u, l[0].find("{\"type\":\"header\",\"version\":600,\"memo\":\"\xE5\x9B\xB3\xE9\x9D\xA2\""));
+    EXPECT_EQ("{\"type\":\"line\",\"glayer\":1,\"layer\":2,\"color\":2,\"style\":1,\"width\":1,"
+              "\"x1\":0,\"y1\":-2,\"x2\":10.5,\"y2\":0.1}", l[1]);
+    EXPECT_EQ("45", field(l[2], "angle"));
+    // The character size does not clash with the pen width
+    EXPECT_EQ("1", field(l[2], "width"));
+    EXPECT_EQ("3", field(l[2], "charWidth"));
+    EXPECT_EQ("\"MS Gothic\"", field(l[2], "font"));
+    EXPECT_NE(std::string::npos, l[2].find("\"text\":\"a \\\"q\\\"\\\\\\t\xE6\xBC\xA2\"}"));
+    EXPECT_EQ("1193046", field(l[3], "rgb"));
+    EXPECT_EQ("\"insert\"", field(l[4], "type"));
+    EXPECT_EQ("", field(l[4], "block"));
+    EXPECT_EQ("{\"type\":\"block\",\"number\":0,\"name\":\"door\",\"flag\":4,\"count\":1}", l[5]);
+    EXPECT_EQ("\"line\"", field(l[6], "type"));
+    EXPECT_EQ("0", field(l[6], "block"));
+    for (size_t i = 0; i < l.size(); i++) {
+        EXPECT_EQ('{', l[i].front());
+        EXPECT_EQ('}', l[i].back());
+    }
+
+    JWWJson::Options options;
+    options.header = false;
+    options.texts = false;
+    std::string filtered;
+    ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), filtered, options, &stats));
+    EXPECT_EQ(4u, stats.records);
+    EXPECT_EQ(std::string::npos, filtered.find("\"header\""));
+    EXPECT_EQ(std::string::npos, filtered.find("\"text\""));
+}
+
+TEST_F(JsonExportTest, RealsReadBack) {
+    const double values[] = {0.1, -1.0 / 3.0, 1e-7, 123456.789, 2.5e20, M_PI, -0.0, 1e15 + 0.5};
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (double v : values)
+            doc.vSen.push_back(line(v, 0, 0, 0));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+    std::string out;
+    ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), out));
+    std::vector<std::string> l = lines(out);
+    ASSERT_EQ(1 + sizeof(values) / sizeof(values[0]), l.size());
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        std::string text = field(l[i + 1], "x1");
+        EXPECT_EQ(values[i], std::strtod(text.c_str(), nullptr)) << text;
+    }
+    EXPECT_EQ("0.1", field(l[1], "x1"));
+}
+
+TEST_F(JsonExportTest, ChunksEndOnLines) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 5000; i++)
+            doc.vSen.push_back(line(i, i * 0.25, i + 1, -i));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string whole;
+    ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), whole));
+    Chunks sink;
+    JWWJson::Options options;
+    options.chunkSize = 4096;
+    JWWJson::Stats stats;
+    ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), sink, options, &stats));
+    ASSERT_GT(sink.chunks.size(), 10u);
+    EXPECT_EQ(sink.chunks.size(), stats.chunks);
+    std::string joined;
+    for (size_t i = 0; i < sink.chunks.size(); i++) {
+        EXPECT_EQ('\n', sink.chunks[i].back());
+        if (i + 1 < sink.chunks.size()) {
+            EXPECT_GE(sink.chunks[i].size(), 4096u);
+            EXPECT_LT(sink.chunks[i].size(), 4096u + 256);
+        }
+        joined += sink.chunks[i];
+    }
+    EXPECT_EQ(whole, joined);
+    EXPECT_EQ(whole.size(), stats.bytes);
+}
+
+TEST_F(JsonExportTest, RejectsOtherData) {
+    const char junk[] = "not a jww file at all";
+    std::string out = "kept";
+    EXPECT_FALSE(JWWJson::convert(junk, sizeof(junk), out));
+    EXPECT_EQ("kept", out);
+    Chunks sink;
+    EXPECT_FALSE(JWWJson::convert(junk, sizeof(junk), sink));
+    EXPECT_TRUE(sink.chunks.empty());
+    EXPECT_FALSE(JWWJson::convertFile(::testing::TempDir() + "missing.jww", path + ".ndjson"));
+    std::ifstream written(path + ".ndjson");
+    EXPECT_FALSE(written.good());
+}
+
+TEST_F(JsonExportTest, RejectsTruncatedData) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.vSen.push_back(line(0, 0, 1, 0));
+        CDataList list;
+        setPen(list, 1);
+        list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+        list.m_strName = "door";
+        list.Count = 2;
+        doc.pBlockList->AddBlockList(list);
+        CDataSen a = line(0, 0, 10, 0), b = line(0, 0, 0, 10);
+        doc.pBlockList->AddDataListSen(a);
+        doc.pBlockList->AddDataListSen(b);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    // The header parses but the definition is cut short
+    for (size_t cut : {bytes.size() - 1, bytes.size() - 40}) {
+        std::string out = "kept";
+        EXPECT_FALSE(JWWJson::convert(bytes.data(), cut, out)) << cut;
+        EXPECT_EQ("kept", out);
+        Chunks sink;
+        EXPECT_FALSE(JWWJson::convert(bytes.data(), cut, sink)) << cut;
+    }
+    {
+        std::ofstream cut(path, std::ios::binary);
+        cut.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+    }
+    EXPECT_FALSE(JWWJson::convertFile(path, path + ".ndjson"));
+    std::ifstream written(path + ".ndjson");
+    EXPECT_FALSE(written.good());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 200k lines and 20k
+// texts to NDJSON in 64 KiB chunks
+TEST_F(JsonExportTest, DISABLED_ConversionThroughput) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 200000; i++)
+            doc.vSen.push_back(line((i * 37) % 1000, (i * 91) % 700, (i * 37) % 1000 + 20.5, (i * 91) % 700 + 0.25));
+        CDataMoji m;
+        setPen(m, 3);
+        m.m_nMojiShu = 0; m.m_dSizeX = 3; m.m_dSizeY = 3; m.m_dKankaku = 0; m.m_degKakudo = 0;
+        m.m_strFontName = "\x82\x6C\x82\x72 \x83\x53\x83\x56\x83\x62\x83\x4E";
+        for (int i = 0; i < 20000; i++) {
+            m.m_start.x = i * 0.1; m.m_start.y = 3; m.m_end.x = i * 0.1 + 10; m.m_end.y = 3;
+            m.m_string = "\x90\x7D\x96\xCA " + std::to_string(i);
+            doc.vMoji.push_back(m);
+        }
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    class Counter : public JWWJson::Sink {
+    public:
+        size_t bytes = 0;
+        void write(const char*, size_t size) override { bytes += size; }
+    } sink;
+    JWWJson::Stats stats;
+    double ms = measureTime([&]() {
+        ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), sink, JWWJson::Options(), &stats));
+    }, 3) / 3;
+    EXPECT_EQ(220000u, stats.records);
+    EXPECT_EQ(3 * stats.bytes, sink.bytes);
+    std::cout << bytes.size() / 1024 << " KiB JWW -> " << stats.bytes / 1024 << " KiB NDJSON in "
+              << stats.chunks << " chunks, " << ms << " ms (" << stats.bytes / 1048.576 / ms << " MB/s)\n";
+}
@@ -0,0 +1,207 @@
+// Line type expansion tests for jwwlib-wasm
+// Checks header pattern decoding, dash placement along lines and arcs, and
+// the per-bucket segment cache
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include "jww_linetype.h"
+
+using JWWLinetype::Pattern;
+using JWWLinetype::PatternTable;
+using JWWLinetype::SegmentCache;
+
+class LinetypeTest : public ::testing::Test {
+protected:
+    // Zeroed header with a dashed, a dotted and a random style
+    static std::unique_ptr<JWWHead> makeHead() {
+        std::unique_ptr<JWWHead> head(new JWWHead());
+        head->JW_DATA_VERSION = 600;
+        // Style 2: 6 dots on, 2 off
+        head->m_alLType1[2].m_alLtype = 0x3F;
+        head->m_alLType1[2].m_anTokushusSenUnitDot = 8;
+        head->m_alLType1[2].m_anTokushuSenPich = 2;
+        // Style 5: 1 on, 1 off
+        head->m_alLType1[5].m_alLtype = 0x1;
+        head->m_alLType1[5].m_anTokushusSenUnitDot = 2;
+        head->m_alLType1[5].m_anTokushuSenPich = 3;
+        // Random line 1
+        head->m_alLType2[11].m_anRandSenWide = 4;
+        head->m_alLType2[11].m_anTokushuSenPich = 10;
+        return head;
+    }
+
+    static double totalLength(const std::vector<double>& segs) {
+        double sum = 0.0;
+        for (size_t i = 0; i + 3 < segs.size(); i += 4)
+            sum += std::hypot(segs[i + 2] - segs[i], segs[i + 3] - segs[i + 1]);
+        return sum;
+    }
+};
+
+TEST_F(LinetypeTest, BitsToDashes) {
+    std::vector<double> dashes;
+    JWWLinetype::bitsToDashes(0x3F, 8, 2, dashes);
+    ASSERT_EQ(2u, dashes.size());
+    EXPECT_EQ(12.0, dashes[0]);
+    EXPECT_EQ(4.0, dashes[1]);
+
+    // Leading gap becomes an empty dash; odd runs are padded to pairs
+    JWWLinetype::bitsToDashes(0x6, 4, 1, dashes);
+    ASSERT_EQ(4u, dashes.size());
+    EXPECT_EQ(0.0, dashes[0]);
+    EXPECT_EQ(1.0, dashes[1]);
+    EXPECT_EQ(2.0, dashes[2]);
+    EXPECT_EQ(1.0, dashes[3]);
+}
+
+TEST_F(LinetypeTest, PatternTableFromHeader) {
+    std::unique_ptr<JWWHead> head = makeHead();
+    // User-defined SXF style 31: 5 mm dash, 1 mm gap
+    head->m_SxfLtp.m_anUDLTypeSegment[1] = 2;
+    head->m_SxfLtp.m_aadUDLTypePitch[1][1] = 5.0;
+    head->m_SxfLtp.m_aadUDLTypePitch[1][2] = 1.0;
+
+    PatternTable table;
+    table.load(*head, 10.0);
+    EXPECT_EQ(Pattern::Solid, table.get(1).kind);
+    EXPECT_EQ(Pattern::Dashed, table.get(2).kind);
+    EXPECT_DOUBLE_EQ(16.0, table.get(2).period());
+    EXPECT_EQ(Pattern::Dashed, table.get(5).kind);
+    EXPECT_DOUBLE_EQ(6.0, table.get(5).period());
+    EXPECT_EQ(Pattern::Random, table.get(11).kind);
+    EXPECT_EQ(Pattern::Solid, table.get(12).kind);
+    ASSERT_EQ(Pattern::Dashed, table.get(31).kind);
+    EXPECT_DOUBLE_EQ(50.0, table.get(31).dashes[0]);
+    EXPECT_DOUBLE_EQ(10.0, table.get(31).dashes[1]);
+    EXPECT_EQ(Pattern::Solid, table.get(-1).kind);
+    EXPECT_EQ(Pattern::Solid, table.get(1000).kind);
+
+    // Before Ver.4.20 the SXF tables are not in the file
+    head->JW_DATA_VERSION = 351;
+    table.load(*head);
+    EXPECT_EQ(Pattern::Solid, table.get(31).kind);
+}
+
+TEST_F(LinetypeTest, LineDashesFollowPattern) {
+    PatternTable table;
+    table.load(*makeHead());
+    const Pattern& dash = table.get(2);    // 12 on, 4 off (dots)
+
+    // Scale 1 dot per unit: 100 units = 6 whole periods and 4 units left
+    std::vector<double> segs;
+    JWWLinetype::expandLine(dash, 1.0, 0, 0, 100, 0, segs);
+    ASSERT_EQ(7u * 4, segs.size());
+    EXPECT_DOUBLE_EQ(16.0, segs[4]);
+    EXPECT_DOUBLE_EQ(28.0, segs[6]);
+    EXPECT_DOUBLE_EQ(100.0, segs[segs.size() - 2]);
+    EXPECT_NEAR(6 * 12.0 + 4.0, totalLength(segs), 1e-9);
+
+    // Diagonal line at 2 dots per unit: 6-unit dashes along the line
+    segs.clear();
+    JWWLinetype::expandLine(dash, 2.0, 0, 0, 30, 40, segs);
+    EXPECT_NEAR(6.0, std::hypot(segs[2], segs[3]), 1e-12);
+    EXPECT_NEAR(40.0 / 30.0, segs[3] / segs[2], 1e-12);
+
+    // Too fine to see: one solid segment
+    segs.clear();
+    JWWLinetype::expandLine(dash, 0.1, 0, 0, 100, 0, segs);
+    ASSERT_EQ(4u, segs.size());
+    EXPECT_DOUBLE_EQ(100.0, segs[2]);
+
+    // Random lines wander no further than the amplitude and end on the line
+    segs.clear();
+    JWWLinetype::expandLine(table.get(11), 1.0, 0, 0, 100, 0, segs);
+    ASSERT_EQ(20u * 4, segs.size());
+    for (size_t i = 1; i < segs.size(); i += 2)
+        EXPECT_LE(std::fabs(segs[i]), 4.0);
+    EXPECT_DOUBLE_EQ(100.0, segs[segs.size() - 2]);
+    EXPECT_DOUBLE_EQ(0.0, segs[segs.size() - 1]);
+}
+
+TEST_F(LinetypeTest, ArcDashesStayOnCurve) {
+    PatternTable table;
+    table.load(*makeHead());
+    std::vector<double> segs;
+    const double r = 50.0;
+    JWWLinetype::expandArc(table.get(2), 1.0, 10, 20, r, 0.0, M_PI, segs);
+    ASSERT_FALSE(segs.empty());
+    for (size_t i = 0; i < segs.size(); i += 2)
+        EXPECT_NEAR(r, std::hypot(segs[i] - 10, segs[i + 1] - 20), 1e-9);
+    // Chords within half a dot of the arc
+    for (size_t i = 0; i < segs.size(); i += 4) {
+        double mx = (segs[i] + segs[i + 2]) * 0.5 - 10;
+        double my = (segs[i + 1] + segs[i + 3]) * 0.5 - 20;
+        EXPECT_LE(r - std::hypot(mx, my), 0.5);
+    }
+    // Three quarters of the arc length is drawn
+    EXPECT_NEAR(r * M_PI * 0.75, totalLength(segs), r * M_PI * 0.05);
+}
+
+TEST_F(LinetypeTest, ScaleBucketsAndCache) {
+    EXPECT_EQ(0, JWWLinetype::scaleBucket(1.0));
+    EXPECT_EQ(4, JWWLinetype::scaleBucket(2.0));
+    EXPECT_EQ(-4, JWWLinetype::scaleBucket(0.5));
+    for (double s : {0.013, 0.7, 1.0, 3.3, 250.0}) {
+        int b = JWWLinetype::scaleBucket(s);
+        EXPECT_LE(JWWLinetype::bucketScale(b), s * (1 + 1e-12));
+        EXPECT_GT(JWWLinetype::bucketScale(b + 1), s);
+    }
+
+    SegmentCache cache(1024);
+    std::vector<double> segs(64, 1.0);
+    const std::vector<double>& stored = cache.insert(7, 3, segs);
+    EXPECT_EQ(64u, stored.size());
+    EXPECT_EQ(&stored, cache.find(7, 3));
+    EXPECT_EQ(nullptr, cache.find(7, 4));
+    EXPECT_EQ(nullptr, cache.find(8, 3));
+    EXPECT_EQ(512u, cache.bytes());
+
+    // Over budget entries survive until trim()
+    segs.assign(128, 2.0);
+    cache.insert(8, 3, segs);
+    EXPECT_EQ(2u, cache.size());
+    cache.trim();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.bytes());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): expanding a dense
+// dashed drawing, then the cached frame
+TEST_F(LinetypeTest, DISABLED_ExpansionSpeed) {
+    PatternTable table;
+    table.load(*makeHead());
+    const Pattern& dot = table.get(5);
+    const size_t count = 100000;
+
+    SegmentCache cache;
+    std::vector<double> scratch;
+    size_t segments = 0;
+    auto frame = [&]() {
+        int bucket = JWWLinetype::scaleBucket(4.0);
+        double scale = JWWLinetype::bucketScale(bucket);
+        for (size_t i = 0; i < count; i++) {
+            const std::vector<double>* hit = cache.find(static_cast<uint32_t>(i), bucket);
+            if (!hit) {
+                scratch.clear();
+                double y = static_cast<double>(i);
+                JWWLinetype::expandLine(dot, scale, 0, y, 50, y + 5, scratch);
+                hit = &cache.insert(static_cast<uint32_t>(i), bucket, scratch);
+            }
+            segments += hit->size() / 4;
+        }
+    };
+    auto t0 = std::chrono::high_resolution_clock::now();
+    frame();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    frame();
+    auto t2 = std::chrono::high_resolution_clock::now();
+    double coldMs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1000.0;
+    double warmMs = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / 1000.0;
+    std::cout << count << " dotted lines: " << segments / 2 << " dashes, expand " << coldMs
+              << " ms, cached " << warmMs << " ms\n";
+    EXPECT_GT(segments, count * 2 * 30);
+}
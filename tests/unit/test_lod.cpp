@@ -0,0 +1,248 @@
+// Level-of-detail pyramid tests for jwwlib-wasm
+// Checks segment chaining, Douglas-Peucker simplification and that the
+// levels shrink while staying within their tolerance
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "jww_lod.h"
+
+using JWWLod::Pyramid;
+
+class LodTest : public ::testing::Test {
+protected:
+    static void addSegment(std::vector<double>& xy, std::vector<uint32_t>& pens,
+                           double x1, double y1, double x2, double y2, uint32_t pen = 0) {
+        xy.push_back(x1);
+        xy.push_back(y1);
+        xy.push_back(x2);
+        xy.push_back(y2);
+        pens.push_back(pen);
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(LodTest, ChainsFollowSharedEndPoints) {
+    std::vector<double> xy;
+    std::vector<uint32_t> pens;
+    // Open path drawn out of order and with one segment reversed
+    addSegment(xy, pens, 1, 0, 2, 0);
+    addSegment(xy, pens, 0, 0, 1, 0);
+    addSegment(xy, pens, 3, 1, 2, 0);
+    // Closed square
+    addSegment(xy, pens, 10, 10, 11, 10);
+    addSegment(xy, pens, 11, 10, 11, 11);
+    addSegment(xy, pens, 11, 11, 10, 11);
+    addSegment(xy, pens, 10, 11, 10, 10);
+    // Same point but another pen: not joined
+    addSegment(xy, pens, 3, 1, 4, 1, 1);
+    // T junction at (20, 0): three separate chains
+    addSegment(xy, pens, 19, 0, 20, 0);
+    addSegment(xy, pens, 20, 0, 21, 0);
+    addSegment(xy, pens, 20, 0, 20, 1);
+
+    std::vector<double> points;
+    std::vector<uint32_t> offsets, chainPens;
+    JWWLod::chainSegments(xy, pens, points, offsets, chainPens);
+    ASSERT_EQ(6u, chainPens.size());
+    ASSERT_EQ(7u, offsets.size());
+
+    // The path is one chain of four points from one end to the other
+    EXPECT_EQ(4u, offsets[1] - offsets[0]);
+    double ax = points[0], bx = points[(offsets[1] - 1) * 2];
+    EXPECT_TRUE((ax == 0 && bx == 3) || (ax == 3 && bx == 0));
+
+    // The square closes on its first point
+    EXPECT_EQ(5u, offsets[2] - offsets[1]);
+    EXPECT_EQ(points[offsets[1] * 2], points[(offsets[2] - 1) * 2]);
+    EXPECT_EQ(points[offsets[1] * 2 + 1], points[(offsets[2] - 1) * 2 + 1]);
+
+    // Every segment is used exactly once
+    size_t segments = 0;
+    for (size_t c = 0; c + 1 < offsets.size(); c++)
+        segments += offsets[c + 1] - offsets[c] - 1;
+    EXPECT_EQ(pens.size(), segments);
+}
+
+TEST_F(LodTest, ChainsSnapEndsWithinTolerance) {
+    std::vector<double> xy;
+    std::vector<uint32_t> pens;
+    // Outline whose corners miss each other by up to 0.004
+    addSegment(xy, pens, 0, 0, 10, 0);
+    addSegment(xy, pens, 10.003, 0.002, 10, 10);
+    addSegment(xy, pens, 0.001, 10, 9.998, 10.004);   // reversed
+    addSegment(xy, pens, 0, 10.002, 0.003, -0.001);
+    // Further than the tolerance: a separate chain
+    addSegment(xy, pens, 0.02, 10, 5, 15);
+
+    std::vector<double> points;
+    std::vector<uint32_t> offsets, chainPens, order;
+    JWWLod::chainSegments(xy, pens, 0.005, points, offsets, chainPens, order);
+    ASSERT_EQ(2u, chainPens.size());
+    ASSERT_EQ(pens.size(), order.size());
+
+    // A closed loop of four edges that shares its corner points exactly
+    EXPECT_EQ(5u, offsets[1] - offsets[0]);
+    EXPECT_EQ(points[0], points[8]);
+    EXPECT_EQ(points[1], points[9]);
+    // Edge k maps back to the segment it came from
+    for (uint32_t c = 0; c + 1 < offsets.size(); c++) {
+        for (uint32_t p = offsets[c]; p + 1 < offsets[c + 1]; p++) {
+            uint32_t seg = order[p - c];
+            double ax = points[p * 2], ay = points[p * 2 + 1];
+            double bx = points[p * 2 + 2], by = points[p * 2 + 3];
+            const double* s = &xy[seg * 4];
+            double forward = std::hypot(ax - s[0], ay - s[1]) + std::hypot(bx - s[2], by - s[3]);
+            double backward = std::hypot(ax - s[2], ay - s[3]) + std::hypot(bx - s[0], by - s[1]);
+            EXPECT_LT(std::min(forward, backward), 0.02);
+        }
+    }
+    EXPECT_EQ(4u, order.back());
+
+    // No tolerance: only exactly shared points join
+    JWWLod::chainSegments(xy, pens, 0.0, points, offsets, chainPens, order);
+    EXPECT_EQ(5u, chainPens.size());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): a million segments of
+// a grid of closed cells with jittered corners, chained at a tolerance
+TEST_F(LodTest, DISABLED_SnapChainingSpeed) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> jitter(-0.001, 0.001);
+    std::vector<double> xy;
+    std::vector<uint32_t> pens;
+    const int cells = 500;
+    for (int i = 0; i < cells; i++) {
+        for (int j = 0; j < cells; j++) {
+            double x = i * 2.0, y = j * 2.0;
+            double c[4][2] = {{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y + 1}};
+            for (int k = 0; k < 4; k++) {
+                addSegment(xy, pens, c[k][0] + jitter(rng), c[k][1] + jitter(rng),
+                           c[(k + 1) % 4][0] + jitter(rng), c[(k + 1) % 4][1] + jitter(rng));
+            }
+        }
+    }
+    std::vector<double> points;
+    std::vector<uint32_t> offsets, chainPens, order;
+    double ms = measureTime([&]() {
+        JWWLod::chainSegments(xy, pens, 0.01, points, offsets, chainPens, order);
+    }, 1);
+    std::cout << pens.size() << " segments -> " << chainPens.size() << " chains in " << ms << " ms\n";
+    EXPECT_EQ(static_cast<size_t>(cells * cells), chainPens.size());
+}
+
+TEST_F(LodTest, SimplifyKeepsShapeWithinTolerance) {
+    // Collinear points collapse to the end points
+    std::vector<double> line = {0, 0, 1, 0, 2, 0, 3, 0, 10, 0};
+    std::vector<uint32_t> keep;
+    JWWLod::simplify(line.data(), 5, 1e-9, keep);
+    ASSERT_EQ(2u, keep.size());
+    EXPECT_EQ(0u, keep[0]);
+    EXPECT_EQ(4u, keep[1]);
+
+    // A sine wave: kept points in order, dropped points within tolerance
+    std::vector<double> wave;
+    for (int i = 0; i <= 1000; i++) {
+        wave.push_back(i * 0.01);
+        wave.push_back(std::sin(i * 0.01));
+    }
+    for (double tol : {0.001, 0.01, 0.1}) {
+        keep.clear();
+        JWWLod::simplify(wave.data(), 1001, tol, keep);
+        ASSERT_GE(keep.size(), 2u);
+        EXPECT_EQ(0u, keep.front());
+        EXPECT_EQ(1000u, keep.back());
+        for (size_t k = 1; k < keep.size(); k++) {
+            ASSERT_LT(keep[k - 1], keep[k]);
+            for (uint32_t i = keep[k - 1] + 1; i < keep[k]; i++) {
+                // Distance from the dropped point to the kept chord
+                double x1 = wave[keep[k - 1] * 2], y1 = wave[keep[k - 1] * 2 + 1];
+                double x2 = wave[keep[k] * 2], y2 = wave[keep[k] * 2 + 1];
+                double cross = (x2 - x1) * (wave[i * 2 + 1] - y1) - (y2 - y1) * (wave[i * 2] - x1);
+                EXPECT_LE(std::fabs(cross) / std::hypot(x2 - x1, y2 - y1), tol + 1e-12);
+            }
+        }
+    }
+}
+
+TEST_F(LodTest, LevelsShrinkAndDropSmallItems) {
+    Pyramid lod;
+    // A finely segmented circle outline of radius 100 as connected lines
+    const int n = 4096;
+    for (int i = 0; i < n; i++) {
+        double a0 = 2 * M_PI * i / n, a1 = 2 * M_PI * (i + 1) / n;
+        lod.addSegment(100 * std::cos(a0), 100 * std::sin(a0), 100 * std::cos(a1), 100 * std::sin(a1), 2);
+    }
+    lod.addArc(0, 0, 50, 50, 0, 0, 2 * M_PI, 1);
+    lod.addArc(0, 0, 0.2, 0.2, 0, 0, M_PI, 1);   // tiny
+    lod.addText(7, 5.0);
+    lod.addText(3, 0.5);
+    lod.build(0.01, 8, 0, 0);
+    ASSERT_EQ(8, lod.levelCount());
+
+    size_t previous = SIZE_MAX;
+    for (int l = 0; l < lod.levelCount(); l++) {
+        const JWWLod::Level& level = lod.level(l);
+        EXPECT_DOUBLE_EQ(0.01 * std::ldexp(1.0, l), level.tolerance);
+        EXPECT_LE(level.vertices.size(), previous);
+        previous = level.vertices.size();
+        // Groups in pen order and covering the buffer
+        ASSERT_EQ(2u, level.groups.size());
+        EXPECT_EQ(1u, level.groups[0].pen);
+        EXPECT_EQ(2u, level.groups[1].pen);
+        EXPECT_EQ(level.vertices.size() / 2, level.groups[1].first + level.groups[1].count);
+        // Simplified outline stays within tolerance of the circle
+        for (uint32_t v = level.groups[1].first; v < level.groups[1].first + level.groups[1].count; v++) {
+            double r = std::hypot(level.vertices[v * 2], level.vertices[v * 2 + 1]);
+            EXPECT_NEAR(100.0, r, 1e-3);
+        }
+    }
+    EXPECT_LT(lod.level(7).vertices.size() * 4, lod.level(0).vertices.size());
+
+    // The tiny arc is gone once the tolerance passes its size
+    EXPECT_GT(lod.level(0).groups[0].count, lod.level(6).groups[0].count);
+    // Texts below the tolerance are dropped
+    EXPECT_EQ(2u, lod.level(0).texts.size());
+    EXPECT_EQ(1u, lod.level(6).texts.size());
+    EXPECT_EQ(7u, lod.level(6).texts[0]);
+
+    EXPECT_EQ(0, lod.levelFor(0.001));
+    EXPECT_EQ(3, lod.levelFor(0.1));
+    EXPECT_EQ(7, lod.levelFor(100.0));
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 1M connected segments
+// (contour-like polylines)
+TEST_F(LodTest, DISABLED_MillionSegmentBuild) {
+    std::mt19937 rng(11);
+    std::normal_distribution<double> step(0.0, 0.3);
+    Pyramid lod;
+    const size_t lines = 1000, perLine = 1000;
+    for (size_t p = 0; p < lines; p++) {
+        double x = 0, y = p * 10.0;
+        for (size_t i = 0; i < perLine; i++) {
+            double nx = x + 1.0, ny = y + step(rng);
+            lod.addSegment(x, y, nx, ny, static_cast<uint32_t>(p % 4));
+            x = nx;
+            y = ny;
+        }
+    }
+    double ms = measureTime([&]() { lod.build(0.01, 8, 500, 5000); }, 1);
+    std::cout << lines * perLine << " segments: build " << ms << " ms; level vertices";
+    for (int l = 0; l < lod.levelCount(); l++)
+        std::cout << " " << lod.level(l).vertices.size() / 2;
+    std::cout << "\n";
+    EXPECT_LT(lod.level(7).vertices.size(), lod.level(0).vertices.size() / 4);
+}
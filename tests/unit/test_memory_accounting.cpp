@@ -0,0 +1,154 @@
+// Heap accounting tests for jwwlib-wasm
+// Built with its own tracked copy of jww_memory.cpp (see CMakeLists.txt)
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include "jwwdoc.h"
+#include "jww_memory.h"
+#include "jww_stream.h"
+
+class MemoryAccountingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!JWWMemory::enabled()) {
+            GTEST_SKIP() << "built without JWW_MEMORY_TRACKING";
+        }
+    }
+
+    static size_t live(JWWMemory::Category category) {
+        return JWWMemory::snapshot().category[category].liveBytes;
+    }
+};
+
+TEST_F(MemoryAccountingTest, ChargesInnermostScope) {
+    size_t entitiesBefore = live(JWWMemory::Entities);
+    size_t indexBefore = live(JWWMemory::Index);
+    size_t allocationsBefore = JWWMemory::snapshot().category[JWWMemory::Entities].allocations;
+
+    std::unique_ptr<std::vector<double>> a, b;
+    {
+        JWWMemory::Scope outer(JWWMemory::Entities);
+        a.reset(new std::vector<double>(1000));
+        {
+            JWWMemory::Scope inner(JWWMemory::Index);
+            b.reset(new std::vector<double>(500));
+        }
+    }
+    EXPECT_GE(live(JWWMemory::Entities) - entitiesBefore, 1000 * sizeof(double));
+    EXPECT_GE(live(JWWMemory::Index) - indexBefore, 500 * sizeof(double));
+    EXPECT_LT(live(JWWMemory::Index) - indexBefore, 1000 * sizeof(double));
+    EXPECT_EQ(allocationsBefore + 2,
+              JWWMemory::snapshot().category[JWWMemory::Entities].allocations);
+
+    // Frees outside any scope still return the bytes to the owning category
+    a.reset();
+    b.reset();
+    EXPECT_EQ(entitiesBefore, live(JWWMemory::Entities));
+    EXPECT_EQ(indexBefore, live(JWWMemory::Index));
+}
+
+TEST_F(MemoryAccountingTest, CountsStringStorageAndNestedVectors) {
+    size_t before = live(JWWMemory::Entities);
+    std::vector<std::vector<std::string>> nested;
+    {
+        JWWMemory::Scope scope(JWWMemory::Entities);
+        nested.resize(10);
+        for (auto& v : nested) {
+            for (int i = 0; i < 10; i++) {
+                v.push_back(std::string(100, 'x'));
+            }
+        }
+    }
+    // 100 heap strings of 100 characters plus the vectors holding them
+    EXPECT_GE(live(JWWMemory::Entities) - before, 100 * 100u);
+    nested.clear();
+    nested.shrink_to_fit();
+    EXPECT_EQ(before, live(JWWMemory::Entities));
+}
+
+TEST_F(MemoryAccountingTest, PeakTracksHighWaterMark) {
+    JWWMemory::resetPeak();
+    size_t base = JWWMemory::snapshot().liveBytes;
+    {
+        std::vector<char> big(1 << 20);
+        big[0] = 1;
+    }
+    JWWMemory::Stats stats = JWWMemory::snapshot();
+    EXPECT_GE(stats.peakBytes, base + (1 << 20));
+    EXPECT_LT(stats.liveBytes, base + (1 << 20));
+
+    JWWMemory::resetPeak();
+    EXPECT_LT(JWWMemory::snapshot().peakBytes, base + (1 << 20));
+}
+
+TEST_F(MemoryAccountingTest, OwnerPaysForItsCharges) {
+    JWWMemory::Owner owner;
+    EXPECT_EQ(0u, owner.liveBytes());
+
+    std::unique_ptr<std::vector<double>> charged, other;
+    {
+        JWWMemory::Charge charge(&owner);
+        charged.reset(new std::vector<double>(1000));
+        {
+            // NULL keeps the current owner
+            JWWMemory::Charge keep(NULL);
+            JWWMemory::Scope scope(JWWMemory::Index);
+            charged->reserve(2000);
+        }
+    }
+    other.reset(new std::vector<double>(4000));
+    EXPECT_GE(owner.liveBytes(), 2000 * sizeof(double));
+    EXPECT_LT(owner.liveBytes(), 4000 * sizeof(double));
+
+    // Growing from 1000 to 2000 doubles briefly held both buffers
+    EXPECT_GE(owner.peakBytes(), 3000 * sizeof(double));
+    charged.reset();
+    EXPECT_EQ(0u, owner.liveBytes());
+    owner.resetPeak();
+    EXPECT_EQ(0u, owner.peakBytes());
+}
+
+TEST_F(MemoryAccountingTest, BlocksMayOutliveTheirOwner) {
+    size_t before = JWWMemory::snapshot().liveBytes;
+    std::unique_ptr<std::vector<char>> block;
+    {
+        JWWMemory::Owner owner;
+        JWWMemory::Charge charge(&owner);
+        block.reset(new std::vector<char>(1 << 16));
+    }
+    block.reset();
+    EXPECT_EQ(before, JWWMemory::snapshot().liveBytes);
+}
+
+TEST_F(MemoryAccountingTest, DocumentRecordsAreCharged) {
+    std::string in(""), out(::testing::TempDir() + "memory_accounting_test.jww");
+    {
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        CDataSen s;
+        s.SetVersion(600);
+        s.m_lGroup = 0; s.m_nPenStyle = 1; s.m_nPenColor = 2; s.m_nPenWidth = 1;
+        s.m_nLayer = 0; s.m_nGLayer = 0; s.m_sFlg = 0;
+        s.m_start.x = 0; s.m_start.y = 0; s.m_end.x = 1; s.m_end.y = 1;
+        doc.vSen.assign(2000, s);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+
+    size_t before = live(JWWMemory::Document);
+    {
+        std::string path(out), none("");
+        JWWDocument doc(path, none);
+        {
+            JWWMemory::Scope scope(JWWMemory::Document);
+            ASSERT_TRUE(doc.Read());
+        }
+        ASSERT_EQ(2000u, doc.vSen.size());
+        EXPECT_GE(live(JWWMemory::Document) - before, 2000 * sizeof(CDataSen));
+    }
+    EXPECT_EQ(before, live(JWWMemory::Document));
+    std::remove(out.c_str());
+}
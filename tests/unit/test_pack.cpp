@@ -0,0 +1,206 @@
+// Packed geometry column tests for jwwlib-wasm
+// Exact integer and real round trips, quantized reals within half a step,
+// truncated input, and the size of packed line data
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <cstring>
+#include "jww_pack.h"
+
+class PackTest : public ::testing::Test {
+protected:
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(PackTest, IntegersRoundTripAtEveryWidth) {
+    // One block per width, including the extremes whose deltas wrap
+    std::vector<int64_t> v;
+    for (int w = 0; w <= 64; w++) {
+        for (size_t k = 0; k < JWWPack::BLOCK; k++) {
+            uint64_t bits = w == 64 ? ~0ULL : (1ULL << w) - 1;
+            v.push_back(static_cast<int64_t>((k * 0x9E3779B97F4A7C15ULL) & bits) * (k & 1 ? -1 : 1));
+        }
+    }
+    v.push_back(std::numeric_limits<int64_t>::min());
+    v.push_back(std::numeric_limits<int64_t>::max());
+    v.push_back(0);
+
+    for (size_t stride : {1u, 4u, 7u}) {
+        std::vector<uint8_t> packed;
+        JWWPack::pack(v.data(), v.size(), stride, packed);
+        std::vector<int64_t> out(v.size());
+        EXPECT_EQ(packed.size(), JWWPack::unpack(packed.data(), packed.size(), v.size(), stride, out.data()));
+        EXPECT_EQ(v, out) << "stride " << stride;
+    }
+
+    // Nothing in, nothing out
+    std::vector<uint8_t> empty;
+    JWWPack::pack(v.data(), 0, 4, empty);
+    EXPECT_TRUE(empty.empty());
+
+    // Past the first value, a constant column is one width byte per block
+    std::vector<int64_t> same(1000, 7);
+    std::vector<uint8_t> packed;
+    JWWPack::pack(same.data(), same.size(), 1, packed);
+    EXPECT_EQ(1 + JWWPack::BLOCK * 4 / 8 + 7, packed.size());
+}
+
+TEST_F(PackTest, RealsWithinHalfAStep) {
+    std::vector<double> v;
+    for (int i = 0; i < 1000; i++)
+        v.push_back(-35e6 + std::fmod(i * 7919.123456, 2e6));
+    v.push_back(std::nan(""));
+    v.push_back(1e300);
+
+    const double step = 1e-3;
+    std::vector<uint8_t> packed;
+    double err = JWWPack::packReals(v.data(), 1000, 2, step, packed);
+    EXPECT_GT(err, 0);
+    EXPECT_LE(err, step * 0.5 + 1e-9);
+    std::vector<double> out(1000);
+    ASSERT_EQ(packed.size(), JWWPack::unpackReals(packed.data(), packed.size(), 1000, 2, step, out.data()));
+    double worst = 0;
+    for (size_t i = 0; i < out.size(); i++)
+        worst = std::max(worst, std::fabs(out[i] - v[i]));
+    EXPECT_EQ(err, worst);
+
+    // A value beyond the step range is clamped, and NaN is stored as 0 with
+    // an infinite error; both show up in the error
+    packed.clear();
+    err = JWWPack::packReals(v.data() + 1001, 1, 1, step, packed);
+    EXPECT_GT(err, 1e299);
+    EXPECT_TRUE(std::isfinite(err));
+    packed.clear();
+    err = JWWPack::packReals(v.data() + 1000, 2, 1, step, packed);
+    EXPECT_TRUE(std::isinf(err));
+    JWWPack::unpackReals(packed.data(), packed.size(), 2, 1, step, out.data());
+    EXPECT_EQ(0, out[0]);
+    EXPECT_TRUE(std::isfinite(out[1]));
+}
+
+TEST_F(PackTest, RealsExactWithoutStep) {
+    std::vector<double> v;
+    for (int i = 0; i < 1000; i++)
+        v.push_back(-35e6 + std::fmod(i * 7919.123456, 2e6) + 1e-7 * i);
+    v.push_back(std::nan(""));
+    v.push_back(-0.0);
+    v.push_back(std::numeric_limits<double>::infinity());
+    v.push_back(std::numeric_limits<double>::denorm_min());
+    v.push_back(1e300);
+
+    for (size_t stride : {1u, 2u, 5u}) {
+        std::vector<uint8_t> packed;
+        EXPECT_EQ(0, JWWPack::packReals(v.data(), v.size(), stride, 0, packed));
+        std::vector<double> out(v.size());
+        ASSERT_EQ(packed.size(), JWWPack::unpackReals(packed.data(), packed.size(), v.size(), stride, 0, out.data()));
+        // Bit for bit, NaN and the sign of zero included
+        EXPECT_EQ(0, std::memcmp(v.data(), out.data(), v.size() * sizeof(double))) << "stride " << stride;
+    }
+}
+
+TEST_F(PackTest, RejectsTruncatedData) {
+    std::vector<int64_t> v(300);
+    for (size_t i = 0; i < v.size(); i++)
+        v[i] = static_cast<int64_t>(i * i);
+    std::vector<uint8_t> packed;
+    JWWPack::pack(v.data(), v.size(), 1, packed);
+    std::vector<int64_t> out(v.size());
+    for (size_t cut = 0; cut < packed.size(); cut++)
+        EXPECT_EQ(0u, JWWPack::unpack(packed.data(), cut, v.size(), 1, out.data())) << cut;
+
+    // A width byte past 64 is not ours
+    std::vector<uint8_t> bad(64, 0);
+    bad[0] = 65;
+    EXPECT_EQ(0u, JWWPack::unpack(bad.data(), bad.size(), 10, 1, out.data()));
+
+    // Streams follow each other: the consumed size finds the next one
+    size_t first = packed.size();
+    JWWPack::pack(v.data(), 10, 1, packed);
+    EXPECT_EQ(first, JWWPack::unpack(packed.data(), packed.size(), v.size(), 1, out.data()));
+    EXPECT_EQ(packed.size() - first,
+              JWWPack::unpack(packed.data() + first, packed.size() - first, 10, 1, out.data()));
+    EXPECT_EQ(81, out[9]);
+}
+
+// 250k lines of a floor plan grid: coordinates and pens per line
+static void floorPlan(size_t lines, std::vector<double>& xy, std::vector<int64_t>& pens) {
+    xy.reserve(lines * 4);
+    for (size_t i = 0; i < lines; i++) {
+        double x = 120000.0 + (i % 500) * 910.0;
+        double y = -45000.0 + (i / 500) * 455.0;
+        xy.push_back(x);
+        xy.push_back(y);
+        xy.push_back(x + 910.0);
+        xy.push_back(y + (i % 3) * 0.5);
+        // color, width, lineType, layer, penStyle
+        pens.push_back(1 + (i / 4000) % 3);
+        pens.push_back(0);
+        pens.push_back((i / 9000) % 2);
+        pens.push_back((i / 20000) % 16);
+        pens.push_back(0);
+    }
+}
+
+TEST_F(PackTest, LineColumnRatio) {
+    const size_t lines = 250000;
+    std::vector<double> xy;
+    std::vector<int64_t> pens;
+    floorPlan(lines, xy, pens);
+    const size_t raw = lines * (4 * sizeof(double) + 5 * sizeof(int));
+
+    std::vector<uint8_t> attrs;
+    JWWPack::pack(pens.data(), pens.size(), 5, attrs);
+    std::vector<int64_t> outPens(pens.size());
+    JWWPack::unpack(attrs.data(), attrs.size(), pens.size(), 5, outPens.data());
+    EXPECT_EQ(pens, outPens);
+
+    // Coordinates at 1/1000 mm
+    std::vector<uint8_t> coords;
+    double err = JWWPack::packReals(xy.data(), xy.size(), 4, 1e-3, coords);
+    EXPECT_LE(err, 5e-4);
+    EXPECT_LT((coords.size() + attrs.size()) * 4, raw);
+    std::vector<double> out(xy.size());
+    JWWPack::unpackReals(coords.data(), coords.size(), xy.size(), 4, 1e-3, out.data());
+    EXPECT_NEAR(xy.back(), out.back(), 5e-4);
+
+    // Exact coordinates still pack smaller than the vectors
+    std::vector<uint8_t> exact;
+    JWWPack::packReals(xy.data(), xy.size(), 4, 0, exact);
+    EXPECT_LT(exact.size() + attrs.size(), raw);
+    std::cout << lines << " lines: " << raw / 1024 << " KiB -> " << (coords.size() + attrs.size()) / 1024
+              << " KiB at 1/1000, " << (exact.size() + attrs.size()) / 1024 << " KiB exact\n";
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): decoding the floor
+// plan columns
+TEST_F(PackTest, DISABLED_LineColumnDecodeSpeed) {
+    const size_t lines = 250000;
+    std::vector<double> xy;
+    std::vector<int64_t> pens;
+    floorPlan(lines, xy, pens);
+    std::vector<double> out(xy.size());
+    std::vector<int64_t> outPens(pens.size());
+    for (double step : {1e-3, 0.0}) {
+        std::vector<uint8_t> coords, attrs;
+        JWWPack::packReals(xy.data(), xy.size(), 4, step, coords);
+        JWWPack::pack(pens.data(), pens.size(), 5, attrs);
+        double ms = measureTime([&]() {
+            JWWPack::unpackReals(coords.data(), coords.size(), xy.size(), 4, step, out.data());
+            JWWPack::unpack(attrs.data(), attrs.size(), pens.size(), 5, outPens.data());
+        }, 5) / 5;
+        std::cout << lines << " lines, step " << step << ": " << (coords.size() + attrs.size()) / 1024
+                  << " KiB, decode " << ms << " ms\n";
+    }
+}
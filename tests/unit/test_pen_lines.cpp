@@ -0,0 +1,141 @@
+// Pen-bucketed line list tests for jwwlib-wasm
+// Checks bucket order and layout, vertex counts and that every item lands
+// in its own pen's bucket
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include "jww_penlines.h"
+#include "jww_tessellate.h"
+
+using JWWPenLines::Builder;
+using JWWPenLines::Group;
+using JWWPenLines::Pen;
+
+class PenLinesTest : public ::testing::Test {
+protected:
+    static Pen pen(int layer, int lineType, int width, int color) {
+        Pen p = {layer, lineType, width, color};
+        return p;
+    }
+
+    // Groups start at vertex 0, follow each other without gaps and cover
+    // every vertex
+    static void expectContiguous(const std::vector<Group>& groups, const std::vector<float>& vertices) {
+        uint32_t next = 0;
+        for (const Group& g : groups) {
+            EXPECT_EQ(next, g.first);
+            EXPECT_GT(g.count, 0u);
+            EXPECT_EQ(0u, g.count % 2);
+            next = g.first + g.count;
+        }
+        EXPECT_EQ(vertices.size(), next * 2u);
+    }
+};
+
+TEST_F(PenLinesTest, BucketsFollowPenOrder) {
+    // Pens added out of order and interleaved, each field deciding once
+    const Pen pens[] = {
+        pen(2, 0, 1, 1), pen(0, 1, 1, 1), pen(0, 0, 2, 1), pen(0, 0, 1, 3),
+        pen(0, 0, 1, 2), pen(1, 0, 0, 0), pen(0, 1, 0, 9),
+    };
+    const size_t penCount = sizeof(pens) / sizeof(pens[0]);
+    std::vector<double> xy;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (size_t i = 0; i < penCount; i++) {
+            xy.insert(xy.end(), {double(i), double(repeat), double(i + 1), double(repeat)});
+        }
+    }
+    Builder builder;
+    for (size_t k = 0; k < xy.size() / 4; k++) {
+        builder.addSegments(&xy[k * 4], 1, pens[k % penCount]);
+    }
+    std::vector<float> vertices;
+    std::vector<Group> groups;
+    builder.build(0.1, 0.0, 0.0, vertices, groups);
+
+    ASSERT_EQ(7u, groups.size());
+    for (size_t g = 1; g < groups.size(); g++) {
+        const Pen& a = groups[g - 1].pen;
+        const Pen& b = groups[g].pen;
+        EXPECT_TRUE(a < b) << "group " << g;
+        // (layer, line type, width, color), compared field by field
+        EXPECT_TRUE(a.layer < b.layer ||
+                    (a.layer == b.layer && (a.lineType < b.lineType ||
+                     (a.lineType == b.lineType && (a.width < b.width ||
+                      (a.width == b.width && a.color < b.color))))));
+    }
+    EXPECT_TRUE(groups[0].pen == pen(0, 0, 1, 2));
+    EXPECT_TRUE(groups[6].pen == pen(2, 0, 1, 1));
+    expectContiguous(groups, vertices);
+    for (const Group& g : groups) {
+        EXPECT_EQ(3u * 2u, g.count);
+    }
+}
+
+TEST_F(PenLinesTest, ItemsLandInTheirBucketInInputOrder) {
+    const Pen red = pen(0, 0, 1, 1), blue = pen(0, 0, 1, 5);
+    const double first[] = {10, 20, 30, 40};
+    const double second[] = {1, 2, 3, 4};
+    // Several segments as one item, e.g. the dashes of one line
+    const double dashes[] = {50, 60, 55, 65, 60, 70, 70, 80};
+    Builder builder;
+    builder.addSegments(first, 1, blue);
+    builder.addSegments(second, 1, red);
+    builder.addSegments(dashes, 2, blue);
+    builder.addSegments(dashes, 0, red);
+    std::vector<float> vertices;
+    std::vector<Group> groups;
+    // Coordinates come out relative to the origin
+    builder.build(0.1, 1.0, 2.0, vertices, groups);
+
+    ASSERT_EQ(2u, groups.size());
+    EXPECT_TRUE(groups[0].pen == red);
+    EXPECT_EQ(2u, groups[0].count);
+    EXPECT_EQ(6u, groups[1].count);
+    const float expected[] = {0, 0, 2, 2, 9, 18, 29, 38, 49, 58, 54, 63, 59, 68, 69, 78};
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        EXPECT_FLOAT_EQ(expected[i], vertices[i]) << i;
+    }
+}
+
+TEST_F(PenLinesTest, VertexCountsMatchTessellation) {
+    const double tolerance = 0.05;
+    const Pen a = pen(0, 0, 1, 1), b = pen(1, 0, 1, 1);
+    const double segment[] = {0, 0, 1, 1};
+    Builder builder;
+    builder.addArc(0, 0, 10, 10, 0.0, 0.0, 2 * M_PI, b);
+    builder.addSegments(segment, 1, a);
+    builder.addArc(5, 5, 100, 100, 0.0, 0.5, 1.0, a);
+    builder.addArc(5, 5, 40, 20, 0.3, 0.0, M_PI, b);
+    EXPECT_EQ(4u, builder.size());
+    std::vector<float> vertices;
+    std::vector<Group> groups;
+    builder.build(tolerance, 0.0, 0.0, vertices, groups);
+
+    using JWWTessellate::segmentCount;
+    ASSERT_EQ(2u, groups.size());
+    EXPECT_EQ(2u * (1 + segmentCount(100, 1.0, tolerance)), groups[0].count);
+    EXPECT_EQ(2u * (segmentCount(10, 2 * M_PI, tolerance) + segmentCount(40, M_PI, tolerance)),
+              groups[1].count);
+    expectContiguous(groups, vertices);
+
+    // The circle opens pen b's bucket and closes on itself
+    int n = segmentCount(10, 2 * M_PI, tolerance);
+    const float* circle = &vertices[groups[1].first * 2];
+    EXPECT_NEAR(10.0, circle[0], 1e-4);
+    EXPECT_NEAR(0.0, circle[1], 1e-4);
+    EXPECT_NEAR(circle[0], circle[n * 4 - 2], 1e-4);
+    EXPECT_NEAR(circle[1], circle[n * 4 - 1], 1e-4);
+
+    // A rebuild at a coarser tolerance reuses the kept input
+    builder.build(tolerance * 10, 0.0, 0.0, vertices, groups);
+    expectContiguous(groups, vertices);
+    EXPECT_LT(groups[1].count, 2u * (segmentCount(10, 2 * M_PI, tolerance) + segmentCount(40, M_PI, tolerance)));
+
+    builder.clear();
+    builder.build(tolerance, 0.0, 0.0, vertices, groups);
+    EXPECT_TRUE(groups.empty());
+    EXPECT_TRUE(vertices.empty());
+}
@@ -0,0 +1,176 @@
+// Picking and snap index tests for jwwlib-wasm
+// Checks the KD-tree and distance helpers against brute force; a disabled
+// benchmark times them
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <limits>
+#include "jww_spatial.h"
+
+using JWWSpatial::Box;
+using JWWSpatial::PackedRTree;
+using JWWSpatial::PointKDTree;
+
+class PickingTest : public ::testing::Test {
+protected:
+    static std::vector<double> makePoints(size_t count, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> pos(-50000.0, 50000.0);
+        std::vector<double> xy(count * 2);
+        for (auto& v : xy) v = pos(rng);
+        return xy;
+    }
+
+    static long bruteNearest(const std::vector<double>& xy, double x, double y,
+                             double maxDistance, double* distance) {
+        long best = -1;
+        double bestD = maxDistance;
+        for (size_t i = 0; i < xy.size() / 2; ++i) {
+            double d = std::hypot(xy[i * 2] - x, xy[i * 2 + 1] - y);
+            if (d <= bestD) {
+                bestD = d;
+                best = static_cast<long>(i);
+            }
+        }
+        *distance = bestD;
+        return best;
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(PickingTest, SegmentAndArcDistance) {
+    double qx, qy;
+    EXPECT_DOUBLE_EQ(1.0, JWWSpatial::distanceToSegment(5, 1, 0, 0, 10, 0, qx, qy));
+    EXPECT_DOUBLE_EQ(5.0, qx);
+    EXPECT_DOUBLE_EQ(5.0, JWWSpatial::distanceToSegment(13, 4, 0, 0, 10, 0, qx, qy));
+    EXPECT_DOUBLE_EQ(10.0, qx);
+    // Degenerate segment is a point
+    EXPECT_DOUBLE_EQ(5.0, JWWSpatial::distanceToSegment(3, 4, 0, 0, 0, 0, qx, qy));
+
+    // Quarter arc from 0 to 90 degrees, radius 10
+    const double halfPi = M_PI / 2;
+    EXPECT_NEAR(2.0, JWWSpatial::distanceToArc(12 / std::sqrt(2.0), 12 / std::sqrt(2.0),
+                                               0, 0, 10, 0, halfPi, qx, qy), 1e-12);
+    EXPECT_NEAR(10 / std::sqrt(2.0), qx, 1e-12);
+    // Behind the arc the closest point is an end point
+    EXPECT_NEAR(std::hypot(10, 10), JWWSpatial::distanceToArc(0, -10, 0, 0, 10, 0, halfPi, qx, qy), 1e-12);
+    EXPECT_NEAR(10.0, qx, 1e-12);
+    // Spans that wrap through the negative x axis
+    EXPECT_NEAR(1.0, JWWSpatial::distanceToArc(-11, 0, 0, 0, 10, halfPi, 3 * halfPi, qx, qy), 1e-12);
+    EXPECT_NEAR(1.0, JWWSpatial::distanceToArc(11, 0, 0, 0, 10, -halfPi, halfPi, qx, qy), 1e-12);
+    // Full circle, query at the center
+    EXPECT_NEAR(10.0, JWWSpatial::distanceToArc(0, 0, 0, 0, 10, 0, 2 * M_PI, qx, qy), 1e-12);
+}
+
+TEST_F(PickingTest, NearestMatchesBruteForce) {
+    for (size_t count : {size_t(0), size_t(1), size_t(2), size_t(17), size_t(5000)}) {
+        std::vector<double> xy = makePoints(count, 3);
+        PointKDTree tree;
+        tree.build(xy);
+        ASSERT_EQ(count, tree.size());
+
+        std::mt19937 rng(9);
+        std::uniform_real_distribution<double> pos(-60000.0, 60000.0);
+        for (int q = 0; q < 200; ++q) {
+            double x = pos(rng), y = pos(rng);
+            double maxDistance = q % 2 ? 2000.0 : std::numeric_limits<double>::infinity();
+            double expected = 0, got = 0;
+            long want = bruteNearest(xy, x, y, maxDistance, &expected);
+            long id = tree.nearest(x, y, maxDistance, &got);
+            if (want < 0) {
+                EXPECT_EQ(-1, id) << "count " << count << " query " << q;
+                continue;
+            }
+            ASSERT_GE(id, 0) << "count " << count << " query " << q;
+            EXPECT_DOUBLE_EQ(expected, got);
+            EXPECT_DOUBLE_EQ(expected, std::hypot(xy[id * 2] - x, xy[id * 2 + 1] - y));
+        }
+    }
+}
+
+TEST_F(PickingTest, DuplicatePoints) {
+    std::vector<double> xy;
+    for (int i = 0; i < 100; ++i) {
+        xy.push_back(1.0);
+        xy.push_back(2.0);
+    }
+    PointKDTree tree;
+    tree.build(xy);
+    double d = -1;
+    long id = tree.nearest(1.0, 2.0, 0.0, &d);
+    ASSERT_GE(id, 0);
+    EXPECT_LT(id, 100);
+    EXPECT_EQ(0.0, d);
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): nearest snap and
+// pick on a million entities
+TEST_F(PickingTest, DISABLED_MillionEntityQuerySpeed) {
+    const size_t count = 1000000;
+    std::vector<double> xy = makePoints(count * 2, 5);
+    std::vector<Box> boxes(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Short segments from each point pair's first point
+        double x1 = xy[i * 4], y1 = xy[i * 4 + 1];
+        xy[i * 4 + 2] = x1 + std::fmod(std::fabs(xy[i * 4 + 2]), 200.0);
+        xy[i * 4 + 3] = y1 + std::fmod(std::fabs(xy[i * 4 + 3]), 200.0);
+        boxes[i] = Box(x1, y1, xy[i * 4 + 2], xy[i * 4 + 3]);
+    }
+
+    PointKDTree snaps;
+    double kdBuildMs = measureTime([&]() { snaps.build(xy); }, 1);
+    PackedRTree tree;
+    tree.build(boxes);
+
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<double> pos(-50000.0, 50000.0);
+    std::vector<double> queries(2000);
+    for (auto& v : queries) v = pos(rng);
+
+    long found = 0;
+    double snapMs = measureTime([&]() {
+        for (size_t q = 0; q < queries.size(); q += 2) {
+            double d;
+            found += snaps.nearest(queries[q], queries[q + 1], 500.0, &d) >= 0;
+        }
+    }, 1);
+
+    // pick(): R-tree candidates within the tolerance, then exact distance
+    std::vector<uint32_t> candidates;
+    long picked = 0;
+    double pickMs = measureTime([&]() {
+        for (size_t q = 0; q < queries.size(); q += 2) {
+            double x = queries[q], y = queries[q + 1], tol = 100.0;
+            candidates.clear();
+            tree.query(x - tol, y - tol, x + tol, y + tol, candidates);
+            double best = tol;
+            long hit = -1;
+            for (uint32_t id : candidates) {
+                double qx, qy;
+                double d = JWWSpatial::distanceToSegment(x, y, xy[id * 4], xy[id * 4 + 1],
+                                                         xy[id * 4 + 2], xy[id * 4 + 3], qx, qy);
+                if (d <= best) {
+                    best = d;
+                    hit = id;
+                }
+            }
+            picked += hit >= 0;
+        }
+    }, 1);
+
+    std::cout << "kd build " << kdBuildMs << " ms; 1000 snaps " << snapMs << " ms ("
+              << found << " found); 1000 picks " << pickMs << " ms (" << picked << " hit)\n";
+}
@@ -0,0 +1,131 @@
+// Quantized coordinate buffer tests for jwwlib-wasm
+// Frames fitted to extents, float32 and int32 error bounds far from the
+// origin and clamping outside the frame; a disabled benchmark times encoding
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include "jww_quant.h"
+
+class QuantTest : public ::testing::Test {
+protected:
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(QuantTest, FrameFitsExtents) {
+    JWWQuant::Frame f = JWWQuant::fit(100, 200, 300, 250, JWWQuant::FLOAT32);
+    EXPECT_EQ(200, f.originX);
+    EXPECT_EQ(225, f.originY);
+    EXPECT_EQ(1, f.scale);
+
+    JWWQuant::Frame i = JWWQuant::fit(100, 200, 300, 250, JWWQuant::INT32);
+    EXPECT_EQ(JWWQuant::INT32, i.format);
+    // The larger half extent fits in int32
+    EXPECT_LT(100 / i.scale, 2147483647.0);
+    EXPECT_GT(100 / i.scale, 2147000000.0);
+
+    // A single point or no extents at all still give a usable frame
+    JWWQuant::Frame point = JWWQuant::fit(5, 5, 5, 5, JWWQuant::INT32);
+    EXPECT_EQ(5, point.originX);
+    EXPECT_GT(point.scale, 0);
+    JWWQuant::Frame empty = JWWQuant::fit(1, 1, 0, 0, JWWQuant::INT32);
+    EXPECT_EQ(0, empty.originX);
+    EXPECT_EQ(1, empty.scale);
+}
+
+// A 2 km site at survey coordinates around (-35000, 120000) m, in mm
+TEST_F(QuantTest, OffsetsKeepPrecisionFarFromZero) {
+    const double minX = -35e6, minY = 120e6, size = 2e6;
+    std::vector<double> xy;
+    for (int i = 0; i < 10000; i++) {
+        xy.push_back(minX + std::fmod(i * 7919.123456, size));
+        xy.push_back(minY + std::fmod(i * 104729.654321, size));
+    }
+
+    // Plain float32 of absolute coordinates is off by several mm
+    double absolute = 0;
+    for (double v : xy)
+        absolute = std::max(absolute, std::fabs(static_cast<double>(static_cast<float>(v)) - v));
+    EXPECT_GT(absolute, 1.0);
+
+    JWWQuant::Store f(JWWQuant::fit(minX, minY, minX + size, minY + size, JWWQuant::FLOAT32));
+    JWWQuant::Store n(JWWQuant::fit(minX, minY, minX + size, minY + size, JWWQuant::INT32));
+    for (size_t k = 0; k < xy.size(); k += 2) {
+        f.point(xy[k], xy[k + 1]);
+        n.point(xy[k], xy[k + 1]);
+    }
+    f.length(1234.5678);
+    n.length(1234.5678);
+    ASSERT_EQ(xy.size() + 1, f.size());
+    ASSERT_EQ(xy.size() + 1, n.size());
+    EXPECT_TRUE(n.float32().empty());
+    EXPECT_TRUE(f.int32().empty());
+
+    // float32 offsets: within half an ulp of the half extent (2^-24 * 1e6)
+    EXPECT_GT(f.maxError(), 0);
+    EXPECT_LE(f.maxError(), 0.0625);
+    EXPECT_LT(f.maxError(), absolute / 8);
+    // int32: within half a step everywhere
+    EXPECT_LE(n.maxError(), n.frame().scale * 0.5 + 1e-12);
+
+    // The reported error bounds every value
+    double worst = 0;
+    for (size_t k = 0; k < xy.size(); k += 2) {
+        worst = std::max(worst, std::fabs(f.frame().x(f.float32()[k]) - xy[k]));
+        worst = std::max(worst, std::fabs(f.frame().y(f.float32()[k + 1]) - xy[k + 1]));
+        EXPECT_LE(std::fabs(n.frame().x(n.int32()[k]) - xy[k]), n.maxError());
+        EXPECT_LE(std::fabs(n.frame().y(n.int32()[k + 1]) - xy[k + 1]), n.maxError());
+    }
+    EXPECT_EQ(worst, f.maxError());
+    EXPECT_NEAR(1234.5678, f.frame().length(f.float32().back()), 1e-4);
+    EXPECT_NEAR(1234.5678, n.frame().length(n.int32().back()), n.frame().scale);
+
+    f.reset(JWWQuant::Frame());
+    EXPECT_EQ(0u, f.size());
+    EXPECT_EQ(0, f.maxError());
+}
+
+TEST_F(QuantTest, ClampsOutsideTheFrame) {
+    JWWQuant::Store n(JWWQuant::fit(0, 0, 10, 10, JWWQuant::INT32));
+    n.point(5, 5);
+    EXPECT_LT(n.maxError(), 1e-8);
+    // Far outside the extents: clamped, and the error says so
+    n.point(1e6, 5);
+    EXPECT_EQ(2147483647, n.int32()[2]);
+    EXPECT_GT(n.maxError(), 1e5);
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 4M coordinates into
+// each format
+TEST_F(QuantTest, DISABLED_EncodeThroughput) {
+    const size_t count = 4000000;
+    std::vector<double> v(count);
+    for (size_t i = 0; i < count; i++)
+        v[i] = 1e5 + std::fmod(i * 0.7071, 5000.0);
+    JWWQuant::Frame frames[2] = {
+        JWWQuant::fit(1e5, 1e5, 1e5 + 5000, 1e5 + 5000, JWWQuant::FLOAT32),
+        JWWQuant::fit(1e5, 1e5, 1e5 + 5000, 1e5 + 5000, JWWQuant::INT32),
+    };
+    for (const JWWQuant::Frame& frame : frames) {
+        JWWQuant::Store s(frame);
+        double ms = measureTime([&]() {
+            s.reset(frame);
+            s.reserve(count);
+            for (size_t i = 0; i < count; i += 2)
+                s.point(v[i], v[i + 1]);
+        }, 3) / 3;
+        EXPECT_EQ(count, s.size());
+        std::cout << (frame.format == JWWQuant::INT32 ? "int32" : "float32") << ": " << count / 1e6
+                  << "M values in " << ms << " ms, max error " << s.maxError() << "\n";
+    }
+}
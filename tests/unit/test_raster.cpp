@@ -0,0 +1,281 @@
+// Software rasterizer tests for jwwlib-wasm
+// Checks anti-aliased coverage of lines and fills, that PNG output inflates
+// back to the canvas, and a thumbnail of a generated drawing
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "jww_raster.h"
+#include "jwwdoc.h"
+
+using JWWRaster::Canvas;
+
+class RasterTest : public ::testing::Test {
+protected:
+    // Darkness of a pixel drawn in black on white: 0 untouched, 1 full
+    static double ink(const Canvas& canvas, int x, int y) {
+        return 1.0 - ((canvas.pixel(x, y) >> 24) & 0xFF) / 255.0;
+    }
+
+    static uint32_t readU32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    // Check the chunk CRCs, inflate IDAT and undo the row filters
+    static bool decodePNG(const std::vector<uint8_t>& png, int& width, int& height,
+                          std::vector<uint8_t>& rgba) {
+        static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        if (png.size() < 8 || !std::equal(SIGNATURE, SIGNATURE + 8, png.begin()))
+            return false;
+        std::vector<uint8_t> idat;
+        bool ended = false;
+        for (size_t pos = 8; pos + 12 <= png.size() && !ended; ) {
+            uint32_t len = readU32(&png[pos]);
+            const uint8_t* type = &png[pos + 4];
+            if (pos + 12 + len > png.size())
+                return false;
+            uint32_t crc = static_cast<uint32_t>(::crc32(0, type, len + 4));
+            EXPECT_EQ(readU32(&png[pos + 8 + len]), crc);
+            EXPECT_EQ(crc, JWWRaster::crc32(type, len + 4));
+            std::string name(reinterpret_cast<const char*>(type), 4);
+            if (name == "IHDR") {
+                width = static_cast<int>(readU32(type + 4));
+                height = static_cast<int>(readU32(type + 8));
+                EXPECT_EQ(8, type[12]);
+                EXPECT_EQ(6, type[13]);
+            } else if (name == "IDAT") {
+                idat.insert(idat.end(), type + 4, type + 4 + len);
+            } else if (name == "IEND") {
+                ended = true;
+            }
+            pos += 12 + len;
+        }
+        const size_t stride = size_t(width) * 4;
+        std::vector<uint8_t> raw((stride + 1) * height);
+        uLongf rawSize = static_cast<uLongf>(raw.size());
+        if (!ended || uncompress(raw.data(), &rawSize, idat.data(), static_cast<uLong>(idat.size())) != Z_OK ||
+            rawSize != raw.size())
+            return false;
+        rgba.assign(stride * height, 0);
+        for (int y = 0; y < height; y++) {
+            const uint8_t* in = &raw[y * (stride + 1) + 1];
+            uint8_t* row = &rgba[y * stride];
+            const uint8_t* up = y > 0 ? row - stride : nullptr;
+            int filter = raw[y * (stride + 1)];
+            for (size_t x = 0; x < stride; x++) {
+                int a = x >= 4 ? row[x - 4] : 0;
+                int b = up ? up[x] : 0;
+                int c = up && x >= 4 ? up[x - 4] : 0;
+                int p = 0;
+                if (filter == 1) p = a;
+                else if (filter == 2) p = b;
+                else if (filter == 3) p = (a + b) / 2;
+                else if (filter == 4) {
+                    int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+                    p = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                }
+                row[x] = static_cast<uint8_t>(in[x] + p);
+            }
+        }
+        return true;
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(RasterTest, LineCoverage) {
+    Canvas canvas(64, 32);
+    // On pixel centers: one full row
+    canvas.drawLine(4.5, 10.5, 60.5, 10.5, JWWRaster::BLACK);
+    for (int x = 5; x < 60; x++) {
+        EXPECT_NEAR(1.0, ink(canvas, x, 10), 0.01);
+        EXPECT_EQ(0.0, ink(canvas, x, 9));
+        EXPECT_EQ(0.0, ink(canvas, x, 11));
+    }
+    // Between two rows: half on each
+    canvas.clear(JWWRaster::WHITE);
+    canvas.drawLine(4.5, 20.0, 60.5, 20.0, JWWRaster::BLACK);
+    for (int x = 5; x < 60; x++) {
+        EXPECT_NEAR(0.5, ink(canvas, x, 19), 0.01);
+        EXPECT_NEAR(0.5, ink(canvas, x, 20), 0.01);
+    }
+    // Diagonal: about one pixel of ink per column
+    canvas.clear(JWWRaster::WHITE);
+    canvas.drawLine(2.0, 3.0, 60.0, 29.0, JWWRaster::BLACK);
+    for (int x = 4; x < 58; x++) {
+        double sum = 0.0;
+        for (int y = 0; y < 32; y++)
+            sum += ink(canvas, x, y);
+        EXPECT_NEAR(1.0, sum, 0.02);
+    }
+    // Far outside: clipped, nothing drawn and no hang
+    canvas.clear(JWWRaster::WHITE);
+    canvas.drawLine(-1e9, -5, 1e9, -5, JWWRaster::BLACK);
+    canvas.drawLine(-1e9, 5.5, 1e9, 5.5, JWWRaster::BLACK);
+    EXPECT_EQ(0.0, ink(canvas, 0, 0));
+    EXPECT_NEAR(1.0, ink(canvas, 31, 5), 0.01);
+}
+
+TEST_F(RasterTest, FillCoverage) {
+    Canvas canvas(32, 32);
+    // Square with edges through pixel centers
+    const double square[8] = {4.5, 4.5, 20.5, 4.5, 20.5, 20.5, 4.5, 20.5};
+    canvas.fillPolygon(square, 4, JWWRaster::BLACK);
+    EXPECT_NEAR(1.0, ink(canvas, 10, 10), 0.01);
+    EXPECT_NEAR(0.5, ink(canvas, 4, 10), 0.01);
+    EXPECT_NEAR(0.5, ink(canvas, 10, 20), 0.01);
+    EXPECT_NEAR(0.25, ink(canvas, 4, 4), 0.01);
+    EXPECT_EQ(0.0, ink(canvas, 3, 10));
+    EXPECT_EQ(0.0, ink(canvas, 21, 21));
+
+    // Total ink equals the area, for a rotated triangle too
+    canvas.clear(JWWRaster::WHITE);
+    const double triangle[6] = {3.2, 2.7, 29.1, 9.4, 12.3, 27.8};
+    canvas.fillPolygon(triangle, 3, JWWRaster::BLACK);
+    double area = std::fabs((29.1 - 3.2) * (27.8 - 2.7) - (12.3 - 3.2) * (9.4 - 2.7)) * 0.5;
+    double sum = 0.0;
+    for (int y = 0; y < 32; y++)
+        for (int x = 0; x < 32; x++)
+            sum += ink(canvas, x, y);
+    EXPECT_NEAR(area, sum, area * 0.01);
+
+    // Translucent colors blend over what is there
+    canvas.clear(JWWRaster::WHITE);
+    canvas.fillPolygon(square, 4, 0xFF000080u);
+    uint32_t p = canvas.pixel(10, 10);
+    EXPECT_EQ(0xFFu, p >> 24);
+    EXPECT_NEAR(127.0, double((p >> 16) & 0xFF), 1.0);
+    EXPECT_EQ(0xFFu, p & 0xFF);
+}
+
+TEST_F(RasterTest, PngDecodesToCanvas) {
+    Canvas canvas(97, 61, 0x20304080u);
+    for (int i = 0; i < 40; i++)
+        canvas.drawLine(i * 2.3, 0, 96 - i * 1.7, 60, 0xFF000000u | (i * 6) << 16 | 0xFF);
+    const double quad[8] = {10, 10, 80, 15, 70, 50, 5, 40};
+    canvas.fillPolygon(quad, 4, 0x00C0FF90u);
+    canvas.drawArc(48, 30, 25, 12, 0.3, 0, 5.0, 0x000000FFu);
+
+    std::vector<uint8_t> png, pixels;
+    JWWRaster::encodePNG(canvas, png);
+    int w = 0, h = 0;
+    ASSERT_TRUE(decodePNG(png, w, h, pixels));
+    EXPECT_EQ(97, w);
+    EXPECT_EQ(61, h);
+    EXPECT_TRUE(pixels == canvas.pixels());
+
+    // Uniform images shrink to almost nothing
+    canvas.resize(512, 512);
+    JWWRaster::encodePNG(canvas, png);
+    EXPECT_LT(png.size() * 100, canvas.pixels().size());
+    ASSERT_TRUE(decodePNG(png, w, h, pixels));
+    EXPECT_TRUE(pixels == canvas.pixels());
+
+    const uint8_t text[] = "123456789";
+    EXPECT_EQ(0xCBF43926u, JWWRaster::crc32(text, 9));
+    EXPECT_EQ(0x091E01DEu, JWWRaster::adler32(text, 9));
+}
+
+// A 20k-entity drawing saved to JWW bytes
+static std::vector<char> makeDrawing() {
+    std::string path = ::testing::TempDir() + "raster_test.jww";
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        CDataSen s;
+        s.SetVersion(600);
+        s.m_lGroup = 0; s.m_nPenStyle = 1; s.m_nPenColor = 2; s.m_nPenWidth = 1;
+        s.m_nLayer = 0; s.m_nGLayer = 0; s.m_sFlg = 0;
+        for (int i = 0; i < 15000; i++) {
+            s.m_nPenColor = 1 + i % 8;
+            s.m_start.x = (i * 37) % 1000; s.m_start.y = (i * 91) % 700;
+            s.m_end.x = s.m_start.x + 20; s.m_end.y = s.m_start.y + (i % 13);
+            doc.vSen.push_back(s);
+        }
+        CDataEnko e;
+        e.SetVersion(600);
+        e.m_lGroup = 0; e.m_nPenStyle = 1; e.m_nPenColor = 3; e.m_nPenWidth = 1;
+        e.m_nLayer = 0; e.m_nGLayer = 0; e.m_sFlg = 0;
+        e.m_radKaishiKaku = 0; e.m_radEnkoKaku = 2 * M_PI; e.m_radKatamukiKaku = 0;
+        e.m_dHenpeiRitsu = 1; e.m_bZenEnFlg = 1;
+        for (int i = 0; i < 5000; i++) {
+            e.m_start.x = (i * 53) % 1000; e.m_start.y = (i * 29) % 700; e.m_dHankei = 2 + i % 30;
+            doc.vEnko.push_back(e);
+        }
+        doc.objCode = 0;
+        EXPECT_TRUE(doc.Save());
+    }
+    std::ifstream f(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    return bytes;
+}
+
+TEST_F(RasterTest, ThumbnailFromFile) {
+    std::vector<char> bytes = makeDrawing();
+    ASSERT_GT(bytes.size(), 0u);
+
+    JWWRaster::Options options;
+    options.width = 320;
+    options.height = 240;
+    Canvas canvas;
+    std::vector<uint8_t> png;
+    ASSERT_TRUE(JWWRaster::renderThumbnail(bytes.data(), bytes.size(), options, canvas));
+    JWWRaster::encodePNG(canvas, png);
+
+    // The drawing fills the canvas inside the margin
+    int w = 0, h = 0;
+    std::vector<uint8_t> pixels;
+    ASSERT_TRUE(decodePNG(png, w, h, pixels));
+    int minX = w, maxX = -1;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            if (canvas.pixel(x, y) != JWWRaster::WHITE) {
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+            }
+    EXPECT_LE(minX, options.margin + 1);
+    EXPECT_GE(maxX, w - options.margin - 2);
+
+    // Not a JWW file
+    const char junk[] = "not a drawing";
+    EXPECT_FALSE(JWWRaster::renderThumbnail(junk, sizeof(junk), options, canvas));
+    EXPECT_EQ(JWWRaster::WHITE, canvas.pixel(160, 120));
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): the drawing from a
+// file to PNG bytes
+TEST_F(RasterTest, DISABLED_ThumbnailThroughput) {
+    std::vector<char> bytes = makeDrawing();
+    ASSERT_GT(bytes.size(), 0u);
+
+    JWWRaster::Options options;
+    options.width = 320;
+    options.height = 240;
+    Canvas canvas;
+    std::vector<uint8_t> png;
+    const int runs = 10;
+    double ms = measureTime([&]() {
+        ASSERT_TRUE(JWWRaster::renderThumbnail(bytes.data(), bytes.size(), options, canvas));
+        JWWRaster::encodePNG(canvas, png);
+    }, runs);
+    std::cout << "20000 entities to 320x240 PNG: " << ms / runs << " ms each, " << png.size() << " bytes\n";
+}
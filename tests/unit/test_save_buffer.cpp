@@ -0,0 +1,259 @@
+// In-memory JWW output tests for jwwlib-wasm
+// Save() through JWWDocument::AttachOutput() into a JWWOutputBuf must give
+// the same bytes as a file and read back through AttachInput(); SaveParallel()
+// must give the same bytes as Save()
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include "jwwdoc.h"
+#include "jww_stream.h"
+
+namespace {
+
+template<typename T>
+void setPen(T& d, int color) {
+    d.SetVersion(600);
+    d.m_lGroup = 0; d.m_nPenStyle = 1; d.m_nPenColor = color; d.m_nPenWidth = 1;
+    d.m_nLayer = 2; d.m_nGLayer = 1; d.m_sFlg = 0;
+}
+
+void fill(JWWDocument& doc, int lines) {
+    doc.Header.head = "JwwData.";
+    doc.Header.JW_DATA_VERSION = 600;
+    for (int i = 0; i < lines; i++) {
+        CDataSen s;
+        setPen(s, 1 + i % 9);
+        s.m_start.x = i; s.m_start.y = i * 0.5;
+        s.m_end.x = i + 3.25; s.m_end.y = -i;
+        doc.vSen.push_back(s);
+    }
+    CDataEnko e;
+    setPen(e, 3);
+    e.m_start.x = 5; e.m_start.y = 6; e.m_dHankei = 7;
+    e.m_radKaishiKaku = 0.5; e.m_radEnkoKaku = 1.5; e.m_radKatamukiKaku = 0;
+    e.m_dHenpeiRitsu = 1; e.m_bZenEnFlg = 0;
+    doc.vEnko.push_back(e);
+    CDataTen t;
+    setPen(t, 4);
+    t.m_start.x = 1; t.m_start.y = 2; t.m_bKariten = 0;
+    t.m_nCode = 3; t.m_radKaitenKaku = 0.25; t.m_dBairitsu = 2;
+    doc.vTen.push_back(t);
+    CDataSolid solid;
+    setPen(solid, 10);
+    solid.m_start.x = 0; solid.m_start.y = 0; solid.m_DPoint2.x = 1; solid.m_DPoint2.y = 0;
+    solid.m_DPoint3.x = 1; solid.m_DPoint3.y = 1; solid.m_end.x = 0; solid.m_end.y = 1;
+    solid.m_Color = 0x123456;
+    doc.vSolid.push_back(solid);
+    doc.objCode = 0;
+}
+
+// Texts and block inserts after the lines, and a definition holding a
+// class (points) first used there
+void addTextsAndBlocks(JWWDocument& doc, int count) {
+    for (int i = 0; i < count; i++) {
+        CDataMoji m;
+        setPen(m, 2);
+        m.m_start.x = i; m.m_start.y = 1; m.m_end.x = i + 4; m.m_end.y = 1;
+        m.m_nMojiShu = 0; m.m_dSizeX = 3; m.m_dSizeY = 3; m.m_dKankaku = 0; m.m_degKakudo = 0;
+        m.m_strFontName = "MS Gothic";
+        m.m_string = "text " + std::to_string(i);
+        doc.vMoji.push_back(m);
+        CDataBlock b;
+        setPen(b, 1);
+        b.m_DPKijunTen.x = i; b.m_DPKijunTen.y = 2;
+        b.m_dBairitsuX = 1; b.m_dBairitsuY = 1; b.m_radKaitenKaku = 0;
+        b.m_n_Number = 0;
+        doc.vBlock.push_back(b);
+    }
+    doc.vTen.clear();
+    CDataList list;
+    setPen(list, 1);
+    list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+    list.m_strName = "mark";
+    list.Count = 2;
+    doc.pBlockList->AddBlockList(list);
+    CDataSen s;
+    setPen(s, 1);
+    s.m_start.x = -1; s.m_start.y = 0; s.m_end.x = 1; s.m_end.y = 0;
+    doc.pBlockList->AddDataListSen(s);
+    CDataTen t;
+    setPen(t, 4);
+    t.m_start.x = 0; t.m_start.y = 0; t.m_bKariten = 0;
+    t.m_nCode = 0; t.m_radKaitenKaku = 0; t.m_dBairitsu = 1;
+    doc.pBlockList->AddDataListTen(t);
+}
+
+std::string save(JWWDocument& doc, int threads) {
+    JWWOutputBuf buf;
+    doc.AttachOutput(&buf);
+    bool ok = threads < 0 ? doc.Save() : doc.SaveParallel(threads);
+    EXPECT_TRUE(ok);
+    doc.AttachOutput(NULL);
+    return std::string(buf.data(), buf.size());
+}
+
+} // namespace
+
+class SaveBufferTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "save_buffer_test.jww";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(SaveBufferTest, MemoryOutputMatchesFile) {
+    std::vector<char> memory;
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        fill(doc, 1000);
+        ASSERT_TRUE(doc.Save());
+        JWWOutputBuf buf;
+        doc.AttachOutput(&buf);
+        ASSERT_TRUE(doc.Save());
+        memory.assign(buf.data(), buf.data() + buf.size());
+    }
+    std::ifstream f(path, std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    ASSERT_GT(file.size(), 1000u * 40);
+    EXPECT_EQ(file, memory);
+}
+
+TEST_F(SaveBufferTest, ReadsBack) {
+    JWWOutputBuf buf;
+    {
+        std::string in(""), out("");
+        JWWDocument doc(in, out);
+        fill(doc, 70000);   // class references past 0x7FFF take the long form
+        doc.AttachOutput(&buf);
+        ASSERT_TRUE(doc.Save());
+    }
+    std::string in(""), out("");
+    JWWDocument doc(in, out);
+    JWWMemoryBuf input(buf.data(), buf.size());
+    doc.AttachInput(&input);
+    ASSERT_TRUE(doc.Read());
+    ASSERT_EQ(70000u, doc.vSen.size());
+    EXPECT_EQ(69999.0, doc.vSen.back().m_start.x);
+    EXPECT_EQ(-69999.0, doc.vSen.back().m_end.y);
+    EXPECT_EQ(1 + 69999 % 9, doc.vSen.back().m_nPenColor);
+    ASSERT_EQ(1u, doc.vEnko.size());
+    EXPECT_EQ(1.5, doc.vEnko[0].m_radEnkoKaku);
+    ASSERT_EQ(1u, doc.vTen.size());
+    EXPECT_EQ(3u, doc.vTen[0].m_nCode);
+    EXPECT_EQ(2.0, doc.vTen[0].m_dBairitsu);
+    ASSERT_EQ(1u, doc.vSolid.size());
+    EXPECT_EQ(0x123456u, doc.vSolid[0].m_Color);
+}
+
+TEST_F(SaveBufferTest, BufferGrowsAndClears) {
+    JWWOutputBuf buf;
+    std::ostream os(&buf);
+    std::string expected;
+    for (int i = 0; i < 100000; i++) {
+        char c = static_cast<char>('a' + i % 26);
+        os.put(c);
+        expected += c;
+    }
+    std::string block(50000, 'z');
+    os.write(block.data(), block.size());
+    expected += block;
+    ASSERT_EQ(expected.size(), buf.size());
+    EXPECT_EQ(expected, std::string(buf.data(), buf.size()));
+
+    size_t capacity = buf.capacity();
+    buf.clear();
+    EXPECT_EQ(0u, buf.size());
+    EXPECT_EQ(capacity, buf.capacity());
+    os << "x";
+    EXPECT_EQ("x", std::string(buf.data(), buf.size()));
+    buf.release();
+    EXPECT_EQ(0u, buf.capacity());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 200k lines saved to
+// memory, buffer reused between saves
+TEST_F(SaveBufferTest, DISABLED_SaveThroughput) {
+    std::string in(""), out("");
+    JWWDocument doc(in, out);
+    fill(doc, 200000);
+    JWWOutputBuf buf;
+    doc.AttachOutput(&buf);
+    double ms = measureTime([&]() {
+        buf.clear();
+        ASSERT_TRUE(doc.Save());
+    }, 5) / 5;
+    std::cout << buf.size() / 1024 << " KiB in " << ms << " ms ("
+              << buf.size() / 1048.576 / ms << " MB/s)\n";
+}
+
+TEST_F(SaveBufferTest, ParallelSaveMatchesSequential) {
+    std::string in(""), out("");
+    JWWDocument doc(in, out);
+    fill(doc, 100000);
+    addTextsAndBlocks(doc, 20000);
+    const std::string sequential = save(doc, -1);
+    for (int threads : {1, 3, 8, 0}) {
+        EXPECT_EQ(sequential, save(doc, threads)) << threads << " threads";
+    }
+
+    JWWDocument back(in, out);
+    JWWMemoryBuf input(sequential.data(), sequential.size());
+    back.AttachInput(&input);
+    ASSERT_TRUE(back.Read());
+    EXPECT_EQ(100000u, back.vSen.size());
+    ASSERT_EQ(20000u, back.vMoji.size());
+    EXPECT_EQ("text 19999", back.vMoji.back().m_string);
+    EXPECT_EQ(20000u, back.vBlock.size());
+    EXPECT_EQ(1, back.pBlockList->getBlockListCount());
+    EXPECT_EQ(2, back.pBlockList->GetDataListCount(0));
+
+    // Nothing but the block definitions
+    JWWDocument empty(in, out);
+    empty.Header = doc.Header;
+    empty.objCode = 0;
+    addTextsAndBlocks(empty, 0);
+    EXPECT_EQ(save(empty, -1), save(empty, 0));
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 400k lines and 40k
+// texts, sequential against all cores
+TEST_F(SaveBufferTest, DISABLED_ParallelSaveThroughput) {
+    std::string in(""), out("");
+    JWWDocument doc(in, out);
+    fill(doc, 400000);
+    addTextsAndBlocks(doc, 40000);
+    JWWOutputBuf buf;
+    doc.AttachOutput(&buf);
+    double sequentialMs = measureTime([&]() {
+        buf.clear();
+        ASSERT_TRUE(doc.Save());
+    }, 3) / 3;
+    double parallelMs = measureTime([&]() {
+        buf.clear();
+        ASSERT_TRUE(doc.SaveParallel());
+    }, 3) / 3;
+    std::cout << buf.size() / 1024 << " KiB: Save " << sequentialMs << " ms, SaveParallel "
+              << parallelMs << " ms (" << buf.size() / 1048.576 / parallelMs << " MB/s)\n";
+}
@@ -0,0 +1,162 @@
+// SIMD geometry kernel tests for jwwlib-wasm
+// Checks the vector paths against the scalar reference and benchmarks them
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <iostream>
+#include "jww_simd.h"
+
+class SimdKernelsTest : public ::testing::Test {
+protected:
+    std::vector<double> points;   // interleaved x, y
+    std::vector<double> angles;
+
+    void SetUp() override {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> coord(-50000.0, 50000.0);
+        std::uniform_real_distribution<double> angle(-20.0, 20.0);
+        // Odd count so every kernel has a scalar tail
+        points.resize(100003 * 2);
+        for (auto& v : points) v = coord(rng);
+        angles.resize(100003);
+        for (auto& v : angles) v = angle(rng);
+    }
+
+    // Helper to measure execution time
+    template<typename Func>
+    double measureTime(Func func, int iterations = 20) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        return duration.count() / 1000.0; // Return milliseconds
+    }
+};
+
+TEST_F(SimdKernelsTest, BackendIsReported) {
+    std::string backend = JWWSimd::backend();
+    std::cout << "SIMD backend: " << backend << "\n";
+    EXPECT_TRUE(backend == "wasm-simd128" || backend == "avx" ||
+                backend == "sse2" || backend == "scalar");
+}
+
+TEST_F(SimdKernelsTest, BoundsMatchScalar) {
+    for (size_t count : {size_t(0), size_t(1), size_t(3), size_t(4), size_t(7), points.size() / 2}) {
+        JWWSimd::Bounds expected, actual;
+        JWWSimd::scalar::computeBounds(points.data(), count, expected);
+        JWWSimd::computeBounds(points.data(), count, actual);
+        ASSERT_EQ(expected.valid, actual.valid) << "count " << count;
+        if (!expected.valid) continue;
+        EXPECT_EQ(expected.minX, actual.minX);
+        EXPECT_EQ(expected.minY, actual.minY);
+        EXPECT_EQ(expected.maxX, actual.maxX);
+        EXPECT_EQ(expected.maxY, actual.maxY);
+    }
+}
+
+TEST_F(SimdKernelsTest, BoundsAccumulateAcrossCalls) {
+    JWWSimd::Bounds whole, split;
+    size_t n = points.size() / 2;
+    JWWSimd::computeBounds(points.data(), n, whole);
+    JWWSimd::computeBounds(points.data(), n / 3, split);
+    JWWSimd::computeBounds(points.data() + (n / 3) * 2, n - n / 3, split);
+    EXPECT_EQ(whole.minX, split.minX);
+    EXPECT_EQ(whole.minY, split.minY);
+    EXPECT_EQ(whole.maxX, split.maxX);
+    EXPECT_EQ(whole.maxY, split.maxY);
+}
+
+TEST_F(SimdKernelsTest, TransformMatchesScalar) {
+    const double c = std::cos(0.3), s = std::sin(0.3);
+    const double m[6] = {2.0 * c, 2.0 * s, -2.0 * s, 2.0 * c, 15.5, -7.25};
+    size_t n = points.size() / 2;
+    std::vector<double> expected(points.size()), actual(points.size());
+    JWWSimd::scalar::transformPoints(points.data(), expected.data(), n, m);
+    JWWSimd::transformPoints(points.data(), actual.data(), n, m);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], actual[i]) << "index " << i;
+    }
+
+    // In-place transform
+    std::vector<double> inPlace = points;
+    JWWSimd::transformPoints(inPlace.data(), inPlace.data(), n, m);
+    EXPECT_EQ(expected, inPlace);
+}
+
+TEST_F(SimdKernelsTest, AngleNormalizationMatchesScalar) {
+    std::vector<double> expected = angles, actual = angles;
+    JWWSimd::scalar::normalizeAngles(expected.data(), expected.size());
+    JWWSimd::normalizeAngles(actual.data(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], actual[i]) << "index " << i;
+        EXPECT_GE(actual[i], 0.0);
+        EXPECT_LT(actual[i], 2.0 * M_PI + 1e-12);
+    }
+}
+
+TEST_F(SimdKernelsTest, ArcAngleNormalizationMatchesScalar) {
+    size_t n = angles.size() - 1;
+    std::vector<double> s1(angles.begin(), angles.begin() + n), e1(angles.begin() + 1, angles.end());
+    std::vector<double> s2 = s1, e2 = e1;
+    JWWSimd::scalar::normalizeArcAngles(s1.data(), e1.data(), n);
+    JWWSimd::normalizeArcAngles(s2.data(), e2.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(s1[i], s2[i]) << "index " << i;
+        ASSERT_EQ(e1[i], e2[i]) << "index " << i;
+        EXPECT_LT(s2[i], e2[i]);
+    }
+}
+
+TEST_F(SimdKernelsTest, FloatConversionMatchesScalar) {
+    std::vector<float> expected(points.size()), actual(points.size());
+    JWWSimd::scalar::toFloat(points.data(), expected.data(), points.size());
+    JWWSimd::toFloat(points.data(), actual.data(), points.size());
+    EXPECT_EQ(expected, actual);
+
+    size_t n = points.size() / 2;
+    JWWSimd::scalar::toFloatRelative(points.data(), expected.data(), n, 1000.0, -2000.0, 0.5);
+    JWWSimd::toFloatRelative(points.data(), actual.data(), n, 1000.0, -2000.0, 0.5);
+    EXPECT_EQ(expected, actual);
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): vector kernels
+// against the scalar reference. In a native release build bounds and arc
+// angles (SSE4.1) are faster; transform and float narrowing match the
+// compiler's own vectorized loops.
+TEST_F(SimdKernelsTest, DISABLED_KernelTimings) {
+    size_t n = points.size() / 2;
+    const double m[6] = {0.5, 0.0, 0.0, 0.5, 10.0, 20.0};
+    std::vector<double> out(points.size());
+    std::vector<float> fout(points.size());
+    std::vector<double> work = angles;
+    std::vector<double> work2 = angles;
+    JWWSimd::Bounds sink;
+
+    struct Row { const char* name; double scalarMs; double simdMs; };
+    std::vector<Row> rows;
+
+    rows.push_back({"bounds",
+        measureTime([&]() { JWWSimd::Bounds b; JWWSimd::scalar::computeBounds(points.data(), n, b); sink = b; }),
+        measureTime([&]() { JWWSimd::Bounds b; JWWSimd::computeBounds(points.data(), n, b); sink = b; })});
+    rows.push_back({"transform",
+        measureTime([&]() { JWWSimd::scalar::transformPoints(points.data(), out.data(), n, m); }),
+        measureTime([&]() { JWWSimd::transformPoints(points.data(), out.data(), n, m); })});
+    rows.push_back({"arc angles",
+        measureTime([&]() { work = angles; work2 = angles; JWWSimd::scalar::normalizeArcAngles(work.data(), work2.data(), work.size()); }),
+        measureTime([&]() { work = angles; work2 = angles; JWWSimd::normalizeArcAngles(work.data(), work2.data(), work.size()); })});
+    rows.push_back({"to float",
+        measureTime([&]() { JWWSimd::scalar::toFloatRelative(points.data(), fout.data(), n, 1.0, 2.0, 1.0); }),
+        measureTime([&]() { JWWSimd::toFloatRelative(points.data(), fout.data(), n, 1.0, 2.0, 1.0); })});
+
+    std::cout << "Backend: " << JWWSimd::backend() << " (" << n << " points x 20)\n";
+    for (const auto& r : rows) {
+        std::cout << "  " << r.name << ": scalar " << r.scalarMs << " ms, simd " << r.simdMs
+                  << " ms, scalar/simd " << (r.simdMs > 0 ? r.scalarMs / r.simdMs : 0.0) << "\n";
+    }
+    EXPECT_TRUE(sink.valid);
+}
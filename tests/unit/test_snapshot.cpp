@@ -0,0 +1,288 @@
+// Columnar snapshot tests for jwwlib-wasm
+// XXH64 reference values, columns read in place after a round trip, block
+// tagging, the string and layer tables and rejection of damaged snapshots and
+// truncated files; a disabled benchmark times opening a snapshot against a
+// full parse
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include "jww_snapshot.h"
+#include "jww_json.h"
+#include "jwwdoc.h"
+
+namespace {
+
+template<typename T>
+void setPen(T& d, int color) {
+    d.SetVersion(600);
+    d.m_lGroup = 0; d.m_nPenStyle = 1; d.m_nPenColor = color; d.m_nPenWidth = 1;
+    d.m_nLayer = 2; d.m_nGLayer = 1; d.m_sFlg = 0;
+}
+
+CDataSen line(int color, double x1, double y1, double x2, double y2) {
+    CDataSen s;
+    setPen(s, color);
+    s.m_start.x = x1; s.m_start.y = y1;
+    s.m_end.x = x2; s.m_end.y = y2;
+    return s;
+}
+
+CDataMoji text(const std::string& s, double x, double y) {
+    CDataMoji m;
+    setPen(m, 2);
+    m.m_start.x = x; m.m_start.y = y; m.m_end.x = x + 10; m.m_end.y = y;
+    m.m_nMojiShu = 0; m.m_dSizeX = 2; m.m_dSizeY = 3; m.m_dKankaku = 0; m.m_degKakudo = 45;
+    m.m_strFontName = "MS Gothic";
+    m.m_string = s;
+    return m;
+}
+
+} // namespace
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "snapshot_test.jww";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+        std::remove((path + ".snap").c_str());
+    }
+
+    // The file written by a JWWDocument once it has been destroyed
+    std::vector<char> load() {
+        std::ifstream f(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(SnapshotTest, HashMatchesXXH64) {
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, JWWSnapshot::hash("", 0));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, JWWSnapshot::hash("abc", 3));
+    // Long enough for the four-lane loop
+    const char* s = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(0xFBCEA83C8A378BF1ULL, JWWSnapshot::hash(s, std::strlen(s)));
+    EXPECT_NE(JWWSnapshot::hash(s, std::strlen(s)), JWWSnapshot::hash(s, std::strlen(s), 1));
+}
+
+TEST_F(SnapshotTest, ColumnsRoundTrip) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.Header.m_strMemo = "memo";
+        doc.Header.m_nZumen = 3;
+        doc.Header.m_aStrLayName[1][2] = "\x95\xC7";	// "壁"
+        doc.Header.m_aStrGLayName[1] = "plan";
+        doc.Header.GLay[1].m_adScale = 50;
+        doc.vSen.push_back(line(2, 0, 0, 10.5, 0));
+        doc.vSen.push_back(line(5, 1, 2, 3, 4));
+        doc.vMoji.push_back(text("\x8A\xBF", 1, 2));
+        doc.vMoji.push_back(text("\x8A\xBF", 5, 6));
+        CDataBlock b;
+        setPen(b, 1);
+        b.m_DPKijunTen.x = 100; b.m_DPKijunTen.y = 200;
+        b.m_dBairitsuX = 2; b.m_dBairitsuY = 3; b.m_radKaitenKaku = 0.5;
+        b.m_n_Number = 0;
+        doc.vBlock.push_back(b);
+        CDataList list;
+        setPen(list, 1);
+        list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+        list.m_strName = "door@@SfigorgFlag@@4";
+        list.Count = 1;
+        doc.pBlockList->AddBlockList(list);
+        CDataSen s = line(4, 0, 0, 7, 0);
+        doc.pBlockList->AddDataListSen(s);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string snapshot;
+    JWWSnapshot::Stats stats;
+    ASSERT_TRUE(JWWSnapshot::write(bytes.data(), bytes.size(), snapshot, &stats));
+    EXPECT_EQ(6u, stats.records);
+    EXPECT_EQ(1u, stats.blocks);
+    EXPECT_EQ(snapshot.size(), stats.bytes);
+    EXPECT_EQ(0u, snapshot.size() % 8);
+
+    // std::string storage is at least 8-byte aligned, as an mmap()ed file is
+    JWWSnapshot::View view;
+    ASSERT_TRUE(view.open(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(JWWSnapshot::hash(bytes.data(), bytes.size()), view.sourceHash());
+    EXPECT_EQ(bytes.size(), view.header().sourceSize);
+    EXPECT_EQ(600u, view.header().jwwVersion);
+    EXPECT_EQ(3u, view.header().paper);
+    EXPECT_EQ("memo", view.string(view.header().memo));
+
+    // The definition's line follows the drawing's lines
+    size_t rows = 0;
+    ASSERT_EQ(3u, view.count(JWWSnapshot::KIND_LINE));
+    const double* x2 = view.column<double>(JWWSnapshot::KIND_LINE, JWWSnapshot::LINE_X2, &rows);
+    ASSERT_TRUE(x2 != NULL);
+    EXPECT_EQ(3u, rows);
+    EXPECT_EQ(10.5, x2[0]);
+    EXPECT_EQ(3, x2[1]);
+    EXPECT_EQ(7, x2[2]);
+    const uint16_t* color = view.column<uint16_t>(JWWSnapshot::KIND_LINE, JWWSnapshot::PEN_COLOR);
+    const uint8_t* layer = view.column<uint8_t>(JWWSnapshot::KIND_LINE, JWWSnapshot::PEN_LAYER);
+    const uint32_t* block = view.column<uint32_t>(JWWSnapshot::KIND_LINE, JWWSnapshot::PEN_BLOCK);
+    ASSERT_TRUE(color && layer && block);
+    EXPECT_EQ(5, color[1]);
+    EXPECT_EQ(1 * 16 + 2, layer[0]);
+    EXPECT_EQ(JWWSnapshot::NO_BLOCK, block[0]);
+    EXPECT_EQ(JWWSnapshot::NO_BLOCK, block[1]);
+    EXPECT_EQ(0u, block[2]);
+    // A column asked for with the wrong type
+    EXPECT_TRUE(view.column<double>(JWWSnapshot::KIND_LINE, JWWSnapshot::PEN_COLOR) == NULL);
+
+    // Both texts share one string table entry, in UTF-8
+    ASSERT_EQ(2u, view.count(JWWSnapshot::KIND_TEXT));
+    const uint32_t* strings = view.column<uint32_t>(JWWSnapshot::KIND_TEXT, JWWSnapshot::TEXT_STRING);
+    const double* angle = view.column<double>(JWWSnapshot::KIND_TEXT, JWWSnapshot::TEXT_ANGLE);
+    ASSERT_TRUE(strings && angle);
+    EXPECT_EQ(strings[0], strings[1]);
+    EXPECT_EQ("\xE6\xBC\xA2", view.string(strings[0]));
+    EXPECT_EQ(45, angle[1]);
+
+    ASSERT_EQ(1u, view.count(JWWSnapshot::KIND_INSERT));
+    EXPECT_EQ(3, view.column<double>(JWWSnapshot::KIND_INSERT, JWWSnapshot::INSERT_SCALE_Y)[0]);
+    ASSERT_EQ(1u, view.count(JWWSnapshot::KIND_BLOCK));
+    EXPECT_EQ("door", view.string(view.column<uint32_t>(JWWSnapshot::KIND_BLOCK, JWWSnapshot::BLOCK_NAME)[0]));
+    EXPECT_EQ(1u, view.column<uint32_t>(JWWSnapshot::KIND_BLOCK, JWWSnapshot::BLOCK_COUNT)[0]);
+
+    // Layer table
+    EXPECT_EQ(256u, view.count(JWWSnapshot::KIND_LAYER));
+    const uint32_t* names = view.column<uint32_t>(JWWSnapshot::KIND_LAYER, JWWSnapshot::LAYER_NAME);
+    const uint32_t* groups = view.column<uint32_t>(JWWSnapshot::KIND_LAYER, JWWSnapshot::LAYER_GROUP_NAME, &rows);
+    const double* scale = view.column<double>(JWWSnapshot::KIND_LAYER, JWWSnapshot::LAYER_GROUP_SCALE);
+    ASSERT_TRUE(names && groups && scale);
+    EXPECT_EQ(16u, rows);
+    EXPECT_EQ("\xE5\xA3\x81", view.string(names[1 * 16 + 2]));
+    EXPECT_EQ("plan", view.string(groups[1]));
+    EXPECT_EQ(50, scale[1]);
+    EXPECT_EQ("", view.string(12345));
+
+    // The same bytes through a file
+    ASSERT_TRUE(JWWSnapshot::writeFile(path, path + ".snap"));
+    std::ifstream f(path + ".snap", std::ios::binary);
+    std::string fromFile((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(snapshot, fromFile);
+}
+
+TEST_F(SnapshotTest, RejectsDamagedSnapshots) {
+    const char junk[] = "not a jww file at all";
+    std::string snapshot = "kept";
+    EXPECT_FALSE(JWWSnapshot::write(junk, sizeof(junk), snapshot));
+    EXPECT_TRUE(snapshot.empty());
+    EXPECT_FALSE(JWWSnapshot::writeFile(::testing::TempDir() + "missing.jww", path + ".snap"));
+
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.vSen.push_back(line(2, 0, 0, 1, 1));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+    ASSERT_TRUE(JWWSnapshot::write(bytes.data(), bytes.size(), snapshot));
+    // A JWW file cut after its header writes no snapshot
+    for (size_t cut : {bytes.size() - 1, bytes.size() - 20}) {
+        std::string partial = "kept";
+        EXPECT_FALSE(JWWSnapshot::write(bytes.data(), cut, partial)) << cut;
+        EXPECT_TRUE(partial.empty());
+    }
+
+    JWWSnapshot::View view;
+    // Truncated
+    EXPECT_FALSE(view.open(snapshot.data(), snapshot.size() - 8));
+    EXPECT_FALSE(view.isOpen());
+    // Other format version
+    std::string damaged = snapshot;
+    damaged[8] = 2;
+    EXPECT_FALSE(view.open(damaged.data(), damaged.size()));
+    // A column reaching past the end
+    damaged = snapshot;
+    JWWSnapshot::SectionEntry entry;
+    std::memcpy(&entry, &damaged[sizeof(JWWSnapshot::FileHeader)], sizeof(entry));
+    entry.count = 0x10000000;
+    std::memcpy(&damaged[sizeof(JWWSnapshot::FileHeader)], &entry, sizeof(entry));
+    EXPECT_FALSE(view.open(damaged.data(), damaged.size()));
+    // Not 8-byte aligned
+    std::vector<char> shifted(snapshot.size() + 8);
+    std::memcpy(shifted.data() + 1, snapshot.data(), snapshot.size());
+    EXPECT_FALSE(view.open(shifted.data() + 1, snapshot.size()));
+
+    ASSERT_TRUE(view.open(snapshot.data(), snapshot.size()));
+    EXPECT_EQ(1u, view.count(JWWSnapshot::KIND_LINE));
+    EXPECT_EQ(0u, view.count(JWWSnapshot::KIND_ARC));
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 200k lines and 5k
+// texts, snapshot written once, then opened and summed in place; a full NDJSON
+// conversion stands in for a reparse
+TEST_F(SnapshotTest, DISABLED_OpenThroughput) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 200000; i++)
+            doc.vSen.push_back(line(1 + i % 9, (i * 37) % 1000, (i * 91) % 700, (i * 37) % 1000 + 20.5, (i * 91) % 700 + 0.25));
+        for (int i = 0; i < 5000; i++)
+            doc.vMoji.push_back(text("\x90\x7D\x96\xCA " + std::to_string(i), i % 1000, i % 700));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string snapshot;
+    JWWSnapshot::Stats stats;
+    double writeMs = measureTime([&]() {
+        ASSERT_TRUE(JWWSnapshot::write(bytes.data(), bytes.size(), snapshot, &stats));
+    }, 1);
+    EXPECT_EQ(205000u, stats.records);
+    // "", the font and the 5000 distinct texts
+    EXPECT_EQ(5002u, stats.strings);
+
+    double sum = 0;
+    double openMs = measureTime([&]() {
+        JWWSnapshot::View view;
+        ASSERT_TRUE(view.open(snapshot.data(), snapshot.size()));
+        size_t n = view.count(JWWSnapshot::KIND_LINE);
+        const double* x1 = view.column<double>(JWWSnapshot::KIND_LINE, JWWSnapshot::LINE_X1);
+        for (size_t i = 0; i < n; i++)
+            sum += x1[i];
+    }, 100) / 100;
+    EXPECT_GT(sum, 0);
+
+    std::string ndjson;
+    double parseMs = measureTime([&]() {
+        ASSERT_TRUE(JWWJson::convert(bytes.data(), bytes.size(), ndjson));
+    }, 1);
+    std::cout << bytes.size() / 1024 << " KiB JWW -> " << stats.bytes / 1024 << " KiB snapshot in "
+              << writeMs << " ms; open and scan " << openMs << " ms vs reparse " << parseMs << " ms\n";
+}
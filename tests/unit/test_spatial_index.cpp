@@ -0,0 +1,117 @@
+// Spatial index tests for jwwlib-wasm
+// Checks packed R-tree queries against a linear scan; a disabled benchmark
+// times them
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "jww_spatial.h"
+
+using JWWSpatial::Box;
+using JWWSpatial::PackedRTree;
+
+class SpatialIndexTest : public ::testing::Test {
+protected:
+    std::vector<Box> makeBoxes(size_t count, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> pos(-50000.0, 50000.0);
+        std::uniform_real_distribution<double> size(0.0, 200.0);
+        std::vector<Box> boxes(count);
+        for (auto& b : boxes) {
+            double x = pos(rng), y = pos(rng);
+            b = Box(x, y, x + size(rng), y + size(rng));
+        }
+        return boxes;
+    }
+
+    static std::vector<uint32_t> linearScan(const std::vector<Box>& boxes, const Box& q) {
+        std::vector<uint32_t> out;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            if (q.intersects(boxes[i])) out.push_back(static_cast<uint32_t>(i));
+        }
+        return out;
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(SpatialIndexTest, EmptyAndSingleItem) {
+    PackedRTree tree;
+    std::vector<uint32_t> out;
+    tree.build({});
+    tree.query(-1, -1, 1, 1, out);
+    EXPECT_TRUE(out.empty());
+    EXPECT_TRUE(tree.empty());
+
+    tree.build({Box(0, 0, 1, 1)});
+    tree.query(0.5, 0.5, 2, 2, out);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(0u, out[0]);
+    out.clear();
+    tree.query(2, 2, 3, 3, out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST_F(SpatialIndexTest, MatchesLinearScan) {
+    for (size_t count : {size_t(15), size_t(16), size_t(17), size_t(257), size_t(20000)}) {
+        std::vector<Box> boxes = makeBoxes(count, 7);
+        PackedRTree tree;
+        tree.build(boxes);
+        ASSERT_EQ(count, tree.size());
+
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> pos(-60000.0, 60000.0);
+        std::uniform_real_distribution<double> size(0.0, 20000.0);
+        for (int q = 0; q < 50; ++q) {
+            double x = pos(rng), y = pos(rng);
+            Box query(x, y, x + size(rng), y + size(rng));
+            std::vector<uint32_t> got;
+            tree.query(query.minX, query.minY, query.maxX, query.maxY, got);
+            std::sort(got.begin(), got.end());
+            EXPECT_EQ(linearScan(boxes, query), got) << "count " << count << " query " << q;
+        }
+        // Item boxes are kept for exact tests by the caller
+        EXPECT_EQ(boxes[count / 2].minX, tree.itemBox(count / 2).minX);
+    }
+}
+
+TEST_F(SpatialIndexTest, ExtentCoversAllItems) {
+    std::vector<Box> boxes = makeBoxes(1000, 3);
+    PackedRTree tree;
+    tree.build(boxes);
+    std::vector<uint32_t> all;
+    const Box& e = tree.extent();
+    tree.query(e.minX, e.minY, e.maxX, e.maxY, all);
+    EXPECT_EQ(1000u, all.size());
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): viewport query cost
+// scales with the visible count
+TEST_F(SpatialIndexTest, DISABLED_ViewportQuerySpeed) {
+    std::vector<Box> boxes = makeBoxes(1000000, 5);
+    PackedRTree tree;
+    double buildMs = measureTime([&]() { tree.build(boxes); }, 1);
+
+    // Viewport showing about 0.1% of the drawing
+    Box view(0, 0, 3000, 3000);
+    std::vector<uint32_t> out;
+    double treeMs = measureTime([&]() { out.clear(); tree.query(view.minX, view.minY, view.maxX, view.maxY, out); }, 100);
+    std::vector<uint32_t> scan;
+    double scanMs = measureTime([&]() { scan = linearScan(boxes, view); }, 10) * 10;
+
+    std::sort(out.begin(), out.end());
+    EXPECT_EQ(scan, out);
+    std::cout << "build " << buildMs << " ms; 100 queries: tree " << treeMs << " ms, scan "
+              << scanMs << " ms (" << out.size() << " visible of " << boxes.size() << ")\n";
+}
@@ -0,0 +1,217 @@
+// Streaming parser tests for jwwlib-wasm
+// Feeds a JWW file in chunks and compares with a whole-file Read()
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <algorithm>
+#include "jwwdoc.h"
+#include "jww_stream.h"
+
+namespace {
+
+// Records in the order the parser delivers them
+struct RecordingHandler : public JWWRecordHandler {
+    int headers = 0;
+    std::vector<std::string> order;
+    std::vector<double> coords;
+
+    void OnHeader(JWWHead&) override { headers++; }
+    void OnSen(CDataSen& D) override {
+        order.push_back("Sen");
+        coords.insert(coords.end(), {D.m_start.x, D.m_start.y, D.m_end.x, D.m_end.y});
+    }
+    void OnEnko(CDataEnko& D) override {
+        order.push_back("Enko");
+        coords.insert(coords.end(), {D.m_start.x, D.m_start.y, D.m_dHankei});
+    }
+};
+
+} // namespace
+
+class StreamParserTest : public ::testing::Test {
+protected:
+    std::string path;
+    std::vector<char> bytes;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "stream_parser_test.jww";
+        std::string in(""), out(path);
+        {
+            JWWDocument doc(in, out);
+            doc.Header.head = "JwwData.";
+            doc.Header.JW_DATA_VERSION = 600;
+            CDataSen s;
+            s.SetVersion(600);
+            s.m_lGroup = 0; s.m_nPenStyle = 1; s.m_nPenColor = 2; s.m_nPenWidth = 1;
+            s.m_nLayer = 0; s.m_nGLayer = 0; s.m_sFlg = 0;
+            for (int i = 0; i < 300; i++) {
+                s.m_start.x = i; s.m_start.y = -i;
+                s.m_end.x = i * 0.5; s.m_end.y = 10.0 + i;
+                doc.vSen.push_back(s);
+            }
+            CDataEnko e;
+            e.SetVersion(600);
+            e.m_lGroup = 0; e.m_nPenStyle = 1; e.m_nPenColor = 3; e.m_nPenWidth = 1;
+            e.m_nLayer = 0; e.m_nGLayer = 0; e.m_sFlg = 0;
+            e.m_radKaishiKaku = 0; e.m_radEnkoKaku = 1; e.m_radKatamukiKaku = 0;
+            e.m_dHenpeiRitsu = 1; e.m_bZenEnFlg = 0;
+            for (int i = 0; i < 40; i++) {
+                e.m_start.x = 5 + i; e.m_start.y = 5 - i; e.m_dHankei = 1 + i;
+                doc.vEnko.push_back(e);
+            }
+            doc.objCode = 0;
+            ASSERT_TRUE(doc.Save());
+        }
+        std::ifstream f(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        ASSERT_GT(bytes.size(), 0u);
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    RecordingHandler parseChunked(size_t chunk) {
+        RecordingHandler handler;
+        JWWStreamParser parser(&handler);
+        for (size_t pos = 0; pos < bytes.size(); pos += chunk) {
+            size_t len = std::min(chunk, bytes.size() - pos);
+            EXPECT_EQ(JWWStreamParser::NeedMore, parser.feed(&bytes[pos], len));
+            // Once records flow only a partial record stays buffered
+            if (!handler.order.empty()) {
+                EXPECT_LT(parser.bufferedBytes(), chunk + 256);
+            }
+        }
+        EXPECT_EQ(JWWStreamParser::Done, parser.finish());
+        EXPECT_EQ(bytes.size() - parser.bufferedBytes(), parser.bytesConsumed());
+        return handler;
+    }
+};
+
+TEST_F(StreamParserTest, WholeFileReadStillWorks) {
+    std::string in(path), out("");
+    JWWDocument doc(in, out);
+    ASSERT_TRUE(doc.Read());
+    EXPECT_EQ(300u, doc.vSen.size());
+    EXPECT_EQ(40u, doc.vEnko.size());
+}
+
+TEST_F(StreamParserTest, ReadsFromMemoryBuffer) {
+    std::string in(""), out("");
+    JWWMemoryBuf input(bytes.data(), bytes.size());
+    JWWDocument doc(in, out);
+    doc.AttachInput(&input);
+    ASSERT_TRUE(doc.Read());
+    EXPECT_EQ(300u, doc.vSen.size());
+    EXPECT_EQ(40u, doc.vEnko.size());
+    EXPECT_EQ(299.0, doc.vSen.back().m_start.x);
+}
+
+TEST_F(StreamParserTest, DocumentIsReusableAfterClear) {
+    std::string in(""), out("");
+    JWWDocument doc(in, out);
+    for (int pass = 0; pass < 3; pass++) {
+        JWWMemoryBuf input(bytes.data(), bytes.size());
+        doc.AttachInput(&input);
+        ASSERT_TRUE(doc.Read()) << "pass " << pass;
+        EXPECT_EQ(300u, doc.vSen.size()) << "pass " << pass;
+        EXPECT_EQ(40u, doc.vEnko.size()) << "pass " << pass;
+        size_t reserved = doc.ReservedBytes();
+        doc.Clear();
+        EXPECT_TRUE(doc.vSen.empty());
+        // Capacity is kept for the next file
+        EXPECT_EQ(reserved, doc.ReservedBytes());
+    }
+    doc.ReleaseMemory();
+    EXPECT_EQ(0u, doc.ReservedBytes());
+}
+
+TEST_F(StreamParserTest, ChunkedMatchesWholeFile) {
+    RecordingHandler whole = parseChunked(bytes.size());
+    ASSERT_EQ(1, whole.headers);
+    ASSERT_EQ(340u, whole.order.size());
+
+    for (size_t chunk : {size_t(1), size_t(3), size_t(7), size_t(64), size_t(4096)}) {
+        RecordingHandler split = parseChunked(chunk);
+        EXPECT_EQ(1, split.headers) << "chunk " << chunk;
+        EXPECT_EQ(whole.order, split.order) << "chunk " << chunk;
+        EXPECT_EQ(whole.coords, split.coords) << "chunk " << chunk;
+    }
+}
+
+TEST_F(StreamParserTest, CollectsIntoDocumentWithoutHandler) {
+    JWWStreamParser parser;
+    parser.feed(bytes.data(), bytes.size() / 2);
+    parser.feed(bytes.data() + bytes.size() / 2, bytes.size() - bytes.size() / 2);
+    ASSERT_EQ(JWWStreamParser::Done, parser.finish());
+    EXPECT_EQ(300u, parser.document()->vSen.size());
+    EXPECT_EQ(40u, parser.document()->vEnko.size());
+    EXPECT_EQ(300u, parser.document()->SenCount);
+}
+
+TEST_F(StreamParserTest, RejectsNonJwwData) {
+    const char junk[] = "This is not a JWW file at all, just some text padding.";
+    JWWStreamParser parser;
+    EXPECT_EQ(JWWStreamParser::Error, parser.feed(junk, sizeof(junk)));
+    EXPECT_EQ(JWWStreamParser::Error, parser.finish());
+}
+
+TEST_F(StreamParserTest, TruncatedHeaderIsAnError) {
+    JWWStreamParser parser;
+    EXPECT_EQ(JWWStreamParser::NeedMore, parser.feed(bytes.data(), 16));
+    EXPECT_EQ(JWWStreamParser::Error, parser.finish());
+}
+
+TEST_F(StreamParserTest, TruncatedRecordsAreAnError) {
+    // Cut inside the records, and cut after the last record but before the
+    // block definition count
+    for (size_t cut : {bytes.size() / 2, bytes.size() - 2}) {
+        RecordingHandler handler;
+        JWWStreamParser parser(&handler);
+        EXPECT_EQ(JWWStreamParser::NeedMore, parser.feed(bytes.data(), cut)) << cut;
+        EXPECT_EQ(JWWStreamParser::Error, parser.finish()) << cut;
+    }
+}
+
+TEST_F(StreamParserTest, DamagedRecordStopsTheStream) {
+    // Rename the arc class: its records can no longer be measured
+    std::string name = "CDataEnko";
+    // (the last match: header padding is not cleared and may hold the name)
+    auto it = std::find_end(bytes.begin(), bytes.end(), name.begin(), name.end());
+    ASSERT_NE(bytes.end(), it);
+    size_t at = it - bytes.begin();
+    bytes[at + 5] = 'X';
+
+    RecordingHandler handler;
+    JWWStreamParser parser(&handler);
+    JWWStreamParser::Status status = JWWStreamParser::NeedMore;
+    size_t pos = 0;
+    for (; pos < bytes.size() && status == JWWStreamParser::NeedMore; pos += 64) {
+        status = parser.feed(&bytes[pos], std::min<size_t>(64, bytes.size() - pos));
+    }
+    EXPECT_EQ(JWWStreamParser::Error, status);
+    // Reported in the chunk holding the bad record, not at the end
+    EXPECT_LE(pos, at + 64 + 64);
+    EXPECT_EQ(300u, handler.order.size());
+    EXPECT_EQ(JWWStreamParser::Error, parser.finish());
+
+    // A class name length no name has is damage too
+    bytes[at - 2] = static_cast<char>(0xFF);
+    JWWStreamParser other;
+    EXPECT_EQ(JWWStreamParser::Error, other.feed(bytes.data(), bytes.size()));
+}
+
+TEST_F(StreamParserTest, DataAfterBlockDefinitionsIsSkipped) {
+    std::vector<char> padded = bytes;
+    padded.insert(padded.end(), 1000, '\x5A');
+    JWWStreamParser parser;
+    EXPECT_EQ(JWWStreamParser::NeedMore, parser.feed(padded.data(), padded.size()));
+    EXPECT_EQ(0u, parser.bufferedBytes());
+    EXPECT_EQ(JWWStreamParser::Done, parser.finish());
+    EXPECT_EQ(padded.size(), parser.bytesConsumed());
+    EXPECT_EQ(40u, parser.document()->vEnko.size());
+}
@@ -0,0 +1,276 @@
+// JWW to SVG conversion tests for jwwlib-wasm
+// Shift_JIS to UTF-8 decoding, path grouping per pen color, arc commands,
+// block definitions with <use>; a disabled benchmark times conversion
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include "jww_sjis.h"
+#include "jww_svg.h"
+#include "jwwdoc.h"
+
+namespace {
+
+template<typename T>
+void setPen(T& d, int color) {
+    d.SetVersion(600);
+    d.m_lGroup = 0; d.m_nPenStyle = 1; d.m_nPenColor = color; d.m_nPenWidth = 1;
+    d.m_nLayer = 2; d.m_nGLayer = 1; d.m_sFlg = 0;
+}
+
+CDataSen line(int color, double x1, double y1, double x2, double y2) {
+    CDataSen s;
+    setPen(s, color);
+    s.m_start.x = x1; s.m_start.y = y1;
+    s.m_end.x = x2; s.m_end.y = y2;
+    return s;
+}
+
+CDataEnko arc(double x, double y, double r, double start, double sweep) {
+    CDataEnko e;
+    setPen(e, 3);
+    e.m_start.x = x; e.m_start.y = y; e.m_dHankei = r;
+    e.m_radKaishiKaku = start; e.m_radEnkoKaku = sweep; e.m_radKatamukiKaku = 0;
+    e.m_dHenpeiRitsu = 1; e.m_bZenEnFlg = sweep >= 2 * M_PI ? 1 : 0;
+    return e;
+}
+
+CDataMoji text(const std::string& s, double x, double y, double degrees) {
+    CDataMoji m;
+    setPen(m, 2);
+    m.m_start.x = x; m.m_start.y = y; m.m_end.x = x + 10; m.m_end.y = y;
+    m.m_nMojiShu = 0; m.m_dSizeX = 2; m.m_dSizeY = 2; m.m_dKankaku = 0; m.m_degKakudo = degrees;
+    m.m_strFontName = "MS Gothic";
+    m.m_string = s;
+    return m;
+}
+
+size_t count(const std::string& s, const std::string& what) {
+    size_t n = 0;
+    for (size_t at = s.find(what); at != std::string::npos; at = s.find(what, at + 1))
+        n++;
+    return n;
+}
+
+} // namespace
+
+class SvgExportTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "svg_export_test.jww";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // The file written by a JWWDocument once it has been destroyed
+    std::vector<char> load() {
+        std::ifstream f(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(SvgExportTest, ShiftJisToUtf8) {
+    // "あ漢字 ABC", half-width katakana, NEC circled 1, a user-defined character
+    EXPECT_EQ("\xE3\x81\x82\xE6\xBC\xA2\xE5\xAD\x97 ABC",
+              JWWSjis::toUtf8("\x82\xA0\x8A\xBF\x8E\x9A ABC"));
+    EXPECT_EQ("\xEF\xBD\xB1", JWWSjis::toUtf8("\xB1"));
+    EXPECT_EQ("\xE2\x91\xA0", JWWSjis::toUtf8("\x87\x40"));
+    EXPECT_EQ("\xEE\x80\x80", JWWSjis::toUtf8("\xF0\x40"));
+    // A cut-off lead byte, an invalid trail byte and a lone 0xFF
+    const std::string replacement = "\xEF\xBF\xBD";
+    EXPECT_EQ("a" + replacement, JWWSjis::toUtf8("a\x82"));
+    EXPECT_EQ(replacement + "\x7F!", JWWSjis::toUtf8("\x82\x7F!"));
+    EXPECT_EQ(replacement, JWWSjis::toUtf8("\xFF"));
+}
+
+TEST_F(SvgExportTest, PathsGroupedByColor) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        // A connected polyline in pen 2, then pen 5 in between
+        doc.vSen.push_back(line(2, 0, 0, 10, 0));
+        doc.vSen.push_back(line(5, 0, 5, 0, 8));
+        doc.vSen.push_back(line(2, 10, 0, 10, 10));
+        doc.vSen.push_back(line(2, 10.004, 10, 20.125, 10));
+        // Quarter arc and a full circle
+        doc.vEnko.push_back(arc(0, 0, 10, 0, M_PI / 2));
+        doc.vEnko.push_back(arc(50, 50, 5, 0, 2 * M_PI));
+        doc.vMoji.push_back(text("\x8A\xBF <&>", 1, 2, 90));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string svg;
+    JWWSvg::Stats stats;
+    ASSERT_TRUE(JWWSvg::convert(bytes.data(), bytes.size(), svg, JWWSvg::Options(), &stats));
+    EXPECT_EQ(svg.size(), stats.bytes);
+    EXPECT_EQ(7u, stats.elements);
+    EXPECT_EQ(1u, stats.texts);
+    EXPECT_EQ(3u, stats.paths);
+    EXPECT_EQ(3u, count(svg, "<path "));
+    EXPECT_EQ(0u, svg.find("<?xml"));
+    EXPECT_NE(std::string::npos, svg.find("</svg>\n"));
+
+    // Pen 2's lines are one path; the continuation needs no moveto, the
+    // line from 10.004 rounds onto the previous end at 2 decimals
+    EXPECT_NE(std::string::npos, svg.find("d=\"M0 0L10 0L10 -10L20.13 -10\""));
+    EXPECT_NE(std::string::npos, svg.find("d=\"M0 -5L0 -8\""));
+    // Counterclockwise quarter arc from (10, 0) to (0, 10), y flipped;
+    // the circle is two half arcs
+    EXPECT_NE(std::string::npos, svg.find("M10 0A10 10 0 0 0 0 -10"));
+    EXPECT_NE(std::string::npos, svg.find("M55 -50A5 5 0 0 0 45 -50A5 5 0 0 0 55 -50"));
+    // Text: UTF-8, escaped, rotated about its insertion point
+    EXPECT_NE(std::string::npos, svg.find(">\xE6\xBC\xA2 &lt;&amp;&gt;</text>"));
+    EXPECT_NE(std::string::npos, svg.find("transform=\"rotate(-90 1 -2)\""));
+
+    // Coarser output: one decimal and a 0.5 grid
+    JWWSvg::Options options;
+    options.precision = 1;
+    options.quantum = 0.5;
+    options.texts = false;
+    std::string coarse;
+    ASSERT_TRUE(JWWSvg::convert(bytes.data(), bytes.size(), coarse, options, &stats));
+    EXPECT_EQ(0u, stats.texts);
+    EXPECT_EQ(std::string::npos, coarse.find("<text"));
+    EXPECT_NE(std::string::npos, coarse.find("L20 -10\""));
+}
+
+TEST_F(SvgExportTest, BlocksBecomeUses) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.vSen.push_back(line(2, 0, 0, 1, 0));
+        CDataBlock b;
+        setPen(b, 1);
+        b.m_DPKijunTen.x = 100; b.m_DPKijunTen.y = 200;
+        b.m_dBairitsuX = 2; b.m_dBairitsuY = 2; b.m_radKaitenKaku = M_PI / 2;
+        b.m_n_Number = 0;
+        doc.vBlock.push_back(b);
+        CDataList list;
+        setPen(list, 1);
+        list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+        list.m_strName = "door";
+        list.Count = 1;
+        doc.pBlockList->AddBlockList(list);
+        CDataSen s = line(4, 0, 0, 10, 0);
+        doc.pBlockList->AddDataListSen(s);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string svg = "prefix";
+    JWWSvg::Stats stats;
+    ASSERT_TRUE(JWWSvg::convert(bytes.data(), bytes.size(), svg, JWWSvg::Options(), &stats));
+    EXPECT_EQ(0u, svg.find("prefix<?xml"));
+    EXPECT_EQ(svg.size() - 6, stats.bytes);
+    EXPECT_EQ(1u, stats.inserts);
+    EXPECT_EQ(2u, stats.elements);
+    size_t defs = svg.find("<defs>\n<g id=\"jww-b0\">\n<path ");
+    size_t use = svg.find("<use xlink:href=\"#jww-b0\" transform=\"translate(100 -200) rotate(-90) scale(2 2)\"/>");
+    ASSERT_NE(std::string::npos, defs);
+    ASSERT_NE(std::string::npos, use);
+    EXPECT_LT(defs, use);
+    // The rotated insert reaches up to y = 220, so the view starts above -220
+    size_t view = svg.find("viewBox=\"");
+    ASSERT_NE(std::string::npos, view);
+    double x, y, w, h;
+    ASSERT_EQ(4, std::sscanf(svg.c_str() + view + 9, "%lf %lf %lf %lf", &x, &y, &w, &h));
+    EXPECT_LT(y, -220);
+    EXPECT_GT(y, -222);
+    EXPECT_LT(x, 0);
+    EXPECT_GT(x + w, 100);
+}
+
+TEST_F(SvgExportTest, RejectsOtherData) {
+    const char junk[] = "not a jww file at all";
+    std::string svg = "kept";
+    EXPECT_FALSE(JWWSvg::convert(junk, sizeof(junk), svg));
+    EXPECT_EQ("kept", svg);
+    EXPECT_FALSE(JWWSvg::convertFile(::testing::TempDir() + "missing.jww", path + ".svg"));
+}
+
+TEST_F(SvgExportTest, RejectsTruncatedData) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        doc.vSen.push_back(line(2, 0, 0, 1, 0));
+        CDataList list;
+        setPen(list, 1);
+        list.m_nNumber = 0; list.m_bReffered = 1; list.m_time = 0;
+        list.m_strName = "door";
+        list.Count = 2;
+        doc.pBlockList->AddBlockList(list);
+        CDataSen a = line(4, 0, 0, 10, 0), b = line(4, 0, 0, 0, 10);
+        doc.pBlockList->AddDataListSen(a);
+        doc.pBlockList->AddDataListSen(b);
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    // The header parses but the definition is cut short
+    for (size_t cut : {bytes.size() - 1, bytes.size() - 40}) {
+        std::string svg = "kept";
+        EXPECT_FALSE(JWWSvg::convert(bytes.data(), cut, svg)) << cut;
+        EXPECT_EQ("kept", svg);
+    }
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 200k lines over 9 pens,
+// 20k arcs and 5k texts to an SVG string; the arcs share pen 3, so 9 paths
+TEST_F(SvgExportTest, DISABLED_ConversionThroughput) {
+    {
+        std::string in(""), out(path);
+        JWWDocument doc(in, out);
+        doc.Header.head = "JwwData.";
+        doc.Header.JW_DATA_VERSION = 600;
+        for (int i = 0; i < 200000; i++)
+            doc.vSen.push_back(line(1 + i % 9, (i * 37) % 1000, (i * 91) % 700, (i * 37) % 1000 + 20.5, (i * 91) % 700 + 0.25));
+        for (int i = 0; i < 20000; i++)
+            doc.vEnko.push_back(arc((i * 53) % 1000, (i * 29) % 700, 2 + i % 30, 0.5, 1.25));
+        for (int i = 0; i < 5000; i++)
+            doc.vMoji.push_back(text("\x90\x7D\x96\xCA " + std::to_string(i), i % 1000, i % 700, 0));
+        doc.objCode = 0;
+        ASSERT_TRUE(doc.Save());
+    }
+    std::vector<char> bytes = load();
+
+    std::string svg;
+    JWWSvg::Stats stats;
+    double ms = measureTime([&]() {
+        svg.clear();
+        ASSERT_TRUE(JWWSvg::convert(bytes.data(), bytes.size(), svg, JWWSvg::Options(), &stats));
+    }, 3) / 3;
+    EXPECT_EQ(225000u, stats.elements);
+    EXPECT_EQ(5000u, stats.texts);
+    EXPECT_EQ(9u, stats.paths);
+    std::cout << bytes.size() / 1024 << " KiB JWW -> " << stats.bytes / 1024 << " KiB SVG in " << ms
+              << " ms (" << stats.bytes / 1048.576 / ms << " MB/s)\n";
+}
@@ -0,0 +1,148 @@
+// Curve tessellation tests for jwwlib-wasm
+// Checks chord error against the tolerance and that arcs close on their ends
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include "jww_tessellate.h"
+
+using JWWTessellate::segmentCount;
+using JWWTessellate::emitArc;
+
+class TessellateTest : public ::testing::Test {
+protected:
+    // Largest distance from a chord midpoint to the circle of radius r
+    static double maxChordError(const std::vector<float>& v, double cx, double cy, double r) {
+        double worst = 0.0;
+        for (size_t i = 0; i + 3 < v.size(); i += 4) {
+            double mx = (v[i] + v[i + 2]) * 0.5 - cx;
+            double my = (v[i + 1] + v[i + 3]) * 0.5 - cy;
+            worst = std::max(worst, std::fabs(std::hypot(mx, my) - r));
+        }
+        return worst;
+    }
+};
+
+TEST_F(TessellateTest, SegmentCountFollowsTolerance) {
+    EXPECT_EQ(JWWTessellate::MIN_SEGMENTS, segmentCount(0.0, 2 * M_PI, 0.1));
+    EXPECT_EQ(JWWTessellate::MIN_SEGMENTS, segmentCount(10.0, 0.0, 0.1));
+    EXPECT_EQ(JWWTessellate::MAX_SEGMENTS, segmentCount(1e9, 2 * M_PI, 1e-6));
+    // Coarser tolerance, fewer segments; bigger radius, more segments
+    EXPECT_GT(segmentCount(100.0, 2 * M_PI, 0.01), segmentCount(100.0, 2 * M_PI, 0.1));
+    EXPECT_GT(segmentCount(1000.0, 2 * M_PI, 0.1), segmentCount(100.0, 2 * M_PI, 0.1));
+    // Half the sweep needs about half the segments
+    EXPECT_NEAR(segmentCount(100.0, 2 * M_PI, 0.01) / 2.0, segmentCount(100.0, M_PI, 0.01), 1.0);
+    // A tolerance above the radius still gives a closed shape
+    EXPECT_EQ(3, segmentCount(1.0, 2 * M_PI, 5.0));
+}
+
+TEST_F(TessellateTest, ChordErrorWithinTolerance) {
+    const double cx = 1000.0, cy = -500.0;
+    for (double r : {1.0, 50.0, 5000.0}) {
+        for (double tol : {0.001, 0.05, 0.5}) {
+            int n = segmentCount(r, 2 * M_PI, tol);
+            std::vector<float> v(n * 4);
+            EXPECT_EQ(v.data() + v.size(), emitArc(v.data(), cx, cy, r, r, 0.0, 0.0, 2 * M_PI, n, 0.0, 0.0));
+            if (n < JWWTessellate::MAX_SEGMENTS) {
+                // float rounding of the vertices adds a little on top
+                EXPECT_LE(maxChordError(v, cx, cy, r), tol + 1e-3) << "r " << r << " tol " << tol;
+            }
+            // Closed: the last vertex meets the first
+            EXPECT_FLOAT_EQ(v[0], v[v.size() - 2]);
+            EXPECT_FLOAT_EQ(v[1], v[v.size() - 1]);
+        }
+    }
+}
+
+TEST_F(TessellateTest, ArcAndEllipseEndpoints) {
+    // Arc from 90 to 180 degrees, relative to an origin
+    std::vector<float> v(8 * 4);
+    emitArc(v.data(), 10.0, 20.0, 5.0, 5.0, 0.0, M_PI / 2, M_PI / 2, 8, 10.0, 20.0);
+    EXPECT_NEAR(0.0, v[0], 1e-6);
+    EXPECT_NEAR(5.0, v[1], 1e-6);
+    EXPECT_NEAR(-5.0, v[v.size() - 2], 1e-6);
+    EXPECT_NEAR(0.0, v[v.size() - 1], 1e-6);
+    // Segments are contiguous
+    for (size_t i = 4; i < v.size(); i += 4) {
+        EXPECT_EQ(v[i - 2], v[i]);
+        EXPECT_EQ(v[i - 1], v[i + 1]);
+    }
+
+    // Ellipse rotated 90 degrees: the major axis runs along y
+    std::vector<float> e(64 * 4);
+    emitArc(e.data(), 0.0, 0.0, 10.0, 4.0, M_PI / 2, 0.0, 2 * M_PI, 64, 0.0, 0.0);
+    EXPECT_NEAR(0.0, e[0], 1e-5);
+    EXPECT_NEAR(10.0, e[1], 1e-5);
+    for (size_t i = 0; i < e.size(); i += 2) {
+        double x = e[i] / 4.0, y = e[i + 1] / 10.0;
+        EXPECT_NEAR(1.0, x * x + y * y, 1e-5);
+    }
+}
+
+TEST_F(TessellateTest, ArcBoundsAreExact) {
+    double box[4];
+    // Quarter arc from 0 to 90 degrees: no quadrant crossing inside
+    JWWTessellate::arcBounds(0.0, 0.0, 10.0, 10.0, 0.0, 0.0, M_PI / 2, box);
+    EXPECT_NEAR(0.0, box[0], 1e-9);
+    EXPECT_NEAR(0.0, box[1], 1e-9);
+    EXPECT_NEAR(10.0, box[2], 1e-9);
+    EXPECT_NEAR(10.0, box[3], 1e-9);
+    // 45 to 225 degrees crosses the top and the left extreme
+    JWWTessellate::arcBounds(5.0, 5.0, 10.0, 10.0, 0.0, M_PI / 4, M_PI, box);
+    EXPECT_NEAR(-5.0, box[0], 1e-9);
+    EXPECT_NEAR(5.0 - 10.0 * std::sqrt(0.5), box[1], 1e-9);
+    EXPECT_NEAR(5.0 + 10.0 * std::sqrt(0.5), box[2], 1e-9);
+    EXPECT_NEAR(15.0, box[3], 1e-9);
+
+    // Rotated elliptic arcs against densely sampled points
+    const double arcs[][5] = {
+        {8.0, 3.0, 0.3, 0.2, 2.5},
+        {8.0, 3.0, 2.0, 5.0, 3.0},
+        {4.0, 4.0, 0.0, 6.0, 1.0},
+        {12.0, 1.0, -1.2, 0.0, 2 * M_PI},
+    };
+    for (const auto& a : arcs) {
+        JWWTessellate::arcBounds(1.0, -2.0, a[0], a[1], a[2], a[3], a[4], box);
+        double c = std::cos(a[2]), s = std::sin(a[2]);
+        double sampled[4] = {1e300, 1e300, -1e300, -1e300};
+        for (int i = 0; i <= 100000; i++) {
+            double t = a[3] + a[4] * i / 100000.0;
+            double ex = a[0] * std::cos(t), ey = a[1] * std::sin(t);
+            double x = 1.0 + ex * c - ey * s, y = -2.0 + ex * s + ey * c;
+            sampled[0] = std::min(sampled[0], x);
+            sampled[1] = std::min(sampled[1], y);
+            sampled[2] = std::max(sampled[2], x);
+            sampled[3] = std::max(sampled[3], y);
+        }
+        for (int k = 0; k < 4; k++) {
+            EXPECT_NEAR(sampled[k], box[k], 1e-6);
+        }
+    }
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 100k full circles at
+// a screen-pixel tolerance
+TEST_F(TessellateTest, DISABLED_BatchSpeed) {
+    const size_t count = 100000;
+    const double tol = 0.05;
+    std::vector<int> segments(count);
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        segments[i] = segmentCount(1.0 + (i % 1000), 2 * M_PI, tol);
+        total += segments[i];
+    }
+    std::vector<float> v(total * 4);
+    auto start = std::chrono::high_resolution_clock::now();
+    float* out = v.data();
+    for (size_t i = 0; i < count; i++) {
+        out = emitArc(out, double(i), 0.0, 1.0 + (i % 1000), 1.0 + (i % 1000), 0.0, 0.0, 2 * M_PI,
+                      segments[i], 0.0, 0.0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_EQ(v.data() + v.size(), out);
+    std::cout << count << " circles, " << total << " segments in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0
+              << " ms\n";
+}
@@ -0,0 +1,208 @@
+// Vector tile tests for jwwlib-wasm
+// Checks the quadtree split, clipping and quantization, that blobs decode
+// back to the clipped geometry, and that threaded builds match serial ones
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "jww_tile.h"
+
+using JWWTile::Tiler;
+using JWWTile::DecodedTile;
+
+class TileTest : public ::testing::Test {
+protected:
+    static DecodedTile decode(const JWWTile::Tile& tile) {
+        DecodedTile out;
+        EXPECT_TRUE(JWWTile::decodeTile(tile.blob.data(), tile.blob.size(), out));
+        return out;
+    }
+
+    template<typename Func>
+    double measureTime(Func func, int iterations) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+    }
+};
+
+TEST_F(TileTest, RootTileRoundTrip) {
+    Tiler tiler;
+    tiler.addSegment(0, 0, 100, 50, 3);
+    tiler.addSegment(100, 100, 0, 0, 1);
+    tiler.addSegment(10, 10, 10.001, 10, 1);    // under a unit: dropped
+    tiler.addSegment(0, 0, 100, 100, 1);        // duplicate, reversed
+    tiler.build();
+    ASSERT_EQ(1u, tiler.tiles().size());
+    const JWWTile::Tile& root = tiler.tiles()[0];
+    EXPECT_TRUE(root.leaf);
+    EXPECT_EQ(2u, root.segments);
+    EXPECT_DOUBLE_EQ(0.0, tiler.getMinX());
+    EXPECT_DOUBLE_EQ(100.0, tiler.getSize());
+
+    DecodedTile t = decode(root);
+    EXPECT_EQ(0, t.z);
+    EXPECT_DOUBLE_EQ(100.0, t.size);
+    EXPECT_EQ(JWWTile::EXTENT, t.extent);
+    ASSERT_EQ(2u, t.groups.size());
+    EXPECT_EQ(1u, t.groups[0].pen);
+    EXPECT_EQ(3u, t.groups[1].pen);
+    ASSERT_EQ(8u, t.vertices.size());
+    const int32_t expected[8] = {0, 0, 4096, 4096, 0, 0, 4096, 2048};
+    for (int i = 0; i < 8; i++)
+        EXPECT_EQ(expected[i], t.vertices[i]);
+
+    // Truncated or foreign data is rejected
+    EXPECT_FALSE(JWWTile::decodeTile(root.blob.data(), root.blob.size() - 1, t));
+    const uint8_t junk[] = "JWW1....";
+    EXPECT_FALSE(JWWTile::decodeTile(junk, sizeof(junk), t));
+}
+
+TEST_F(TileTest, SplitAndClip) {
+    Tiler tiler;
+    // A long line across the drawing plus enough short ones to split
+    tiler.addSegment(0, 50, 100, 50, 7);
+    tiler.addSegment(0, 0, 100, 100, 7);
+    for (int i = 0; i < 40; i++)
+        tiler.addSegment(10 + i, 10, 10 + i, 12, 1);
+    JWWTile::Options options;
+    options.maxItems = 16;
+    options.maxZoom = 3;
+    tiler.build(options);
+
+    const JWWTile::Tile* root = tiler.find(0, 0, 0);
+    ASSERT_NE(nullptr, root);
+    EXPECT_FALSE(root->leaf);
+    // Upper tiles only hold the two long lines: leaves at z = 1
+    const JWWTile::Tile* upper = tiler.find(1, 0, 1);
+    ASSERT_NE(nullptr, upper);
+    EXPECT_TRUE(upper->leaf);
+    EXPECT_EQ(nullptr, tiler.find(2, 0, 2));
+    // The short lines are split down to the lower-left corner
+    EXPECT_NE(nullptr, tiler.find(3, 0, 0));
+
+    // Everything stays within the tile plus its buffer
+    for (const JWWTile::Tile& tile : tiler.tiles()) {
+        DecodedTile t = decode(tile);
+        EXPECT_EQ(tile.z, t.z);
+        EXPECT_EQ(tile.x, t.x);
+        EXPECT_EQ(tile.y, t.y);
+        EXPECT_DOUBLE_EQ(100.0 / (1 << tile.z), t.size);
+        for (int32_t v : t.vertices) {
+            EXPECT_GE(v, -JWWTile::BUFFER);
+            EXPECT_LE(v, JWWTile::EXTENT + JWWTile::BUFFER);
+        }
+    }
+    DecodedTile t = decode(*upper);
+    ASSERT_EQ(1u, t.groups.size());
+    EXPECT_EQ(7u, t.groups[0].pen);
+    // The horizontal line on the lower edge, clipped to the buffer on the
+    // right, and the corner of the diagonal
+    ASSERT_EQ(8u, t.vertices.size());
+    bool edge = false;
+    for (size_t i = 0; i < t.vertices.size(); i += 4) {
+        edge |= t.vertices[i] == 0 && t.vertices[i + 1] == 0 &&
+                t.vertices[i + 2] == JWWTile::EXTENT + JWWTile::BUFFER && t.vertices[i + 3] == 0;
+    }
+    EXPECT_TRUE(edge);
+}
+
+TEST_F(TileTest, ArcsFollowTheCurve) {
+    Tiler tiler;
+    tiler.addArc(50, 50, 40, 40, 0, 0, 2 * M_PI, 2);
+    tiler.addArc(50, 50, 20, 8, 0.5, 0.2, 3.0, 3);
+    JWWTile::Options options;
+    options.maxItems = 1;
+    options.maxZoom = 2;
+    tiler.build(options);
+    ASSERT_GT(tiler.tiles().size(), 1u);
+
+    for (const JWWTile::Tile& tile : tiler.tiles()) {
+        DecodedTile t = decode(tile);
+        double unit = t.size / t.extent;
+        for (const JWWTile::Group& g : t.groups) {
+            if (g.pen != 2)
+                continue;
+            // Chord ends within a unit of the circle, or on the clip box
+            for (uint32_t v = g.first; v < g.first + g.count; v++) {
+                int32_t qx = t.vertices[v * 2], qy = t.vertices[v * 2 + 1];
+                double r = std::hypot(t.minX + qx * unit - 50, t.minY + qy * unit - 50);
+                bool onEdge = qx == -JWWTile::BUFFER || qy == -JWWTile::BUFFER ||
+                              qx == JWWTile::EXTENT + JWWTile::BUFFER || qy == JWWTile::EXTENT + JWWTile::BUFFER;
+                if (!onEdge) {
+                    EXPECT_NEAR(40.0, r, unit);
+                }
+            }
+        }
+    }
+    // The circle only passes near the middle tiles of z = 2
+    const JWWTile::Tile* middle = tiler.find(2, 1, 1);
+    ASSERT_NE(nullptr, middle);
+    DecodedTile t = decode(*middle);
+    ASSERT_EQ(1u, t.groups.size());
+    EXPECT_EQ(3u, t.groups[0].pen);
+}
+
+// Random short lines and circles
+static void addRandomItems(Tiler& tiler, int lines, int circles) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> pos(0.0, 10000.0), step(-5.0, 5.0);
+    for (int i = 0; i < lines; i++) {
+        double x = pos(rng), y = pos(rng);
+        tiler.addSegment(x, y, x + step(rng), y + step(rng), static_cast<uint32_t>(i % 5));
+    }
+    for (int i = 0; i < circles; i++)
+        tiler.addArc(pos(rng), pos(rng), 20, 20, 0, 0, 2 * M_PI, 9);
+}
+
+TEST_F(TileTest, ThreadedMatchesSerial) {
+    Tiler tiler;
+    addRandomItems(tiler, 30000, 200);
+
+    JWWTile::Options options;
+    options.maxZoom = 5;
+    options.maxItems = 1024;
+    options.threads = 1;
+    tiler.build(options);
+    std::vector<JWWTile::Tile> serial = tiler.tiles();
+    options.threads = 4;
+    tiler.build(options);
+
+    size_t bytes = 0, segments = 0;
+    ASSERT_EQ(serial.size(), tiler.tiles().size());
+    for (size_t i = 0; i < serial.size(); i++) {
+        EXPECT_TRUE(serial[i].blob == tiler.tiles()[i].blob);
+        bytes += serial[i].blob.size();
+        segments += serial[i].segments;
+    }
+    // Coordinates take a few bytes per segment
+    EXPECT_LT(bytes, segments * 8);
+}
+
+// Benchmark (run with --gtest_also_run_disabled_tests): 300k random short
+// lines, serial against threaded
+TEST_F(TileTest, DISABLED_ParallelBuild) {
+    Tiler tiler;
+    addRandomItems(tiler, 300000, 2000);
+
+    JWWTile::Options options;
+    options.maxZoom = 6;
+    options.maxItems = 4096;
+    options.threads = 1;
+    double serialMs = measureTime([&]() { tiler.build(options); }, 1);
+    size_t bytes = 0, segments = 0;
+    for (const JWWTile::Tile& tile : tiler.tiles()) {
+        bytes += tile.blob.size();
+        segments += tile.segments;
+    }
+    options.threads = 0;
+    double parallelMs = measureTime([&]() { tiler.build(options); }, 1);
+    std::cout << tiler.tiles().size() << " tiles, " << segments << " segments, " << bytes / 1024
+              << " KiB: serial " << serialMs << " ms, threaded " << parallelMs << " ms\n";
+}